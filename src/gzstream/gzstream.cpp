@@ -57,6 +57,10 @@
 #include <gzstream.h>
 #include <iostream>
 #include <string.h>  // for memcpy
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "util/thread/parallel_for.h"
 
 #ifdef GZSTREAM_NAMESPACE
 namespace GZSTREAM_NAMESPACE {
@@ -66,10 +70,192 @@ namespace GZSTREAM_NAMESPACE {
 // Internal classes to implement gzstream. See header file for user classes.
 // ----------------------------------------------------------------------------
 
+// --------------------------------------
+// BGZF block inflation
+// --------------------------------------
+
+static inline unsigned short GetLE16( const char *p) {
+    return (unsigned short)( (unsigned char)p[0] | ((unsigned char)p[1] << 8));
+}
+
+static inline unsigned int GetLE32( const char *p) {
+    return (unsigned int) GetLE16( p) | ((unsigned int) GetLE16( p + 2) << 16);
+}
+
+// reads up to n bytes; returns the number read, short only at end of file
+static int ReadFully( int fd, char *p, int n) {
+    int total = 0;
+    while ( total < n) {
+        ssize_t r = ::read( fd, p + total, n - total);
+        if ( r <= 0)
+            break;
+        total += r;
+    }
+    return total;
+}
+
+// offset of the BSIZE field in the extra subfields [p, p + xlen), or -1
+static int FindBgzfSubfield( const char *p, int xlen) {
+    int i = 0;
+    while ( i + 4 <= xlen) {
+        int slen = GetLE16( p + i + 2);
+        if ( p[i] == 'B' && p[i + 1] == 'C' && slen == 2 && i + 6 <= xlen)
+            return i + 4;
+        i += 4 + slen;
+    }
+    return -1;
+}
+
+static void InflateBgzfBlocks( void *arg, ulong begin, ulong end) {
+    bgzf_block *blocks = reinterpret_cast< bgzf_block * >( arg);
+    for ( ulong i = begin; i < end; ++i) {
+        bgzf_block &b = blocks[i];
+        b.ok = false;
+        b.out_size = 0;
+
+        // member layout: 12 byte header, XLEN extra bytes, deflate data,
+        // CRC32 and ISIZE
+        int xlen = GetLE16( &b.in[10]);
+        int data_size = b.in_size - 12 - xlen - 8;
+        if ( data_size < 0)
+            continue;
+        const char *tail = &b.in[0] + b.in_size - 8;
+        unsigned int crc = GetLE32( tail), isize = GetLE32( tail + 4);
+        if ( isize > (unsigned int) gzstreambuf::bgzfMaxBlockSize)
+            continue;
+
+        z_stream zs;
+        memset( &zs, 0, sizeof( zs));
+        if ( inflateInit2( &zs, -15) != Z_OK)
+            continue;
+        zs.next_in = (Bytef *) &b.in[12 + xlen];
+        zs.avail_in = data_size;
+        zs.next_out = (Bytef *) &b.out[gzstreambuf::putbackSize];
+        zs.avail_out = gzstreambuf::bgzfMaxBlockSize;
+        int status = inflate( &zs, Z_FINISH);
+        b.out_size = zs.total_out;
+        inflateEnd( &zs);
+
+        b.ok = ( status == Z_STREAM_END && (unsigned int) b.out_size == isize
+                 && crc32( crc32( 0L, Z_NULL, 0), (const Bytef *) &b.out[gzstreambuf::putbackSize], b.out_size) == crc);
+    }
+}
+
 // --------------------------------------
 // class gzstreambuf:
 // --------------------------------------
 
+gzstreambuf::gzstreambuf( int buffer_size, unsigned threads) : opened(0), bgzf_fd(-1), nThreads( threads), block_count(0), block_next(0), bgzf_error(false) {
+    bufferSize = ( buffer_size > 2 * putbackSize) ? buffer_size : defaultBufferSize;
+    buffer = new char[bufferSize];
+    setp( buffer, buffer + (bufferSize-1));
+    setg( buffer + putbackSize,     // beginning of putback area
+          buffer + putbackSize,     // read position
+          buffer + putbackSize);    // end position      
+    // ASSERT: both input & output capabilities will not be used together
+}
+
+gzstreambuf::~gzstreambuf() {
+    close();
+    delete [] buffer;
+}
+
+bool gzstreambuf::isBgzf( const char *name) {
+    // gzip member with FEXTRA set and a 'BC' subfield
+    char head[18];
+    int fd = ::open( name, O_RDONLY);
+    if ( fd < 0)
+        return false;
+    int n = ReadFully( fd, head, 18);
+    ::close( fd);
+
+    if ( n < 18 || (unsigned char)head[0] != 0x1f || (unsigned char)head[1] != 0x8b
+            || head[2] != 8 || !( head[3] & 0x04))
+        return false;
+    return FindBgzfSubfield( head + 12, GetLE16( head + 10)) >= 0;
+}
+
+// reads the next member into b; returns 1 on success, 0 at end of file and
+// -1 when the member is malformed
+int gzstreambuf::readBgzfBlock( bgzf_block &b) {
+    if ( b.in.size() < (size_t)( bgzfMaxBlockSize + 1))
+        b.in.resize( bgzfMaxBlockSize + 1);
+    char *p = &b.in[0];
+
+    int n = ReadFully( bgzf_fd, p, 12);
+    if ( n == 0)
+        return 0;
+    if ( n < 12 || (unsigned char)p[0] != 0x1f || (unsigned char)p[1] != 0x8b || !( p[3] & 0x04))
+        return -1;
+
+    int xlen = GetLE16( p + 10);
+    if ( 12 + xlen > bgzfMaxBlockSize || ReadFully( bgzf_fd, p + 12, xlen) < xlen)
+        return -1;
+    int bsize = FindBgzfSubfield( p + 12, xlen);
+    if ( bsize < 0)
+        return -1;
+
+    // BSIZE is the member size minus 1
+    b.in_size = GetLE16( p + 12 + bsize) + 1;
+    int rest = b.in_size - 12 - xlen;
+    if ( rest < 8 || ReadFully( bgzf_fd, p + 12 + xlen, rest) < rest)
+        return -1;
+    return 1;
+}
+
+// reads and inflates the next batch of members; false at end of file
+bool gzstreambuf::fillBgzfBlocks() {
+    block_count = 0;
+    block_next = 0;
+
+    // the file position is lost after a malformed member
+    if ( bgzf_error)
+        return false;
+
+    for ( ; block_count < blocks.size(); ++block_count) {
+        int res = readBgzfBlock( blocks[block_count]);
+        if ( res < 0)
+            bgzf_error = true;
+        if ( res <= 0)
+            break;
+    }
+
+    if ( block_count == 0)
+        return false;
+
+    util::ParallelFor( 0, block_count, InflateBgzfBlocks, &blocks[0], nThreads);
+    return true;
+}
+
+int gzstreambuf::bgzfUnderflow() {
+    // keep the putback characters of the current block
+    char putback[putbackSize];
+    int n_putback = gptr() - eback();
+    if ( n_putback > putbackSize)
+        n_putback = putbackSize;
+    memcpy( putback, gptr() - n_putback, n_putback);
+
+    while ( true) {
+        if ( block_next >= block_count && ! fillBgzfBlocks())
+            return EOF;
+
+        bgzf_block &b = blocks[block_next++];
+        if ( ! b.ok) {
+            bgzf_error = true;
+            return EOF;
+        }
+        if ( b.out_size == 0)   // e.g. the end of file marker
+            continue;
+
+        memcpy( &b.out[putbackSize - n_putback], putback, n_putback);
+        setg( &b.out[putbackSize - n_putback],     // beginning of putback area
+              &b.out[putbackSize],                 // read position
+              &b.out[putbackSize] + b.out_size);   // end of buffer
+
+        return * reinterpret_cast<unsigned char *>( gptr());
+    }
+}
+
 gzstreambuf* gzstreambuf::open( const char* name, int open_mode) {
     if ( is_open())
         return (gzstreambuf*)0;
@@ -86,9 +272,30 @@ gzstreambuf* gzstreambuf::open( const char* name, int open_mode) {
         *fmodeptr++ = 'w';
     *fmodeptr++ = 'b';
     *fmodeptr = '\0';
+
+    if (( mode & std::ios::in) && isBgzf( name)) {
+        bgzf_fd = ::open( name, O_RDONLY);
+        if ( bgzf_fd < 0)
+            return (gzstreambuf*)0;
+
+        unsigned threads = ( nThreads > 0) ? nThreads : util::GetProcessorCount();
+        blocks.resize( threads * bgzfBlocksPerThread);
+        for ( unsigned i = 0; i < blocks.size(); ++i)
+            blocks[i].out.resize( putbackSize + bgzfMaxBlockSize);
+        block_count = block_next = 0;
+        bgzf_error = false;
+
+        opened = 1;
+        return this;
+    }
+
     file = gzopen( name, fmode);
     if (file == 0)
         return (gzstreambuf*)0;
+#if ZLIB_VERNUM >= 0x1240
+    // let zlib read the compressed file in pieces as large as ours
+    gzbuffer( file, bufferSize);
+#endif
     opened = 1;
     return this;
 }
@@ -97,6 +304,14 @@ gzstreambuf * gzstreambuf::close() {
     if ( is_open()) {
         sync();
         opened = 0;
+        if ( is_bgzf()) {
+            ::close( bgzf_fd);
+            bgzf_fd = -1;
+            blocks.clear();
+            block_count = block_next = 0;
+            setg( buffer + putbackSize, buffer + putbackSize, buffer + putbackSize);
+            return this;
+        }
         if ( gzclose( file) == Z_OK)
             return this;
     }
@@ -109,20 +324,22 @@ int gzstreambuf::underflow() { // used for input buffer only
 
     if ( ! (mode & std::ios::in) || ! opened)
         return EOF;
+    if ( is_bgzf())
+        return bgzfUnderflow();
     // Josuttis' implementation of inbuf
     int n_putback = gptr() - eback();
-    if ( n_putback > 4)
-        n_putback = 4;
-    memcpy( buffer + (4 - n_putback), gptr() - n_putback, n_putback);
+    if ( n_putback > putbackSize)
+        n_putback = putbackSize;
+    memcpy( buffer + (putbackSize - n_putback), gptr() - n_putback, n_putback);
 
-    int num = gzread( file, buffer+4, bufferSize-4);
+    int num = gzread( file, buffer+putbackSize, bufferSize-putbackSize);
     if (num <= 0) // ERROR or EOF
         return EOF;
 
     // reset buffer pointers
-    setg( buffer + (4 - n_putback),   // beginning of putback area
-          buffer + 4,                 // read position
-          buffer + 4 + num);          // end of buffer
+    setg( buffer + (putbackSize - n_putback),   // beginning of putback area
+          buffer + putbackSize,                 // read position
+          buffer + putbackSize + num);          // end of buffer
 
     // return next character
     return * reinterpret_cast<unsigned char *>( gptr());
@@ -170,6 +387,11 @@ gzstreambase::gzstreambase( const char* name, int mode) {
     open( name, mode);
 }
 
+gzstreambase::gzstreambase( const char* name, int mode, int buffer_size, unsigned threads) : buf( buffer_size, threads) {
+    init( &buf);
+    open( name, mode);
+}
+
 gzstreambase::~gzstreambase() {
     buf.close();
 }
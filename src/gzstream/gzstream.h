@@ -60,6 +60,7 @@
 // standard C++ with new header file names and std:: namespace
 #include <iostream>
 #include <fstream>
+#include <vector>
 #include <zlib.h>
 
 #ifdef GZSTREAM_NAMESPACE
@@ -70,29 +71,57 @@ namespace GZSTREAM_NAMESPACE {
 // Internal classes to implement gzstream. See below for user classes.
 // ----------------------------------------------------------------------------
 
+// One BGZF block: its compressed member and, after inflation, its data
+// (preceded by room for the putback characters).
+struct bgzf_block {
+    std::vector<char> in;
+    std::vector<char> out;
+    int              in_size;
+    int              out_size;
+    bool             ok;
+};
+
 class gzstreambuf : public std::streambuf {
-private:
-    static const int bufferSize = 47+256;    // size of data buff
-    // totals 512 bytes under g++ for igzstream at the end.
+public:
+    static const int defaultBufferSize = 1 << 17;   // 128KB
+    static const int putbackSize = 4;
 
+    // BGZF blocks hold at most 64KB of data
+    static const int bgzfMaxBlockSize = 1 << 16;
+    // blocks inflated per batch and thread
+    static const int bgzfBlocksPerThread = 4;
+private:
     gzFile           file;               // file handle for compressed file
-    char             buffer[bufferSize]; // data buffer
+    char*            buffer;             // data buffer
+    int              bufferSize;         // size of data buffer
     char             opened;             // open/close state of stream
     int              mode;               // I/O mode
 
+    // BGZF (block gzip) input: independent deflate members of at most 64KB
+    // of data, which are inflated a batch at a time on several threads and
+    // handed to the reader in file order.
+    int              bgzf_fd;            // file descriptor; -1 unless reading BGZF
+    unsigned         nThreads;           // 0 uses every processor
+    std::vector<bgzf_block> blocks;
+    unsigned         block_count, block_next;
+    bool             bgzf_error;
+
     int flush_buffer();
+
+    bool isBgzf( const char *name );
+    int readBgzfBlock( bgzf_block &b );
+    bool fillBgzfBlocks();
+    int bgzfUnderflow();
 public:
-    gzstreambuf() : opened(0) {
-        setp( buffer, buffer + (bufferSize-1));
-        setg( buffer + 4,     // beginning of putback area
-              buffer + 4,     // read position
-              buffer + 4);    // end position      
-        // ASSERT: both input & output capabilities will not be used together
-    }
+    gzstreambuf( int buffer_size = defaultBufferSize, unsigned threads = 0 );
     int is_open() { return opened; }
+    // whether the open file is block gzip, inflated on several threads
+    bool is_bgzf() { return bgzf_fd >= 0; }
+    // a BGZF member was malformed or failed its CRC
+    bool bgzf_failed() { return bgzf_error; }
     gzstreambuf* open( const char* name, int open_mode);
     gzstreambuf* close();
-    ~gzstreambuf() { close(); }
+    ~gzstreambuf();
     
     virtual int     overflow( int c = EOF);
     virtual int     underflow();
@@ -105,6 +134,7 @@ protected:
 public:
     gzstreambase() { init(&buf); }
     gzstreambase( const char* name, int open_mode);
+    gzstreambase( const char* name, int open_mode, int buffer_size, unsigned threads );
     ~gzstreambase();
     void open( const char* name, int open_mode);
     void close();
@@ -122,6 +152,10 @@ public:
     igzstream() : std::istream( &buf) {} 
     igzstream( const char* name, int open_mode = std::ios::in)
         : gzstreambase( name, open_mode), std::istream( &buf) {}  
+    // buffer_size bytes of plain gzip are inflated per read; BGZF files are
+    // inflated on threads threads (0 uses every processor)
+    igzstream( const char* name, int open_mode, int buffer_size, unsigned threads = 0 )
+        : gzstreambase( name, open_mode, buffer_size, threads), std::istream( &buf) {}
     gzstreambuf* rdbuf() { return gzstreambase::rdbuf(); }
     void open( const char* name, int open_mode = std::ios::in) {
         gzstreambase::open( name, open_mode);
@@ -0,0 +1,256 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/association_func.h"
+
+#include <cstdio>
+#include <cmath>
+
+namespace libgwaspp {
+namespace algorithms {
+
+void AssociationStatistics( const association_block & blk, uint n, association_result * res ) {
+    // every loop below is branch free over the block so that it vectorizes
+    for( uint i = 0; i < n; ++i ) {
+        double a = 2.0 * blk.case_aa[i] + blk.case_ab[i], b = 2.0 * blk.case_bb[i] + blk.case_ab[i];
+        double c = 2.0 * blk.ctrl_aa[i] + blk.ctrl_ab[i], d = 2.0 * blk.ctrl_bb[i] + blk.ctrl_ab[i];
+
+        double N = a + b + c + d;
+        double den = ( a + b ) * ( c + d ) * ( a + c ) * ( b + d );
+        double diff = a * d - b * c;
+
+        res[i].allelic_chi2 = ( den > 0.0 ) ? N * diff * diff / den : 0.0;
+        res[i].odds_ratio = ( b * c > 0.0 ) ? ( a * d ) / ( b * c ) : NAN;
+    }
+
+    for( uint i = 0; i < n; ++i ) {
+        double R = blk.case_aa[i] + blk.case_ab[i] + blk.case_bb[i];
+        double S = blk.ctrl_aa[i] + blk.ctrl_ab[i] + blk.ctrl_bb[i];
+        double N = R + S;
+
+        double n1 = blk.case_ab[i] + blk.ctrl_ab[i], n2 = blk.case_bb[i] + blk.ctrl_bb[i];
+
+        // additive scores 0, 1, 2
+        double t_case = blk.case_ab[i] + 2.0 * blk.case_bb[i];
+        double t_all = n1 + 2.0 * n2;
+        double t_sq = n1 + 4.0 * n2;
+
+        double den = R * S * ( N * t_sq - t_all * t_all );
+        double num = N * t_case - R * t_all;
+
+        res[i].trend_chi2 = ( den > 0.0 ) ? N * num * num / den : 0.0;
+    }
+
+    for( uint i = 0; i < n; ++i ) {
+        double r[3] = { blk.case_aa[i], blk.case_ab[i], blk.case_bb[i] };
+        double s[3] = { blk.ctrl_aa[i], blk.ctrl_ab[i], blk.ctrl_bb[i] };
+
+        double R = r[0] + r[1] + r[2], S = s[0] + s[1] + s[2], N = R + S;
+        double fr = ( N > 0.0 ) ? R / N : 0.0, fs = ( N > 0.0 ) ? S / N : 0.0;
+
+        double chi2 = 0.0;
+        uint cols = 0;
+        for( uint g = 0; g < 3; ++g ) {
+            double t = r[g] + s[g];
+            double er = fr * t, es = fs * t;
+
+            chi2 += ( er > 0.0 ) ? ( r[g] - er ) * ( r[g] - er ) / er : 0.0;
+            chi2 += ( es > 0.0 ) ? ( s[g] - es ) * ( s[g] - es ) / es : 0.0;
+            cols += ( t > 0.0 );
+        }
+
+        res[i].genotypic_chi2 = chi2;
+        res[i].genotypic_df = ( R > 0.0 && S > 0.0 && cols > 1 ) ? cols - 1 : 0;
+    }
+
+    for( uint i = 0; i < n; ++i ) {
+        res[i].allelic_p = pchisq( res[i].allelic_chi2, 1.0, 0, 0 );
+        res[i].trend_p = pchisq( res[i].trend_chi2, 1.0, 0, 0 );
+        res[i].genotypic_p = ( res[i].genotypic_df > 0 ) ? pchisq( res[i].genotypic_chi2, ( double ) res[i].genotypic_df, 0, 0 ) : 1.0;
+    }
+}
+
+/**
+ * Gathers the distributions of rows [begin, end) (at most one block) and
+ * computes their statistics.
+ */
+static void AssociationRows( GenoTable & gt, CaseControlSet & ccs, uint begin, uint end, association_block & blk, association_result * res ) {
+    CaseControlGenotypeDistribution ccgd;
+    const frequency_table &cs = *ccgd.getCaseDistribution();
+    const frequency_table &ct = *ccgd.getControlDistribution();
+
+    for( uint r = begin, i = 0; r < end; ++r, ++i ) {
+        gt.getCaseControlGenotypeDistribution( r, ccs, ccgd );
+
+        blk.case_aa[i] = cs.aa; blk.case_ab[i] = cs.ab; blk.case_bb[i] = cs.bb;
+        blk.ctrl_aa[i] = ct.aa; blk.ctrl_ab[i] = ct.ab; blk.ctrl_bb[i] = ct.bb;
+    }
+
+    AssociationStatistics( blk, end - begin, res );
+}
+
+struct association_work {
+    GenoTable *gt;
+    CaseControlSet *ccs;
+    uint row_begin, row_end;
+    association_result *res;
+
+    // association_scan only
+    const vector< string > *ids;
+    vector< string > *text;
+};
+
+uint ConcurrentReadThreads( GenoTable & gt, CaseControlSet & ccs, uint row, uint nThreads ) {
+    if( !gt.supportsConcurrentReads() ) return 1;
+
+    CaseControlGenotypeDistribution ccgd;
+    gt.getCaseControlGenotypeDistribution( row, ccs, ccgd );
+    return nThreads;
+}
+
+static void AssociationWorker( void *arg, ulong begin, ulong end ) {
+    association_work &w = *reinterpret_cast< association_work * >( arg );
+    association_block *blk = new association_block;
+
+    for( ulong b = begin; b < end; ++b ) {
+        uint r0 = w.row_begin + b * ASSOCIATION_BLOCK_SIZE;
+        uint r1 = min( r0 + ASSOCIATION_BLOCK_SIZE, w.row_end );
+
+        AssociationRows( *w.gt, *w.ccs, r0, r1, *blk, w.res + ( r0 - w.row_begin ) );
+    }
+
+    delete blk;
+}
+
+void computeAssociation( GenoTable & gt, CaseControlSet & ccs, uint row_begin, uint row_end, association_result * res, uint nThreads ) {
+    if( row_end <= row_begin ) return;
+
+    association_work w;
+    w.gt = &gt;
+    w.ccs = &ccs;
+    w.row_begin = row_begin;
+    w.row_end = row_end;
+    w.res = res;
+    w.ids = NULL;
+    w.text = NULL;
+
+    nThreads = ConcurrentReadThreads( gt, ccs, row_begin, nThreads );
+
+    ulong nBlocks = ( row_end - row_begin + ASSOCIATION_BLOCK_SIZE - 1 ) / ASSOCIATION_BLOCK_SIZE;
+    ParallelFor( 0, nBlocks, AssociationWorker, &w, nThreads );
+}
+
+static void AssociationFormatWorker( void *arg, ulong begin, ulong end ) {
+    association_work &w = *reinterpret_cast< association_work * >( arg );
+    association_block *blk = new association_block;
+
+    char line[ 256 ], odds[ 32 ];
+    for( ulong b = begin; b < end; ++b ) {
+        uint r0 = w.row_begin + b * ASSOCIATION_BLOCK_SIZE;
+        uint r1 = min( r0 + ASSOCIATION_BLOCK_SIZE, w.row_end );
+
+        association_result *res = w.res + ( r0 - w.row_begin );
+        AssociationRows( *w.gt, *w.ccs, r0, r1, *blk, res );
+
+        string &out = ( *w.text )[ b ];
+        out.clear();
+        for( uint r = r0; r < r1; ++r, ++res ) {
+            char a1, a2;
+            w.gt->getRowAlleles( r, a1, a2 );
+
+            // undefined when the cases carry no B allele or the controls no A allele
+            if( std::isnan( res->odds_ratio ) ) {
+                snprintf( odds, sizeof( odds ), "NA" );
+            } else {
+                snprintf( odds, sizeof( odds ), "%g", res->odds_ratio );
+            }
+
+            snprintf( line, sizeof( line ), "\t%c\t%g\t%g\t%s\t%g\t%g\t%g\t%u\t%g\n", a1, res->allelic_chi2, res->allelic_p, odds,
+                    res->trend_chi2, res->trend_p, res->genotypic_chi2, res->genotypic_df, res->genotypic_p );
+            out += ( *w.ids )[ r - w.row_begin ];
+            out += line;
+        }
+    }
+
+    delete blk;
+}
+
+void association_scan( GeneticData *gd, ostream *out, uint nThreads ) {
+    uint marker_count = gd->getGenotypedMarkersCount();
+    GenoTable &gt = *gd->getGenotypeTable();
+
+    assert( gd->getCaseControlSet() != NULL );
+    CaseControlSet &ccs = *gd->getCaseControlSet();
+
+    if( marker_count == 0 ) return;
+
+    nThreads = ConcurrentReadThreads( gt, ccs, 0, nThreads );
+
+    cout << "Single marker association of " << marker_count << " markers (" << ccs.getCaseCount() << " cases, "
+         << ccs.getControlCount() << " controls) on " << ( ( nThreads == 0 ) ? GetProcessorCount() : nThreads ) << " threads" << endl;
+
+    const uint rows_per_write = ASSOCIATION_BLOCK_SIZE * ASSOCIATION_BLOCKS_PER_WRITE;
+
+    vector< association_result > res( rows_per_write );
+    vector< string > ids, text( ASSOCIATION_BLOCKS_PER_WRITE );
+
+    association_work w;
+    w.gt = &gt;
+    w.ccs = &ccs;
+    w.res = &res[0];
+    w.ids = &ids;
+    w.text = &text;
+
+    *out << "MARKER\tA1\tCHISQ_ALLELIC\tP_ALLELIC\tOR\tCHISQ_TREND\tP_TREND\tCHISQ_GENO\tDF_GENO\tP_GENO\n";
+
+    for( uint r = 0; r < marker_count; r += rows_per_write ) {
+        w.row_begin = r;
+        w.row_end = min( r + rows_per_write, marker_count );
+
+        ids.clear();
+        for( uint i = w.row_begin; i < w.row_end; ++i ) {
+            ids.push_back( gd->getGenotypedMarkerID( i ) );
+        }
+
+        ulong nBlocks = ( w.row_end - w.row_begin + ASSOCIATION_BLOCK_SIZE - 1 ) / ASSOCIATION_BLOCK_SIZE;
+        ParallelFor( 0, nBlocks, AssociationFormatWorker, &w, nThreads );
+
+        // blocks are written in marker order
+        for( ulong b = 0; b < nBlocks; ++b ) {
+            out->write( text[ b ].data(), text[ b ].size() );
+        }
+    }
+    out->flush();
+}
+
+void association_scan( GeneticData *gd, ostream *out ) {
+    association_scan( gd, out, 0 );
+}
+
+}
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef ASSOCIATION_FUNC_H
+#define ASSOCIATION_FUNC_H
+
+#include <fstream>
+#include <vector>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/common_genotype_func.h"
+#include "genetics/analyzable/case_control_set.h"
+#include "util/thread/parallel_for.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+// markers whose distributions are gathered before the statistics are computed
+const uint ASSOCIATION_BLOCK_SIZE = 1024;
+// blocks held in memory between two writes of association_scan
+const uint ASSOCIATION_BLOCKS_PER_WRITE = 64;
+
+struct association_result {
+    double allelic_chi2, allelic_p, odds_ratio;     // 1 df allelic test; odds ratio of allele A, NaN when undefined
+    double trend_chi2, trend_p;                     // 1 df Cochran-Armitage trend test
+    double genotypic_chi2, genotypic_p;             // 2 df genotype test
+    uint genotypic_df;
+};
+
+/**
+ * Case/control counts of ASSOCIATION_BLOCK_SIZE markers laid out as one
+ * array per genotype so the statistics are computed a column at a time.
+ */
+struct association_block {
+    double case_aa[ ASSOCIATION_BLOCK_SIZE ], case_ab[ ASSOCIATION_BLOCK_SIZE ], case_bb[ ASSOCIATION_BLOCK_SIZE ];
+    double ctrl_aa[ ASSOCIATION_BLOCK_SIZE ], ctrl_ab[ ASSOCIATION_BLOCK_SIZE ], ctrl_bb[ ASSOCIATION_BLOCK_SIZE ];
+};
+
+void AssociationStatistics( const association_block & blk, uint n, association_result * res );
+
+/**
+ * Number of threads a scan of gt may use: 1 unless the table supports
+ * concurrent reads, in which case row is read once with ccs first so that
+ * the table can set up any per-set state before the threads share it.
+ */
+uint ConcurrentReadThreads( GenoTable & gt, CaseControlSet & ccs, uint row, uint nThreads );
+
+// tests rows [row_begin, row_end) of gt; res holds row_end - row_begin results
+void computeAssociation( GenoTable & gt, CaseControlSet & ccs, uint row_begin, uint row_end, association_result * res, uint nThreads = 0 );
+
+void association_scan( GeneticData *gd, ostream *out, uint nThreads );
+void association_scan( GeneticData *gd, ostream *out );
+
+}
+}
+
+#endif // ASSOCIATION_FUNC_H
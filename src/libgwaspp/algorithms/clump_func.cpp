@@ -0,0 +1,388 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/clump_func.h"
+
+#include <map>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <sstream>
+
+namespace libgwaspp {
+namespace algorithms {
+
+typedef pair< uint, uint > located_hit;     // position, hit
+
+struct ClumpHitComparer {
+    bool operator()( const clump_hit & lhs, const clump_hit & rhs ) const { return lhs.p < rhs.p || ( lhs.p == rhs.p && lhs.row < rhs.row ); }
+};
+
+struct ClumpPairHitComparer {
+    bool operator()( const clump_pair_hit & lhs, const clump_pair_hit & rhs ) const {
+        return lhs.p < rhs.p || ( lhs.p == rhs.p && ( lhs.row1 < rhs.row1 || ( lhs.row1 == rhs.row1 && lhs.row2 < rhs.row2 ) ) );
+    }
+};
+
+void getMarkerLocations( GeneticData *gd, vector< ChromosomeID > & chromosome, vector< uint > & positions ) {
+    uint marker_count = gd->getGenotypedMarkersCount();
+
+    chromosome.resize( marker_count );
+    positions.resize( marker_count );
+    for( uint r = 0; r < marker_count; ++r ) {
+        const Marker *m = gd->getGenotypedMarker( r );
+        chromosome[r] = m->getChromosomeID();
+        positions[r] = m->getStart();
+    }
+}
+
+// hits of lst whose position lies within max_bp of pos
+static void NearbyHits( const vector< located_hit > & lst, uint pos, uint max_bp, vector< located_hit >::const_iterator & it, vector< located_hit >::const_iterator & end ) {
+    it = lst.begin();
+    end = lst.end();
+    if( max_bp == 0 ) return;
+
+    uint lo = (( pos > max_bp ) ? pos - max_bp : 0 );
+    uint hi = (( pos < UINT_MAX - max_bp ) ? pos + max_bp : UINT_MAX );
+    it = lower_bound( lst.begin(), lst.end(), located_hit( lo, 0 ) );
+    end = upper_bound( it, lst.end(), located_hit( hi, UINT_MAX ) );
+}
+
+void clumpResults( LDCache & ld, const vector< ChromosomeID > & chromosome, const vector< uint > & positions, vector< clump_hit > & hits, const clump_params & params, vector< clump > & clumps ) {
+    clumps.clear();
+
+    uint n = 0;
+    for( uint h = 0; h < hits.size(); ++h ) {
+        if( hits[h].p <= params.member_p ) {
+            hits[ n++ ] = hits[h];
+        }
+    }
+    hits.resize( n );
+    sort( hits.begin(), hits.end(), ClumpHitComparer() );
+
+    map< ChromosomeID, vector< located_hit > > by_chrom;
+    for( uint h = 0; h < n; ++h ) {
+        by_chrom[ chromosome[ hits[h].row ] ].push_back( located_hit( positions[ hits[h].row ], h ) );
+    }
+    for( map< ChromosomeID, vector< located_hit > >::iterator c = by_chrom.begin(); c != by_chrom.end(); ++c ) {
+        sort( c->second.begin(), c->second.end() );
+    }
+
+    vector< byte > clumped( n, 0 );
+    vector< located_hit >::const_iterator it, end;
+
+    for( uint h = 0; h < n && hits[h].p <= params.index_p; ++h ) {
+        if( clumped[h] ) continue;
+        clumped[h] = 1;
+
+        clumps.push_back( clump() );
+        clump &c = clumps.back();
+        c.index = h;
+
+        uint row = hits[h].row;
+        NearbyHits( by_chrom[ chromosome[ row ] ], positions[ row ], params.max_bp, it, end );
+        for( ; it != end; ++it ) {
+            uint m = it->second;
+            if( clumped[m] ) continue;
+
+            if( hits[m].row == row || ld.getR2( row, hits[m].row ) >= params.r2 ) {
+                clumped[m] = 1;
+                c.members.push_back( m );
+            }
+        }
+
+        sort( c.members.begin(), c.members.end() );
+    }
+}
+
+// same row, or on the same chromosome within max_bp and r2
+static bool IsLinked( LDCache & ld, const vector< ChromosomeID > & chromosome, const vector< uint > & positions, const clump_params & params, uint r1, uint r2 ) {
+    if( r1 == r2 ) return true;
+    if( chromosome[ r1 ] != chromosome[ r2 ] ) return false;
+
+    uint d = (( positions[ r1 ] > positions[ r2 ] ) ? positions[ r1 ] - positions[ r2 ] : positions[ r2 ] - positions[ r1 ] );
+    if( params.max_bp && d > params.max_bp ) return false;
+
+    return ld.getR2( r1, r2 ) >= params.r2;
+}
+
+void clumpPairResults( LDCache & ld, const vector< ChromosomeID > & chromosome, const vector< uint > & positions, vector< clump_pair_hit > & hits, const clump_params & params, vector< clump > & clumps ) {
+    clumps.clear();
+
+    // row1 is the earlier of the two rows by chromosome and position
+    uint n = 0;
+    for( uint h = 0; h < hits.size(); ++h ) {
+        if( hits[h].p > params.member_p ) continue;
+
+        clump_pair_hit hit = hits[h];
+        if( chromosome[ hit.row2 ] < chromosome[ hit.row1 ] ||
+            ( chromosome[ hit.row2 ] == chromosome[ hit.row1 ] && ( positions[ hit.row2 ] < positions[ hit.row1 ] ||
+                ( positions[ hit.row2 ] == positions[ hit.row1 ] && hit.row2 < hit.row1 ) ) ) ) {
+            swap( hit.row1, hit.row2 );
+        }
+        hits[ n++ ] = hit;
+    }
+    hits.resize( n );
+    sort( hits.begin(), hits.end(), ClumpPairHitComparer() );
+
+    // hits of every chromosome pair in order of the position of row1
+    typedef pair< ChromosomeID, ChromosomeID > chromosome_pair;
+    map< chromosome_pair, vector< located_hit > > by_chrom;
+    for( uint h = 0; h < n; ++h ) {
+        chromosome_pair key( chromosome[ hits[h].row1 ], chromosome[ hits[h].row2 ] );
+        by_chrom[ key ].push_back( located_hit( positions[ hits[h].row1 ], h ) );
+    }
+    for( map< chromosome_pair, vector< located_hit > >::iterator c = by_chrom.begin(); c != by_chrom.end(); ++c ) {
+        sort( c->second.begin(), c->second.end() );
+    }
+
+    vector< byte > clumped( n, 0 );
+    vector< located_hit >::const_iterator it, end;
+
+    for( uint h = 0; h < n && hits[h].p <= params.index_p; ++h ) {
+        if( clumped[h] ) continue;
+        clumped[h] = 1;
+
+        clumps.push_back( clump() );
+        clump &c = clumps.back();
+        c.index = h;
+
+        uint a = hits[h].row1, b = hits[h].row2;
+
+        // a member linked crosswise (row1 to b, row2 to a) also has row1 within max_bp of a
+        NearbyHits( by_chrom[ chromosome_pair( chromosome[ a ], chromosome[ b ] ) ], positions[ a ], params.max_bp, it, end );
+        for( ; it != end; ++it ) {
+            uint m = it->second;
+            if( clumped[m] ) continue;
+
+            uint x = hits[m].row1, y = hits[m].row2;
+            if(( IsLinked( ld, chromosome, positions, params, x, a ) && IsLinked( ld, chromosome, positions, params, y, b ) ) ||
+               ( IsLinked( ld, chromosome, positions, params, x, b ) && IsLinked( ld, chromosome, positions, params, y, a ) ) ) {
+                clumped[m] = 1;
+                c.members.push_back( m );
+            }
+        }
+
+        sort( c.members.begin(), c.members.end() );
+    }
+}
+
+void clump_scan( GeneticData *gd, ostream *out ) {
+    uint marker_count = gd->getGenotypedMarkersCount();
+    GenoTable &gt = *gd->getGenotypeTable();
+
+    assert( gd->getCaseControlSet() != NULL );
+    CaseControlSet &ccs = *gd->getCaseControlSet();
+
+    if( marker_count == 0 ) return;
+
+    clump_params params;
+
+    cout << "Clumping allelic association results of " << marker_count << " markers (index p <= " << params.index_p << ", member p <= "
+         << params.member_p << ", r2 >= " << params.r2 << ", within " << params.max_bp << " bp)" << endl;
+
+    // only the hits which may be clumped are kept
+    const uint rows_per_pass = ASSOCIATION_BLOCK_SIZE * ASSOCIATION_BLOCKS_PER_WRITE;
+    vector< association_result > res( rows_per_pass );
+    vector< clump_hit > hits;
+
+    for( uint r = 0; r < marker_count; r += rows_per_pass ) {
+        uint r1 = min( r + rows_per_pass, marker_count );
+        computeAssociation( gt, ccs, r, r1, &res[0] );
+
+        for( uint i = r; i < r1; ++i ) {
+            if( res[ i - r ].allelic_p <= params.member_p ) {
+                clump_hit hit;
+                hit.row = i;
+                hit.p = res[ i - r ].allelic_p;
+                hits.push_back( hit );
+            }
+        }
+    }
+
+    writeClumps( gd, hits, params, out );
+}
+
+/**
+ * Rows of the MARKER column and p values of the P_ALLELIC column (or of a P
+ * column) of an association table; rows of markers which are not genotyped
+ * and p values which are not numbers (NA) are skipped.
+ */
+static bool ReadAssociationHits( GeneticData *gd, istream *results, double member_p, vector< clump_hit > & hits ) {
+    string line, tok;
+    if( !getline( *results, line ) ) {
+        cout << "ERROR: No header in the association results" << endl;
+        return false;
+    }
+
+    int marker_col = -1, p_col = -1, col = 0;
+    istringstream header( line );
+    while( header >> tok ) {
+        if( tok == "MARKER" || tok == "SNP" ) {
+            marker_col = col;
+        } else if( tok == "P_ALLELIC" || ( tok == "P" && p_col < 0 ) ) {
+            p_col = col;
+        }
+        ++col;
+    }
+
+    if( marker_col < 0 || p_col < 0 ) {
+        cout << "ERROR: The association results need a MARKER and a P_ALLELIC column" << endl;
+        return false;
+    }
+
+    uint skipped = 0;
+    string id;
+    double p;
+    char *end;
+    while( getline( *results, line ) ) {
+        if( line.empty() ) continue;
+
+        id.clear();
+        p = 1.0;
+        istringstream fields( line );
+        for( col = 0; fields >> tok; ++col ) {
+            if( col == marker_col ) {
+                id = tok;
+            } else if( col == p_col ) {
+                p = strtod( tok.c_str(), &end );
+                if( end == tok.c_str() ) p = 1.0;
+            }
+        }
+
+        int row = gd->getGenotypedMarkerIndex( id );
+        if( row < 0 ) {
+            ++skipped;
+            continue;
+        }
+
+        if( p <= member_p ) {
+            clump_hit hit;
+            hit.row = row;
+            hit.p = p;
+            hits.push_back( hit );
+        }
+    }
+
+    if( skipped ) {
+        cout << "Skipped the results of " << skipped << " markers which are not genotyped" << endl;
+    }
+    return true;
+}
+
+void clump_scan( GeneticData *gd, istream *results, ostream *out ) {
+    clump_params params;
+
+    cout << "Clumping association results (index p <= " << params.index_p << ", member p <= "
+         << params.member_p << ", r2 >= " << params.r2 << ", within " << params.max_bp << " bp)" << endl;
+
+    vector< clump_hit > hits;
+    if( ReadAssociationHits( gd, results, params.member_p, hits ) ) {
+        writeClumps( gd, hits, params, out );
+    }
+}
+
+void writeClumps( GeneticData *gd, vector< clump_hit > & hits, const clump_params & params, ostream *out ) {
+    vector< ChromosomeID > chromosome;
+    vector< uint > positions;
+    getMarkerLocations( gd, chromosome, positions );
+
+    LDCache ld( *gd->getGenotypeTable() );
+    vector< clump > clumps;
+    clumpResults( ld, chromosome, positions, hits, params, clumps );
+
+    *out << "INDEX\tCHR\tBP\tP\tTOTAL\tMEMBERS\n";
+    for( uint i = 0; i < clumps.size(); ++i ) {
+        const clump &c = clumps[i];
+        const clump_hit &idx = hits[ c.index ];
+
+        *out << gd->getGenotypedMarkerID( idx.row ) << "\t" << gd->findChromosome( chromosome[ idx.row ] )->getName() << "\t" << positions[ idx.row ] << "\t" << idx.p << "\t" << c.members.size() << "\t";
+        if( c.members.empty() ) {
+            *out << "NONE";
+        }
+        for( uint j = 0; j < c.members.size(); ++j ) {
+            *out << (( j > 0 ) ? "," : "" ) << gd->getGenotypedMarkerID( hits[ c.members[j] ].row );
+        }
+        *out << "\n";
+    }
+    out->flush();
+
+    cout << hits.size() << " hits in " << clumps.size() << " clumps; " << ld.getComputedCount() << " of " << ld.getLookupCount() << " r2 lookups computed" << endl;
+}
+
+void boost_clump_scan( GeneticData *gd, ostream *pairs, ostream *out ) {
+    vector< SNPInteractionPair > interactions;
+    vector< double > zval;
+    computeBoost( gd, pairs, interactions, zval );
+
+    clump_params params;
+
+    // the BOOST statistic is tested as a chi-square with 4 df
+    vector< clump_pair_hit > hits;
+    hits.reserve( interactions.size() );
+    for( uint i = 0; i < interactions.size(); ++i ) {
+        clump_pair_hit hit;
+        hit.row1 = interactions[i].first.first;
+        hit.row2 = interactions[i].first.second;
+        hit.p = pchisq( interactions[i].second, 4.0, 0, 0 );
+        hits.push_back( hit );
+    }
+
+    cout << "Clumping " << hits.size() << " interactions (index p <= " << params.index_p << ", member p <= "
+         << params.member_p << ", r2 >= " << params.r2 << ", within " << params.max_bp << " bp)" << endl;
+
+    vector< ChromosomeID > chromosome;
+    vector< uint > positions;
+    getMarkerLocations( gd, chromosome, positions );
+
+    LDCache ld( *gd->getGenotypeTable() );
+    vector< clump > clumps;
+    clumpPairResults( ld, chromosome, positions, hits, params, clumps );
+
+    *out << "INDEX1\tINDEX2\tP\tTOTAL\tMEMBERS\n";
+    for( uint i = 0; i < clumps.size(); ++i ) {
+        const clump &c = clumps[i];
+        const clump_pair_hit &idx = hits[ c.index ];
+
+        *out << gd->getGenotypedMarkerID( idx.row1 ) << "\t" << gd->getGenotypedMarkerID( idx.row2 ) << "\t" << idx.p << "\t" << c.members.size() << "\t";
+        if( c.members.empty() ) {
+            *out << "NONE";
+        }
+        for( uint j = 0; j < c.members.size(); ++j ) {
+            const clump_pair_hit &m = hits[ c.members[j] ];
+            *out << (( j > 0 ) ? "," : "" ) << gd->getGenotypedMarkerID( m.row1 ) << ":" << gd->getGenotypedMarkerID( m.row2 );
+        }
+        *out << "\n";
+    }
+    out->flush();
+
+    cout << hits.size() << " interactions in " << clumps.size() << " clumps; " << ld.getComputedCount() << " of " << ld.getLookupCount() << " r2 lookups computed" << endl;
+}
+
+}
+}
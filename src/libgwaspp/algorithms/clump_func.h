@@ -0,0 +1,117 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef CLUMP_FUNC_H
+#define CLUMP_FUNC_H
+
+#include <fstream>
+#include <vector>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/marker/marker.h"
+#include "algorithms/ld_func.h"
+#include "algorithms/association_func.h"
+#include "algorithms/epistasis_func.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+// default clumping: index p value, member p value, r2 and distance limits
+const double CLUMP_INDEX_P = 1e-4;
+const double CLUMP_MEMBER_P = 1e-2;
+const double CLUMP_R2 = 0.5;
+const uint CLUMP_MAX_BP = 250000;
+
+struct clump_params {
+    double index_p;     // hits at or below start a clump
+    double member_p;    // hits above are dropped before clumping
+    double r2;          // members have at least this r2 with the index
+    uint max_bp;        // members lie within this distance of the index; 0 for no limit
+
+    clump_params() : index_p( CLUMP_INDEX_P ), member_p( CLUMP_MEMBER_P ), r2( CLUMP_R2 ), max_bp( CLUMP_MAX_BP ) {}
+};
+
+struct clump_hit {
+    uint row;
+    double p;
+};
+
+// an interaction hit; both rows of a member lie near the rows of the index
+struct clump_pair_hit {
+    uint row1, row2;
+    double p;
+};
+
+// members index the hit vector after clumping has sorted it
+struct clump {
+    uint index;
+    vector< uint > members;
+};
+
+// chromosome and start of the marker of every genotyped row
+void getMarkerLocations( GeneticData *gd, vector< ChromosomeID > & chromosome, vector< uint > & positions );
+
+/**
+ * Drops the hits above member_p and sorts the rest by p value. Then, in order
+ * of significance, every hit at or below index_p which is not yet part of a
+ * clump takes the remaining hits of its chromosome within max_bp and r2. The
+ * hits of a chromosome are kept in position order, so only those within
+ * max_bp of an index are visited; r2 comes from ld.
+ */
+void clumpResults( LDCache & ld, const vector< ChromosomeID > & chromosome, const vector< uint > & positions, vector< clump_hit > & hits, const clump_params & params, vector< clump > & clumps );
+
+/**
+ * As above for marker pairs: a pair joins the clump of an index pair when
+ * each of its rows is the same as, or in LD with, a different row of the
+ * index pair.
+ */
+void clumpPairResults( LDCache & ld, const vector< ChromosomeID > & chromosome, const vector< uint > & positions, vector< clump_pair_hit > & hits, const clump_params & params, vector< clump > & clumps );
+
+// clumps the hits and writes one line per clump
+void writeClumps( GeneticData *gd, vector< clump_hit > & hits, const clump_params & params, ostream *out );
+
+// clumps of the allelic association test
+void clump_scan( GeneticData *gd, ostream *out );
+
+// clumps of association results read from a table with a header line, as
+// written by association_scan; the MARKER column names the marker and the
+// P_ALLELIC column, or else a P column, holds its p value
+void clump_scan( GeneticData *gd, istream *results, ostream *out );
+
+// clumps of the interactions reported by computeBoost; the interactions are
+// written to pairs and the clumps to out
+void boost_clump_scan( GeneticData *gd, ostream *pairs, ostream *out );
+
+}
+}
+
+#endif // CLUMP_FUNC_H
@@ -0,0 +1,269 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/cmh_func.h"
+
+#include <cmath>
+
+namespace libgwaspp {
+namespace algorithms {
+
+/**
+ * q = u' V^-1 u for a positive semi-definite V by an LDL' factorization.
+ * Pivots which vanish are dropped, which yields the generalized inverse
+ * for the rank deficient tables produced by monomorphic columns.
+ */
+static double QuadraticForm( vector< double > & V, vector< double > & u, uint m, uint & rank ) {
+    const double EPS = 1e-10;
+    vector< double > d( m, 0.0 );
+
+    double scale = 0.0;
+    for( uint i = 0; i < m; ++i ) {
+        if( V[ i * m + i ] > scale ) scale = V[ i * m + i ];
+    }
+
+    // V is overwritten with L below the diagonal
+    for( uint j = 0; j < m; ++j ) {
+        double dj = V[ j * m + j ];
+        for( uint k = 0; k < j; ++k ) {
+            dj -= V[ j * m + k ] * V[ j * m + k ] * d[ k ];
+        }
+
+        if( dj <= EPS * scale ) {
+            d[ j ] = 0.0;
+            for( uint i = j + 1; i < m; ++i ) V[ i * m + j ] = 0.0;
+            continue;
+        }
+
+        d[ j ] = dj;
+        for( uint i = j + 1; i < m; ++i ) {
+            double l = V[ i * m + j ];
+            for( uint k = 0; k < j; ++k ) {
+                l -= V[ i * m + k ] * V[ j * m + k ] * d[ k ];
+            }
+            V[ i * m + j ] = l / dj;
+        }
+    }
+
+    double q = 0.0;
+    rank = 0;
+    for( uint j = 0; j < m; ++j ) {
+        double z = u[ j ];
+        for( uint k = 0; k < j; ++k ) {
+            z -= V[ j * m + k ] * u[ k ];
+        }
+        u[ j ] = z;
+
+        if( d[ j ] > 0.0 ) {
+            q += z * z / d[ j ];
+            ++rank;
+        }
+    }
+    return q;
+}
+
+void GeneralizedCMH( const double * cases, const double * ctrls, uint nStrata, uint nColumns, cmh_result & res ) {
+    res.chi2 = 0.0;
+    res.pval = 1.0;
+    res.df = 0;
+
+    // columns observed in at least one stratum
+    vector< uint > cols;
+    for( uint j = 0; j < nColumns; ++j ) {
+        double tot = 0.0;
+        for( uint k = 0; k < nStrata; ++k ) {
+            tot += cases[ k * nColumns + j ] + ctrls[ k * nColumns + j ];
+        }
+        if( tot > 0.0 ) cols.push_back( j );
+    }
+
+    if( cols.size() < 2 ) return;
+
+    // the last observed column is implied by the row totals
+    const uint m = cols.size() - 1;
+    vector< double > u( m, 0.0 ), V( m * m, 0.0 ), c( m );
+
+    for( uint k = 0; k < nStrata; ++k ) {
+        const double *x = cases + k * nColumns;
+        const double *y = ctrls + k * nColumns;
+
+        double n1 = 0.0, n2 = 0.0;
+        for( uint j = 0; j < cols.size(); ++j ) {
+            n1 += x[ cols[ j ] ];
+            n2 += y[ cols[ j ] ];
+        }
+
+        double n = n1 + n2;
+        if( n < 2.0 || n1 == 0.0 || n2 == 0.0 ) continue;
+
+        for( uint i = 0; i < m; ++i ) {
+            c[ i ] = x[ cols[ i ] ] + y[ cols[ i ] ];
+            u[ i ] += x[ cols[ i ] ] - n1 * c[ i ] / n;
+        }
+
+        double f = n1 * n2 / ( n * n * ( n - 1.0 ) );
+        for( uint i = 0; i < m; ++i ) {
+            for( uint j = 0; j < m; ++j ) {
+                V[ i * m + j ] += f * (( i == j ) ? n * c[ i ] : 0.0 ) - f * c[ i ] * c[ j ];
+            }
+        }
+    }
+
+    res.chi2 = QuadraticForm( V, u, m, res.df );
+    if( res.df > 0 ) {
+        res.pval = pchisq( res.chi2, ( double ) res.df, 0, 0 );
+    }
+}
+
+void CMHAllelic( CaseControlGenotypeDistribution * ccgd, uint nStrata, cmh_result & res ) {
+    vector< double > cases( 2 * nStrata ), ctrls( 2 * nStrata );
+
+    double num = 0.0, den = 0.0;
+    for( uint k = 0; k < nStrata; ++k ) {
+        const frequency_table &cs = *ccgd[ k ].getCaseDistribution();
+        const frequency_table &ct = *ccgd[ k ].getControlDistribution();
+
+        double a = 2.0 * cs.aa + cs.ab, b = 2.0 * cs.bb + cs.ab;
+        double c = 2.0 * ct.aa + ct.ab, d = 2.0 * ct.bb + ct.ab;
+
+        cases[ 2 * k ] = a; cases[ 2 * k + 1 ] = b;
+        ctrls[ 2 * k ] = c; ctrls[ 2 * k + 1 ] = d;
+
+        double n = a + b + c + d;
+        if( n > 0.0 ) {
+            num += a * d / n;
+            den += b * c / n;
+        }
+    }
+
+    GeneralizedCMH( &cases[0], &ctrls[0], nStrata, 2, res );
+    res.odds_ratio = ( den > 0.0 ) ? num / den : NAN;
+}
+
+void CMHGenotypic( CaseControlGenotypeDistribution * ccgd, uint nStrata, cmh_result & res ) {
+    vector< double > cases( 3 * nStrata ), ctrls( 3 * nStrata );
+
+    for( uint k = 0; k < nStrata; ++k ) {
+        const frequency_table &cs = *ccgd[ k ].getCaseDistribution();
+        const frequency_table &ct = *ccgd[ k ].getControlDistribution();
+
+        // missing calls do not enter the test
+        for( uint g = 0; g < 3; ++g ) {
+            cases[ 3 * k + g ] = cs.freq[ g ];
+            ctrls[ 3 * k + g ] = ct.freq[ g ];
+        }
+    }
+
+    GeneralizedCMH( &cases[0], &ctrls[0], nStrata, 3, res );
+    res.odds_ratio = 0.0;
+}
+
+void CMHJointGenotypic( CaseControlContingencyTable * ccct, uint nStrata, cmh_result & res ) {
+    vector< double > cases( 9 * nStrata ), ctrls( 9 * nStrata );
+
+    for( uint k = 0; k < nStrata; ++k ) {
+        const CONTIN_TABLE_T &cs = *ccct[ k ].getCaseContingencyTable();
+        const CONTIN_TABLE_T &ct = *ccct[ k ].getControlContingencyTable();
+
+        for( uint a = 0; a < 3; ++a ) {
+            for( uint b = 0; b < 3; ++b ) {
+                cases[ 9 * k + 3 * a + b ] = cs.contin[ a * CONTIN_COLUMN_COUNT + b ];
+                ctrls[ 9 * k + 3 * a + b ] = ct.contin[ a * CONTIN_COLUMN_COUNT + b ];
+            }
+        }
+    }
+
+    GeneralizedCMH( &cases[0], &ctrls[0], nStrata, 9, res );
+    res.odds_ratio = 0.0;
+}
+
+void computeCMHAllelic( GenoTable & gt, uint rIdx, StratifiedSampleSet & strata, cmh_result & res ) {
+    vector< CaseControlGenotypeDistribution > ccgd( strata.getStratumCount() );
+
+    gt.getCaseControlGenotypeDistributions( rIdx, strata.getStrata(), &ccgd[0] );
+    CMHAllelic( &ccgd[0], ccgd.size(), res );
+}
+
+void computeCMHGenotypic( GenoTable & gt, uint rIdx, StratifiedSampleSet & strata, cmh_result & res ) {
+    vector< CaseControlGenotypeDistribution > ccgd( strata.getStratumCount() );
+
+    gt.getCaseControlGenotypeDistributions( rIdx, strata.getStrata(), &ccgd[0] );
+    CMHGenotypic( &ccgd[0], ccgd.size(), res );
+}
+
+void computeCMHPair( GenoTable & gt, uint rIdx1, uint rIdx2, StratifiedSampleSet & strata, cmh_result & res ) {
+    vector< CaseControlContingencyTable > ccct( strata.getStratumCount() );
+
+    gt.getCaseControlContingencyTables( rIdx1, rIdx2, strata.getStrata(), &ccct[0] );
+    CMHJointGenotypic( &ccct[0], ccct.size(), res );
+}
+
+void cmh_scan( GeneticData *gd, StratifiedSampleSet & strata, ostream *out ) {
+    int marker_count = gd->getGenotypedMarkersCount();
+    GenoTable &gt = *gd->getGenotypeTable();
+
+    uint nStrata = strata.getStratumCount();
+    vector< CaseControlGenotypeDistribution > ccgd( nStrata );
+    cmh_result allelic, genotypic;
+
+    cout << "CMH scan of " << marker_count << " markers over " << nStrata << " strata ("
+         << strata.getCaseCount() << " cases, " << strata.getControlCount() << " controls)" << endl;
+
+    *out << "MARKER\tA1\tCHISQ_CMH\tP_CMH\tOR_MH\tCHISQ_CMH_GENO\tDF_CMH_GENO\tP_CMH_GENO" << endl;
+
+    char a1, a2;
+    for( int i = 0; i < marker_count; ++i ) {
+        // one pass over the row yields the counts of every stratum
+        gt.getCaseControlGenotypeDistributions( i, strata.getStrata(), &ccgd[0] );
+
+        CMHAllelic( &ccgd[0], nStrata, allelic );
+        CMHGenotypic( &ccgd[0], nStrata, genotypic );
+
+        // the common odds ratio is that of the A allele
+        gt.getRowAlleles( i, a1, a2 );
+
+        *out << gd->getGenotypedMarkerID( i ) << "\t" << a1 << "\t" << allelic.chi2 << "\t" << allelic.pval << "\t";
+        if( std::isnan( allelic.odds_ratio ) ) {
+            *out << "NA";
+        } else {
+            *out << allelic.odds_ratio;
+        }
+        *out << "\t" << genotypic.chi2 << "\t" << genotypic.df << "\t" << genotypic.pval << endl;
+    }
+}
+
+void cmh_scan( GeneticData *gd, ostream *out ) {
+    if( gd->getStratifiedSampleSet() == NULL ) {
+        cout << "CMH scan needs the strata of the samples" << endl;
+        return;
+    }
+    cmh_scan( gd, *gd->getStratifiedSampleSet(), out );
+}
+
+}
+}
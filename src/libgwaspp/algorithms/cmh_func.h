@@ -0,0 +1,81 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef CMH_FUNC_H
+#define CMH_FUNC_H
+
+#include <fstream>
+#include <vector>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/common_genotype_func.h"
+#include "genetics/analyzable/stratified_sample_set.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+struct cmh_result {
+    double chi2, pval;
+    uint df;
+    double odds_ratio;  // Mantel-Haenszel common odds ratio of the A allele; allelic test only, NaN when undefined
+};
+
+/**
+ * Generalized Cochran-Mantel-Haenszel statistic for K strata of 2 x J
+ * tables. cases[ k * J + j ] and ctrls[ k * J + j ] are the counts of
+ * column j in stratum k. Strata with fewer than two samples and columns
+ * which are empty in every stratum do not contribute; df is the rank of
+ * the pooled covariance.
+ */
+void GeneralizedCMH( const double * cases, const double * ctrls, uint nStrata, uint nColumns, cmh_result & res );
+
+// tests from per-stratum counts as returned by the batched table kernels
+void CMHAllelic( CaseControlGenotypeDistribution * ccgd, uint nStrata, cmh_result & res );
+void CMHGenotypic( CaseControlGenotypeDistribution * ccgd, uint nStrata, cmh_result & res );
+void CMHJointGenotypic( CaseControlContingencyTable * ccct, uint nStrata, cmh_result & res );
+
+// 1 df allelic test and 2 df genotypic test of a single marker
+void computeCMHAllelic( GenoTable & gt, uint rIdx, StratifiedSampleSet & strata, cmh_result & res );
+void computeCMHGenotypic( GenoTable & gt, uint rIdx, StratifiedSampleSet & strata, cmh_result & res );
+
+// 8 df test of the 3 x 3 joint genotypes of a marker pair
+void computeCMHPair( GenoTable & gt, uint rIdx1, uint rIdx2, StratifiedSampleSet & strata, cmh_result & res );
+
+void cmh_scan( GeneticData *gd, StratifiedSampleSet & strata, ostream *out );
+
+// scan over the strata of gd
+void cmh_scan( GeneticData *gd, ostream *out );
+
+}
+}
+
+#endif // CMH_FUNC_H
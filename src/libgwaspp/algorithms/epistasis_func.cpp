@@ -346,7 +346,113 @@ void EpistasisPerformance( void * input, void * output ) {
     cout << endl;
 }
 
+// groups markers by their canonical row; only rows with aliases are listed
+static uint BuildRowAliases( GenoTable & gt, uint nMarkerCount, vector< uint > & canonical, map< uint, vector< uint > > & aliases ) {
+    uint nAliasCount = 0;
+
+    canonical.resize( nMarkerCount );
+    for( uint r = 0; r < nMarkerCount; ++r ) {
+        canonical[ r ] = gt.getCanonicalRow( r );
+        if( canonical[ r ] != r ) {
+            vector< uint > & group = aliases[ canonical[ r ] ];
+            if( group.empty() ) {
+                group.push_back( canonical[ r ] );
+            }
+            group.push_back( r );
+            ++nAliasCount;
+        }
+    }
+
+    for( map< uint, vector< uint > >::iterator it = aliases.begin(); it != aliases.end(); it++ ) {
+        sort( it->second.begin(), it->second.end() );
+    }
+    return nAliasCount;
+}
+
+// a pair is scanned once per pair of canonical rows; a duplicated row is
+// paired with itself through its two lowest aliases
+static inline bool IsScannedPair( const vector< uint > & canonical, const map< uint, vector< uint > > & aliases, uint r1, uint r2 ) {
+    uint c1 = canonical[ r1 ], c2 = canonical[ r2 ];
+    if( c1 != c2 ) {
+        return r1 == c1 && r2 == c2;
+    }
+
+    const vector< uint > & group = aliases.find( c1 )->second;
+    return r1 == group[ 0 ] && r2 == group[ 1 ];
+}
+
+static inline uint AliasCount( const map< uint, vector< uint > > & aliases, uint c ) {
+    map< uint, vector< uint > >::const_iterator it = aliases.find( c );
+    return (( it == aliases.end() ) ? 1 : it->second.size() );
+}
+
+// number of marker pairs ExpandAliasedPairs reports for the scanned pairs
+static ulong CountAliasedPairs( const vector< uint > & canonical, const map< uint, vector< uint > > & aliases, const vector< SNPInteractionPair > & pairs ) {
+    if( aliases.empty() ) return pairs.size();
+
+    ulong nPairs = 0;
+    for( uint i = 0; i < pairs.size(); ++i ) {
+        uint c1 = canonical[ pairs[i].first.first ], c2 = canonical[ pairs[i].first.second ];
+        ulong na = AliasCount( aliases, c1 );
+
+        nPairs += (( c1 == c2 ) ? ( na * ( na - 1 ) ) / 2 : na * AliasCount( aliases, c2 ) );
+    }
+    return nPairs;
+}
+
+// copies the results of each scanned pair to every pair of aliased markers
+static void ExpandAliasedPairs( const vector< uint > & canonical, const map< uint, vector< uint > > & aliases, vector< SNPInteractionPair > & pairs, vector< double > & zval ) {
+    if( aliases.empty() ) return;
+
+    typedef pair< SNPInteractionPair, double > ScoredPair;
+    vector< ScoredPair > expanded;
+    vector< uint > single_a( 1 ), single_b( 1 );
+    map< uint, vector< uint > >::const_iterator itA, itB;
+
+    for( uint i = 0; i < pairs.size(); ++i ) {
+        uint c1 = canonical[ pairs[i].first.first ], c2 = canonical[ pairs[i].first.second ];
+
+        itA = aliases.find( c1 );
+        itB = aliases.find( c2 );
+
+        single_a[0] = c1;
+        single_b[0] = c2;
+        const vector< uint > & ga = (( itA == aliases.end() ) ? single_a : itA->second );
+        const vector< uint > & gb = (( itB == aliases.end() ) ? single_b : itB->second );
+
+        if( c1 == c2 ) {
+            for( uint j = 0; j < ga.size(); ++j ) {
+                for( uint k = j + 1; k < ga.size(); ++k ) {
+                    expanded.push_back( ScoredPair( SNPInteractionPair( SNPPair( ga[j], ga[k] ), pairs[i].second ), zval[i] ) );
+                }
+            }
+        } else {
+            for( uint j = 0; j < ga.size(); ++j ) {
+                for( uint k = 0; k < gb.size(); ++k ) {
+                    SNPPair p = (( ga[j] < gb[k] ) ? SNPPair( ga[j], gb[k] ) : SNPPair( gb[k], ga[j] ));
+                    expanded.push_back( ScoredPair( SNPInteractionPair( p, pairs[i].second ), zval[i] ) );
+                }
+            }
+        }
+    }
+
+    sort( expanded.begin(), expanded.end() );
+
+    pairs.clear();
+    zval.clear();
+    for( vector< ScoredPair >::const_iterator it = expanded.begin(); it != expanded.end(); it++ ) {
+        pairs.push_back( it->first );
+        zval.push_back( it->second );
+    }
+}
+
 void computeBoost( GeneticData * gd, ostream * out ) {
+    vector< SNPInteractionPair > interactions;
+    vector< double > zval;
+    computeBoost( gd, out, interactions, zval );
+}
+
+void computeBoost( GeneticData * gd, ostream * out, vector< SNPInteractionPair > & passingThreshold, vector< double > & zval ) {
     CaseControlSet &ccs = *gd->getCaseControlSet();
 
     int nCases = ccs.getCaseCount();
@@ -362,7 +468,7 @@ void computeBoost( GeneticData * gd, ostream * out ) {
     // pre-compute marginal distributions for all markers
     marginal_information * pMargins = NULL;
     marginal_information * pMar1, * pMar2;
-    computeMargins( gt, nIndivids, pMargins, nMarkerCount );
+    computeMargins( *gd->getSummaryCache(), ccs, pMargins, nMarkerCount );
 
     vector< uint > filteredIndices;
 
@@ -371,7 +477,11 @@ void computeBoost( GeneticData * gd, ostream * out ) {
         filteredIndices.push_back(i);
     }
 
-    vector< uint >::const_iterator itIdx1, itIdx2;
+    // markers which share a canonical row have identical tables
+    vector< uint > canonical;
+    map< uint, vector< uint > > aliases;
+    uint nAliasCount = BuildRowAliases( gt, nMarkerCount, canonical, aliases );
+
     uint idx, idx2;
     CaseControlContingencyTable ccct;
 
@@ -383,24 +493,26 @@ void computeBoost( GeneticData * gd, ostream * out ) {
     double tao, interMeasure;
     double tmp1, tmp2, tmp3;
 
-    typedef pair< uint, uint > SNPPair;
-    typedef pair< SNPPair, double> SNPInteractionPair;
-    vector< SNPInteractionPair > passingThreshold;
+    passingThreshold.clear();
+    zval.clear();
 
     double maxInteraction = -99999999, minInteraction = 999999999, thresholdRecord = 30.0;
 
     *out << "Pre-screening " << filteredIndices.size() << " SNP interactions" << endl;
+    if( nAliasCount > 0 ) {
+        *out << "Skipping " << nAliasCount << " markers identical to an earlier marker" << endl;
+    }
 
     INIT_LAPSE_TIME;
     RECORD_START;
     // pre-screening
-    for( itIdx1 = filteredIndices.begin(); itIdx1 != filteredIndices.end(); itIdx1++ ) {
-        idx = *itIdx1;
-    //for( idx = 0; idx < (uint) nMarkerCount; ++idx ) {
+    // pairs are visited in row block tiles to maximize block reuse
+    PairTileScheduler pairs( gt, 0, nMarkerCount );
+    while( pairs.next( idx, idx2 ) ) {
+        if( !IsScannedPair( canonical, aliases, idx, idx2 ) ) continue;
+
         pMar1 = &pMargins[idx];
-        for( itIdx2 = itIdx1 + 1; itIdx2 != filteredIndices.end(); itIdx2++ ) {
-        //for( int idx2 = idx + 1; idx2 < nMarkerCount; ++idx2 ) {
-            idx2 = *itIdx2;
+        {
             pMar2 = &pMargins[ idx2 ];
             //RECORD_START;
             gt.getCaseControlContingencyTable( idx, idx2, *pMar1, *pMar2, ccct );
@@ -430,7 +542,7 @@ void computeBoost( GeneticData * gd, ostream * out ) {
             pPca_co = &pMar1->dPca[GENOTYPE_COUNT];
             denom = &pMar2->margins.freq[0];
 
-            //*out << idx << "x" << *itIdx2<<endl;
+            //*out << idx << "x" << idx2<<endl;
 
             for( int i = 0, j = 3; i < 9; ++i ) {
                 if( ! j-- ) {
@@ -468,7 +580,7 @@ void computeBoost( GeneticData * gd, ostream * out ) {
             }
 
             interMeasure = (interMeasure + log(tao)) * nIndivids * 2.0;
-            //*out << idx << "x" << *itIdx2 << "\t" << tao << "\t" << interMeasure << endl;
+            //*out << idx << "x" << idx2 << "\t" << tao << "\t" << interMeasure << endl;
 
 
             if( interMeasure > maxInteraction ) {
@@ -488,12 +600,18 @@ void computeBoost( GeneticData * gd, ostream * out ) {
     PRINT_LAPSE( *out, "");
     *out << endl;
 
-    *out << "Located " << passingThreshold.size() << " potential interactions" << endl;
+    // report interactions in marker order regardless of the tile order
+    sort( passingThreshold.begin(), passingThreshold.end() );
+
+    // count the marker pairs which will be reported, not the scanned pairs
+    *out << "Located " << CountAliasedPairs( canonical, aliases, passingThreshold ) << " potential interactions" << endl;
 
     *out << "Performing deeper analysis of SNPs" << endl;
-    vector< double > zval;
     computeGTest(gt, pMargins, nIndivids, passingThreshold, zval );
 
+    // report every marker pair represented by a scanned pair
+    ExpandAliasedPairs( canonical, aliases, passingThreshold, zval );
+
     vector< SNPInteractionPair >::const_iterator itPair;
     vector< double >::const_iterator itZ;
     idx = 0;
@@ -712,12 +830,71 @@ void computeMargins( GenoTable & gt, int nIndivids, marginal_information *& pMar
 
     pMargins = new marginal_information[ nMarkerCount ];
 
-    CaseControlGenotypeDistribution ccgd;
+    frequency_table *cases = new frequency_table[ nMarkerCount ];
+    frequency_table *ctrls = new frequency_table[ nMarkerCount ];
+
+    // assumes individuals have already been separated into cases and controls
+    computeCaseControlGenotypeDistributions( gt, 0, nMarkerCount, cases, ctrls );
 
     for ( int i = 0; i < nMarkerCount; ++i ) {
-        // assumes individuals have already been separated into cases and controls
-        gt.getCaseControlGenotypeDistribution( i, ccgd, pMargins[i] );
+        computeMarginalInformation( cases[i], ctrls[i], nIndivids, pMargins[i] );
     }
+
+    delete [] cases;
+    delete [] ctrls;
+}
+
+void computeMargins( MarkerSummaryCache & summary, CaseControlSet & ccs, marginal_information *& pMargins, int & nMarkerCount ) {
+    nMarkerCount = summary.getGenotypeTable()->row_size();
+
+    if( pMargins != NULL ) {
+        delete [] pMargins;
+    }
+
+    pMargins = new marginal_information[ nMarkerCount ];
+
+    frequency_table *cases = new frequency_table[ nMarkerCount ];
+    frequency_table *ctrls = new frequency_table[ nMarkerCount ];
+
+    summary.getCaseControlCounts( 0, nMarkerCount, ccs, cases, ctrls );
+
+    for ( int i = 0; i < nMarkerCount; ++i ) {
+        computeMarginalInformation( cases[i], ctrls[i], ccs.getCaseCount() + ccs.getControlCount(), pMargins[i] );
+    }
+
+    delete [] cases;
+    delete [] ctrls;
+}
+
+/**
+ * Margins of every marker for a batch of phenotypes. Each row is read once for
+ * all of the sets; the margins of marker i for set k are stored at
+ * pMargins[ i * sets.size() + k ].
+ */
+void computeMargins( GenoTable & gt, const vector< CaseControlSet * > & sets, marginal_information *& pMargins, int & nMarkerCount ) {
+    nMarkerCount = gt.row_size();
+
+    if( pMargins != NULL ) {
+        delete [] pMargins;
+    }
+
+    const uint nSets = sets.size();
+    pMargins = new marginal_information[ nMarkerCount * nSets ];
+
+    if( nSets == 0 ) return;
+
+    CaseControlGenotypeDistribution *ccgd = new CaseControlGenotypeDistribution[ nSets ];
+
+    for( int i = 0; i < nMarkerCount; ++i ) {
+        gt.getCaseControlGenotypeDistributions( i, sets, ccgd );
+
+        marginal_information *m = pMargins + i * nSets;
+        for( uint k = 0; k < nSets; ++k ) {
+            computeMarginalInformation( *ccgd[k].getCaseDistribution(), *ccgd[k].getControlDistribution(), sets[k]->getCaseCount() + sets[k]->getControlCount(), m[k] );
+        }
+    }
+
+    delete [] ccgd;
 }
 
 double pairwise_epi_test ( const CONTIN_TABLE_T &cs, const CONTIN_TABLE_T &ct) {
@@ -32,6 +32,8 @@
 #include <cstring>
 #include <cmath>
 #include <fstream>
+#include <algorithm>
+#include <map>
 
 #include "genetics/genetic_data.h"
 #include "genetics/genotype/common_genotype.h"
@@ -41,6 +43,8 @@
 #include "util/time/timing.h"
 
 #include "algorithms/computation_engine.h"
+#include "algorithms/pair_tile_scheduler.h"
+#include "algorithms/maf_func.h"
 
 #include "boost/format.hpp"
 
@@ -77,7 +81,12 @@ void EpistasisPerformance( void * input, void * output );
 void computeGTest( GenoTable & gt, marginal_information * pMargins, uint nIndivids, vector< SNPInteractionPair > & passingThreshold, vector< double > & zval );
 
 void computeMargins( GenoTable & gt, int nIndivids, marginal_information *& pMargins, int & nMarkerCount );
+void computeMargins( GenoTable & gt, const vector< CaseControlSet * > & sets, marginal_information *& pMargins, int & nMarkerCount );
+// as computeMargins( gt, nIndivids, ... ), from the case/control counts kept by the cache
+void computeMargins( MarkerSummaryCache & summary, CaseControlSet & ccs, marginal_information *& pMargins, int & nMarkerCount );
 void computeBoost( GeneticData *gd, ostream *out );
+// as above; also returns the reported pairs with their BOOST statistic and z value
+void computeBoost( GeneticData *gd, ostream *out, vector< SNPInteractionPair > & interactions, vector< double > & zval );
 
 double pairwise_epi_test( const CONTIN_TABLE_T &_case, const CONTIN_TABLE_T &_ctrl);
 double pairwise_epi_test( const CONTIN_TABLE_T &_case, const CONTIN_TABLE_T &_ctrl, const marginal_information & m1, const marginal_information & m2 );
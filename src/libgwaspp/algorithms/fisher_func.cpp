@@ -0,0 +1,171 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/fisher_func.h"
+#include "algorithms/association_func.h"
+
+#include <cmath>
+#include <cfloat>
+
+namespace libgwaspp {
+namespace algorithms {
+
+// tables as likely as the observed one up to this relative error are in the tail
+const double FisherExactTest::RELATIVE_ERROR = 1e-7;
+
+FisherExactTest::FisherExactTest( uint max_total ) : log_factorial( max_total + 1 ) {
+    log_factorial[ 0 ] = 0.0;
+    for( uint i = 1; i <= max_total; ++i ) {
+        log_factorial[ i ] = log_factorial[ i - 1 ] + log( ( double ) i );
+    }
+}
+
+double FisherExactTest::logProbability( uint a, uint b, uint c, uint d ) const {
+    const double *lf = &log_factorial[0];
+    return lf[ a + b ] + lf[ c + d ] + lf[ a + c ] + lf[ b + d ] - lf[ a + b + c + d ] - lf[ a ] - lf[ b ] - lf[ c ] - lf[ d ];
+}
+
+double FisherExactTest::twoSided( uint a, uint b, uint c, uint d ) const {
+    const uint n = a + b + c + d;
+    assert( n <= getMaximumTotal() );
+
+    const uint r1 = a + b, r2 = c + d, c1 = a + c;
+    const uint lo = ( c1 > r2 ) ? c1 - r2 : 0;
+    const uint hi = ( r1 < c1 ) ? r1 : c1;
+
+    if( lo == hi ) return 1.0;
+
+    uint mode = ( uint )(( double )( r1 + 1 ) * ( c1 + 1 ) / ( n + 2 ));
+    if( mode < lo ) mode = lo;
+    if( mode > hi ) mode = hi;
+
+    // terms are kept relative to the most likely table, so they never overflow
+    const double lp_mode = logProbability( mode, r1 - mode, c1 - mode, r2 - c1 + mode );
+    const double q_obs = exp( logProbability( a, b, c, d ) - lp_mode ) * ( 1.0 + RELATIVE_ERROR );
+
+    double sum = ( q_obs >= 1.0 ) ? 1.0 : 0.0;
+    double q = 1.0;
+
+    // the terms fall monotonically on either side of the mode
+    for( uint x = mode; x > lo; --x ) {
+        q *= ( double ) x * ( ( double ) r2 - c1 + x ) / ( ( double )( r1 - x + 1 ) * ( c1 - x + 1 ) );
+        if( q <= q_obs ) {
+            sum += q;
+            if( q < sum * DBL_EPSILON ) break;
+        }
+    }
+
+    q = 1.0;
+    for( uint x = mode; x < hi; ++x ) {
+        q *= ( double )( r1 - x ) * ( c1 - x ) / ( ( double )( x + 1 ) * ( ( double ) r2 - c1 + x + 1 ) );
+        if( q <= q_obs ) {
+            sum += q;
+            if( q < sum * DBL_EPSILON ) break;
+        }
+    }
+
+    double p = sum * exp( lp_mode );
+    return ( p < 1.0 ) ? p : 1.0;
+}
+
+struct fisher_work {
+    GenoTable *gt;
+    CaseControlSet *ccs;
+    const FisherExactTest *fet;
+    uint row_begin;
+    fisher_result *res;
+};
+
+static void FisherWorker( void *arg, ulong begin, ulong end ) {
+    fisher_work &w = *reinterpret_cast< fisher_work * >( arg );
+
+    CaseControlGenotypeDistribution ccgd;
+    const frequency_table &cs = *ccgd.getCaseDistribution();
+    const frequency_table &ct = *ccgd.getControlDistribution();
+
+    for( ulong r = begin; r < end; ++r ) {
+        w.gt->getCaseControlGenotypeDistribution( r, *w.ccs, ccgd );
+
+        fisher_result &res = w.res[ r - w.row_begin ];
+        res.case_A = 2 * cs.aa + cs.ab;
+        res.case_a = 2 * cs.bb + cs.ab;
+        res.ctrl_A = 2 * ct.aa + ct.ab;
+        res.ctrl_a = 2 * ct.bb + ct.ab;
+
+        res.pval = w.fet->twoSided( res.case_A, res.case_a, res.ctrl_A, res.ctrl_a );
+    }
+}
+
+void computeFisherExact( GenoTable & gt, CaseControlSet & ccs, const FisherExactTest & fet, uint row_begin, uint row_end, fisher_result * res, uint nThreads ) {
+    if( row_end <= row_begin ) return;
+
+    // every allele table of ccs must fit the log-factorial table
+    assert( 2 * ccs.getTotalCount() <= fet.getMaximumTotal() );
+
+    fisher_work w;
+    w.gt = &gt;
+    w.ccs = &ccs;
+    w.fet = &fet;
+    w.row_begin = row_begin;
+    w.res = res;
+
+    nThreads = ConcurrentReadThreads( gt, ccs, row_begin, nThreads );
+    ParallelFor( row_begin, row_end, FisherWorker, &w, nThreads, ASSOCIATION_BLOCK_SIZE );
+}
+
+void fisher_scan( GeneticData *gd, ostream *out ) {
+    uint marker_count = gd->getGenotypedMarkersCount();
+    GenoTable &gt = *gd->getGenotypeTable();
+
+    assert( gd->getCaseControlSet() != NULL );
+    CaseControlSet &ccs = *gd->getCaseControlSet();
+
+    // built once for the whole analysis
+    FisherExactTest fet( 2 * gd->getGenotypedIndividualsCount() );
+
+    cout << "Fisher exact allelic test of " << marker_count << " markers (" << ccs.getCaseCount() << " cases, "
+         << ccs.getControlCount() << " controls)" << endl;
+
+    const uint rows_per_write = ASSOCIATION_BLOCK_SIZE * ASSOCIATION_BLOCKS_PER_WRITE;
+    vector< fisher_result > res( rows_per_write );
+
+    *out << "MARKER\tCASE_A\tCASE_a\tCTRL_A\tCTRL_a\tP\n";
+    for( uint r = 0; r < marker_count; r += rows_per_write ) {
+        uint r_end = min( r + rows_per_write, marker_count );
+        computeFisherExact( gt, ccs, fet, r, r_end, &res[0] );
+
+        for( uint i = r; i < r_end; ++i ) {
+            const fisher_result &f = res[ i - r ];
+            *out << gd->getGenotypedMarkerID( i ) << "\t" << f.case_A << "\t" << f.case_a << "\t" << f.ctrl_A << "\t" << f.ctrl_a << "\t" << f.pval << "\n";
+        }
+    }
+    out->flush();
+}
+
+}
+}
@@ -0,0 +1,83 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef FISHER_FUNC_H
+#define FISHER_FUNC_H
+
+#include <fstream>
+#include <vector>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/analyzable/case_control_set.h"
+#include "util/thread/parallel_for.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+/**
+ * Class: FisherExactTest
+ * Description: Two-sided Fisher exact test of 2x2 tables whose total does not
+ * exceed the size given at construction. The log-factorials are tabulated
+ * once; a p-value then costs two table lookups for the mode and a
+ * multiplicative walk over the hypergeometric terms, which stops once the
+ * remaining terms no longer change the sum.
+ */
+class FisherExactTest {
+public:
+    FisherExactTest( uint max_total );
+
+    uint getMaximumTotal() const { return log_factorial.size() - 1; }
+
+    // log probability of the table | a b | c d | given its margins
+    double logProbability( uint a, uint b, uint c, uint d ) const;
+    double twoSided( uint a, uint b, uint c, uint d ) const;
+
+    static const double RELATIVE_ERROR;
+
+protected:
+    vector< double > log_factorial;
+};
+
+struct fisher_result {
+    uint case_A, case_a, ctrl_A, ctrl_a;   // allele counts
+    double pval;
+};
+
+// allelic tests of rows [row_begin, row_end); res holds row_end - row_begin results
+void computeFisherExact( GenoTable & gt, CaseControlSet & ccs, const FisherExactTest & fet, uint row_begin, uint row_end, fisher_result * res, uint nThreads = 0 );
+
+void fisher_scan( GeneticData *gd, ostream *out );
+
+}
+}
+
+#endif // FISHER_FUNC_H
@@ -0,0 +1,211 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/hwe_func.h"
+#include "algorithms/association_func.h"
+
+#include <algorithm>
+
+namespace libgwaspp {
+namespace algorithms {
+
+// heterozygote counts as likely as the observed one up to this relative error are in the tail
+const double HardyWeinbergTest::RELATIVE_ERROR = 1e-7;
+
+const HardyWeinbergTest::het_distribution & HardyWeinbergTest::distribution( uint nGenotypes, uint nRare ) {
+    pair< uint, uint > key( nGenotypes, nRare );
+
+    map< pair< uint, uint >, het_distribution >::iterator it = cache.find( key );
+    if( it != cache.end() ) return it->second;
+
+    if( cache.size() >= max_cached ) {
+        cache.clear();
+    }
+
+    het_distribution &hd = cache[ key ];
+
+    const uint parity = nRare & 1;
+    const uint nHets = nRare / 2 + 1;
+    hd.by_het.assign( nHets, 0.0 );
+
+    // start at the expected heterozygote count, where the terms are largest
+    uint mid = ( uint )(( double ) nRare * ( 2.0 * nGenotypes - nRare ) / ( 2.0 * nGenotypes ));
+    if(( mid & 1 ) != parity ) ++mid;
+    if( mid > nRare ) mid = nRare;
+
+    double *p = &hd.by_het[0];
+    uint m = mid / 2;
+    p[ m ] = 1.0;
+    double sum = 1.0;
+
+    uint hom_r = ( nRare - mid ) / 2;
+    uint hom_c = nGenotypes - mid - hom_r;
+    for( uint h = mid; h > 1; h -= 2 ) {
+        uint i = ( h - parity ) / 2;
+        p[ i - 1 ] = p[ i ] * h * ( h - 1.0 ) / ( 4.0 * ( hom_r + 1.0 ) * ( hom_c + 1.0 ) );
+        sum += p[ i - 1 ];
+        ++hom_r;
+        ++hom_c;
+    }
+
+    hom_r = ( nRare - mid ) / 2;
+    hom_c = nGenotypes - mid - hom_r;
+    for( uint h = mid; h + 2 <= nRare; h += 2 ) {
+        uint i = ( h - parity ) / 2;
+        p[ i + 1 ] = p[ i ] * 4.0 * hom_r * hom_c / (( h + 2.0 ) * ( h + 1.0 ));
+        sum += p[ i + 1 ];
+        --hom_r;
+        --hom_c;
+    }
+
+    for( uint i = 0; i < nHets; ++i ) {
+        p[ i ] /= sum;
+    }
+
+    hd.sorted = hd.by_het;
+    sort( hd.sorted.begin(), hd.sorted.end() );
+
+    hd.prefix.resize( nHets + 1 );
+    hd.prefix[ 0 ] = 0.0;
+    for( uint i = 0; i < nHets; ++i ) {
+        hd.prefix[ i + 1 ] = hd.prefix[ i ] + hd.sorted[ i ];
+    }
+
+    return hd;
+}
+
+double HardyWeinbergTest::exact( uint hom1, uint het, uint hom2 ) {
+    uint nGenotypes = hom1 + het + hom2;
+    if( nGenotypes == 0 ) return 1.0;
+
+    uint hom_rare = ( hom1 < hom2 ) ? hom1 : hom2;
+    uint nRare = 2 * hom_rare + het;
+
+    const het_distribution &hd = distribution( nGenotypes, nRare );
+
+    double p_obs = hd.by_het[ het / 2 ] * ( 1.0 + RELATIVE_ERROR );
+    uint n = upper_bound( hd.sorted.begin(), hd.sorted.end(), p_obs ) - hd.sorted.begin();
+
+    double p = hd.prefix[ n ];
+    return ( p < 1.0 ) ? p : 1.0;
+}
+
+struct hwe_work {
+    GenoTable *gt;
+    CaseControlSet *ccs;
+    uint row_begin;
+    hwe_result *res;
+};
+
+static void HWEWorker( void *arg, ulong begin, ulong end ) {
+    hwe_work &w = *reinterpret_cast< hwe_work * >( arg );
+
+    HardyWeinbergTest hwe;
+    GenotypeDistribution dist;
+    CaseControlGenotypeDistribution ccgd;
+
+    for( ulong r = begin; r < end; ++r ) {
+        hwe_result &res = w.res[ r - w.row_begin ];
+
+        w.gt->getGenotypeDistribution( r, dist );
+        CopyFrequencyTable( res.all, *dist.getDistribution() );
+        res.p_all = hwe.exact( res.all );
+
+        if( w.ccs != NULL ) {
+            w.gt->getCaseControlGenotypeDistribution( r, *w.ccs, ccgd );
+            res.p_case = hwe.exact( *ccgd.getCaseDistribution() );
+            res.p_ctrl = hwe.exact( *ccgd.getControlDistribution() );
+        } else {
+            res.p_case = 1.0;
+            res.p_ctrl = 1.0;
+        }
+    }
+}
+
+void computeHWE( GenoTable & gt, uint row_begin, uint row_end, hwe_result * res, uint nThreads ) {
+    if( row_end <= row_begin ) return;
+
+    hwe_work w;
+    w.gt = &gt;
+    w.ccs = NULL;
+    w.row_begin = row_begin;
+    w.res = res;
+
+    if( !gt.supportsConcurrentReads() ) nThreads = 1;
+
+    ParallelFor( row_begin, row_end, HWEWorker, &w, nThreads, ASSOCIATION_BLOCK_SIZE );
+}
+
+void computeHWE( GenoTable & gt, CaseControlSet & ccs, uint row_begin, uint row_end, hwe_result * res, uint nThreads ) {
+    if( row_end <= row_begin ) return;
+
+    hwe_work w;
+    w.gt = &gt;
+    w.ccs = &ccs;
+    w.row_begin = row_begin;
+    w.res = res;
+
+    nThreads = ConcurrentReadThreads( gt, ccs, row_begin, nThreads );
+    ParallelFor( row_begin, row_end, HWEWorker, &w, nThreads, ASSOCIATION_BLOCK_SIZE );
+}
+
+void hwe_scan( GeneticData *gd, ostream *out ) {
+    uint marker_count = gd->getGenotypedMarkersCount();
+    GenoTable &gt = *gd->getGenotypeTable();
+    CaseControlSet *ccs = gd->getCaseControlSet();
+
+    cout << "Hardy-Weinberg exact test of " << marker_count << " markers" << endl;
+
+    const uint rows_per_write = ASSOCIATION_BLOCK_SIZE * ASSOCIATION_BLOCKS_PER_WRITE;
+    vector< hwe_result > res( rows_per_write );
+
+    *out << "MARKER\tAA\tAB\tBB\tP";
+    if( ccs != NULL ) *out << "\tP_CASE\tP_CTRL";
+    *out << "\n";
+
+    for( uint r = 0; r < marker_count; r += rows_per_write ) {
+        uint r_end = min( r + rows_per_write, marker_count );
+
+        if( ccs != NULL ) {
+            computeHWE( gt, *ccs, r, r_end, &res[0] );
+        } else {
+            computeHWE( gt, r, r_end, &res[0] );
+        }
+
+        for( uint i = r; i < r_end; ++i ) {
+            const hwe_result &h = res[ i - r ];
+            *out << gd->getGenotypedMarkerID( i ) << "\t" << h.all.aa << "\t" << h.all.ab << "\t" << h.all.bb << "\t" << h.p_all;
+            if( ccs != NULL ) *out << "\t" << h.p_case << "\t" << h.p_ctrl;
+            *out << "\n";
+        }
+    }
+    out->flush();
+}
+
+}
+}
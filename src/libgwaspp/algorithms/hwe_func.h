@@ -0,0 +1,99 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef HWE_FUNC_H
+#define HWE_FUNC_H
+
+#include <fstream>
+#include <vector>
+#include <map>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/analyzable/case_control_set.h"
+#include "util/thread/parallel_for.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+// distributions kept by a HardyWeinbergTest before its cache is dropped
+const uint HWE_CACHE_LIMIT = 4096;
+
+/**
+ * Class: HardyWeinbergTest
+ * Description: Exact test of Hardy-Weinberg equilibrium (Wigginton, Cutler and
+ * Abecasis, 2005). The null distribution of the heterozygote count depends
+ * only on the number of genotypes and the number of rare alleles, so it is
+ * built once per pair with the recurrence over heterozygote counts and kept
+ * sorted with its prefix sums; the p-value of a marker is then a binary
+ * search. Instances are not shared between threads.
+ */
+class HardyWeinbergTest {
+public:
+    HardyWeinbergTest( uint cache_limit = HWE_CACHE_LIMIT ) : max_cached( cache_limit ) {}
+
+    double exact( uint hom1, uint het, uint hom2 );
+    double exact( const frequency_table & ft ) { return exact( ft.aa, ft.ab, ft.bb ); }
+
+    uint getCachedCount() const { return cache.size(); }
+
+    static const double RELATIVE_ERROR;
+
+protected:
+    struct het_distribution {
+        vector< double > by_het;    // probability of 2 * i + parity heterozygotes
+        vector< double > sorted;    // by_het in ascending order
+        vector< double > prefix;    // prefix[ i ] = sum of the i smallest probabilities
+    };
+
+    const het_distribution & distribution( uint nGenotypes, uint nRare );
+
+    uint max_cached;
+    map< pair< uint, uint >, het_distribution > cache;
+};
+
+struct hwe_result {
+    frequency_table all;
+    double p_all, p_case, p_ctrl;
+};
+
+// all samples of rows [row_begin, row_end); res holds row_end - row_begin results
+void computeHWE( GenoTable & gt, uint row_begin, uint row_end, hwe_result * res, uint nThreads = 0 );
+
+// as above, with separate tests for the cases and controls of ccs
+void computeHWE( GenoTable & gt, CaseControlSet & ccs, uint row_begin, uint row_end, hwe_result * res, uint nThreads = 0 );
+
+void hwe_scan( GeneticData *gd, ostream *out );
+
+}
+}
+
+#endif // HWE_FUNC_H
@@ -0,0 +1,320 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/ld_func.h"
+
+#include <cmath>
+#include <map>
+#include <algorithm>
+
+namespace libgwaspp {
+namespace algorithms {
+
+double GenotypeR2( const CONTIN_TABLE_T & ct ) {
+    // row i and column j count the copies of the second allele of each marker
+    double n = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, syy = 0.0, sxy = 0.0;
+    for( uint i = 0; i < 3; ++i ) {
+        for( uint j = 0; j < 3; ++j ) {
+            double c = ct.contin[ i * CONTIN_COLUMN_COUNT + j ];
+            n += c;
+            sx += i * c;
+            sy += j * c;
+            sxx += i * i * c;
+            syy += j * j * c;
+            sxy += i * j * c;
+        }
+    }
+
+    if( n == 0.0 ) return 0.0;
+
+    double ss_x = sxx - sx * sx / n;
+    double ss_y = syy - sy * sy / n;
+    double ss_xy = sxy - sx * sy / n;
+
+    return (( ss_x > 0.0 && ss_y > 0.0 ) ? ss_xy * ss_xy / ( ss_x * ss_y ) : 0.0 );
+}
+
+void LDStatistics( const CONTIN_TABLE_T & ct, ld_result & res ) {
+    double n = 0.0;
+    double cell[ 3 ][ 3 ];
+    for( uint i = 0; i < 3; ++i ) {
+        for( uint j = 0; j < 3; ++j ) {
+            cell[ i ][ j ] = ct.contin[ i * CONTIN_COLUMN_COUNT + j ];
+            n += cell[ i ][ j ];
+        }
+    }
+
+    res.n = ( uint ) n;
+    res.r2 = GenotypeR2( ct );
+    res.dprime = 0.0;
+
+    if( n == 0.0 ) return;
+
+    // haplotypes counted from every genotype but the double heterozygote
+    double c11 = 2.0 * cell[0][0] + cell[0][1] + cell[1][0];
+    double c12 = 2.0 * cell[0][2] + cell[0][1] + cell[1][2];
+    double c21 = 2.0 * cell[2][0] + cell[1][0] + cell[2][1];
+    double c22 = 2.0 * cell[2][2] + cell[2][1] + cell[1][2];
+    double h = cell[1][1];
+    double N = 2.0 * n;
+
+    // x is the fraction of double heterozygotes in the 11/22 phase
+    double x = 0.5, p11 = 0.0, p12 = 0.0, p21 = 0.0, p22 = 0.0;
+    for( uint it = 0; it < LD_EM_MAX_ITERATIONS; ++it ) {
+        p11 = ( c11 + h * x ) / N;
+        p22 = ( c22 + h * x ) / N;
+        p12 = ( c12 + h * ( 1.0 - x ) ) / N;
+        p21 = ( c21 + h * ( 1.0 - x ) ) / N;
+
+        if( h == 0.0 ) break;
+
+        double cis = p11 * p22, trans = p12 * p21;
+        double next = (( cis + trans > 0.0 ) ? cis / ( cis + trans ) : 0.5 );
+        bool converged = fabs( next - x ) < LD_EM_TOLERANCE;
+        x = next;
+        if( converged ) break;
+    }
+
+    double pA = p11 + p12, pB = p11 + p21;
+    double D = p11 - pA * pB;
+    double Dmax = (( D > 0.0 ) ? min( pA * ( 1.0 - pB ), ( 1.0 - pA ) * pB ) : min( pA * pB, ( 1.0 - pA ) * ( 1.0 - pB ) ) );
+
+    if( Dmax > 0.0 ) {
+        res.dprime = D / Dmax;
+    }
+}
+
+void computeLD( GenoTable & gt, uint rIdx1, uint rIdx2, ld_result & res ) {
+    ContingencyTable ct;
+    gt.getContingencyTable( rIdx1, rIdx2, ct );
+    LDStatistics( *ct.getContingencyTable(), res );
+}
+
+double LDCache::getR2( uint rIdx1, uint rIdx2 ) {
+    if( rIdx1 > rIdx2 ) {
+        swap( rIdx1, rIdx2 );
+    }
+
+    ++lookups;
+    ulong key = (( ulong ) rIdx1 << 32 ) | rIdx2;
+    map< ulong, double >::iterator it = r2_cache.lower_bound( key );
+    if( it != r2_cache.end() && it->first == key ) {
+        return it->second;
+    }
+
+    gt.getContingencyTable( rIdx1, rIdx2, ct );
+    double r2 = GenotypeR2( *ct.getContingencyTable() );
+    r2_cache.insert( it, make_pair( key, r2 ) );
+    return r2;
+}
+
+void orderMarkersByPosition( GeneticData *gd, vector< vector< uint > > & chromosomes, vector< uint > & positions ) {
+    uint marker_count = gd->getGenotypedMarkersCount();
+
+    map< ChromosomeID, vector< pair< uint, uint > > > by_chrom;
+    positions.resize( marker_count );
+    for( uint r = 0; r < marker_count; ++r ) {
+        const Marker *m = gd->getGenotypedMarker( r );
+        positions[r] = m->getStart();
+        by_chrom[ m->getChromosomeID() ].push_back( make_pair( m->getStart(), r ) );
+    }
+
+    chromosomes.clear();
+    chromosomes.reserve( by_chrom.size() );
+
+    map< ChromosomeID, vector< pair< uint, uint > > >::iterator it = by_chrom.begin();
+    for( ; it != by_chrom.end(); ++it ) {
+        sort( it->second.begin(), it->second.end() );
+
+        chromosomes.push_back( vector< uint >() );
+        vector< uint > &rows = chromosomes.back();
+        rows.reserve( it->second.size() );
+        for( uint i = 0; i < it->second.size(); ++i ) {
+            rows.push_back( it->second[i].second );
+        }
+    }
+}
+
+struct ld_prune_work {
+    GenoTable *gt;
+    const vector< vector< uint > > *chromosomes;
+    const vector< uint > *positions;
+    const ld_window *w;
+    vector< double > maf;
+    vector< uint > order;   // chromosomes by decreasing marker count
+    uint nThreads;
+    byte *keep;
+};
+
+struct ChromosomeSizeComparer {
+    const vector< vector< uint > > *chromosomes;
+    bool operator()( uint lhs, uint rhs ) const { return ( *chromosomes )[ lhs ].size() > ( *chromosomes )[ rhs ].size(); }
+};
+
+static void PruneChromosome( ld_prune_work & w, const vector< uint > & rows ) {
+    const vector< uint > &positions = *w.positions;
+    const uint size = w.w->size, max_bp = w.w->max_bp;
+    const double threshold = w.w->r2_threshold;
+
+    ContingencyTable ct;
+
+    uint m = rows.size(), tested_end = 0;
+    for( uint s = 0; s < m; s += w.w->step ) {
+        uint e = min( s + size, m );
+
+        // rows before tested_end were paired with every row of this window already
+        for( uint j = max( tested_end, s ); j < e; ++j ) {
+            uint rj = rows[j];
+            for( uint i = s; i < j && w.keep[ rj ]; ++i ) {
+                uint ri = rows[i];
+                if( !w.keep[ ri ] ) continue;
+                if( max_bp && positions[ rj ] - positions[ ri ] > max_bp ) continue;
+
+                w.gt->getContingencyTable( ri, rj, ct );
+
+                if( GenotypeR2( *ct.getContingencyTable() ) > threshold ) {
+                    if( w.maf[ ri ] < w.maf[ rj ] ) {
+                        w.keep[ ri ] = 0;
+                    } else {
+                        w.keep[ rj ] = 0;
+                    }
+                }
+            }
+        }
+
+        tested_end = e;
+        if( e == m ) break;
+    }
+}
+
+static void LDPruneWorker( void *arg, ulong begin, ulong end ) {
+    ld_prune_work &w = *reinterpret_cast< ld_prune_work * >( arg );
+
+    // thread b takes every nThreads-th chromosome of the size order
+    for( ulong b = begin; b < end; ++b ) {
+        for( ulong k = b; k < w.order.size(); k += w.nThreads ) {
+            PruneChromosome( w, ( *w.chromosomes )[ w.order[k] ] );
+        }
+    }
+}
+
+void pruneLD( GenoTable & gt, const vector< vector< uint > > & chromosomes, const vector< uint > & positions, const ld_window & w, vector< byte > & keep, uint nThreads ) {
+    assert( w.size > 1 && w.step > 0 && w.step <= w.size );
+
+    uint row_count = positions.size();
+    keep.assign( row_count, 1 );
+    if( row_count == 0 ) return;
+
+    ld_prune_work work;
+    work.gt = &gt;
+    work.chromosomes = &chromosomes;
+    work.positions = &positions;
+    work.w = &w;
+    work.keep = &keep[0];
+
+    vector< frequency_table > dist( row_count );
+    gt.getGenotypeDistributions( 0, row_count, &dist[0] );
+
+    work.maf.resize( row_count );
+    for( uint r = 0; r < row_count; ++r ) {
+        // from the allele counts, so that equal frequencies compare equal
+        uint called = 2 * ( dist[r].aa + dist[r].ab + dist[r].bb );
+        uint minor = min( 2 * dist[r].aa + dist[r].ab, 2 * dist[r].bb + dist[r].ab );
+        work.maf[r] = (( called > 0 ) ? ( double ) minor / called : 0.0 );
+    }
+
+    work.order.resize( chromosomes.size() );
+    for( uint c = 0; c < chromosomes.size(); ++c ) {
+        work.order[c] = c;
+    }
+    ChromosomeSizeComparer comp;
+    comp.chromosomes = &chromosomes;
+    stable_sort( work.order.begin(), work.order.end(), comp );
+
+    if( !gt.supportsConcurrentReads() ) {
+        nThreads = 1;
+    } else if( nThreads == 0 ) {
+        nThreads = GetProcessorCount();
+    }
+    if( nThreads > chromosomes.size() ) {
+        nThreads = chromosomes.size();
+    }
+    if( nThreads == 0 ) return;
+
+    work.nThreads = nThreads;
+    ParallelFor( 0, nThreads, LDPruneWorker, &work, nThreads );
+}
+
+void ld_prune( GeneticData *gd, const ld_window & w, set< string > & marker_ids, uint nThreads ) {
+    vector< vector< uint > > chromosomes;
+    vector< uint > positions;
+    orderMarkersByPosition( gd, chromosomes, positions );
+
+    vector< byte > keep;
+    pruneLD( *gd->getGenotypeTable(), chromosomes, positions, w, keep, nThreads );
+
+    for( uint r = 0; r < keep.size(); ++r ) {
+        if( keep[r] ) {
+            marker_ids.insert( gd->getGenotypedMarkerID( r ) );
+        }
+    }
+}
+
+void ld_prune_scan( GeneticData *gd, ostream *out ) {
+    uint marker_count = gd->getGenotypedMarkersCount();
+    if( marker_count == 0 ) return;
+
+    ld_window w;
+
+    vector< vector< uint > > chromosomes;
+    vector< uint > positions;
+    orderMarkersByPosition( gd, chromosomes, positions );
+
+    cout << "LD pruning of " << marker_count << " markers on " << chromosomes.size() << " chromosomes (window " << w.size
+         << ", step " << w.step << ", r2 > " << w.r2_threshold << ")" << endl;
+
+    vector< byte > keep;
+    pruneLD( *gd->getGenotypeTable(), chromosomes, positions, w, keep );
+
+    uint kept = 0;
+    for( uint c = 0; c < chromosomes.size(); ++c ) {
+        const vector< uint > &rows = chromosomes[c];
+        for( uint i = 0; i < rows.size(); ++i ) {
+            if( keep[ rows[i] ] ) {
+                *out << gd->getGenotypedMarkerID( rows[i] ) << "\n";
+                ++kept;
+            }
+        }
+    }
+    out->flush();
+
+    cout << kept << " markers remain after pruning" << endl;
+}
+
+}
+}
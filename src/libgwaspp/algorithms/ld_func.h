@@ -0,0 +1,131 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef LD_FUNC_H
+#define LD_FUNC_H
+
+#include <fstream>
+#include <vector>
+#include <set>
+#include <map>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/common_genotype.h"
+#include "util/thread/parallel_for.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+// default sliding window: markers per window, markers per step, r2 cut off
+const uint LD_WINDOW_SIZE = 50;
+const uint LD_WINDOW_STEP = 5;
+const double LD_R2_THRESHOLD = 0.5;
+
+// haplotype frequency estimation of D'
+const uint LD_EM_MAX_ITERATIONS = 100;
+const double LD_EM_TOLERANCE = 1e-8;
+
+/**
+ * Linkage disequilibrium of a pair of markers. r2 is the squared correlation
+ * of the allele dosages over the individuals called at both markers; D' is
+ * normalised by Dmax of the haplotype frequencies, which are estimated by EM
+ * since the phase of the double heterozygotes is unknown. D' carries the sign
+ * of D relative to the first alleles of the two rows.
+ */
+struct ld_result {
+    uint n;             // individuals called at both markers
+    double r2;
+    double dprime;
+};
+
+struct ld_window {
+    uint size, step;    // in markers
+    uint max_bp;        // pairs further apart are not tested; 0 for no limit
+    double r2_threshold;
+
+    ld_window() : size( LD_WINDOW_SIZE ), step( LD_WINDOW_STEP ), max_bp( 0 ), r2_threshold( LD_R2_THRESHOLD ) {}
+};
+
+void LDStatistics( const CONTIN_TABLE_T & ct, ld_result & res );
+void computeLD( GenoTable & gt, uint rIdx1, uint rIdx2, ld_result & res );
+
+// r2 alone; skips the haplotype estimation of LDStatistics
+double GenotypeR2( const CONTIN_TABLE_T & ct );
+
+/**
+ * r2 of row pairs computed on demand from the table and kept for later
+ * requests of the same pair, in either order.
+ */
+class LDCache {
+    public:
+        LDCache( GenoTable & t ) : gt( t ), lookups( 0 ) {}
+
+        double getR2( uint rIdx1, uint rIdx2 );
+
+        ulong getLookupCount() const { return lookups; }
+        ulong getComputedCount() const { return r2_cache.size(); }
+
+        void clear() { r2_cache.clear(); lookups = 0; }
+
+        virtual ~LDCache() {}
+    protected:
+        GenoTable & gt;
+        ContingencyTable ct;
+        map< ulong, double > r2_cache;
+        ulong lookups;
+};
+
+/**
+ * Groups the genotyped rows by chromosome, each group in position order.
+ * positions[r] receives the start of the marker of row r.
+ */
+void orderMarkersByPosition( GeneticData *gd, vector< vector< uint > > & chromosomes, vector< uint > & positions );
+
+/**
+ * Slides the window along every chromosome; of each pair of remaining rows in
+ * a window with r2 above the threshold, the row with the lower minor allele
+ * frequency is removed (the later row on ties). Pairs which were tested in the
+ * previous window are not tested again. keep[r] is left non-zero for the rows
+ * which remain. The chromosomes are spread over the threads when the table
+ * supports concurrent reads.
+ */
+void pruneLD( GenoTable & gt, const vector< vector< uint > > & chromosomes, const vector< uint > & positions, const ld_window & w, vector< byte > & keep, uint nThreads = 0 );
+
+// ids of the remaining markers, usable as the marker set of a BasicInput
+void ld_prune( GeneticData *gd, const ld_window & w, set< string > & marker_ids, uint nThreads = 0 );
+
+void ld_prune_scan( GeneticData *gd, ostream *out );
+
+}
+}
+
+#endif // LD_FUNC_H
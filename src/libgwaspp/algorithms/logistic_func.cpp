@@ -0,0 +1,426 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/logistic_func.h"
+
+#include <cmath>
+
+namespace libgwaspp {
+namespace algorithms {
+
+// dosage of the second allele and missing indicator of every stream code
+static const double CODE_DOSAGE[ GENOTYPE_COUNT ] = { 0.0, 0.0, 1.0, 2.0 };
+static const double CODE_MISSING[ GENOTYPE_COUNT ] = { 1.0, 0.0, 0.0, 0.0 };
+
+// lower Cholesky factor of the p x p matrix a, in place; only the lower
+// triangle of a is read. False unless a is positive definite.
+static bool CholeskyDecompose( double *a, uint p ) {
+    for( uint j = 0; j < p; ++j ) {
+        double d = a[ j * p + j ];
+        for( uint k = 0; k < j; ++k ) {
+            d -= a[ j * p + k ] * a[ j * p + k ];
+        }
+        if( d <= 0.0 ) return false;
+
+        d = sqrt( d );
+        a[ j * p + j ] = d;
+
+        for( uint i = j + 1; i < p; ++i ) {
+            double s = a[ i * p + j ];
+            for( uint k = 0; k < j; ++k ) {
+                s -= a[ i * p + k ] * a[ j * p + k ];
+            }
+            a[ i * p + j ] = s / d;
+        }
+    }
+    return true;
+}
+
+// solves L z = b in place
+static void ForwardSolve( const double *l, uint p, double *b ) {
+    for( uint i = 0; i < p; ++i ) {
+        double s = b[ i ];
+        for( uint k = 0; k < i; ++k ) {
+            s -= l[ i * p + k ] * b[ k ];
+        }
+        b[ i ] = s / l[ i * p + i ];
+    }
+}
+
+// solves L L' z = b in place
+static void CholeskySolve( const double *l, uint p, double *b ) {
+    ForwardSolve( l, p, b );
+    for( uint i = p; i-- > 0; ) {
+        double s = b[ i ];
+        for( uint k = i + 1; k < p; ++k ) {
+            s -= l[ k * p + i ] * b[ k ];
+        }
+        b[ i ] = s / l[ i * p + i ];
+    }
+}
+
+static inline double Dot( const double *a, const double *b, uint n ) {
+    double s = 0.0;
+    for( uint i = 0; i < n; ++i ) {
+        s += a[ i ] * b[ i ];
+    }
+    return s;
+}
+
+// per thread buffers of the model fits
+struct logistic_workspace {
+    vector< double > mu, weight, residual, weighted_row;
+    vector< double > step, info;
+
+    void resize( uint n, uint p ) {
+        mu.resize( n );
+        weight.resize( n );
+        residual.resize( n );
+        weighted_row.resize( n );
+        step.resize( p );
+        info.resize( p * p );
+    }
+};
+
+static void LogisticFitted( const double * const *rows, uint p, const double *beta, uint n, double *mu ) {
+    for( uint i = 0; i < n; ++i ) {
+        mu[ i ] = 0.0;
+    }
+    for( uint k = 0; k < p; ++k ) {
+        const double *row = rows[ k ];
+        for( uint i = 0; i < n; ++i ) {
+            mu[ i ] += beta[ k ] * row[ i ];
+        }
+    }
+    for( uint i = 0; i < n; ++i ) {
+        mu[ i ] = 1.0 / ( 1.0 + exp( -mu[ i ] ) );
+    }
+}
+
+// score ( ws.step ) and Cholesky factor of the information ( ws.info ) at beta
+static bool LogisticScoreInformation( const double * const *rows, uint p, const double *y, uint n, const double *beta, logistic_workspace & ws ) {
+    LogisticFitted( rows, p, beta, n, &ws.mu[0] );
+
+    for( uint i = 0; i < n; ++i ) {
+        ws.weight[ i ] = ws.mu[ i ] * ( 1.0 - ws.mu[ i ] );
+        ws.residual[ i ] = y[ i ] - ws.mu[ i ];
+    }
+
+    for( uint k = 0; k < p; ++k ) {
+        ws.step[ k ] = Dot( rows[ k ], &ws.residual[0], n );
+
+        for( uint i = 0; i < n; ++i ) {
+            ws.weighted_row[ i ] = ws.weight[ i ] * rows[ k ][ i ];
+        }
+        for( uint j = 0; j <= k; ++j ) {
+            ws.info[ k * p + j ] = Dot( &ws.weighted_row[0], rows[ j ], n );
+        }
+    }
+
+    return CholeskyDecompose( &ws.info[0], p );
+}
+
+/**
+ * Newton-Raphson fit of logit P( y = 1 ) = sum_k beta_k rows[k][i], starting
+ * from beta. Every iteration takes the full step from the score and the
+ * information at the current beta, so ws.info holds the factor of the
+ * information at the last beta a step was taken from. nIterations is 0 if
+ * the information became singular, in which case beta is not usable.
+ */
+static bool FitLogistic( const double * const *rows, uint p, const double *y, uint n, uint maxIterations, double *beta, logistic_workspace & ws, uint & nIterations ) {
+    nIterations = 0;
+    for( uint it = 0; it < maxIterations; ++it ) {
+        if( !LogisticScoreInformation( rows, p, y, n, beta, ws ) ) {
+            nIterations = 0;
+            return false;
+        }
+
+        CholeskySolve( &ws.info[0], p, &ws.step[0] );
+
+        double change = 0.0;
+        for( uint k = 0; k < p; ++k ) {
+            beta[ k ] += ws.step[ k ];
+            change = max( change, fabs( ws.step[ k ] ) );
+        }
+        ++nIterations;
+
+        if( change < LOGISTIC_TOLERANCE ) return true;
+    }
+    return false;
+}
+
+bool fitLogisticNullModel( CaseControlSet & ccs, const CovariateSet * covariates, logistic_null_model & model ) {
+    const ushort *cases = ccs.stream_case_begin();
+    const ushort *ctrls = ccs.stream_control_begin();
+    const uint nCovariates = ( covariates == NULL ) ? 0 : covariates->getCovariateCount();
+
+    model.columns.clear();
+    model.y.clear();
+    for( uint c = 0; c <= ccs.getMaximumIndex(); ++c ) {
+        ushort bit = ( 1 << ( c & 0x0F ) );
+        bool is_case = ( cases[ c >> 4 ] & bit ) != 0, is_ctrl = ( ctrls[ c >> 4 ] & bit ) != 0;
+
+        if( !( is_case || is_ctrl ) || ( covariates != NULL && !covariates->isComplete( c ) ) ) continue;
+
+        model.columns.push_back( c );
+        model.y.push_back( is_case ? 1.0 : 0.0 );
+    }
+
+    const uint n = model.columns.size(), p = 1 + nCovariates;
+    model.nSamples = n;
+    model.nParams = p;
+
+    model.design.resize( ( ulong ) p * n );
+    for( uint i = 0; i < n; ++i ) {
+        model.design[ i ] = 1.0;
+    }
+    for( uint k = 0; k < nCovariates; ++k ) {
+        const double *cov = covariates->covariate_begin( k );
+        double *row = &model.design[ ( ulong )( k + 1 ) * n ];
+        for( uint i = 0; i < n; ++i ) {
+            row[ i ] = cov[ model.columns[ i ] ];
+        }
+    }
+
+    vector< const double * > rows( p );
+    for( uint k = 0; k < p; ++k ) {
+        rows[ k ] = &model.design[ ( ulong ) k * n ];
+    }
+
+    // intercept at the log odds of the case fraction
+    double nCases = 0.0;
+    for( uint i = 0; i < n; ++i ) {
+        nCases += model.y[ i ];
+    }
+    model.beta.assign( p, 0.0 );
+    model.iterations = 0;
+    if( nCases > 0.0 && nCases < n ) {
+        model.beta[ 0 ] = log( nCases / ( n - nCases ) );
+    }
+
+    logistic_workspace ws;
+    ws.resize( n, p );
+
+    model.converged = ( n > p ) && FitLogistic( &rows[0], p, &model.y[0], n, LOGISTIC_MAX_ITERATIONS, &model.beta[0], ws, model.iterations );
+
+    // marker tests use the residuals, weights and information at the fitted beta
+    if( n > 0 && !LogisticScoreInformation( &rows[0], p, &model.y[0], n, &model.beta[0], ws ) ) {
+        model.converged = false;
+    }
+
+    model.residual.swap( ws.residual );
+    model.weight.swap( ws.weight );
+    model.info_factor.swap( ws.info );
+
+    model.weighted_design.resize( ( ulong ) p * n );
+    for( uint k = 0; k < p; ++k ) {
+        const double *row = rows[ k ];
+        double *wrow = &model.weighted_design[ ( ulong ) k * n ];
+        for( uint i = 0; i < n; ++i ) {
+            wrow[ i ] = model.weight[ i ] * row[ i ];
+        }
+    }
+
+    return model.converged;
+}
+
+struct logistic_marker_buffers {
+    vector< double > dosage, missing, projection, beta;
+    vector< const double * > rows;
+    logistic_workspace ws;
+
+    logistic_marker_buffers( const logistic_null_model & m ) : dosage( m.nSamples ), missing( m.nSamples ), projection( m.nParams ), beta( m.nParams + 1 ), rows( m.nParams + 1 ) {
+        for( uint k = 0; k < m.nParams; ++k ) {
+            rows[ k ] = &m.design[ ( ulong ) k * m.nSamples ];
+        }
+        rows[ m.nParams ] = &dosage[0];
+        ws.resize( m.nSamples, m.nParams + 1 );
+    }
+};
+
+/**
+ * Score test of the decoded row codes: U = x'r and V = x'Wx - b' ( X'WX )^-1 b
+ * with b = X'Wx. The null information factor L turns the quadratic form into
+ * the squared norm of L^-1 b, so every marker costs nParams + 2 dot products
+ * and one triangular solve.
+ */
+static void LogisticMarker( const logistic_null_model & m, const byte *codes, uint nIterations, logistic_marker_buffers & buf, logistic_result & res ) {
+    const uint n = m.nSamples, p = m.nParams;
+    double *x = &buf.dosage[0], *miss = &buf.missing[0];
+
+    res.score_chi2 = 0.0;
+    res.score_p = 1.0;
+    res.beta = 0.0;
+    res.se = 0.0;
+    res.odds_ratio = 1.0;
+    res.wald_p = 1.0;
+    res.iterations = 0;
+    res.converged = false;
+
+    for( uint i = 0; i < n; ++i ) {
+        byte code = codes[ m.columns[ i ] ];
+        x[ i ] = CODE_DOSAGE[ code ];
+        miss[ i ] = CODE_MISSING[ code ];
+    }
+
+    double sum = 0.0, nMissing = 0.0;
+    for( uint i = 0; i < n; ++i ) {
+        sum += x[ i ];
+        nMissing += miss[ i ];
+    }
+
+    res.n_called = n - ( uint ) nMissing;
+    if( res.n_called == 0 ) return;
+
+    double mean = sum / res.n_called;
+    for( uint i = 0; i < n; ++i ) {
+        x[ i ] += mean * miss[ i ];
+    }
+
+    double u = Dot( x, &m.residual[0], n );
+    double sxx = 0.0;
+    for( uint i = 0; i < n; ++i ) {
+        sxx += m.weight[ i ] * x[ i ] * x[ i ];
+    }
+    for( uint k = 0; k < p; ++k ) {
+        buf.projection[ k ] = Dot( &m.weighted_design[ ( ulong ) k * n ], x, n );
+    }
+    ForwardSolve( &m.info_factor[0], p, &buf.projection[0] );
+
+    double v = sxx - Dot( &buf.projection[0], &buf.projection[0], p );
+
+    // no dosage variation left once the covariates are accounted for
+    if( v <= LOGISTIC_TOLERANCE * sxx ) return;
+
+    res.score_chi2 = u * u / v;
+    res.score_p = pchisq( res.score_chi2, 1.0, 0, 0 );
+
+    res.beta = u / v;
+    res.se = 1.0 / sqrt( v );
+    res.wald_p = res.score_p;
+    res.converged = true;
+
+    if( nIterations > 0 ) {
+        copy( m.beta.begin(), m.beta.end(), buf.beta.begin() );
+        buf.beta[ p ] = res.beta;
+
+        res.converged = FitLogistic( &buf.rows[0], p + 1, &m.y[0], n, nIterations, &buf.beta[0], buf.ws, res.iterations );
+        // a singular information leaves the one step estimate; otherwise the
+        // last diagonal entry of the factor is the square root of the Schur
+        // complement of the dosage, so var( beta ) is its inverse square
+        if( res.iterations > 0 ) {
+            double l = buf.ws.info[ p * ( p + 1 ) + p ];
+
+            res.beta = buf.beta[ p ];
+            res.se = 1.0 / l;
+            res.wald_p = pchisq( ( res.beta * res.beta ) * ( l * l ), 1.0, 0, 0 );
+        }
+    }
+
+    res.odds_ratio = exp( res.beta );
+}
+
+struct logistic_work {
+    GenoTable *gt;
+    const logistic_null_model *model;
+    uint row_begin, row_end, nIterations;
+    logistic_result *res;
+};
+
+static void LogisticWorker( void *arg, ulong begin, ulong end ) {
+    logistic_work &w = *reinterpret_cast< logistic_work * >( arg );
+    const uint nColumns = w.gt->column_size();
+
+    vector< byte > codes( ( ulong ) LOGISTIC_BLOCK_SIZE * nColumns );
+    logistic_marker_buffers buf( *w.model );
+
+    for( ulong b = begin; b < end; ++b ) {
+        uint r0 = w.row_begin + b * LOGISTIC_BLOCK_SIZE;
+        uint r1 = min( r0 + LOGISTIC_BLOCK_SIZE, w.row_end );
+
+        w.gt->getGenotypeCodes( r0, r1, &codes[0] );
+
+        for( uint r = r0; r < r1; ++r ) {
+            LogisticMarker( *w.model, &codes[ ( ulong )( r - r0 ) * nColumns ], w.nIterations, buf, w.res[ r - w.row_begin ] );
+        }
+    }
+}
+
+void computeLogisticAssociation( GenoTable & gt, const logistic_null_model & model, uint row_begin, uint row_end, logistic_result * res, uint nIterations, uint nThreads ) {
+    if( row_end <= row_begin ) return;
+
+    if( !gt.supportsConcurrentReads() ) {
+        nThreads = 1;
+    }
+
+    logistic_work w;
+    w.gt = &gt;
+    w.model = &model;
+    w.row_begin = row_begin;
+    w.row_end = row_end;
+    w.nIterations = nIterations;
+    w.res = res;
+
+    ulong nBlocks = ( row_end - row_begin + LOGISTIC_BLOCK_SIZE - 1 ) / LOGISTIC_BLOCK_SIZE;
+    ParallelFor( 0, nBlocks, LogisticWorker, &w, nThreads );
+}
+
+void logistic_scan( GeneticData *gd, const CovariateSet * covariates, ostream *out, uint nIterations ) {
+    uint marker_count = gd->getGenotypedMarkersCount();
+    GenoTable &gt = *gd->getGenotypeTable();
+
+    assert( gd->getCaseControlSet() != NULL );
+    CaseControlSet &ccs = *gd->getCaseControlSet();
+
+    logistic_null_model model;
+    if( !fitLogisticNullModel( ccs, covariates, model ) ) {
+        cout << "WARNING: Null logistic model did not converge after " << model.iterations << " iterations" << endl;
+    }
+
+    cout << "Logistic regression of " << marker_count << " markers (" << model.nSamples << " samples, " << ( model.nParams - 1 ) << " covariates)" << endl;
+
+    if( marker_count == 0 ) return;
+
+    vector< logistic_result > res( marker_count );
+    computeLogisticAssociation( gt, model, 0, marker_count, &res[0], nIterations );
+
+    *out << "MARKER\tN\tCHISQ_SCORE\tP_SCORE\tBETA\tSE\tOR\tP_WALD\n";
+    for( uint i = 0; i < marker_count; ++i ) {
+        const logistic_result &r = res[i];
+        *out << gd->getGenotypedMarkerID( i ) << "\t" << r.n_called << "\t" << r.score_chi2 << "\t" << r.score_p << "\t" << r.beta
+             << "\t" << r.se << "\t" << r.odds_ratio << "\t" << r.wald_p << "\n";
+    }
+    out->flush();
+}
+
+void logistic_scan( GeneticData *gd, ostream *out ) {
+    logistic_scan( gd, gd->getCovariateSet(), out, LOGISTIC_MAX_ITERATIONS );
+}
+
+}
+}
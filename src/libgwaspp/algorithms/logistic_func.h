@@ -0,0 +1,114 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef LOGISTIC_FUNC_H
+#define LOGISTIC_FUNC_H
+
+#include <fstream>
+#include <vector>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/common_genotype_func.h"
+#include "genetics/analyzable/case_control_set.h"
+#include "genetics/analyzable/covariate_set.h"
+#include "util/thread/parallel_for.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+// markers decoded together; every thread holds their codes for all columns
+const uint LOGISTIC_BLOCK_SIZE = 64;
+
+const uint LOGISTIC_MAX_ITERATIONS = 25;
+const double LOGISTIC_TOLERANCE = 1e-8;
+
+/**
+ * Null model logit P( case ) = b0 + sum_k b_k * covariate_k over the cases
+ * and controls which have every covariate, fitted once for a scan.
+ *
+ * The per sample quantities of the marker tests are kept from the fit: the
+ * residuals y - mu, the weights mu ( 1 - mu ), the weighted design rows and
+ * the Cholesky factor of the information matrix X'WX.
+ */
+struct logistic_null_model {
+    uint nSamples, nParams;         // nParams = 1 + covariates
+    vector< uint > columns;         // table column of every sample
+    vector< double > y;             // 1 for cases, 0 for controls
+
+    vector< double > design;        // nParams rows of nSamples; row 0 is the intercept
+    vector< double > beta;
+
+    vector< double > residual, weight;
+    vector< double > weighted_design;   // design rows times weight
+    vector< double > info_factor;       // lower triangle, nParams x nParams
+
+    uint iterations;
+    bool converged;
+};
+
+// covariates may be NULL for an intercept only model
+bool fitLogisticNullModel( CaseControlSet & ccs, const CovariateSet * covariates, logistic_null_model & model );
+
+/**
+ * Test of the dosage of the second allele of a marker (AA = 0, AB = 1,
+ * BB = 2) added to the null model. Missing genotypes are set to the mean
+ * dosage of the called samples.
+ *
+ * The score test only needs the null model. The effect is the one step
+ * estimate U / V from the null model unless Newton-Raphson iterations of the
+ * full model are requested, in which case beta, se and wald_p are those of
+ * the fit.
+ */
+struct logistic_result {
+    uint n_called;
+    double score_chi2, score_p;
+    double beta, se, odds_ratio, wald_p;
+    uint iterations;
+    bool converged;
+};
+
+/**
+ * Tests rows [row_begin, row_end) of gt; res holds row_end - row_begin
+ * results. Rows are decoded LOGISTIC_BLOCK_SIZE at a time and the blocks
+ * are split over the threads when the table supports concurrent reads.
+ */
+void computeLogisticAssociation( GenoTable & gt, const logistic_null_model & model, uint row_begin, uint row_end, logistic_result * res, uint nIterations = 0, uint nThreads = 0 );
+
+void logistic_scan( GeneticData *gd, const CovariateSet * covariates, ostream *out, uint nIterations = 0 );
+
+// covariates of gd; beta, se and wald_p are those of the full model fit
+void logistic_scan( GeneticData *gd, ostream *out );
+
+}
+}
+
+#endif // LOGISTIC_FUNC_H
@@ -221,18 +221,75 @@ void maf_all( IndexedInput &inp, void *output ) {
     }
 }
 
+struct distribution_work {
+    GenoTable *gt;
+    uint row_begin, row_end;
+    frequency_table *out, *cases, *ctrls;
+};
+
+static void DistributionWorker( void *arg, ulong begin, ulong end ) {
+    distribution_work &w = *reinterpret_cast< distribution_work * >( arg );
+
+    for( ulong b = begin; b < end; ++b ) {
+        uint r0 = w.row_begin + b * DISTRIBUTION_BLOCK_SIZE;
+        uint r1 = min( r0 + DISTRIBUTION_BLOCK_SIZE, w.row_end );
+
+        w.gt->getGenotypeDistributions( r0, r1, w.out + ( r0 - w.row_begin ) );
+    }
+}
+
+static void CaseControlDistributionWorker( void *arg, ulong begin, ulong end ) {
+    distribution_work &w = *reinterpret_cast< distribution_work * >( arg );
+
+    for( ulong b = begin; b < end; ++b ) {
+        uint r0 = w.row_begin + b * DISTRIBUTION_BLOCK_SIZE;
+        uint r1 = min( r0 + DISTRIBUTION_BLOCK_SIZE, w.row_end );
+
+        w.gt->getCaseControlGenotypeDistributions( r0, r1, w.cases + ( r0 - w.row_begin ), w.ctrls + ( r0 - w.row_begin ) );
+    }
+}
+
+void computeGenotypeDistributions( GenoTable &gt, uint row_begin, uint row_end, frequency_table *out, uint nThreads ) {
+    if( row_begin >= row_end ) return;
+
+    distribution_work w;
+    w.gt = &gt;
+    w.row_begin = row_begin;
+    w.row_end = row_end;
+    w.out = out;
+
+    ulong nBlocks = ( row_end - row_begin + DISTRIBUTION_BLOCK_SIZE - 1 ) / DISTRIBUTION_BLOCK_SIZE;
+    ParallelFor( 0, nBlocks, DistributionWorker, &w, ( gt.supportsConcurrentReads() ? nThreads : 1 ) );
+}
+
+void computeCaseControlGenotypeDistributions( GenoTable &gt, uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls, uint nThreads ) {
+    if( row_begin >= row_end ) return;
+
+    distribution_work w;
+    w.gt = &gt;
+    w.row_begin = row_begin;
+    w.row_end = row_end;
+    w.cases = cases;
+    w.ctrls = ctrls;
+
+    ulong nBlocks = ( row_end - row_begin + DISTRIBUTION_BLOCK_SIZE - 1 ) / DISTRIBUTION_BLOCK_SIZE;
+    ParallelFor( 0, nBlocks, CaseControlDistributionWorker, &w, ( gt.supportsConcurrentReads() ? nThreads : 1 ) );
+}
+
 void compute_maf_perform( GeneticData *gd, ostream *out) {
     int marker_count = gd->getGenotypedMarkersCount();
     GenoTable &gt = *gd->getGenotypeTable();
 
-    GenotypeDistribution dist;
-    const frequency_table &ft = *dist.getDistribution();
+    frequency_table *dist = new frequency_table[ marker_count ];
     double _tot, _maf;
 
+    computeGenotypeDistributions( gt, 0, marker_count, dist );
+
     for( int i = 0; i < marker_count; ++i ) {
-        gt.getGenotypeDistribution( i, dist );
-        MinorAlleleFrequency( ft, _tot, _maf );
+        MinorAlleleFrequency( dist[i], _tot, _maf );
     }
+
+    delete [] dist;
 }
 
 void select_cc_maf( GeneticData *gd, ostream *out ) {
@@ -272,15 +329,15 @@ void genotype_dist_performance( GeneticData *gd, ostream *out ) {
     int marker_count = gd->getGenotypedMarkersCount();
     GenoTable &gt = *gd->getGenotypeTable();
     
-    GenotypeDistribution dist;
-    //const frequency_table &ft = *dist.getDistribution();
+    frequency_table dist[ DISTRIBUTION_BLOCK_SIZE ];
     //double _tot, _maf;
 
+    // one timing per block of rows; the index is the first row of the block
     //*out << "<RESULTS>" << endl;
     INIT_LAPSE_TIME;
-    for( int i = 0; i < marker_count; ++i ) {
+    for( int i = 0; i < marker_count; i += DISTRIBUTION_BLOCK_SIZE ) {
         RECORD_START;
-        gt.getGenotypeDistribution( i, dist );
+        gt.getGenotypeDistributions( i, min( i + ( int ) DISTRIBUTION_BLOCK_SIZE, marker_count ), dist );
         RECORD_STOP;
         *out << (int) i;
         PRINT_LAPSE( *out, "\t" );
@@ -318,15 +375,14 @@ void inline_cc_maf( GeneticData *gd, ostream *out ) {
 void inline_maf_print( GeneticData *gd, ostream *out ) {
     int marker_count = gd->getGenotypedMarkersCount();
     int individ_count = gd->getGenotypedIndividualsCount();
-    GenoTable &gt = *gd->getGenotypeTable();
+    MarkerSummaryCache &summary = *gd->getSummaryCache();
 
-    GenotypeDistribution dist;
-    const frequency_table &ft = *dist.getDistribution();
+    frequency_table ft;
     double _tot, _maf;
 
     //cout << "<RESULT>" << endl;
     for( int i = 0; i < marker_count; ++i ) {
-        gt.getGenotypeDistribution( i, dist );
+        summary.getCounts( i, ft );
         MinorAlleleFrequency( ft, _tot, _maf );
 
         *out << (int)(individ_count - _tot) << "\t" << ft.aa << "\t" << ft.ab << "\t" << ft.bb << endl;
@@ -34,6 +34,7 @@
 #include "genetics/genetic_data.h"
 #include "genetics/genotype/geno_table.h"
 #include "util/time/timing.h"
+#include "util/thread/parallel_for.h"
 
 #include "algorithms/computation_engine.h"
 
@@ -55,6 +56,20 @@ inline void MinorAlleleFrequency( const frequency_table & ft, double & tot, doub
 
 const int POSSIBLE_ENC = 1 << ( 8 * sizeof( ushort ) );
 
+// rows handed to a batch distribution call at a time
+const uint DISTRIBUTION_BLOCK_SIZE = 1024;
+
+/**
+ * Genotype distributions of the rows [row_begin, row_end); out[i] belongs to
+ * row row_begin + i. Blocks of DISTRIBUTION_BLOCK_SIZE rows are counted with
+ * the batch kernels of the table, on nThreads threads when the table supports
+ * concurrent reads (0 uses every processor).
+ */
+void computeGenotypeDistributions( GenoTable &gt, uint row_begin, uint row_end, frequency_table *out, uint nThreads = 0 );
+
+// assumes that CaseControl Set has already been selected
+void computeCaseControlGenotypeDistributions( GenoTable &gt, uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls, uint nThreads = 0 );
+
 void computeMAF( GenoTable &gt );
 void computeMAF( GeneticData *gd, const set<string> & row_ids, const set<string> & column_ids );
 
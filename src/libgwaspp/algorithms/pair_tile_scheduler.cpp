@@ -0,0 +1,123 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/pair_tile_scheduler.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+const uint PairTileScheduler::DEFAULT_TILE_ROWS = 256;
+
+PairTileScheduler::PairTileScheduler( GenoTable &_gt, uint _begin, uint _end ) : gt( _gt ), row_begin( _begin ), row_end( _end ), pinned( false ) {
+    tile_rows = gt.getRowBlockSize();
+    uint resident = gt.getResidentRowBlockCount();
+
+    if( tile_rows == 0 ) {
+        tile_rows = DEFAULT_TILE_ROWS;
+    }
+
+    // one resident block is left for the streamed tile
+    group_tiles = (( resident > 1 ) ? resident - 1 : 1 );
+
+    reset();
+}
+
+void PairTileScheduler::reset() {
+    endGroup();
+
+    group_begin = row_begin;
+    beginGroup();
+}
+
+void PairTileScheduler::beginGroup() {
+    if( group_begin >= row_end ) return;
+
+    // align groups and tiles to row blocks so that each tile spans exactly one block
+    group_end = ( group_begin / tile_rows + group_tiles ) * tile_rows;
+    if( group_end > row_end ) {
+        group_end = row_end;
+    }
+
+    gt.pinRows( group_begin, group_end );
+    pinned = true;
+
+    gt.prefetchRows( group_end, group_end + tile_rows );
+
+    tile_begin = group_begin;
+    tile_end = group_end;
+
+    i = group_begin;
+    j = i + 1;
+}
+
+void PairTileScheduler::endGroup() {
+    if( pinned ) {
+        gt.unpinRows( group_begin, group_end );
+        pinned = false;
+    }
+}
+
+bool PairTileScheduler::next( uint &rIdx1, uint &rIdx2 ) {
+    while( group_begin < row_end ) {
+        if( i < group_end ) {
+            if( j < tile_end ) {
+                rIdx1 = i;
+                rIdx2 = j++;
+                return true;
+            }
+
+            ++i;
+            j = (( tile_begin == group_begin ) ? i + 1 : tile_begin );
+        } else if( tile_end < row_end ) {
+            // stream the next tile against the anchor group
+            tile_begin = tile_end;
+            tile_end = ( tile_begin / tile_rows + 1 ) * tile_rows;
+            if( tile_end > row_end ) {
+                tile_end = row_end;
+            }
+
+            gt.prefetchRows( tile_end, tile_end + tile_rows );
+
+            i = group_begin;
+            j = tile_begin;
+        } else {
+            endGroup();
+
+            group_begin = group_end;
+            beginGroup();
+        }
+    }
+    return false;
+}
+
+PairTileScheduler::~PairTileScheduler() {
+    endGroup();
+}
+
+}
+}
@@ -0,0 +1,77 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef PAIR_TILE_SCHEDULER_H
+#define PAIR_TILE_SCHEDULER_H
+
+#include "genetics/genotype/geno_table.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+
+/**
+ * Enumerates every row pair (i, j), with row_begin <= i < j < row_end, in
+ * row block tiles instead of row major order.
+ *
+ * Rows are visited in anchor groups spanning as many row blocks as the table
+ * can keep resident, less one. The anchor group is pinned, the pairs within
+ * the group are visited first, then each following row block is streamed once,
+ * in ascending order, against the whole group. For a paged table every page is
+ * read sequentially once per anchor group; for resident tables the tiles keep
+ * the working set small.
+ */
+class PairTileScheduler {
+public:
+    PairTileScheduler( GenoTable &gt, uint row_begin, uint row_end );
+
+    bool next( uint &rIdx1, uint &rIdx2 );
+    void reset();
+
+    virtual ~PairTileScheduler();
+
+    static const uint DEFAULT_TILE_ROWS;
+protected:
+    void beginGroup();
+    void endGroup();
+
+    GenoTable &gt;
+    uint row_begin, row_end;
+    uint tile_rows, group_tiles;
+
+    uint group_begin, group_end;
+    uint tile_begin, tile_end;
+    uint i, j;
+    bool pinned;
+};
+
+}
+}
+
+#endif // PAIR_TILE_SCHEDULER_H
@@ -0,0 +1,422 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/pca_func.h"
+#include "algorithms/maf_func.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+
+namespace libgwaspp {
+namespace algorithms {
+
+// Jacobi sweeps of the projected eigenproblem
+const uint PCA_MAX_SWEEPS = 100;
+
+static uint ProductThreads( GenoTable & gt, uint nThreads ) {
+    if( !gt.supportsConcurrentReads() ) return 1;
+    return ( nThreads == 0 ) ? GetProcessorCount() : nThreads;
+}
+
+void StandardizeMarkers( GenoTable & gt, uint row_begin, uint row_end, standardized_markers & sm, uint nThreads ) {
+    const uint nRows = row_end - row_begin;
+
+    sm.row_begin = row_begin;
+    sm.row_end = row_end;
+    sm.polymorphic = 0;
+    sm.mean.assign( nRows, 0.0 );
+    sm.inv_sd.assign( nRows, 0.0 );
+
+    vector< frequency_table > dist( nRows );
+    computeGenotypeDistributions( gt, row_begin, row_end, &dist[0], nThreads );
+
+    for( uint i = 0; i < nRows; ++i ) {
+        const frequency_table &ft = dist[ i ];
+        uint called = ft.aa + ft.ab + ft.bb;
+        if( called == 0 ) continue;
+
+        // the B allele is the one counted by the dosage
+        double p = ( double )( ft.ab + 2 * ft.bb ) / ( 2.0 * called );
+        sm.mean[ i ] = 2.0 * p;
+
+        double var = 2.0 * p * ( 1.0 - p );
+        if( var > 0.0 ) {
+            sm.inv_sd[ i ] = 1.0 / sqrt( var );
+            ++sm.polymorphic;
+        }
+    }
+}
+
+struct product_work {
+    GenoTable *gt;
+    const standardized_markers *sm;
+    uint row_begin, row_end;
+    const double *v;
+    uint l;
+    double *out;
+    uint out_row;           // row of the first values of out
+    double *groups;         // 3 * l values per row of the block
+    const double *total;    // column sum of v
+    uint nParts;
+};
+
+/**
+ * The row sums over the AB, BB and missing columns give X v directly: the AA
+ * columns have dosage 0 and the called columns are the total less the missing.
+ */
+static void ProductWorker( void *arg, ulong begin, ulong end ) {
+    product_work &w = *reinterpret_cast< product_work * >( arg );
+    const uint l = w.l;
+
+    double *groups = w.groups + ( begin - w.row_begin ) * 3 * l;
+    w.gt->getGenotypeVectorSums( begin, end, w.v, l, groups );
+
+    for( ulong r = begin; r < end; ++r, groups += 3 * l ) {
+        uint i = r - w.sm->row_begin;
+        double mean = w.sm->mean[ i ], inv_sd = w.sm->inv_sd[ i ];
+        double *o = w.out + ( r - w.out_row ) * l;
+
+        for( uint k = 0; k < l; ++k ) {
+            o[ k ] = inv_sd * ( groups[ k ] + 2.0 * groups[ l + k ] - mean * ( w.total[ k ] - groups[ 2 * l + k ] ) );
+        }
+    }
+}
+
+static void TransposeWorker( void *arg, ulong begin, ulong end ) {
+    product_work &w = *reinterpret_cast< product_work * >( arg );
+
+    for( ulong part = begin; part < end; ++part ) {
+        w.gt->addGenotypeVectorProducts( w.row_begin, w.row_end, w.groups, w.l, part, w.nParts, w.out );
+    }
+}
+
+void multiplyStandardized( GenoTable & gt, uint row_begin, uint row_end, const standardized_markers & sm, const double *v, uint l, double *out, uint nThreads ) {
+    assert( sm.row_begin <= row_begin && row_end <= sm.row_end );
+
+    const uint n = gt.column_size();
+    vector< double > total( l, 0.0 );
+    for( uint c = 0; c < n; ++c ) {
+        for( uint k = 0; k < l; ++k ) {
+            total[ k ] += v[ ( ulong ) c * l + k ];
+        }
+    }
+
+    vector< double > groups( 3 * l * min( PCA_MARKER_BLOCK, row_end - row_begin ) );
+
+    product_work w;
+    w.gt = &gt;
+    w.sm = &sm;
+    w.v = v;
+    w.l = l;
+    w.out = out;
+    w.out_row = row_begin;
+    w.groups = &groups[0];
+    w.total = &total[0];
+    w.nParts = 0;
+
+    nThreads = ProductThreads( gt, nThreads );
+    for( uint r = row_begin; r < row_end; r += PCA_MARKER_BLOCK ) {
+        w.row_begin = r;
+        w.row_end = min( r + PCA_MARKER_BLOCK, row_end );
+        ParallelFor( w.row_begin, w.row_end, ProductWorker, &w, nThreads, 64 );
+    }
+}
+
+/**
+ * Relative to AA, whose standardised dosage -mean * inv_sd every column
+ * receives, AB columns add inv_sd, BB columns 2 * inv_sd and missing columns
+ * mean * inv_sd. The table adds those group values over disjoint parts of
+ * the columns, one part per thread; the AA term is added once at the end.
+ */
+void multiplyStandardizedTranspose( GenoTable & gt, uint row_begin, uint row_end, const standardized_markers & sm, const double *y, uint l, double *out, uint nThreads ) {
+    assert( sm.row_begin <= row_begin && row_end <= sm.row_end );
+
+    const uint n = gt.column_size();
+    vector< double > base( l, 0.0 );
+    vector< double > groups( 3 * l * min( PCA_MARKER_BLOCK, row_end - row_begin ) );
+
+    nThreads = ProductThreads( gt, nThreads );
+
+    product_work w;
+    w.gt = &gt;
+    w.sm = &sm;
+    w.v = NULL;
+    w.l = l;
+    w.out = out;
+    w.out_row = 0;
+    w.groups = &groups[0];
+    w.total = NULL;
+    w.nParts = nThreads;
+
+    for( uint r = row_begin; r < row_end; r += PCA_MARKER_BLOCK ) {
+        w.row_begin = r;
+        w.row_end = min( r + PCA_MARKER_BLOCK, row_end );
+
+        double *g = &groups[0];
+        for( uint i = w.row_begin - sm.row_begin; i < w.row_end - sm.row_begin; ++i, g += 3 * l ) {
+            const double *yi = y + ( ulong ) ( i + sm.row_begin - row_begin ) * l;
+            double mean = sm.mean[ i ], inv_sd = sm.inv_sd[ i ];
+
+            for( uint k = 0; k < l; ++k ) {
+                double s = inv_sd * yi[ k ];
+                g[ k ] = s;
+                g[ l + k ] = 2.0 * s;
+                g[ 2 * l + k ] = mean * s;
+                base[ k ] -= mean * s;
+            }
+        }
+
+        ParallelFor( 0, w.nParts, TransposeWorker, &w, nThreads );
+    }
+
+    for( uint c = 0; c < n; ++c ) {
+        for( uint k = 0; k < l; ++k ) {
+            out[ ( ulong ) c * l + k ] += base[ k ];
+        }
+    }
+}
+
+/**
+ * Modified Gram-Schmidt over the l columns of a, which holds l values per
+ * row, applied twice to keep the columns orthogonal to working precision.
+ * Columns which vanish are left at zero.
+ */
+static void Orthonormalize( double *a, uint n, uint l ) {
+    for( uint pass = 0; pass < 2; ++pass ) {
+        for( uint j = 0; j < l; ++j ) {
+            for( uint i = 0; i < j; ++i ) {
+                double d = 0.0;
+                for( uint c = 0; c < n; ++c ) {
+                    d += a[ ( ulong ) c * l + i ] * a[ ( ulong ) c * l + j ];
+                }
+                for( uint c = 0; c < n; ++c ) {
+                    a[ ( ulong ) c * l + j ] -= d * a[ ( ulong ) c * l + i ];
+                }
+            }
+
+            double norm = 0.0;
+            for( uint c = 0; c < n; ++c ) {
+                norm += a[ ( ulong ) c * l + j ] * a[ ( ulong ) c * l + j ];
+            }
+            norm = sqrt( norm );
+
+            double scale = ( norm > 1e-12 ) ? 1.0 / norm : 0.0;
+            for( uint c = 0; c < n; ++c ) {
+                a[ ( ulong ) c * l + j ] *= scale;
+            }
+        }
+    }
+}
+
+/**
+ * Cyclic Jacobi eigendecomposition of the symmetric l x l matrix a, which is
+ * destroyed. vectors receives the eigenvectors as columns.
+ */
+static void SymmetricEigen( vector< double > & a, uint l, vector< double > & values, vector< double > & vectors ) {
+    vectors.assign( l * l, 0.0 );
+    for( uint i = 0; i < l; ++i ) {
+        vectors[ i * l + i ] = 1.0;
+    }
+
+    for( uint sweep = 0; sweep < PCA_MAX_SWEEPS; ++sweep ) {
+        double off = 0.0, diag = 0.0;
+        for( uint i = 0; i < l; ++i ) {
+            diag += a[ i * l + i ] * a[ i * l + i ];
+            for( uint j = i + 1; j < l; ++j ) {
+                off += a[ i * l + j ] * a[ i * l + j ];
+            }
+        }
+        if( off <= 1e-30 * diag || off == 0.0 ) break;
+
+        for( uint p = 0; p < l; ++p ) {
+            for( uint q = p + 1; q < l; ++q ) {
+                double apq = a[ p * l + q ];
+                if( apq == 0.0 ) continue;
+
+                double theta = ( a[ q * l + q ] - a[ p * l + p ] ) / ( 2.0 * apq );
+                double t = (( theta >= 0.0 ) ? 1.0 : -1.0 ) / ( fabs( theta ) + sqrt( theta * theta + 1.0 ) );
+                double c = 1.0 / sqrt( t * t + 1.0 ), s = t * c;
+
+                for( uint k = 0; k < l; ++k ) {
+                    double akp = a[ k * l + p ], akq = a[ k * l + q ];
+                    a[ k * l + p ] = c * akp - s * akq;
+                    a[ k * l + q ] = s * akp + c * akq;
+                }
+                for( uint k = 0; k < l; ++k ) {
+                    double apk = a[ p * l + k ], aqk = a[ q * l + k ];
+                    a[ p * l + k ] = c * apk - s * aqk;
+                    a[ q * l + k ] = s * apk + c * aqk;
+                }
+                for( uint k = 0; k < l; ++k ) {
+                    double vkp = vectors[ k * l + p ], vkq = vectors[ k * l + q ];
+                    vectors[ k * l + p ] = c * vkp - s * vkq;
+                    vectors[ k * l + q ] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    values.resize( l );
+    for( uint i = 0; i < l; ++i ) {
+        values[ i ] = a[ i * l + i ];
+    }
+}
+
+void computePCA( GenoTable & gt, uint row_begin, uint row_end, const pca_params & params, pca_result & res, uint nThreads ) {
+    const uint n = gt.column_size();
+    const uint l = min( params.components + params.oversampling, n );
+    const uint k = min( params.components, l );
+
+    standardized_markers sm;
+    StandardizeMarkers( gt, row_begin, row_end, sm, nThreads );
+
+    res.n = n;
+    res.k = k;
+    res.markers = sm.polymorphic;
+    res.eigenvalues.assign( k, 0.0 );
+    res.components.assign( ( ulong ) n * k, 0.0 );
+
+    if( k == 0 || sm.polymorphic == 0 ) return;
+
+    vector< double > q( ( ulong ) n * l ), z( ( ulong ) n * l );
+    vector< double > y( ( ulong ) l * min( PCA_MARKER_BLOCK, row_end - row_begin ) );
+
+    gsl_rng *rng = gsl_rng_alloc( gsl_rng_mt19937 );
+    gsl_rng_set( rng, params.seed );
+    for( ulong e = 0; e < q.size(); ++e ) {
+        q[ e ] = gsl_ran_gaussian( rng, 1.0 );
+    }
+    gsl_rng_free( rng );
+
+    Orthonormalize( &q[0], n, l );
+
+    // z = X'X q, a block of rows at a time; the last pass keeps q and z for
+    // the projection
+    for( uint it = 0; it < max( params.iterations, 1u ); ++it ) {
+        if( it > 0 ) {
+            q.swap( z );
+            Orthonormalize( &q[0], n, l );
+        }
+
+        fill( z.begin(), z.end(), 0.0 );
+        for( uint r = row_begin; r < row_end; r += PCA_MARKER_BLOCK ) {
+            uint r_end = min( r + PCA_MARKER_BLOCK, row_end );
+            multiplyStandardized( gt, r, r_end, sm, &q[0], l, &y[0], nThreads );
+            multiplyStandardizedTranspose( gt, r, r_end, sm, &y[0], l, &z[0], nThreads );
+        }
+    }
+
+    // Rayleigh-Ritz: eigenvectors of q'X'X q give those of X'X within q
+    vector< double > t( l * l, 0.0 ), values, vectors;
+    for( uint c = 0; c < n; ++c ) {
+        const double *qc = &q[ ( ulong ) c * l ], *zc = &z[ ( ulong ) c * l ];
+        for( uint i = 0; i < l; ++i ) {
+            for( uint j = 0; j < l; ++j ) {
+                t[ i * l + j ] += qc[ i ] * zc[ j ];
+            }
+        }
+    }
+    for( uint i = 0; i < l; ++i ) {
+        for( uint j = 0; j < i; ++j ) {
+            t[ i * l + j ] = t[ j * l + i ] = 0.5 * ( t[ i * l + j ] + t[ j * l + i ] );
+        }
+    }
+
+    SymmetricEigen( t, l, values, vectors );
+
+    vector< pair< double, uint > > order( l );
+    for( uint i = 0; i < l; ++i ) {
+        order[ i ] = make_pair( -values[ i ], i );
+    }
+    sort( order.begin(), order.end() );
+
+    for( uint j = 0; j < k; ++j ) {
+        uint src = order[ j ].second;
+        res.eigenvalues[ j ] = values[ src ] / sm.polymorphic;
+
+        double largest = 0.0;
+        for( uint c = 0; c < n; ++c ) {
+            double s = 0.0;
+            for( uint i = 0; i < l; ++i ) {
+                s += q[ ( ulong ) c * l + i ] * vectors[ i * l + src ];
+            }
+            res.components[ ( ulong ) c * k + j ] = s;
+            if( fabs( s ) > fabs( largest ) ) {
+                largest = s;
+            }
+        }
+
+        // the sign of an eigenvector is arbitrary; make the largest entry positive
+        if( largest < 0.0 ) {
+            for( uint c = 0; c < n; ++c ) {
+                res.components[ ( ulong ) c * k + j ] = -res.components[ ( ulong ) c * k + j ];
+            }
+        }
+    }
+}
+
+void pca_scan( GeneticData *gd, ostream *out ) {
+    GenoTable &gt = *gd->getGenotypeTable();
+    uint marker_count = gd->getGenotypedMarkersCount();
+    uint n = gt.column_size();
+
+    if( marker_count == 0 || n == 0 ) return;
+
+    cout << "Principal components of " << n << " individuals over " << marker_count << " markers" << endl;
+
+    pca_params params;
+    pca_result res;
+    computePCA( gt, 0, marker_count, params, res );
+
+    cout << res.markers << " polymorphic markers used" << endl;
+    for( uint j = 0; j < res.k; ++j ) {
+        cout << "PC" << ( j + 1 ) << " eigenvalue: " << res.eigenvalues[ j ] << endl;
+    }
+
+    *out << "ID";
+    for( uint j = 0; j < res.k; ++j ) {
+        *out << "\tPC" << ( j + 1 );
+    }
+    *out << "\n";
+
+    for( uint c = 0; c < n; ++c ) {
+        *out << gd->getGenotypedIndividualID( c );
+        for( uint j = 0; j < res.k; ++j ) {
+            *out << "\t" << res.components[ ( ulong ) c * res.k + j ];
+        }
+        *out << "\n";
+    }
+    out->flush();
+}
+
+}
+}
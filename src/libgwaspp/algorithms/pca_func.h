@@ -0,0 +1,123 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef PCA_FUNC_H
+#define PCA_FUNC_H
+
+#include <fstream>
+#include <vector>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/common_genotype.h"
+#include "util/thread/parallel_for.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+// default decomposition: principal components, extra sample vectors carried
+// along to speed up convergence, and passes over the table
+const uint PCA_COMPONENTS = 10;
+const uint PCA_OVERSAMPLING = 10;
+const uint PCA_ITERATIONS = 5;
+const ulong PCA_SEED = 5489;
+
+// rows multiplied at a time; bounds the per-row buffers
+const uint PCA_MARKER_BLOCK = 4096;
+
+/**
+ * Standardisation of the rows [row_begin, row_end) of a table: the dosage g
+ * of a called genotype (0 for AA, 1 for AB, 2 for BB) becomes
+ * ( g - mean ) * inv_sd, with mean = 2p and sd = sqrt( 2p(1 - p) ) from the
+ * genotype distribution of the row. Missing genotypes become 0. Rows which
+ * are monomorphic or never called have inv_sd 0 and so drop out.
+ */
+struct standardized_markers {
+    uint row_begin, row_end;
+    uint polymorphic;       // rows with inv_sd > 0
+    vector< double > mean, inv_sd;
+};
+
+void StandardizeMarkers( GenoTable & gt, uint row_begin, uint row_end, standardized_markers & sm, uint nThreads = 0 );
+
+/**
+ * Products of the standardised genotype matrix X (rows of sm x columns of gt)
+ * with blocks of l vectors, computed on the 2-bit streams: only the AB, BB
+ * and missing genotypes of a row are visited, the AA genotypes follow from
+ * the totals. The rows [row_begin, row_end) must lie within sm.
+ *
+ * multiplyStandardized: out = X v, with v holding l values per column and out
+ * l values per row.
+ *
+ * multiplyStandardizedTranspose: out += X' y, with y holding l values per row
+ * and out l values per column.
+ */
+void multiplyStandardized( GenoTable & gt, uint row_begin, uint row_end, const standardized_markers & sm, const double *v, uint l, double *out, uint nThreads = 0 );
+void multiplyStandardizedTranspose( GenoTable & gt, uint row_begin, uint row_end, const standardized_markers & sm, const double *y, uint l, double *out, uint nThreads = 0 );
+
+struct pca_params {
+    uint components;
+    uint oversampling;
+    uint iterations;
+    ulong seed;
+
+    pca_params() : components( PCA_COMPONENTS ), oversampling( PCA_OVERSAMPLING ), iterations( PCA_ITERATIONS ), seed( PCA_SEED ) {}
+};
+
+/**
+ * Leading eigenvectors of the genomic relationship matrix X'X / markers, with
+ * markers the polymorphic rows. components holds k values per column (the
+ * principal components of each individual, unit length over the
+ * individuals); eigenvalues the k matching eigenvalues, largest first.
+ */
+struct pca_result {
+    uint n, k;
+    uint markers;
+    vector< double > eigenvalues;
+    vector< double > components;
+};
+
+/**
+ * Randomized subspace iteration: a block of components + oversampling random
+ * sample vectors is multiplied by X'X and orthonormalised once per
+ * iteration, then the leading eigenvectors are taken from the projection of
+ * X'X onto the block. Each iteration is a single pass over the rows; besides
+ * the table only a few blocks of sample vectors are held. Only the 2-bit
+ * stream tables are supported.
+ */
+void computePCA( GenoTable & gt, uint row_begin, uint row_end, const pca_params & params, pca_result & res, uint nThreads = 0 );
+
+void pca_scan( GeneticData *gd, ostream *out );
+
+}
+}
+
+#endif // PCA_FUNC_H
@@ -0,0 +1,151 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/qt_func.h"
+
+#include <cmath>
+
+namespace libgwaspp {
+namespace algorithms {
+
+void QTStatistics( const trait_sums * sums, uint n, const QuantitativeTraitSet & qts, qt_result * res ) {
+    const double scale = qts.getScale();
+
+    for( uint i = 0; i < n; ++i ) {
+        const trait_sums &ts = sums[i];
+        qt_result &r = res[i];
+
+        double N = ( double ) ts.count.aa + ts.count.ab + ts.count.bb;
+
+        double sx = ( double ) ts.count.ab + 2.0 * ts.count.bb;
+        double sxx = ( double ) ts.count.ab + 4.0 * ts.count.bb;
+        double sy = ( double ) ts.sum[0] + ( double ) ts.sum[1] + ( double ) ts.sum[2];
+        double sxy = ( double ) ts.sum[1] + 2.0 * ( double ) ts.sum[2];
+        double syy = ( double ) ts.square_sum_called;
+
+        r.n = ( uint ) N;
+        r.beta = 0.0;
+        r.se = 0.0;
+        r.t = 0.0;
+        r.pval = 1.0;
+        r.r2 = 0.0;
+
+        if( N < 3.0 ) continue;
+
+        double ss_x = sxx - sx * sx / N;
+        double ss_xy = sxy - sx * sy / N;
+        double ss_y = syy - sy * sy / N;
+
+        if( ss_x <= 0.0 || ss_y <= 0.0 ) continue;
+
+        double b = ss_xy / ss_x;
+        double rss = ss_y - b * ss_xy;
+        if( rss < 0.0 ) rss = 0.0;
+
+        double se = sqrt( rss / ( N - 2.0 ) / ss_x );
+
+        r.beta = b / scale;
+        r.se = se / scale;
+        r.r2 = ss_xy * ss_xy / ( ss_x * ss_y );
+
+        if( se > 0.0 ) {
+            r.t = b / se;
+            r.pval = 2.0 * pt( -fabs( r.t ), N - 2.0, 1, 0 );
+        } else {
+            r.pval = 0.0;
+        }
+    }
+}
+
+struct qt_work {
+    GenoTable *gt;
+    QuantitativeTraitSet *qts;
+    uint row_begin, row_end;
+    qt_result *res;
+};
+
+static void QTWorker( void *arg, ulong begin, ulong end ) {
+    qt_work &w = *reinterpret_cast< qt_work * >( arg );
+    vector< trait_sums > sums( QT_BLOCK_SIZE );
+
+    for( ulong b = begin; b < end; ++b ) {
+        uint r0 = w.row_begin + b * QT_BLOCK_SIZE;
+        uint r1 = min( r0 + QT_BLOCK_SIZE, w.row_end );
+
+        w.gt->getTraitSums( r0, r1, *w.qts, &sums[0] );
+        QTStatistics( &sums[0], r1 - r0, *w.qts, w.res + ( r0 - w.row_begin ) );
+    }
+}
+
+void computeQTAssociation( GenoTable & gt, QuantitativeTraitSet & qts, uint row_begin, uint row_end, qt_result * res, uint nThreads ) {
+    if( row_end <= row_begin ) return;
+
+    if( !gt.supportsConcurrentReads() ) {
+        nThreads = 1;
+    } else {
+        // the first read lets the table set up its trait planes before the threads share them
+        trait_sums ts;
+        gt.getTraitSums( row_begin, row_begin + 1, qts, &ts );
+    }
+
+    qt_work w;
+    w.gt = &gt;
+    w.qts = &qts;
+    w.row_begin = row_begin;
+    w.row_end = row_end;
+    w.res = res;
+
+    ulong nBlocks = ( row_end - row_begin + QT_BLOCK_SIZE - 1 ) / QT_BLOCK_SIZE;
+    ParallelFor( 0, nBlocks, QTWorker, &w, nThreads );
+}
+
+void qt_scan( GeneticData *gd, ostream *out ) {
+    uint marker_count = gd->getGenotypedMarkersCount();
+    GenoTable &gt = *gd->getGenotypeTable();
+
+    assert( gd->getQuantitativeTraitSet() != NULL );
+    QuantitativeTraitSet &qts = *gd->getQuantitativeTraitSet();
+
+    if( marker_count == 0 ) return;
+
+    cout << "Quantitative trait association of " << marker_count << " markers (" << qts.getCount() << " individuals with a trait value, "
+         << qts.getValueBits() << " bit values)" << endl;
+
+    vector< qt_result > res( marker_count );
+    computeQTAssociation( gt, qts, 0, marker_count, &res[0] );
+
+    *out << "MARKER\tN\tBETA\tSE\tT\tP\tR2\n";
+    for( uint i = 0; i < marker_count; ++i ) {
+        const qt_result &r = res[i];
+        *out << gd->getGenotypedMarkerID( i ) << "\t" << r.n << "\t" << r.beta << "\t" << r.se << "\t" << r.t << "\t" << r.pval << "\t" << r.r2 << "\n";
+    }
+    out->flush();
+}
+
+}
+}
@@ -0,0 +1,77 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef QT_FUNC_H
+#define QT_FUNC_H
+
+#include <fstream>
+#include <vector>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/common_genotype_func.h"
+#include "genetics/analyzable/quantitative_trait_set.h"
+#include "util/thread/parallel_for.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+// markers whose trait sums are gathered before the statistics are computed
+const uint QT_BLOCK_SIZE = 1024;
+
+/**
+ * Least squares fit of trait = a + beta * dosage, with the dosage of a marker
+ * the number of copies of its second allele (AA = 0, AB = 1, BB = 2). Only
+ * individuals with a trait value and a called genotype are included.
+ */
+struct qt_result {
+    uint n;             // individuals in the fit
+    double beta, se;    // in trait units
+    double t, pval;     // t = beta / se on n - 2 df
+    double r2;
+};
+
+// res[i] from sums[i]; the sums are in the fixed-point units of qts
+void QTStatistics( const trait_sums * sums, uint n, const QuantitativeTraitSet & qts, qt_result * res );
+
+/**
+ * Tests rows [row_begin, row_end) of gt against the trait in qts; res holds
+ * row_end - row_begin results. The rows are split into blocks over the
+ * threads when the table supports concurrent reads.
+ */
+void computeQTAssociation( GenoTable & gt, QuantitativeTraitSet & qts, uint row_begin, uint row_end, qt_result * res, uint nThreads = 0 );
+
+void qt_scan( GeneticData *gd, ostream *out );
+
+}
+}
+
+#endif // QT_FUNC_H
@@ -0,0 +1,345 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/relationship_func.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace libgwaspp {
+namespace algorithms {
+
+const uint RELATIONSHIP_BLOCK_WORDS = RELATIONSHIP_MARKER_BLOCK / 64;
+
+/**
+ * A block of markers in sample-major order. Sample c owns the words
+ * [c * RELATIONSHIP_BLOCK_WORDS, (c + 1) * RELATIONSHIP_BLOCK_WORDS) of each
+ * plane, bit k of which belongs to marker k of the block: aa is set for AA
+ * and BB, ab for AB and BB, as in the streams of the table. z holds the
+ * standardised dosages, RELATIONSHIP_MARKER_BLOCK per sample. The samples
+ * are padded to whole tiles; padding is never called.
+ */
+struct relationship_block {
+    uint n, n_pad;
+    uint markers;
+    vector< byte > codes;
+    vector< ulong > aa, ab;
+    vector< ulong > poly;       // markers which are not monomorphic
+    vector< double > z;
+};
+
+void ResetRelationshipMatrix( relationship_matrix & rm, uint n, bool with_grm, bool with_ibs ) {
+    ulong entries = TriangleIndex( n, 0 );
+
+    rm.n = n;
+    rm.with_grm = with_grm;
+    rm.with_ibs = with_ibs;
+
+    rm.grm_sum.assign( with_grm ? entries : 0, 0.0 );
+    rm.grm_count.assign( with_grm ? entries : 0, 0 );
+
+    rm.called.assign( with_ibs ? entries : 0, 0 );
+    rm.ibs0.assign( with_ibs ? entries : 0, 0 );
+    rm.ibs2.assign( with_ibs ? entries : 0, 0 );
+}
+
+static void TransposeBlock( GenoTable & gt, uint row_begin, uint row_end, bool with_grm, relationship_block & blk ) {
+    const uint n = blk.n;
+
+    blk.markers = row_end - row_begin;
+    gt.getGenotypeCodes( row_begin, row_end, &blk.codes[0] );
+
+    fill( blk.aa.begin(), blk.aa.end(), 0 );
+    fill( blk.ab.begin(), blk.ab.end(), 0 );
+    fill( blk.poly.begin(), blk.poly.end(), 0 );
+
+    for( uint k = 0; k < blk.markers; ++k ) {
+        const byte *codes = &blk.codes[ ( ulong ) k * n ];
+
+        uint called = 0, dosage = 0;
+        for( uint c = 0; c < n; ++c ) {
+            if( codes[c] != STREAM_CODE_MISSING ) {
+                ++called;
+                dosage += codes[c] - 1;
+            }
+        }
+
+        const uint w = k / 64;
+        const ulong bit = 1UL << ( k % 64 );
+
+        bool polymorphic = ( dosage > 0 && dosage < 2 * called );
+        if( polymorphic ) {
+            blk.poly[ w ] |= bit;
+        }
+
+        // the low bit of a code is its aa stream bit, the high bit its ab stream bit
+        ulong *aa = &blk.aa[ w ], *ab = &blk.ab[ w ];
+        for( uint c = 0; c < n; ++c, aa += RELATIONSHIP_BLOCK_WORDS, ab += RELATIONSHIP_BLOCK_WORDS ) {
+            if( codes[c] & 1 ) *aa |= bit;
+            if( codes[c] & 2 ) *ab |= bit;
+        }
+
+        if( !with_grm ) continue;
+
+        double p = (( called > 0 ) ? ( double ) dosage / ( 2.0 * called ) : 0.0 );
+        double scale = (( polymorphic ) ? 1.0 / sqrt( 2.0 * p * ( 1.0 - p ) ) : 0.0 );
+
+        double *z = &blk.z[ k ];
+        for( uint c = 0; c < n; ++c, z += RELATIONSHIP_MARKER_BLOCK ) {
+            *z = (( codes[c] != STREAM_CODE_MISSING ) ? ( codes[c] - 1 - 2.0 * p ) * scale : 0.0 );
+        }
+    }
+}
+
+/**
+ * Pair counts of the samples [i0, i0 + 4) and [j0, j0 + 4) over the words of
+ * the block, kept in registers until the block is done.
+ */
+static void IBSMicroTile( const relationship_block & blk, uint i0, uint j0, bool with_grm, uint called[4][4], uint ibs0[4][4], uint ibs2[4][4], uint grm_count[4][4] ) {
+    const ulong *aa_i = &blk.aa[ ( ulong ) i0 * RELATIONSHIP_BLOCK_WORDS ], *ab_i = &blk.ab[ ( ulong ) i0 * RELATIONSHIP_BLOCK_WORDS ];
+    const ulong *aa_j = &blk.aa[ ( ulong ) j0 * RELATIONSHIP_BLOCK_WORDS ], *ab_j = &blk.ab[ ( ulong ) j0 * RELATIONSHIP_BLOCK_WORDS ];
+
+    for( uint w = 0; w < RELATIONSHIP_BLOCK_WORDS; ++w ) {
+        ulong ai[4], bi[4], ci[4], aj[4], bj[4], cj[4];
+        for( uint a = 0; a < RELATIONSHIP_MICRO_TILE; ++a ) {
+            ai[a] = aa_i[ a * RELATIONSHIP_BLOCK_WORDS + w ];
+            bi[a] = ab_i[ a * RELATIONSHIP_BLOCK_WORDS + w ];
+            ci[a] = ai[a] | bi[a];
+            aj[a] = aa_j[ a * RELATIONSHIP_BLOCK_WORDS + w ];
+            bj[a] = ab_j[ a * RELATIONSHIP_BLOCK_WORDS + w ];
+            cj[a] = aj[a] | bj[a];
+        }
+
+        const ulong poly = blk.poly[ w ];
+        for( uint a = 0; a < RELATIONSHIP_MICRO_TILE; ++a ) {
+            for( uint b = 0; b < RELATIONSHIP_MICRO_TILE; ++b ) {
+                ulong both = ci[a] & cj[b];
+                if( !both ) continue;
+
+                called[a][b] += PopCount( both );
+                ibs2[a][b] += PopCount( both & ~(( ai[a] ^ aj[b] ) | ( bi[a] ^ bj[b] )) );
+                ibs0[a][b] += PopCount( ai[a] & aj[b] & ( bi[a] ^ bj[b] ) );
+
+                if( with_grm ) {
+                    grm_count[a][b] += PopCount( both & poly );
+                }
+            }
+        }
+    }
+}
+
+// sum of z_i * z_j of the samples [i0, i0 + 4) and [j0, j0 + 4) over the block
+static void GRMMicroTile( const relationship_block & blk, uint i0, uint j0, double sum[4][4] ) {
+    const double *zi = &blk.z[ ( ulong ) i0 * RELATIONSHIP_MARKER_BLOCK ];
+    const double *zj = &blk.z[ ( ulong ) j0 * RELATIONSHIP_MARKER_BLOCK ];
+
+    double s[4][4];
+    memset( s, 0, sizeof( s ) );
+
+    for( uint k = 0; k < blk.markers; ++k ) {
+        double x[4], y[4];
+        for( uint a = 0; a < RELATIONSHIP_MICRO_TILE; ++a ) {
+            x[a] = zi[ a * RELATIONSHIP_MARKER_BLOCK + k ];
+            y[a] = zj[ a * RELATIONSHIP_MARKER_BLOCK + k ];
+        }
+        for( uint a = 0; a < RELATIONSHIP_MICRO_TILE; ++a ) {
+            for( uint b = 0; b < RELATIONSHIP_MICRO_TILE; ++b ) {
+                s[a][b] += x[a] * y[b];
+            }
+        }
+    }
+
+    memcpy( sum, s, sizeof( s ) );
+}
+
+static void AccumulateMicroTile( const relationship_block & blk, uint i0, uint j0, relationship_matrix & rm ) {
+    uint called[4][4], ibs0[4][4], ibs2[4][4], grm_count[4][4];
+    double grm_sum[4][4];
+
+    memset( called, 0, sizeof( called ) );
+    memset( ibs0, 0, sizeof( ibs0 ) );
+    memset( ibs2, 0, sizeof( ibs2 ) );
+    memset( grm_count, 0, sizeof( grm_count ) );
+
+    IBSMicroTile( blk, i0, j0, rm.with_grm, called, ibs0, ibs2, grm_count );
+    if( rm.with_grm ) {
+        GRMMicroTile( blk, i0, j0, grm_sum );
+    }
+
+    for( uint a = 0; a < RELATIONSHIP_MICRO_TILE && i0 + a < blk.n; ++a ) {
+        uint i = i0 + a;
+        ulong row = TriangleIndex( i, 0 );
+        for( uint b = 0; b < RELATIONSHIP_MICRO_TILE && j0 + b <= i; ++b ) {
+            ulong e = row + j0 + b;
+            if( rm.with_ibs ) {
+                rm.called[ e ] += called[a][b];
+                rm.ibs0[ e ] += ibs0[a][b];
+                rm.ibs2[ e ] += ibs2[a][b];
+            }
+            if( rm.with_grm ) {
+                rm.grm_sum[ e ] += grm_sum[a][b];
+                rm.grm_count[ e ] += grm_count[a][b];
+            }
+        }
+    }
+}
+
+struct relationship_work {
+    const relationship_block *blk;
+    relationship_matrix *rm;
+    uint tiles, nThreads;
+};
+
+static void RelationshipWorker( void *arg, ulong begin, ulong end ) {
+    relationship_work &w = *reinterpret_cast< relationship_work * >( arg );
+    const relationship_block &blk = *w.blk;
+
+    // thread b takes every nThreads-th row of tiles; every entry of the
+    // triangle belongs to exactly one tile
+    for( ulong b = begin; b < end; ++b ) {
+        for( uint I = b; I < w.tiles; I += w.nThreads ) {
+            uint i_begin = I * RELATIONSHIP_SAMPLE_TILE, i_end = min( i_begin + RELATIONSHIP_SAMPLE_TILE, blk.n );
+
+            for( uint J = 0; J <= I; ++J ) {
+                uint j_begin = J * RELATIONSHIP_SAMPLE_TILE;
+
+                for( uint i0 = i_begin; i0 < i_end; i0 += RELATIONSHIP_MICRO_TILE ) {
+                    uint j_end = min( j_begin + RELATIONSHIP_SAMPLE_TILE, i0 + RELATIONSHIP_MICRO_TILE );
+                    for( uint j0 = j_begin; j0 < j_end; j0 += RELATIONSHIP_MICRO_TILE ) {
+                        AccumulateMicroTile( blk, i0, j0, *w.rm );
+                    }
+                }
+            }
+        }
+    }
+}
+
+void computeRelationship( GenoTable & gt, uint row_begin, uint row_end, relationship_matrix & rm, uint nThreads ) {
+    assert( rm.n == ( uint ) gt.column_size() );
+    if( row_end <= row_begin || rm.n == 0 ) return;
+
+    relationship_block blk;
+    blk.n = rm.n;
+    blk.n_pad = ( rm.n + RELATIONSHIP_SAMPLE_TILE - 1 ) / RELATIONSHIP_SAMPLE_TILE * RELATIONSHIP_SAMPLE_TILE;
+    blk.codes.resize( ( ulong ) RELATIONSHIP_MARKER_BLOCK * rm.n );
+    blk.aa.resize( ( ulong ) blk.n_pad * RELATIONSHIP_BLOCK_WORDS );
+    blk.ab.resize( ( ulong ) blk.n_pad * RELATIONSHIP_BLOCK_WORDS );
+    blk.poly.resize( RELATIONSHIP_BLOCK_WORDS );
+    if( rm.with_grm ) {
+        blk.z.assign( ( ulong ) blk.n_pad * RELATIONSHIP_MARKER_BLOCK, 0.0 );
+    }
+
+    relationship_work w;
+    w.blk = &blk;
+    w.rm = &rm;
+    w.tiles = blk.n_pad / RELATIONSHIP_SAMPLE_TILE;
+
+    if( nThreads == 0 ) {
+        nThreads = GetProcessorCount();
+    }
+    w.nThreads = min( nThreads, w.tiles );
+
+    // the table is only read here, so every table type may be used
+    for( uint r = row_begin; r < row_end; r += RELATIONSHIP_MARKER_BLOCK ) {
+        TransposeBlock( gt, r, min( r + RELATIONSHIP_MARKER_BLOCK, row_end ), rm.with_grm, blk );
+        ParallelFor( 0, w.nThreads, RelationshipWorker, &w, w.nThreads );
+    }
+}
+
+void writeGRM( const relationship_matrix & rm, ostream & out ) {
+    assert( rm.with_grm );
+
+    const ulong entries = TriangleIndex( rm.n, 0 );
+    vector< float > buffer;
+    buffer.reserve( 0x10000 );
+
+    for( ulong e = 0; e < entries; ++e ) {
+        buffer.push_back(( rm.grm_count[ e ] > 0 ) ? ( float )( rm.grm_sum[ e ] / rm.grm_count[ e ] ) : 0.0f );
+        if( buffer.size() == buffer.capacity() || e + 1 == entries ) {
+            out.write( reinterpret_cast< const char * >( &buffer[0] ), buffer.size() * sizeof( float ) );
+            buffer.clear();
+        }
+    }
+    out.flush();
+}
+
+void writeIBS( const relationship_matrix & rm, ostream & out ) {
+    assert( rm.with_ibs );
+
+    const ulong entries = TriangleIndex( rm.n, 0 );
+    vector< uint > buffer;
+    buffer.reserve( 3 * 0x10000 );
+
+    for( ulong e = 0; e < entries; ++e ) {
+        buffer.push_back( rm.ibs0[ e ] );
+        buffer.push_back( rm.called[ e ] - rm.ibs0[ e ] - rm.ibs2[ e ] );
+        buffer.push_back( rm.ibs2[ e ] );
+        if( buffer.size() == buffer.capacity() || e + 1 == entries ) {
+            out.write( reinterpret_cast< const char * >( &buffer[0] ), buffer.size() * sizeof( uint ) );
+            buffer.clear();
+        }
+    }
+    out.flush();
+}
+
+void grm_scan( GeneticData *gd, ostream *out ) {
+    GenoTable &gt = *gd->getGenotypeTable();
+    uint marker_count = gd->getGenotypedMarkersCount();
+    uint n = gt.column_size();
+
+    if( marker_count == 0 || n == 0 ) return;
+
+    cout << "Genomic relationship matrix of " << n << " individuals over " << marker_count << " markers" << endl;
+
+    relationship_matrix rm;
+    ResetRelationshipMatrix( rm, n, true, false );
+    computeRelationship( gt, 0, marker_count, rm );
+    writeGRM( rm, *out );
+
+    cout << "Wrote " << TriangleIndex( n, 0 ) << " 32-bit floats: the lower triangle by rows, individuals in table order" << endl;
+}
+
+void ibs_scan( GeneticData *gd, ostream *out ) {
+    GenoTable &gt = *gd->getGenotypeTable();
+    uint marker_count = gd->getGenotypedMarkersCount();
+    uint n = gt.column_size();
+
+    if( marker_count == 0 || n == 0 ) return;
+
+    cout << "IBS counts of " << n << " individuals over " << marker_count << " markers" << endl;
+
+    relationship_matrix rm;
+    ResetRelationshipMatrix( rm, n, false, true );
+    computeRelationship( gt, 0, marker_count, rm );
+    writeIBS( rm, *out );
+
+    cout << "Wrote " << TriangleIndex( n, 0 ) << " IBS0, IBS1, IBS2 triples of 32-bit counts: the lower triangle by rows, individuals in table order" << endl;
+}
+
+}
+}
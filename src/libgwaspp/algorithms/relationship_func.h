@@ -0,0 +1,106 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef RELATIONSHIP_FUNC_H
+#define RELATIONSHIP_FUNC_H
+
+#include <fstream>
+#include <vector>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/common_genotype.h"
+#include "genetics/genotype/common_genotype_func.h"
+#include "util/thread/parallel_for.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+// markers transposed to sample-major planes at a time; a multiple of 64
+const uint RELATIONSHIP_MARKER_BLOCK = 256;
+
+// samples of a cache tile of the matrix; a multiple of RELATIONSHIP_MICRO_TILE
+const uint RELATIONSHIP_SAMPLE_TILE = 64;
+
+// samples on each side of the register block of the kernels
+const uint RELATIONSHIP_MICRO_TILE = 4;
+
+/**
+ * Sample x sample relationship counts, accumulated over blocks of markers.
+ * The matrices are stored as their lower triangle by rows, diagonal included;
+ * TriangleIndex gives the position of an entry.
+ *
+ * GRM: grm_sum holds the sum of z_i * z_j over the markers called in both
+ * samples, with z the genotype dosage standardised by the allele frequency of
+ * the marker, and grm_count the number of those markers. Monomorphic markers
+ * are not counted.
+ *
+ * IBS: of the markers called in both samples, ibs0 counts those which share
+ * no allele (opposite homozygotes) and ibs2 those with the same genotype.
+ */
+struct relationship_matrix {
+    uint n;
+    bool with_grm, with_ibs;
+
+    vector< double > grm_sum;
+    vector< uint > grm_count;
+
+    vector< uint > called, ibs0, ibs2;
+};
+
+inline ulong TriangleIndex( ulong i, ulong j ) {
+    return i * ( i + 1 ) / 2 + j;
+}
+
+void ResetRelationshipMatrix( relationship_matrix & rm, uint n, bool with_grm, bool with_ibs );
+
+/**
+ * Adds the rows [row_begin, row_end) of gt to rm, which holds gt.column_size()
+ * samples. The rows are read a block at a time, transposed into sample-major
+ * bit-planes (and standardised dosages for the GRM), and the tiles of the
+ * matrix are spread over the threads. Only the 2-bit stream tables are
+ * supported.
+ */
+void computeRelationship( GenoTable & gt, uint row_begin, uint row_end, relationship_matrix & rm, uint nThreads = 0 );
+
+// grm_sum / grm_count as 32-bit floats, in the lower triangle order
+void writeGRM( const relationship_matrix & rm, ostream & out );
+
+// IBS0, IBS1 and IBS2 counts as 32-bit unsigned integers, in the lower triangle order
+void writeIBS( const relationship_matrix & rm, ostream & out );
+
+void grm_scan( GeneticData *gd, ostream *out );
+void ibs_scan( GeneticData *gd, ostream *out );
+
+}
+}
+
+#endif // RELATIONSHIP_FUNC_H
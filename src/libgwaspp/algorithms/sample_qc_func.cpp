@@ -0,0 +1,268 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "algorithms/sample_qc_func.h"
+#include "algorithms/maf_func.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+struct sample_count_work {
+    GenoTable *gt;
+    uint row_begin, row_end, nChunks, nColumns;
+    frequency_table **columns;      // tables of every chunk
+};
+
+static void SampleCountWorker( void *arg, ulong begin, ulong end ) {
+    sample_count_work &w = *reinterpret_cast< sample_count_work * >( arg );
+    const ulong nRows = w.row_end - w.row_begin;
+
+    for( ulong k = begin; k < end; ++k ) {
+        uint r0 = w.row_begin + ( uint )( nRows * k / w.nChunks );
+        uint r1 = w.row_begin + ( uint )( nRows * ( k + 1 ) / w.nChunks );
+
+        for( uint r = r0; r < r1; r += SAMPLE_QC_BLOCK_SIZE ) {
+            w.gt->addColumnGenotypeCounts( r, min( r + SAMPLE_QC_BLOCK_SIZE, r1 ), w.columns[ k ] );
+        }
+    }
+}
+
+void computeSampleCounts( GenoTable & gt, uint row_begin, uint row_end, frequency_table * columns, uint nThreads ) {
+    if( row_end <= row_begin ) return;
+
+    if( !gt.supportsConcurrentReads() ) {
+        nThreads = 1;
+    } else if( nThreads == 0 ) {
+        nThreads = GetProcessorCount();
+    }
+
+    uint nChunks = ( row_end - row_begin + SAMPLE_QC_BLOCK_SIZE - 1 ) / SAMPLE_QC_BLOCK_SIZE;
+    if( nChunks > nThreads ) nChunks = nThreads;
+
+    sample_count_work w;
+    w.gt = &gt;
+    w.row_begin = row_begin;
+    w.row_end = row_end;
+    w.nChunks = nChunks;
+    w.nColumns = gt.column_size();
+
+    // the first chunk adds to the caller's tables
+    vector< frequency_table * > chunk_columns( nChunks, columns );
+    for( uint k = 1; k < nChunks; ++k ) {
+        chunk_columns[ k ] = new frequency_table[ w.nColumns ];
+        for( uint c = 0; c < w.nColumns; ++c ) {
+            ResetFrequencyTable( chunk_columns[ k ][ c ] );
+        }
+    }
+    w.columns = &chunk_columns[0];
+
+    ParallelFor( 0, nChunks, SampleCountWorker, &w, nChunks );
+
+    for( uint k = 1; k < nChunks; ++k ) {
+        const frequency_table *part = chunk_columns[ k ];
+        for( uint c = 0; c < w.nColumns; ++c ) {
+            columns[ c ].aa += part[ c ].aa;
+            columns[ c ].ab += part[ c ].ab;
+            columns[ c ].bb += part[ c ].bb;
+            columns[ c ].xx += part[ c ].xx;
+        }
+        delete [] chunk_columns[ k ];
+    }
+}
+
+struct missing_hom_work {
+    GenoTable *gt;
+    uint row_begin, row_end, nParts;
+    const double *groups;       // AB, BB and missing weights of every row
+    double *hom;
+};
+
+static void MissingHomWorker( void *arg, ulong begin, ulong end ) {
+    missing_hom_work &w = *reinterpret_cast< missing_hom_work * >( arg );
+
+    for( ulong part = begin; part < end; ++part ) {
+        w.gt->addGenotypeVectorProducts( w.row_begin, w.row_end, w.groups, 1, part, w.nParts, w.hom );
+    }
+}
+
+/**
+ * The transpose vector kernel with a weight on the missing group only: each
+ * row adds e_hom to the columns which miss it, over disjoint column parts.
+ */
+void computeMissingHomozygosity( GenoTable & gt, uint row_begin, uint row_end, const double * e_hom, double * hom, uint nThreads ) {
+    if( row_end <= row_begin ) return;
+
+    if( !gt.supportsConcurrentReads() ) {
+        nThreads = 1;
+    } else if( nThreads == 0 ) {
+        nThreads = GetProcessorCount();
+    }
+
+    vector< double > groups( 3 * min( SAMPLE_QC_BLOCK_SIZE, row_end - row_begin ), 0.0 );
+
+    missing_hom_work w;
+    w.gt = &gt;
+    w.nParts = nThreads;
+    w.groups = &groups[0];
+    w.hom = hom;
+
+    for( uint r = row_begin; r < row_end; r += SAMPLE_QC_BLOCK_SIZE ) {
+        w.row_begin = r;
+        w.row_end = min( r + SAMPLE_QC_BLOCK_SIZE, row_end );
+
+        for( uint i = w.row_begin; i < w.row_end; ++i ) {
+            groups[ 3 * ( i - r ) + 2 ] = e_hom[ i ];
+        }
+
+        ParallelFor( 0, w.nParts, MissingHomWorker, &w, nThreads );
+    }
+}
+
+/**
+ * Rows whose minor allele is B weigh the BB group by 1. Rows whose minor
+ * allele is A count AA = 1 - AB - BB - missing: they add 1 to every column
+ * and weigh the other three groups by -1.
+ */
+void computeMinorHomozygotes( GenoTable & gt, uint row_begin, uint row_end, const frequency_table * dist, double * hom, uint nThreads ) {
+    if( row_end <= row_begin ) return;
+
+    if( !gt.supportsConcurrentReads() ) {
+        nThreads = 1;
+    } else if( nThreads == 0 ) {
+        nThreads = GetProcessorCount();
+    }
+
+    vector< double > groups( 3 * min( SAMPLE_QC_BLOCK_SIZE, row_end - row_begin ), 0.0 );
+
+    missing_hom_work w;
+    w.gt = &gt;
+    w.nParts = nThreads;
+    w.groups = &groups[0];
+    w.hom = hom;
+
+    uint nMinorAA = 0;
+    for( uint r = row_begin; r < row_end; r += SAMPLE_QC_BLOCK_SIZE ) {
+        w.row_begin = r;
+        w.row_end = min( r + SAMPLE_QC_BLOCK_SIZE, row_end );
+
+        for( uint i = w.row_begin; i < w.row_end; ++i ) {
+            double *g = &groups[ 3 * ( i - r ) ];
+            if( dist[i].aa < dist[i].bb ) {
+                g[0] = g[1] = g[2] = -1.0;
+                ++nMinorAA;
+            } else {
+                g[0] = g[2] = 0.0;
+                g[1] = ( dist[i].bb < dist[i].aa ) ? 1.0 : 0.0;
+            }
+        }
+
+        ParallelFor( 0, w.nParts, MissingHomWorker, &w, nThreads );
+    }
+
+    for( uint c = 0; c < gt.column_size(); ++c ) {
+        hom[c] += nMinorAA;
+    }
+}
+
+void computeSampleQC( GenoTable & gt, sample_qc_result * res, uint nThreads ) {
+    vector< frequency_table > dist( gt.row_size() );
+    computeGenotypeDistributions( gt, 0, gt.row_size(), &dist[0], nThreads );
+
+    computeSampleQC( gt, &dist[0], res, nThreads );
+}
+
+void computeSampleQC( GenoTable & gt, const frequency_table * dist, sample_qc_result * res, uint nThreads ) {
+    uint marker_count = gt.row_size(), individ_count = gt.column_size();
+
+    // expected homozygosity of every marker; markers without calls add nothing
+    vector< double > e_hom( marker_count, 0.0 );
+    double total_hom = 0.0;
+    for( uint i = 0; i < marker_count; ++i ) {
+        uint n = dist[i].aa + dist[i].ab + dist[i].bb;
+        if( n == 0 ) continue;
+
+        double p = ( 2.0 * dist[i].aa + dist[i].ab ) / ( 2.0 * n );
+        e_hom[i] = 1.0 - 2.0 * p * ( 1.0 - p );
+        total_hom += e_hom[i];
+    }
+
+    // a sample expects the homozygosity of every marker less that of its missing markers
+    vector< double > missing_hom( individ_count, 0.0 );
+    if( marker_count > 0 ) {
+        computeMissingHomozygosity( gt, 0, marker_count, &e_hom[0], &missing_hom[0], nThreads );
+    }
+
+    vector< frequency_table > columns( individ_count );
+    for( uint c = 0; c < individ_count; ++c ) {
+        ResetFrequencyTable( columns[c] );
+    }
+    computeSampleCounts( gt, 0, marker_count, &columns[0], nThreads );
+
+    vector< double > hom_minor( individ_count, 0.0 );
+    if( marker_count > 0 ) {
+        computeMinorHomozygotes( gt, 0, marker_count, dist, &hom_minor[0], nThreads );
+    }
+
+    for( uint c = 0; c < individ_count; ++c ) {
+        sample_qc_result &s = res[c];
+        CopyFrequencyTable( s.counts, columns[c] );
+        s.hom_minor = ( uint )( hom_minor[c] + 0.5 );
+
+        uint called = s.counts.aa + s.counts.ab + s.counts.bb;
+        double o_hom = s.counts.aa + s.counts.bb;
+
+        s.call_rate = ( marker_count > 0 ) ? ( double ) called / marker_count : 0.0;
+        s.heterozygosity = ( called > 0 ) ? ( double ) s.counts.ab / called : 0.0;
+        s.expected_hom = total_hom - missing_hom[c];
+        s.inbreeding = ( called > s.expected_hom ) ? ( o_hom - s.expected_hom ) / ( called - s.expected_hom ) : 0.0;
+    }
+}
+
+void sample_qc_scan( GeneticData *gd, ostream *out ) {
+    uint individ_count = gd->getGenotypedIndividualsCount();
+    GenoTable &gt = *gd->getGenotypeTable();
+
+    cout << "Sample QC of " << individ_count << " individuals over " << gd->getGenotypedMarkersCount() << " markers" << endl;
+
+    vector< frequency_table > dist( gt.row_size() );
+    gd->getSummaryCache()->getCounts( 0, gt.row_size(), &dist[0] );
+
+    vector< sample_qc_result > res( individ_count );
+    computeSampleQC( gt, &dist[0], &res[0] );
+
+    *out << "INDIVIDUAL\tN_CALLED\tN_MISS\tCALL_RATE\tN_HET\tN_HOM_MINOR\tHET_RATE\tE_HOM\tF\n";
+    for( uint c = 0; c < individ_count; ++c ) {
+        const sample_qc_result &s = res[c];
+        *out << gd->getGenotypedIndividualID( c ) << "\t" << ( s.counts.aa + s.counts.ab + s.counts.bb ) << "\t" << s.counts.xx << "\t" << s.call_rate
+             << "\t" << s.counts.ab << "\t" << s.hom_minor << "\t" << s.heterozygosity << "\t" << s.expected_hom << "\t" << s.inbreeding << "\n";
+    }
+    out->flush();
+}
+
+}
+}
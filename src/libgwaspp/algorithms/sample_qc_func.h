@@ -0,0 +1,101 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef SAMPLE_QC_FUNC_H
+#define SAMPLE_QC_FUNC_H
+
+#include <fstream>
+#include <vector>
+
+#include "genetics/genetic_data.h"
+#include "genetics/genotype/geno_table.h"
+#include "util/thread/parallel_for.h"
+
+namespace libgwaspp {
+namespace algorithms {
+
+using namespace libgwaspp::genetics;
+using namespace std;
+
+// rows handed to GenoTable::addColumnGenotypeCounts at a time
+const uint SAMPLE_QC_BLOCK_SIZE = 4096;
+
+/**
+ * Per-sample call rate, heterozygosity and inbreeding coefficient.
+ *
+ * The expected number of homozygous calls of a sample is the sum of the
+ * expected homozygosity 1 - 2pq over the markers the sample has called.
+ *
+ * Which homozygote a table stores as AA differs between tables, so the
+ * homozygous calls of the minor allele are counted per marker from its
+ * genotype counts. A marker whose alleles are equally frequent has no minor
+ * allele and adds to neither homozygote count.
+ */
+struct sample_qc_result {
+    frequency_table counts;     // AA, AB, BB and missing calls over all markers
+    uint hom_minor;             // calls homozygous for the minor allele of their marker
+    double call_rate;           // called / markers
+    double heterozygosity;      // AB / called
+    double expected_hom;        // E(hom)
+    double inbreeding;          // F = ( O(hom) - E(hom) ) / ( called - E(hom) )
+};
+
+/**
+ * Adds the genotypes of rows [row_begin, row_end) to the per-sample tables
+ * columns[0, gt.column_size()). The rows are split into one contiguous range
+ * per thread when the table supports concurrent reads; every range is
+ * counted into its own tables, which are summed at the end.
+ */
+void computeSampleCounts( GenoTable & gt, uint row_begin, uint row_end, frequency_table * columns, uint nThreads = 0 );
+
+/**
+ * Adds to hom[c] the sum of the expected homozygosity e_hom[i] of the rows i
+ * in [row_begin, row_end) at which column c is missing. The columns are split
+ * into one part per thread when the table supports concurrent reads.
+ */
+void computeMissingHomozygosity( GenoTable & gt, uint row_begin, uint row_end, const double * e_hom, double * hom, uint nThreads = 0 );
+
+/**
+ * Adds to hom[c] the number of rows i in [row_begin, row_end) at which column
+ * c is homozygous for the minor allele given by the genotype counts dist[i].
+ * Uses the same column split as computeMissingHomozygosity.
+ */
+void computeMinorHomozygotes( GenoTable & gt, uint row_begin, uint row_end, const frequency_table * dist, double * hom, uint nThreads = 0 );
+
+// res holds gt.column_size() results
+void computeSampleQC( GenoTable & gt, sample_qc_result * res, uint nThreads = 0 );
+
+// as above, with the genotype counts of every marker of gt already in dist
+void computeSampleQC( GenoTable & gt, const frequency_table * dist, sample_qc_result * res, uint nThreads = 0 );
+
+void sample_qc_scan( GeneticData *gd, ostream *out );
+
+}
+}
+
+#endif // SAMPLE_QC_FUNC_H
@@ -72,6 +72,7 @@ CaseControlSet::CaseControlSet( const indexer *idx ) : possible_indices( idx ) {
     stream_cs_end = stream_case_set + stream_byte_count + 1;
 
     case_count = 0; ctrl_count = 0; total_count = 0;
+    revision = 0;
 }
 
 void CaseControlSet::setCases( const set<int> & case_idx ) {
@@ -98,6 +99,7 @@ void CaseControlSet::setCases( const set<int> & case_idx ) {
     assert(case_count == (uint) case_idx.size());
     case_count = ( uint ) case_idx.size();
     total_count = case_count + ctrl_count;
+    ++revision;
 
 /*
     cout << "Cases: ";
@@ -136,6 +138,7 @@ void CaseControlSet::setControls( const set<int> & ctrl_idx ) {
     assert(ctrl_count == (uint) ctrl_idx.size());
     ctrl_count = ( uint ) ctrl_idx.size();
     total_count = case_count + ctrl_count;
+    ++revision;
 /*
     cout << "Controls: ";
     for( uint i = 0; i < block_count; ++i ) {
@@ -159,6 +162,7 @@ void CaseControlSet::setAllAsCases() {
     case_count = max_index + 1;
     ctrl_count = 0;
     total_count = case_count;
+    ++revision;
 
     case_set[ block_count - 1 ] &=  ( 0xFFFF >> (( (7 - ( max_index & 7 )) << 1 ) ) );
 
@@ -181,6 +185,7 @@ void CaseControlSet::setAllAsControls() {
     ctrl_count = max_index + 1;
     case_count = 0;
     total_count = ctrl_count;
+    ++revision;
 
     control_set[ block_count - 1 ] &=  ( 0xFFFF >> (( (7 - ( max_index & 7 )) << 1 ) ) );
 
@@ -196,6 +201,7 @@ void CaseControlSet::reset() {
     memset( control_set, 0x00, byte_count );
     memset( stream_case_set, 0x00, stream_byte_count );
     memset( stream_control_set, 0x00, stream_byte_count );
+    ++revision;
 }
 
 bool CaseControlSet::isCase( uint idx ) {
@@ -55,6 +55,9 @@ class CaseControlSet
         uint getControlCount() const { return ctrl_count; }
         uint getTotalCount() const { return total_count; }
 
+        // changes whenever the cases or controls are replaced
+        uint getRevision() const { return revision; }
+
         void setCases( const set<int> & case_idx );
         void setControls( const set<int> & ctrl_idx );
 
@@ -87,6 +90,7 @@ class CaseControlSet
         ushort * control_set_end, *case_set_end;
 
         uint case_count, ctrl_count, total_count;
+        uint revision;
 
         uint stream_block_count, stream_byte_count;
         ushort *stream_buffer, *stream_control_set, *stream_case_set;
@@ -0,0 +1,62 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/analyzable/covariate_set.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+CovariateSet::CovariateSet( const indexer * idx ) : possible_indices( idx ) {
+    column_count = possible_indices->included_size();
+    present.assign( column_count, 0 );
+}
+
+uint CovariateSet::addCovariate( const string & name, const map< int, double > & covariate_values ) {
+    uint k = names.size();
+    names.push_back( name );
+    values.resize( values.size() + column_count, 0.0 );
+
+    double *col = &values[0] + ( ulong ) k * column_count;
+    for( map< int, double >::const_iterator it = covariate_values.begin(); it != covariate_values.end(); ++it ) {
+        assert( it->first >= 0 && it->first < ( int ) column_count );
+
+        col[ it->first ] = it->second;
+        ++present[ it->first ];
+    }
+
+    return k;
+}
+
+void CovariateSet::reset() {
+    names.clear();
+    values.clear();
+    present.assign( column_count, 0 );
+}
+
+}
+}
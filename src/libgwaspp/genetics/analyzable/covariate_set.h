@@ -0,0 +1,85 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef COVARIATESET_H
+#define COVARIATESET_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cassert>
+
+#include "libgwaspp.h"
+
+#include "util/index_set/indexer.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+using namespace std;
+using namespace util;
+
+/**
+ * Class: CovariateSet
+ * Description: Numeric covariates (age, sex, principal components, ...) of
+ * the genotyped individuals. Every covariate is stored as one contiguous
+ * column of included_size() values so that model fits can sweep a
+ * covariate over all individuals at once. An individual is complete when
+ * it has a value for every covariate.
+ */
+class CovariateSet {
+    public:
+        CovariateSet( const indexer * _idx );
+
+        // values by column; columns without a value are missing. Returns the
+        // index of the covariate.
+        uint addCovariate( const string & name, const map< int, double > & values );
+
+        uint getCovariateCount() const { return names.size(); }
+        const string & getName( uint k ) const { assert( k < names.size() ); return names[ k ]; }
+
+        const double * covariate_begin( uint k ) const { assert( k < names.size() ); return &values[0] + ( ulong ) k * column_count; }
+
+        bool isComplete( uint idx ) const { return present[ idx ] == names.size(); }
+
+        void reset();
+
+        virtual ~CovariateSet() {}
+    protected:
+        const indexer * possible_indices;
+        uint column_count;
+
+        vector< string > names;
+        vector< double > values;    // covariate major
+        vector< uint > present;     // number of covariates with a value, by column
+};
+
+}
+}
+
+#endif // COVARIATESET_H
@@ -0,0 +1,118 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/analyzable/quantitative_trait_set.h"
+
+#include <cmath>
+
+namespace libgwaspp {
+namespace genetics {
+
+QuantitativeTraitSet::QuantitativeTraitSet( const indexer *idx, uint _value_bits ) : possible_indices( idx ), value_bits( _value_bits ), revision( 0 ) {
+    assert( value_bits > 0 && value_bits <= QT_MAX_VALUE_BITS );
+
+    // same stream width as the masks of a CaseControlSet
+    stream_block_count = ( possible_indices->included_size() >> 4 ) + 1;
+
+    int block_per_pword = ( PROCESSOR_WORD_SIZE / ( sizeof( ushort ) << 3 ) );
+    if( block_per_pword > 1 && stream_block_count % block_per_pword ) {
+        stream_block_count += ( block_per_pword - ( stream_block_count % block_per_pword ));
+    }
+
+    planes.resize( getPlaneCount() * stream_block_count );
+    fixed_values.resize( possible_indices->included_size() );
+
+    reset();
+}
+
+void QuantitativeTraitSet::setValues( const map< int, double > & values, QuantitativeTrait * trait ) {
+    reset();
+
+    if( values.empty() ) return;
+
+    double y_min = values.begin()->second, y_max = y_min;
+    double mean = 0.0, m2 = 0.0;
+    uint n = 0;
+    for( map< int, double >::const_iterator it = values.begin(); it != values.end(); ++it ) {
+        assert( it->first >= 0 && it->first < possible_indices->included_size() );
+
+        if( it->second < y_min ) y_min = it->second;
+        if( it->second > y_max ) y_max = it->second;
+
+        // Welford's running variance
+        double d = it->second - mean;
+        mean += d / ++n;
+        m2 += d * ( it->second - mean );
+    }
+
+    offset = y_min;
+    scale = ( y_max > y_min ) ? ( double )(( 1UL << value_bits ) - 1 ) / ( y_max - y_min ) : 1.0;
+
+    for( map< int, double >::const_iterator it = values.begin(); it != values.end(); ++it ) {
+        uint block = it->first >> 4;
+        ushort bit = ( 1 << ( it->first & 0x0F ));
+
+        ulong q = ( ulong ) floor(( it->second - offset ) * scale + 0.5 );
+        ulong q2 = q * q;
+
+        planes[ block ] |= bit;
+        for( uint k = 0; k < value_bits; ++k ) {
+            if(( q >> k ) & 1 ) planes[ ( 1 + k ) * stream_block_count + block ] |= bit;
+        }
+        for( uint k = 0; k < 2 * value_bits; ++k ) {
+            if(( q2 >> k ) & 1 ) planes[ ( 1 + value_bits + k ) * stream_block_count + block ] |= bit;
+        }
+
+        fixed_values[ it->first ] = q;
+        value_sum += q;
+        square_sum += q2;
+    }
+    count = values.size();
+
+    if( trait != NULL ) {
+        trait->setMean( mean );
+        trait->setVariance(( n > 1 ) ? m2 / ( n - 1 ) : 0.0 );
+        trait->setMin( y_min );
+        trait->setMax( y_max );
+    }
+}
+
+void QuantitativeTraitSet::reset() {
+    fill( planes.begin(), planes.end(), 0 );
+    fill( fixed_values.begin(), fixed_values.end(), 0 );
+
+    count = 0;
+    value_sum = 0;
+    square_sum = 0;
+    offset = 0.0;
+    scale = 1.0;
+    ++revision;
+}
+
+}
+}
@@ -0,0 +1,113 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef QUANTITATIVETRAITSET_H
+#define QUANTITATIVETRAITSET_H
+
+#include <map>
+#include <vector>
+#include <cassert>
+
+#include "libgwaspp.h"
+
+#include "util/index_set/indexer.h"
+#include "genetics/trait/quantitative_trait.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+using namespace std;
+using namespace util;
+
+// default and largest number of fixed-point bits of a trait value
+const uint QT_VALUE_BITS = 16;
+const uint QT_MAX_VALUE_BITS = 20;
+
+/**
+ * Class: QuantitativeTraitSet
+ * Description: Values of a quantitative trait for the genotyped individuals,
+ * stored as fixed-point bit-planes in the stream column layout of the 2-bit
+ * stream tables (column c at block c >> 4, bit c & 0x0F).
+ *
+ * A value y is quantized to q = round( ( y - offset ) * scale ), an integer of
+ * value_bits bits. Plane 0 marks the individuals which have a value, planes
+ * 1 .. value_bits hold the bits of q and the next 2 * value_bits planes the
+ * bits of q * q. The sum of q over any set of columns is then
+ *
+ *      sum_k 2^k * PopCount( set & plane_k )
+ *
+ * which the tables evaluate for the genotype groups of a row.
+ */
+class QuantitativeTraitSet {
+    public:
+        QuantitativeTraitSet( const indexer * _idx, uint value_bits = QT_VALUE_BITS );
+
+        // values by column; columns without a value are excluded. The summary
+        // of trait, when given, is updated from the values.
+        void setValues( const map< int, double > & values, QuantitativeTrait * trait = NULL );
+
+        uint getCount() const { return count; }
+        uint getValueBits() const { return value_bits; }
+        uint getPlaneCount() const { return 1 + 3 * value_bits; }
+        uint getStreamBlockCount() const { return stream_block_count; }
+
+        // changes whenever the values are replaced
+        uint getRevision() const { return revision; }
+
+        const ushort * plane_begin() const { return &planes[0]; }
+        const ushort * plane( uint k ) const { return &planes[0] + k * stream_block_count; }
+
+        bool isPhenotyped( uint idx ) const { return ( planes[ idx >> 4 ] >> ( idx & 0x0F ) ) & 1; }
+        ulong value( uint idx ) const { return fixed_values[ idx ]; }
+
+        ulong getValueSum() const { return value_sum; }
+        ulong getSquareSum() const { return square_sum; }
+
+        // y = offset + q / scale
+        double getOffset() const { return offset; }
+        double getScale() const { return scale; }
+
+        void reset();
+
+        virtual ~QuantitativeTraitSet() {}
+    protected:
+        const indexer * possible_indices;
+        uint value_bits, stream_block_count;
+        uint count, revision;
+
+        vector< ushort > planes;
+        vector< ulong > fixed_values;
+        ulong value_sum, square_sum;
+
+        double offset, scale;
+};
+
+}
+}
+
+#endif // QUANTITATIVETRAITSET_H
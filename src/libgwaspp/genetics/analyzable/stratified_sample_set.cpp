@@ -0,0 +1,104 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/analyzable/stratified_sample_set.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+StratifiedSampleSet::StratifiedSampleSet( const indexer * idx, uint nStrata ) : possible_indices( idx ) {
+    assert( nStrata > 0 );
+
+    strata.reserve( nStrata );
+    for( uint s = 0; s < nStrata; ++s ) {
+        strata.push_back( new CaseControlSet( possible_indices ) );
+    }
+}
+
+void StratifiedSampleSet::setStrata( const vector< int > & stratum_of, const set< int > & case_idx, const set< int > & ctrl_idx ) {
+    vector< set< int > > cases( strata.size() ), controls( strata.size() );
+
+    set< int >::const_iterator it;
+    for( it = case_idx.begin(); it != case_idx.end(); ++it ) {
+        assert( *it < ( int ) stratum_of.size() );
+        int s = stratum_of[ *it ];
+        if( s >= 0 && s < ( int ) strata.size() )
+            cases[ s ].insert( *it );
+    }
+
+    for( it = ctrl_idx.begin(); it != ctrl_idx.end(); ++it ) {
+        assert( *it < ( int ) stratum_of.size() );
+        int s = stratum_of[ *it ];
+        if( s >= 0 && s < ( int ) strata.size() && cases[ s ].find( *it ) == cases[ s ].end() )
+            controls[ s ].insert( *it );
+    }
+
+    for( uint s = 0; s < strata.size(); ++s ) {
+        setStratum( s, cases[ s ], controls[ s ] );
+    }
+}
+
+void StratifiedSampleSet::setStratum( uint s, const set< int > & case_idx, const set< int > & ctrl_idx ) {
+    assert( s < strata.size() );
+
+    strata[ s ]->reset();
+    strata[ s ]->setCases( case_idx );
+    strata[ s ]->setControls( ctrl_idx );
+}
+
+uint StratifiedSampleSet::getCaseCount() const {
+    uint count = 0;
+    for( uint s = 0; s < strata.size(); ++s ) {
+        count += strata[ s ]->getCaseCount();
+    }
+    return count;
+}
+
+uint StratifiedSampleSet::getControlCount() const {
+    uint count = 0;
+    for( uint s = 0; s < strata.size(); ++s ) {
+        count += strata[ s ]->getControlCount();
+    }
+    return count;
+}
+
+void StratifiedSampleSet::reset() {
+    set< int > empty;
+    for( uint s = 0; s < strata.size(); ++s ) {
+        setStratum( s, empty, empty );
+    }
+}
+
+StratifiedSampleSet::~StratifiedSampleSet() {
+    for( uint s = 0; s < strata.size(); ++s ) {
+        delete strata[ s ];
+    }
+}
+
+}
+}
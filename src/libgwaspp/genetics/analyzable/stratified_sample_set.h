@@ -0,0 +1,83 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef STRATIFIEDSAMPLESET_H
+#define STRATIFIEDSAMPLESET_H
+
+#include <set>
+#include <vector>
+#include <cassert>
+
+#include "libgwaspp.h"
+
+#include "util/index_set/indexer.h"
+#include "genetics/analyzable/case_control_set.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+using namespace std;
+using namespace util;
+
+/**
+ * Class: StratifiedSampleSet
+ * Description: Splits the cases and controls into K strata (ancestry groups,
+ * study sites, ...). Every stratum is kept as a CaseControlSet so that its
+ * masks are in the same stream format as a single two group set, and the
+ * whole collection can be handed to the batched table kernels
+ * (getCaseControlGenotypeDistributions, getCaseControlContingencyTables)
+ * to obtain the per-stratum counts in a single pass over a row.
+ */
+class StratifiedSampleSet {
+    public:
+        StratifiedSampleSet( const indexer * _idx, uint nStrata );
+
+        uint getStratumCount() const { return strata.size(); }
+
+        // stratum_of[ i ] is the stratum of column i; negative values exclude the column
+        void setStrata( const vector< int > & stratum_of, const set< int > & case_idx, const set< int > & ctrl_idx );
+        void setStratum( uint s, const set< int > & case_idx, const set< int > & ctrl_idx );
+
+        CaseControlSet & getStratum( uint s ) { assert( s < strata.size() ); return *strata[ s ]; }
+        const vector< CaseControlSet * > & getStrata() const { return strata; }
+
+        uint getCaseCount() const;
+        uint getControlCount() const;
+
+        void reset();
+
+        virtual ~StratifiedSampleSet();
+    protected:
+        const indexer * possible_indices;
+        vector< CaseControlSet * > strata;
+};
+
+}
+}
+
+#endif // STRATIFIEDSAMPLESET_H
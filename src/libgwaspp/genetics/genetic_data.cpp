@@ -31,7 +31,7 @@
 namespace libgwaspp {
 namespace genetics {
 
-GeneticData::GeneticData( eCompressionLevel comp_level, bool _phase ) : compression_level( comp_level), ccs(NULL), genotyped_individs(NULL), genotyped_markers(NULL), phenotyped_individs(NULL), phenotyped_traits(NULL), geno_tbl(NULL) {
+GeneticData::GeneticData( eCompressionLevel comp_level, bool _phase ) : compression_level( comp_level), ccs(NULL), qts(NULL), covariates(NULL), strata(NULL), genotyped_individs(NULL), genotyped_markers(NULL), phenotyped_individs(NULL), phenotyped_traits(NULL), geno_tbl(NULL), page_rows( PagedGenotypeTable::DEFAULT_ROWS_PER_PAGE ), cached_pages( PagedGenotypeTable::DEFAULT_CACHED_PAGES ) {
     //ctor
     individuals = new IndividualCollection();
     markers = new MarkerCollection();
@@ -73,14 +73,37 @@ void GeneticData::updateGenotypeTable() {
     case e2BitStream:
         geno_tbl = new CompressedGenotypeTable5( genotyped_markers, genotyped_individs );
         break;
+    case eSparse2BitStream:
+        geno_tbl = new SparseGenotypeTable( genotyped_markers, genotyped_individs );
+        break;
+    case ePaged2BitStream:
+        geno_tbl = new PagedGenotypeTable( genotyped_markers, genotyped_individs, page_file, page_rows, cached_pages );
+        break;
+    case eDedup2BitStream:
+        geno_tbl = new DedupGenotypeTable( genotyped_markers, genotyped_individs );
+        break;
+    case ePhased2BitStream:
+        // haplotype planes are only meaningful for phased calls
+        assert( phased );
+        geno_tbl = new HaplotypeTable( genotyped_markers, genotyped_individs );
+        break;
+    case eMultiAllelicBitPlane:
+        geno_tbl = new MultiAllelicGenotypeTable( genotyped_markers, genotyped_individs );
+        break;
+    case ePermuted2BitStream:
+        geno_tbl = new PermutedGenotypeTable( genotyped_markers, genotyped_individs );
+        break;
     default:
         geno_tbl = new BasicGenotypeTable( genotyped_markers, genotyped_individs );
         break;
     }
+
+    summary.setGenotypeTable( geno_tbl );
 }
 
 void GeneticData::addGenotype( int r, int c, const string &s ) {
     geno_tbl->addGenotype( r, c, s );
+    summary.invalidateRow( r );
 }
 
 const char *GeneticData::getGenotype( int r, int c ) {
@@ -118,9 +141,100 @@ void GeneticData::setCaseControlSet( set<string> * case_set, set<string> * ctrl_
         ccs = new CaseControlSet( this->genotyped_individs );
     }
 
-    ccs->reset();
+    fillCaseControlSet( *ccs, case_set, ctrl_set );
+}
+
+uint GeneticData::addCaseControlSet( set<string> * case_set, set<string> * ctrl_set ) {
+    CaseControlSet *cc_set = new CaseControlSet( this->genotyped_individs );
+    fillCaseControlSet( *cc_set, case_set, ctrl_set );
+
+    ccs_batch.push_back( cc_set );
+    return ccs_batch.size() - 1;
+}
 
+void GeneticData::setQuantitativeTraitSet( map< string, double > * values, QuantitativeTrait * trait ) {
+    if( qts == NULL ) {
+        qts = new QuantitativeTraitSet( this->genotyped_individs );
+    }
 
+    map< int, double > indexed;
+
+    int idx;
+    if( values != NULL ) {
+        for( map< string, double >::iterator it = values->begin(); it != values->end(); it++ ) {
+            if( (idx = getGenotypedIndividualIndex( it->first ) ) >= 0 )
+                indexed[ idx ] = it->second;
+            else {
+                cout << "Phenotyped Individual not genotyped: " << it->first << endl;
+            }
+        }
+    }
+
+    qts->setValues( indexed, trait );
+}
+
+void GeneticData::addCovariate( const string & name, map< string, double > * values ) {
+    if( covariates == NULL ) {
+        covariates = new CovariateSet( this->genotyped_individs );
+    }
+
+    map< int, double > indexed;
+
+    int idx;
+    if( values != NULL ) {
+        for( map< string, double >::iterator it = values->begin(); it != values->end(); it++ ) {
+            if( (idx = getGenotypedIndividualIndex( it->first ) ) >= 0 )
+                indexed[ idx ] = it->second;
+        }
+    }
+
+    covariates->addCovariate( name, indexed );
+}
+
+bool GeneticData::setStrata( map< string, string > * labels ) {
+    assert( ccs != NULL );
+
+    // strata are numbered in the order of their labels
+    map< string, int > stratum_idx;
+    for( map< string, string >::iterator it = labels->begin(); it != labels->end(); it++ ) {
+        stratum_idx.insert( make_pair( it->second, 0 ) );
+    }
+    if( stratum_idx.empty() ) {
+        return false;
+    }
+
+    int s = 0;
+    for( map< string, int >::iterator it = stratum_idx.begin(); it != stratum_idx.end(); it++ ) {
+        it->second = s++;
+    }
+
+    vector< int > stratum_of( ccs->getMaximumIndex() + 1, -1 );
+    int idx;
+    for( map< string, string >::iterator it = labels->begin(); it != labels->end(); it++ ) {
+        if( (idx = getGenotypedIndividualIndex( it->first ) ) >= 0 && idx < ( int ) stratum_of.size() )
+            stratum_of[ idx ] = stratum_idx[ it->second ];
+    }
+
+    const ushort *case_stream = ccs->stream_case_begin(), *ctrl_stream = ccs->stream_control_begin();
+    set< int > cases, controls;
+    for( uint c = 0; c < stratum_of.size(); ++c ) {
+        ushort bit = ( 1 << ( c & 0x0F ) );
+        if( case_stream[ c >> 4 ] & bit ) {
+            cases.insert( c );
+        } else if( ctrl_stream[ c >> 4 ] & bit ) {
+            controls.insert( c );
+        }
+    }
+
+    delete strata;
+    strata = new StratifiedSampleSet( this->genotyped_individs, stratum_idx.size() );
+    strata->setStrata( stratum_of, cases, controls );
+
+    return strata->getCaseCount() + strata->getControlCount() > 0;
+}
+
+void GeneticData::fillCaseControlSet( CaseControlSet & cc_set, set<string> * case_set, set<string> * ctrl_set ) {
+    cc_set.reset();
 
     set< int > cases, controls;
     set< int >::iterator dup_it;
@@ -153,8 +267,8 @@ void GeneticData::setCaseControlSet( set<string> * case_set, set<string> * ctrl_
         }
     }
 
-    ccs->setCases( cases );
-    ccs->setControls( controls );
+    cc_set.setCases( cases );
+    cc_set.setControls( controls );
 }
 
 GeneticData::~GeneticData() {
@@ -166,12 +280,19 @@ GeneticData::~GeneticData() {
     delete phenotyped_traits;
 
     delete geno_tbl;
+    delete qts;
+    delete covariates;
+    delete strata;
+
+    for( vector< CaseControlSet * >::iterator it = ccs_batch.begin(); it != ccs_batch.end(); it++ ) {
+        delete *it;
+    }
 
     delete individuals;
     delete markers;
 
-    delete GenotypeRecordFactory::instance();
-
+    // GenotypeRecordFactory::instance() is shared by every GeneticData of
+    // the process, so it is not deleted here
 
 }
 
@@ -49,7 +49,11 @@
 #include "util/index_set/indexer.h"
 
 #include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/marker_summary_cache.h"
 #include "genetics/analyzable/case_control_set.h"
+#include "genetics/analyzable/quantitative_trait_set.h"
+#include "genetics/analyzable/covariate_set.h"
+#include "genetics/analyzable/stratified_sample_set.h"
 
 /*
 #if COMPRESSION_LEVEL == 1
@@ -74,7 +78,7 @@ using namespace libgwaspp::algorithms;
 namespace libgwaspp {
 namespace genetics {
 
-enum eCompressionLevel { eBasicCompression = 0, eByteCompression, eHalfByteCompression, e2BitBlockCompression, e3BitStream, e2BitStream };
+enum eCompressionLevel { eBasicCompression = 0, eByteCompression, eHalfByteCompression, e2BitBlockCompression, e3BitStream, e2BitStream, eSparse2BitStream, ePaged2BitStream, eDedup2BitStream, ePhased2BitStream, eMultiAllelicBitPlane, ePermuted2BitStream };
 
 class GeneticData {
     public:
@@ -94,8 +98,14 @@ class GeneticData {
         void setExpGenotypeWidth( int mwidth );
         void setExpMarkerCount( int mcnt );
 
-        void addGenotypeRow( int r, string::const_iterator & it, string::const_iterator & it_end, char delim) { geno_tbl->addGenotypeRow( r, it, it_end, delim); }
-        void addGenotypeRow( int rIdx, const char * p_begin, const char * p_end, char delim ) { geno_tbl->addGenotypeRow( rIdx, p_begin, p_end, delim); }
+        // backing file and frame geometry of the paged genotype table;
+        // an empty file name pages to an unlinked temporary file
+        void setPageFile( const string & file ) { page_file = file; }
+        void setPageRowCount( uint rows ) { page_rows = rows; }
+        void setCachedPageCount( uint pages ) { cached_pages = pages; }
+
+        void addGenotypeRow( int r, string::const_iterator & it, string::const_iterator & it_end, char delim) { geno_tbl->addGenotypeRow( r, it, it_end, delim); summary.invalidateRow( r ); }
+        void addGenotypeRow( int rIdx, const char * p_begin, const char * p_end, char delim ) { geno_tbl->addGenotypeRow( rIdx, p_begin, p_end, delim); summary.invalidateRow( rIdx ); }
 
         void addGenotype( int r, int c, const string & s );
         const char * getGenotype( int r, int c );
@@ -115,6 +125,7 @@ class GeneticData {
         // MarkerCollection Wrapper functions
         const Marker *createMarker( string &id, string &chrom, uint start, uint end, double gPos, string &alleles ) { return markers->createMarker( id, chrom, start, end, gPos, alleles); }
         int getMarkerIndex( const Marker * m ) const;
+        const Chromosome *findChromosome( ChromosomeID id ) const { return markers->findChromosome( id ); }
 
         vector< Marker *>::iterator marker_begin() { return markers->marker_begin(); }
         vector< Marker *>::iterator marker_end() { return markers->marker_end(); }
@@ -128,10 +139,15 @@ class GeneticData {
 
         GenoTable * getGenotypeTable() { return geno_tbl; }
 
+        // per-marker counts, MAF, missing rate and case/control counts of the
+        // genotype table; rows written through this class are invalidated
+        MarkerSummaryCache * getSummaryCache() { return &summary; }
+
         int getGenotypedIndividualIndex( const std::string & id ) const;
         int getGenotypedMarkerIndex( const std::string & id ) const;
 
         string getGenotypedMarkerID( int order ) { return genotyped_markers->getIDAtOrderedIndex( order ); }
+        const Marker *getGenotypedMarker( int order ) { return markers->getMarkerAt( genotyped_markers->indexOf( order ) ); }
         string getGenotypedIndividualID( int order) { return genotyped_individs->getIDAtOrderedIndex(order); }
 
         void getRandomGenotypedIndividualIDSet( std::set<std::string> & id_set, int count = 10) { RandomIDSet( genotyped_individs, id_set, count); }
@@ -140,19 +156,46 @@ class GeneticData {
         void setCaseControlSet( set<string> * case_set, set<string> * ctrl_set );
         CaseControlSet * getCaseControlSet() { return ccs; }
 
+        // phenotypes which are analysed together, one CaseControlSet each, so
+        // that every genotype row is read once for all of them
+        uint addCaseControlSet( set<string> * case_set, set<string> * ctrl_set );
+        vector< CaseControlSet * > & getCaseControlSets() { return ccs_batch; }
+
+        // trait values by individual id; individuals which are not genotyped are skipped
+        void setQuantitativeTraitSet( map< string, double > * values, QuantitativeTrait * trait = NULL );
+        QuantitativeTraitSet * getQuantitativeTraitSet() { return qts; }
+
+        // covariate values by individual id; individuals which are not genotyped are skipped
+        void addCovariate( const string & name, map< string, double > * values );
+        CovariateSet * getCovariateSet() { return covariates; }
+
+        // stratum labels by individual id; the cases and controls of the
+        // CaseControlSet are split into one stratum per label. False when no
+        // stratum holds a case or a control.
+        bool setStrata( map< string, string > * labels );
+        StratifiedSampleSet * getStratifiedSampleSet() { return strata; }
+
         virtual ~GeneticData();
     protected:
+        void fillCaseControlSet( CaseControlSet & cc_set, set<string> * case_set, set<string> * ctrl_set );
 
     private:
         eCompressionLevel compression_level;
         IndividualCollection *individuals;
         MarkerCollection *markers;
         CaseControlSet *ccs;
+        vector< CaseControlSet * > ccs_batch;
+        QuantitativeTraitSet *qts;
+        CovariateSet *covariates;
+        StratifiedSampleSet *strata;
 
         indexer *genotyped_individs, *genotyped_markers;
         indexer *phenotyped_individs, *phenotyped_traits;
 
         GenoTable * geno_tbl;
+        MarkerSummaryCache summary;
+        string page_file;
+        uint page_rows, cached_pages;
 
         bool phased;
 };
@@ -0,0 +1,137 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/genotype/case_control_split.h"
+
+#include <vector>
+#include <cstring>
+
+#include "genetics/genotype/common_genotype_func.h"
+#include "util/thread/parallel_for.h"
+
+using namespace std;
+
+namespace libgwaspp {
+namespace genetics {
+
+// rows per thread below which threads are not worth starting
+static const ulong MIN_SPLIT_ROWS = 256;
+
+struct split_context {
+    const case_control_split *layout;
+    const PWORD *case_mask, *ctrl_mask;
+    const byte *case_n, *ctrl_n;       // selected columns per mask word
+};
+
+// appends the low n bits of v to the word stream at fill
+inline void AppendBits( PWORD v, uint n, uint fill, PWORD &cur, PWORD *&out ) {
+    cur |= ( v << fill );
+    if( fill + n >= PROCESSOR_WORD_SIZE ) {
+        *out++ = cur;
+        cur = (( fill ) ? ( v >> ( PROCESSOR_WORD_SIZE - fill )) : 0 );
+    }
+}
+
+static void SplitRows( void *arg, ulong row_begin, ulong row_end ) {
+    const split_context *ctx = reinterpret_cast< const split_context * >( arg );
+    const case_control_split &l = *ctx->layout;
+
+    const PWORD *in[ CASE_CONTROL_MAX_PLANES ];
+    PWORD *case_out[ CASE_CONTROL_MAX_PLANES ], *ctrl_out[ CASE_CONTROL_MAX_PLANES ];
+    PWORD case_cur[ CASE_CONTROL_MAX_PLANES ], ctrl_cur[ CASE_CONTROL_MAX_PLANES ];
+
+    for( ulong r = row_begin; r < row_end; ++r ) {
+        const DataBlock *src = l.src + r * l.src_stride;
+        DataBlock *dst = l.dst + r * l.dst_stride;
+
+        memset( dst, 0, l.dst_stride * sizeof( DataBlock ) );
+
+        for( uint p = 0; p < l.plane_count; ++p ) {
+            in[ p ] = reinterpret_cast< const PWORD * >( src + p * l.src_plane_offset );
+            case_out[ p ] = reinterpret_cast< PWORD * >( dst + p * l.case_blocks );
+            ctrl_out[ p ] = reinterpret_cast< PWORD * >( dst + l.plane_count * l.case_blocks + p * l.ctrl_blocks );
+            case_cur[ p ] = 0;
+            ctrl_cur[ p ] = 0;
+        }
+
+        uint case_fill = 0, ctrl_fill = 0, n;
+        for( uint w = 0; w < l.plane_words; ++w ) {
+            if(( n = ctx->case_n[ w ] ) != 0 ) {
+                for( uint p = 0; p < l.plane_count; ++p ) {
+                    AppendBits( ExtractBits( in[ p ][ w ], ctx->case_mask[ w ] ), n, case_fill, case_cur[ p ], case_out[ p ] );
+                }
+                case_fill = ( case_fill + n ) & ( PROCESSOR_WORD_SIZE - 1 );
+            }
+
+            if(( n = ctx->ctrl_n[ w ] ) != 0 ) {
+                for( uint p = 0; p < l.plane_count; ++p ) {
+                    AppendBits( ExtractBits( in[ p ][ w ], ctx->ctrl_mask[ w ] ), n, ctrl_fill, ctrl_cur[ p ], ctrl_out[ p ] );
+                }
+                ctrl_fill = ( ctrl_fill + n ) & ( PROCESSOR_WORD_SIZE - 1 );
+            }
+        }
+
+        for( uint p = 0; p < l.plane_count; ++p ) {
+            if( case_fill ) {
+                *case_out[ p ] = case_cur[ p ];
+            }
+            if( ctrl_fill ) {
+                *ctrl_out[ p ] = ctrl_cur[ p ];
+            }
+        }
+    }
+}
+
+void SplitCaseControl( const case_control_split &layout, CaseControlSet &ccs, ulong nRows, uint nThreads ) {
+    assert( layout.plane_count <= CASE_CONTROL_MAX_PLANES );
+
+    const PWORD *case_ptr = reinterpret_cast< const PWORD * >( ccs.stream_case_begin() );
+    const PWORD *ctrl_ptr = reinterpret_cast< const PWORD * >( ccs.stream_control_begin() );
+
+    vector< PWORD > case_mask( case_ptr, case_ptr + layout.plane_words );
+    vector< PWORD > ctrl_mask( layout.plane_words );
+    vector< byte > case_n( layout.plane_words ), ctrl_n( layout.plane_words );
+
+    for( uint w = 0; w < layout.plane_words; ++w ) {
+        ctrl_mask[ w ] = ctrl_ptr[ w ] & ~case_mask[ w ];
+        case_n[ w ] = PopCount( case_mask[ w ] );
+        ctrl_n[ w ] = PopCount( ctrl_mask[ w ] );
+    }
+
+    split_context ctx;
+    ctx.layout = &layout;
+    ctx.case_mask = &case_mask[0];
+    ctx.ctrl_mask = &ctrl_mask[0];
+    ctx.case_n = &case_n[0];
+    ctx.ctrl_n = &ctrl_n[0];
+
+    util::ParallelFor( 0, nRows, &SplitRows, &ctx, nThreads, MIN_SPLIT_ROWS );
+}
+
+}
+}
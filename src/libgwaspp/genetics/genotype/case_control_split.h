@@ -0,0 +1,73 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef CASECONTROLSPLIT_H
+#define CASECONTROLSPLIT_H
+
+#include "common.h"
+#include "genetics/analyzable/case_control_set.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+#define CASE_CONTROL_MAX_PLANES 3
+
+/**
+ * Describes how the bit planes of a streaming table are split into a
+ * case/control buffer.
+ *
+ * Every source row holds plane_count planes of plane_words processor words,
+ * src_plane_offset blocks apart. Every destination row holds the case planes
+ * (case_blocks blocks each) followed by the control planes (ctrl_blocks
+ * blocks each), which is the layout read by the selected kernels of
+ * CompressedGenotypeTable4 and CompressedGenotypeTable5.
+ */
+struct case_control_split {
+    const DataBlock *src;       // first data block (after the header) of row 0
+    ulong src_stride;           // blocks per source row
+    uint src_plane_offset;
+    uint plane_words;
+    uint plane_count;
+
+    DataBlock *dst;             // row 0 of the case/control buffer
+    ulong dst_stride;           // blocks per destination row
+    uint case_blocks, ctrl_blocks;
+};
+
+/**
+ * Packs the case and control columns of nRows rows into the case/control
+ * buffer. Columns are gathered a processor word at a time (see ExtractBits)
+ * and rows are partitioned across nThreads threads (0 = all processors).
+ * A column which is both a case and a control is treated as a case.
+ */
+void SplitCaseControl( const case_control_split &layout, CaseControlSet &ccs, ulong nRows, uint nThreads = 0 );
+
+}
+}
+
+#endif // CASECONTROLSPLIT_H
@@ -105,6 +105,30 @@ struct marginal_information {
     double dPca[ 2 * GENOTYPE_COUNT ];   // cases[4]; controls[4]
 };
 
+/// 2-bit stream genotype codes: bit 0 from the aa stream, bit 1 from the ab stream
+#define STREAM_CODE_MISSING 0
+#define STREAM_CODE_AA 1
+#define STREAM_CODE_AB 2
+#define STREAM_CODE_BB 3
+
+/// Quantitative trait sums of a marker over the individuals with a trait value;
+/// count and sum follow the frequency table layout. square_sum_called is the
+/// sum of squared trait values over the called genotypes (aa, ab and bb).
+struct trait_sums {
+    frequency_table count;
+    ulong sum[ GENOTYPE_COUNT ];
+    ulong square_sum_called;
+};
+
+inline void ResetTraitSums( trait_sums & ts ) {
+    ResetFrequencyTable( ts.count );
+    ts.sum[ 0 ] = 0;
+    ts.sum[ 1 ] = 0;
+    ts.sum[ 2 ] = 0;
+    ts.sum[ 3 ] = 0;
+    ts.square_sum_called = 0;
+}
+
 #ifndef ResetJointGenotype
 #define ResetJointGenotype( x ) x.ul = 0; x.b = 0;
 #endif
@@ -170,6 +170,16 @@ int init_bit_count( byte * _count ) {
     return 1;
 }
 
+int init_spread_bits( ulong * spread ) {
+    for( uint i = 0; i < 0x100; ++i ) {
+        spread[ i ] = 0;
+        for( uint j = 0; j < 8; ++j ) {
+            if(( i >> j ) & 1 ) spread[ i ] |= ( 1UL << ( j << 3 ) );
+        }
+    }
+    return 1;
+}
+
 void computeMarginalInformation( const frequency_table & _cases, const frequency_table & _ctrls, uint nIndivids, marginal_information & m) {
     CopyFrequencyTable( m.cases, _cases );
     CopyFrequencyTable( m.controls, _ctrls );
@@ -36,6 +36,10 @@
 #define MATHLIB_STANDALONE
 #include "Rmath.h"
 
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
 #include "genetics/genotype/common_genotype.h"
 
 using namespace std;
@@ -52,10 +56,12 @@ ostream &operator<<(ostream &out, marginal_information &mi );
 
 uint ones16( register uint i );
 int init_bit_count( byte * bit_count );
+int init_spread_bits( ulong * spread );
 
 inline int PopCount( ushort v ) {
     static byte bit_count16[ 0x10000 ];
     static int init = init_bit_count( bit_count16 );
+    ( void ) init;
     return bit_count16[ v ];
 }
 
@@ -89,6 +95,86 @@ inline int PopCount( register ulong v ) {
     return PopCount( (ushort) v ) + PopCount( (ushort) (v >> 16) ) + PopCount( (ushort) (v >> 32) ) + PopCount( (ushort) (v >> 48) );
 }
 
+/**
+ * Gathers the bits of v selected by mask into the low order bits of the result
+ * (parallel bit extract). Uses the BMI2 pext instruction when it is enabled.
+ */
+inline ulong ExtractBits( ulong v, ulong mask ) {
+#ifdef __BMI2__
+    return _pext_u64( v, mask );
+#else
+    ulong res = 0;
+    for( ulong bit = 1; mask; bit <<= 1 ) {
+        if( v & mask & ( ~mask + 1 ) ) {
+            res |= bit;
+        }
+        mask &= ( mask - 1 );
+    }
+    return res;
+#endif
+}
+
+/**
+ * Spreads the bits of v over the bytes of the result: bit j becomes the low
+ * bit of byte j. Uses the BMI2 pdep instruction when it is enabled.
+ */
+inline ulong SpreadBits( byte v ) {
+#ifdef __BMI2__
+    return _pdep_u64( v, 0x0101010101010101UL );
+#else
+    static ulong spread[ 0x100 ];
+    static int init = init_spread_bits( spread );
+    ( void ) init;
+    return spread[ v ];
+#endif
+}
+
+/**
+ * Carry-save adder over the bit positions of three words: l receives the sum
+ * bits and h the carry bits.
+ */
+inline void CarrySaveAdd( ulong & h, ulong & l, ulong a, ulong b, ulong c ) {
+    ulong u = a ^ b;
+    h = ( a & b ) | ( u & c );
+    l = u ^ c;
+}
+
+/**
+ * Vertical bit counter (Harley-Seal). Words are accumulated eight at a time
+ * into per-bit ones/twos/fours counters; only the carry out of the fours is
+ * population counted, so a long stream costs about one PopCount per eight
+ * words instead of one per word.
+ */
+struct vertical_counter {
+    ulong ones, twos, fours;
+    uint eights;
+};
+
+inline void ResetVerticalCounter( vertical_counter & vc ) {
+    vc.ones = 0;
+    vc.twos = 0;
+    vc.fours = 0;
+    vc.eights = 0;
+}
+
+inline void AccumulateVertical( vertical_counter & vc, const ulong * w ) {
+    ulong twos_a, twos_b, fours_a, fours_b, eights;
+
+    CarrySaveAdd( twos_a, vc.ones, vc.ones, w[0], w[1] );
+    CarrySaveAdd( twos_b, vc.ones, vc.ones, w[2], w[3] );
+    CarrySaveAdd( fours_a, vc.twos, vc.twos, twos_a, twos_b );
+    CarrySaveAdd( twos_a, vc.ones, vc.ones, w[4], w[5] );
+    CarrySaveAdd( twos_b, vc.ones, vc.ones, w[6], w[7] );
+    CarrySaveAdd( fours_b, vc.twos, vc.twos, twos_a, twos_b );
+    CarrySaveAdd( eights, vc.fours, vc.fours, fours_a, fours_b );
+
+    vc.eights += PopCount( eights );
+}
+
+inline uint VerticalCount( const vertical_counter & vc ) {
+    return 8 * vc.eights + 4 * PopCount( vc.fours ) + 2 * PopCount( vc.twos ) + PopCount( vc.ones );
+}
+
 #ifndef IncrementFrequencyValueStream
 #define IncrementFrequencyValueStream( ft, l_aa, l_ab, l_bb )       \
                             ft.aa += PopCount( l_aa );              \
@@ -141,8 +141,9 @@ void CompressedGenotypeTable3::initialize() {
         err_lookup[ k ] = '0';
     }
 
-    constructCountLookup();
-    constructContingencyLookup();
+    count_lookup = GenotypeLookupRegistry::getCountLookup();
+    contingency_lookup = GenotypeLookupRegistry::getContingencyLookup();
+    skip_count = GenotypeLookupRegistry::getSkipCount();
 
     cout << "Initialized Genotype Lookups: " << lookup_size << " (bytes)" << endl;
 }
@@ -968,74 +969,6 @@ void CompressedGenotypeTable3::getCaseControlContingencyTable( uint rIdx1, uint
 //    ccct.setControlContingency( ctrl_cont );
 //}
 
-void CompressedGenotypeTable3::constructCountLookup( ) {
-    genotype_counts counts;
-    for( uint i = 0; i < 0x10000; ++i ) {
-        counts.ui = 0;
-
-        for( uint j = 0, k = i; j < 8; ++j, k >>= 2 ) {
-            switch( k & 0x0003 ) {
-            case 0x0003:
-                ++counts.c3;
-                break;
-            case 0x0002:
-                ++counts.c2;
-                break;
-            case 0x0001:
-                ++counts.c1;
-                break;
-            default:
-                ++counts.c0;
-                break;
-            }
-        }
-
-        count_lookup[i].ui = counts.ui;
-    }
-}
-
-void CompressedGenotypeTable3::constructContingencyLookup() {
-    joint_genotypes jg;
-
-    byte ma, mb;
-    uint base_offset, offset;
-    int bit_mask, shift, idx;
-
-    memset( contingency_lookup, 0, 16 * 256 * 256 * sizeof( joint_genotypes ) );
-
-    for( uint k = 1, mask = 0x00; k < 16; ++k ) {
-        mask = 0;
-        mask |= (( k & 0x01 ) ? 0x03 : 0 );
-        mask |= (( k & 0x02 ) ? 0x0C : 0 );
-        mask |= (( k & 0x04 ) ? 0x30 : 0 );
-        mask |= (( k & 0x08 ) ? 0xC0 : 0 );
-
-        skip_count[ k ] = 0;
-        skip_count[ k ] += ((( k & 0x01 ) ) ? 0 : 1 );
-        skip_count[ k ] += ((( k & 0x02 ) ) ? 0 : 1 );
-        skip_count[ k ] += ((( k & 0x04 ) ) ? 0 : 1 );
-        skip_count[ k ] += ((( k & 0x08 ) ) ? 0 : 1 );
-
-        for( uint i = 0; i < 256; ++i ) {
-            base_offset = (( k << 16 ) | ( i << 8 ) );
-            for( uint j = 0; j < 256; ++j ) {
-                // clear data
-                ResetJointGenotype( jg );
-                for( bit_mask = 0xC0, shift = 6, idx = 0; shift >= 0; bit_mask >>= 2, shift -= 2, ++idx ) {
-                    ma = (( i & ( bit_mask & mask ) ) >> shift );
-                    mb = (( j & ( bit_mask & mask ) ) >> shift );
-
-                    SetJointGenotype( jg, ma, mb, idx );
-                }
-
-                offset = base_offset | j;
-                CopyJointGenotype( contingency_lookup[ offset ], jg );
-
-            }
-        }
-    }
-}
-
 bool CompressedGenotypeTable3::isGenotypeHomozygous( ushort encoded_gt ) {
     // 0 == AA; 5 == CC; 10 == GG; 15 == TT
     return (( encoded_gt != 0xFFFF ) && ( encoded_gt == 0 || encoded_gt == 5 || encoded_gt == 10 || encoded_gt == 15 ) );
@@ -1056,9 +989,6 @@ CompressedGenotypeTable3::~CompressedGenotypeTable3() {
         delete [] lookup[ i ];
     }
     delete [] lookup;
-
-//    delete [] contingency_lookup;
-//    delete [] skip_count;
 }
 
 }
@@ -37,6 +37,7 @@
 #include "genetics/genotype/geno_table.h"
 #include "genetics/genotype/common_genotype.h"
 #include "genetics/genotype/common_genotype_func.h"
+#include "genetics/genotype/genotype_lookup_registry.h"
 
 using namespace std;
 using namespace util;
@@ -262,24 +263,20 @@ public:
     virtual ~CompressedGenotypeTable3();
 protected:
     void initialize();
-    void constructCountLookup();
-    void constructContingencyLookup();
 
 
     char *gt_lookup, * err_lookup;
     uint gt_size, lookup_size;
     DataBlock **lookup;
 
-    genotype_counts count_lookup[ 0x10000 ];
+    // shared lookups (see GenotypeLookupRegistry)
+    const genotype_counts *count_lookup;
 
     DataBlock *m_cases, *m_controls;
-    joint_genotypes contingency_lookup[ 0x100000 ];
-    byte skip_count[ 16 ];
+    const joint_genotypes *contingency_lookup;
+    const byte *skip_count;
 };
 
-//    contingency_lookup = new joint_genotypes[ 0x100000 ]; // 16 * 256 * 256 == 2^4 * 2^8 * 2^8 == 2^20 == 0x100000
-//    skip_count = new byte[ 16 ];
-
 }
 }
 
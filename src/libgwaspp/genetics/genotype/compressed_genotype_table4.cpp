@@ -145,8 +145,6 @@ void CompressedGenotypeTable4::initialize() {
         err_lookup[ k ] = '0';
     }
 
-    constructCountLookup();
-    constructContingencyLookup();
 
     cout << "Initialized Genotype Lookups: " << lookup_size << " (bytes)" << endl;
 }
@@ -477,121 +475,19 @@ void CompressedGenotypeTable4::selectCaseControl( CaseControlSet & ccs ) {
     nControlCount = ccs.getControlCount();
     nIndivids = nCaseCount + nControlCount;
 
-    // clear case control buffer
-    memset( m_cases_controls, 0, nCaseControlSize * sizeof(DataBlock) );
-
-    // Mask out cases and controls
-    const PWORD *case_ptr = reinterpret_cast< const PWORD * >( ccs.stream_case_begin() );
-    const PWORD *ctrl_ptr = reinterpret_cast< const PWORD * >( ccs.stream_control_begin() );
-
-    const PWORD *tmp_case, *tmp_ctrl;
-
-    PWORD case_word, case_word_ab, case_word_bb, ctrl_word, ctrl_word_ab, ctrl_word_bb;
-    PWORD _aa, _ab, _bb;
-    PWORD case_mask, ctrl_mask, mask;
-    PWORD _case, _ctrl;
-
-    // for every row
-    for( uint i = 0, offset = 1; i < (uint)max_row; ++i, offset += blocks_per_row ) {
-        // locate the start of the data segment for each row 
-        PWORD *_data = reinterpret_cast< PWORD * >( data + offset );
-        PWORD *_data_ab = reinterpret_cast< PWORD *>( data + offset + genotype_block_offset_ab);
-        PWORD *_data_bb = reinterpret_cast< PWORD *>( data + offset + genotype_block_offset_bb);
-
-        ulong cc_offset = i * nCaseControlBlockCount;
-        PWORD *case_out = reinterpret_cast< PWORD * >( m_cases_controls + cc_offset );
-        PWORD *case_out_ab = reinterpret_cast< PWORD * >(m_cases_controls + cc_offset + nCaseBlockCount );
-        PWORD *case_out_bb = reinterpret_cast< PWORD * >(m_cases_controls + cc_offset + 2 * nCaseBlockCount );
-
-        cc_offset += nControlBlockOffset;
-        PWORD *ctrl_out = reinterpret_cast< PWORD * >( m_cases_controls + cc_offset );
-        PWORD *ctrl_out_ab = reinterpret_cast< PWORD * >( m_cases_controls + cc_offset + nControlBlockCount);
-        PWORD *ctrl_out_bb = reinterpret_cast< PWORD * >( m_cases_controls + cc_offset + 2*nControlBlockCount);
-        
-
-        // reset the mask pointers
-        tmp_case = case_ptr;
-        tmp_ctrl = ctrl_ptr;
-
-        case_word = 0;
-        case_word_ab = 0;
-        case_word_bb = 0;
-
-        ctrl_word = 0;
-        ctrl_word_ab = 0;
-        ctrl_word_bb = 0;
-
-        case_mask = 1;
-        ctrl_mask = 1;
-        // for every data block
-        for( uint j = 1; j < genotype_block_offset_ab; j += BLOCKS_PER_PWORD ) {
-            // mask out all unnecessary data columns
-            _aa = *_data++;
-            _ab = *_data_ab++;
-            _bb = *_data_bb++;
-
-            _case = *tmp_case++;
-            _ctrl = *tmp_ctrl++;
-
-            mask = 1;
-            while( mask != 0 ) {
-                if( case_mask == 0 ) {
-                    *case_out++ = case_word;
-                    *case_out_ab++ = case_word_ab;
-                    *case_out_bb++ = case_word_bb;
-
-                    case_word = 0;
-                    case_word_ab = 0;
-                    case_word_bb = 0;
-                    case_mask = 1;
-                }
-
-                if( ctrl_mask == 0 ) {
-                    *ctrl_out++ = ctrl_word;
-                    *ctrl_out_ab++ = ctrl_word_ab;
-                    *ctrl_out_bb++ = ctrl_word_bb;
-
-                    ctrl_word = 0;
-                    ctrl_word_ab = 0;
-                    ctrl_word_bb = 0;
-                    ctrl_mask = 1;
-                }
-                if( _case & mask ) {
-                    if( _aa & mask ) {
-                        case_word |= case_mask;
-                    } else if( _ab & mask ) {
-                        case_word_ab |= case_mask;
-                    } else if( _bb & mask ) {
-                        case_word_bb |= case_mask;
-                    }
-                    case_mask <<= 1;
-                } else if( _ctrl & mask ) {
-                    if ( _aa & mask ) {
-                        ctrl_word |= ctrl_mask;
-                    } else if( _ab & mask ) {
-                        ctrl_word_ab |= ctrl_mask;
-                    } else if( _bb & mask ) {
-                        ctrl_word_bb |= ctrl_mask;
-                    }
-                    ctrl_mask <<= 1;
-                }
-
-                mask <<= 1;
-            }
-            
-        }
-
-        if( case_mask != 1 ) {
-            *case_out++ = case_word;
-            *case_out_ab++ = case_word_ab;
-            *case_out_bb++ = case_word_bb;
-        }
-        if( ctrl_mask != 1 ) {
-            *ctrl_out++ = ctrl_word;
-            *ctrl_out_ab++ = ctrl_word_ab;
-            *ctrl_out_bb++ = ctrl_word_bb;
-        }
-    }
+    // pack the case and control columns of every row
+    case_control_split layout;
+    layout.src = data + 1;
+    layout.src_stride = blocks_per_row;
+    layout.src_plane_offset = genotype_block_offset_ab;
+    layout.plane_words = genotype_block_offset_ab / BLOCKS_PER_PWORD;
+    layout.plane_count = 3;
+    layout.dst = m_cases_controls;
+    layout.dst_stride = nCaseControlBlockCount;
+    layout.case_blocks = nCaseBlockCount;
+    layout.ctrl_blocks = nControlBlockCount;
+
+    SplitCaseControl( layout, ccs, max_row );
 }
 
 /*
@@ -719,9 +615,9 @@ void CompressedGenotypeTable4::getCaseControlGenotypeDistribution( uint rIdx, Ca
     }
     case_gt.xx = nCaseCount - case_gt.aa - case_gt.ab - case_gt.bb;
     
-    tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount );
-    tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ nControlBlockCount);
-    tmp_data_bb = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ (nControlBlockCount << 1));
+    tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ nControlBlockOffset);
+    tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ nControlBlockCount+ nControlBlockOffset);
+    tmp_data_bb = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ (nControlBlockCount << 1)+ nControlBlockOffset);
 
     for( uint i = 0; i < nControlBlockCount; i += BLOCKS_PER_PWORD) {
         _aa = *tmp_data++;
@@ -1108,74 +1004,6 @@ void CompressedGenotypeTable4::getCaseControlContingencyTable( uint rIdx1, uint
     ccct.updateContingencyTables(case_cont, ctrl_cont);
 }
 
-void CompressedGenotypeTable4::constructCountLookup( ) {
-    genotype_counts counts;
-    for( uint i = 0; i < 0x10000; ++i ) {
-        counts.ui = 0;
-
-        for( uint j = 0, k = i; j < 8; ++j, k >>= 2 ) {
-            switch( k & 0x0003 ) {
-            case 0x0003:
-                ++counts.c3;
-                break;
-            case 0x0002:
-                ++counts.c2;
-                break;
-            case 0x0001:
-                ++counts.c1;
-                break;
-            default:
-                ++counts.c0;
-                break;
-            }
-        }
-
-        count_lookup[i].ui = counts.ui;
-    }
-}
-
-void CompressedGenotypeTable4::constructContingencyLookup() {
-    joint_genotypes jg;
-
-    byte ma, mb;
-    uint base_offset, offset;
-    int bit_mask, shift, idx;
-
-    memset( contingency_lookup, 0, 16 * 256 * 256 * sizeof( joint_genotypes ) );
-
-    for( uint k = 1, mask = 0x00; k < 16; ++k ) {
-        mask = 0;
-        mask |= (( k & 0x01 ) ? 0x03 : 0 );
-        mask |= (( k & 0x02 ) ? 0x0C : 0 );
-        mask |= (( k & 0x04 ) ? 0x30 : 0 );
-        mask |= (( k & 0x08 ) ? 0xC0 : 0 );
-
-        skip_count[ k ] = 0;
-        skip_count[ k ] += ((( k & 0x01 ) ) ? 0 : 1 );
-        skip_count[ k ] += ((( k & 0x02 ) ) ? 0 : 1 );
-        skip_count[ k ] += ((( k & 0x04 ) ) ? 0 : 1 );
-        skip_count[ k ] += ((( k & 0x08 ) ) ? 0 : 1 );
-
-        for( uint i = 0; i < 256; ++i ) {
-            base_offset = (( k << 16 ) | ( i << 8 ) );
-            for( uint j = 0; j < 256; ++j ) {
-                // clear data
-                ResetJointGenotype( jg );
-                for( bit_mask = 0xC0, shift = 6, idx = 0; shift >= 0; bit_mask >>= 2, shift -= 2, ++idx ) {
-                    ma = (( i & ( bit_mask & mask ) ) >> shift );
-                    mb = (( j & ( bit_mask & mask ) ) >> shift );
-
-                    SetJointGenotype( jg, ma, mb, idx );
-                }
-
-                offset = base_offset | j;
-                CopyJointGenotype( contingency_lookup[ offset ], jg );
-
-            }
-        }
-    }
-}
-
 bool CompressedGenotypeTable4::isGenotypeHomozygous( ushort encoded_gt ) {
     // 0 == AA; 5 == CC; 10 == GG; 15 == TT
     return (( encoded_gt != 0xFFFF ) && ( encoded_gt == 0 || encoded_gt == 5 || encoded_gt == 10 || encoded_gt == 15 ) );
@@ -1196,9 +1024,6 @@ CompressedGenotypeTable4::~CompressedGenotypeTable4() {
         delete [] lookup[ i ];
     }
     delete [] lookup;
-
-//    delete [] contingency_lookup;
-//    delete [] skip_count;
 }
 
 }
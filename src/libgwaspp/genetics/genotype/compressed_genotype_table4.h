@@ -37,6 +37,7 @@
 #include "genetics/genotype/geno_table.h"
 #include "genetics/genotype/common_genotype.h"
 #include "genetics/genotype/common_genotype_func.h"
+#include "genetics/genotype/case_control_split.h"
 
 using namespace std;
 using namespace util;
@@ -146,8 +147,6 @@ public:
     virtual ~CompressedGenotypeTable4();
 protected:
     void initialize();
-    void constructCountLookup();
-    void constructContingencyLookup();
 
 
     char *gt_lookup, * err_lookup;
@@ -155,11 +154,6 @@ protected:
     DataBlock **lookup;
 
     uint genotype_block_offset_ab, genotype_block_offset_bb;
-
-    genotype_counts count_lookup[ 0x10000 ];
-
-    joint_genotypes contingency_lookup[ 0x100000 ];
-    byte skip_count[ 16 ];
 };
 
 }
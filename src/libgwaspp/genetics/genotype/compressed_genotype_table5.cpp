@@ -67,7 +67,7 @@ void CompressedGenotypeTable5::initialize() {
 
     // finally, add an additional block for genotype headers
     ++blocks_per_row;
-    total_block_count = blocks_per_row * max_row;
+    total_block_count = blocks_per_row * row_capacity;
     bytes_per_row = blocks_per_row * BYTES_PER_BLOCK;
     data_size = total_block_count * BYTES_PER_BLOCK;
 
@@ -80,7 +80,7 @@ void CompressedGenotypeTable5::initialize() {
     if( data != NULL ) {
         delete [] data;
     }
-    data_size = max_row * bytes_per_row;
+    data_size = row_capacity * bytes_per_row;
 
     cout << "Total Table size: " << data_size << " (bytes)" << endl;
 
@@ -146,8 +146,6 @@ void CompressedGenotypeTable5::initialize() {
         err_lookup[ k ] = '0';
     }
 
-    constructCountLookup();
-    constructContingencyLookup();
 
     cout << "Initialized Genotype Lookups: " << lookup_size << " (bytes)" << endl;
 }
@@ -275,16 +273,20 @@ void CompressedGenotypeTable5::addGenotypeRow( int rIdx, string::const_iterator
 }
 
 void CompressedGenotypeTable5::addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim ) {
-#if MAX_ALLELE_COUNT == 2
     if( p_begin >= p_end) return;
 
+    encodeGenotypeRow( data + rIdx * blocks_per_row, p_begin, p_end );
+}
+
+void CompressedGenotypeTable5::encodeGenotypeRow( DataBlock *row, const char *p_begin, const char *p_end ) {
+#if MAX_ALLELE_COUNT == 2
     ushort enc = 0, tmp_e = 0;
     ushort c1, c2;
 
     ushort enc_set[ 256 ];
     memset( enc_set, 0xFF, 256 * sizeof( ushort ) );
 
-    DataBlock *tmp_data = data + rIdx * blocks_per_row;
+    DataBlock *tmp_data = row;
     DataBlock *tmp_header = tmp_data;
 
     // make sure the data row is "unknown"
@@ -464,114 +466,33 @@ void CompressedGenotypeTable5::selectCaseControl( CaseControlSet & ccs ) {
         nControlBlockOffset = 2 * nCaseBlockCount;
         nCaseControlBlockCount = 2 * (nCaseBlockCount + nControlBlockCount);
 
-        nCaseControlSize = nCaseControlBlockCount * max_row;
+        nCaseControlSize = nCaseControlBlockCount * row_capacity;
         m_cases_controls = new DataBlock[ nCaseControlSize ]; 
     }
 
+    selected_data = m_cases_controls;
+    selected_stride = nCaseControlBlockCount;
+    selected_case_ab = nCaseBlockCount;
+    selected_ctrl = nControlBlockOffset;
+    selected_ctrl_ab = nControlBlockOffset + nControlBlockCount;
+
     nCaseCount = ccs.getCaseCount();
     nControlCount = ccs.getControlCount();
     nIndivids = nCaseCount + nControlCount;
 
-    // clear case control buffer
-    memset( m_cases_controls, 0, nCaseControlSize * sizeof(DataBlock) );
-
-    // Mask out cases and controls
-    const PWORD *case_ptr = reinterpret_cast< const PWORD * >( ccs.stream_case_begin() );
-    const PWORD *ctrl_ptr = reinterpret_cast< const PWORD * >( ccs.stream_control_begin() );
-
-    const PWORD *tmp_case, *tmp_ctrl;
-
-    PWORD case_word, case_word_ab, ctrl_word, ctrl_word_ab;
-    PWORD _aa, _ab;
-    PWORD case_mask, ctrl_mask, mask;
-    PWORD _case, _ctrl;
-
-    // for every row
-    for( uint i = 0; i < (uint)max_row; ++i ) {
-        // locate the start of the data segment for each row 
-        PWORD *_data = reinterpret_cast< PWORD * >( data + i * blocks_per_row + 1 );
-        PWORD *_data_ab = reinterpret_cast< PWORD *>( data + i * blocks_per_row + 1 + genotype_block_offset_ab);
-
-        PWORD *case_out = reinterpret_cast< PWORD * >( m_cases_controls + i * nCaseControlBlockCount );
-        PWORD *case_out_ab = reinterpret_cast< PWORD * >(m_cases_controls + i * nCaseControlBlockCount + nCaseBlockCount );
-
-        PWORD *ctrl_out = reinterpret_cast< PWORD * >( m_cases_controls + i * nCaseControlBlockCount + nControlBlockOffset );
-        PWORD *ctrl_out_ab = reinterpret_cast< PWORD * >( m_cases_controls + i * nCaseControlBlockCount + nControlBlockOffset + nControlBlockCount);
-        
-
-        // reset the mask pointers
-        tmp_case = case_ptr;
-        tmp_ctrl = ctrl_ptr;
-
-        case_word = 0;
-        case_word_ab = 0;
-
-        ctrl_word = 0;
-        ctrl_word_ab = 0;
-
-        case_mask = 1;
-        ctrl_mask = 1;
-        // for every data block
-        for( uint j = 1; j < blocks_per_row; j += BLOCKS_PER_PWORD ) {
-            // mask out all unnecessary data columns
-            _aa = *_data++;
-            _ab = *_data_ab++;
-
-            _case = *tmp_case++;
-            _ctrl = *tmp_ctrl++;
-
-            mask = 1;
-            while( mask != 0 ) {
-                if( case_mask == 0 ) {
-                    *case_out++ = case_word;
-                    *case_out_ab++ = case_word_ab;
-
-                    case_word = 0;
-                    case_word_ab = 0;
-                    case_mask = 1;
-                }
-
-                if( ctrl_mask == 0 ) {
-                    *ctrl_out++ = ctrl_word;
-                    *ctrl_out_ab++ = ctrl_word_ab;
-                    ctrl_word = 0;
-                    ctrl_word_ab = 0;
-                    ctrl_mask = 1;
-                }
-                if( _case & mask ) {
-                    if( _aa & mask ) {
-                        case_word |= case_mask;
-                        if( _ab & mask )
-                            case_word_ab |= case_mask;
-                    } else if( _ab & mask ) {
-                        case_word_ab |= case_mask;
-                    }
-                    case_mask <<= 1;
-                } else if( _ctrl & mask ) {
-                    if (_aa & mask ) {
-                        ctrl_word |= ctrl_mask;
-                        if( _ab & mask )
-                            ctrl_word_ab |= ctrl_mask;
-                    } else if( _ab & mask ) {
-                        ctrl_word_ab |= ctrl_mask;
-                    }
-                    ctrl_mask <<= 1;
-                }
-
-                mask <<= 1;
-            }
-            
-        }
-
-        if( case_mask != 1 ) {
-            *case_out++ = case_word;
-            *case_out_ab++ = case_word_ab;
-        }
-        if( ctrl_mask != 1 ) {
-            *ctrl_out++ = ctrl_word;
-            *ctrl_out_ab++ = ctrl_word_ab;
-        }
-    }
+    // pack the case and control columns of every row
+    case_control_split layout;
+    layout.src = data + 1;
+    layout.src_stride = blocks_per_row;
+    layout.src_plane_offset = genotype_block_offset_ab;
+    layout.plane_words = genotype_block_offset_ab / BLOCKS_PER_PWORD;
+    layout.plane_count = 2;
+    layout.dst = m_cases_controls;
+    layout.dst_stride = nCaseControlBlockCount;
+    layout.case_blocks = nCaseBlockCount;
+    layout.ctrl_blocks = nControlBlockCount;
+
+    SplitCaseControl( layout, ccs, row_capacity );
 }
 
 void CompressedGenotypeTable5::getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist ) {
@@ -618,8 +539,8 @@ void CompressedGenotypeTable5::getCaseControlGenotypeDistribution( uint rIdx, Ca
     ResetFrequencyTable( case_gt );
     ResetFrequencyTable( ctrl_gt );
 
-    const PWORD *case_ptr = reinterpret_cast< const PWORD * >( ccs.stream_case_begin() );
-    const PWORD *ctrl_ptr = reinterpret_cast< const PWORD * >( ccs.stream_control_begin() );
+    const PWORD *case_ptr = reinterpret_cast< const PWORD * >( caseStream( ccs ) );
+    const PWORD *ctrl_ptr = reinterpret_cast< const PWORD * >( controlStream( ccs ) );
 
     // skip header block
     for( uint i = 1; i < genotype_block_offset_ab; i += BLOCKS_PER_PWORD ) {
@@ -656,10 +577,64 @@ void CompressedGenotypeTable5::getCaseControlGenotypeDistribution( uint rIdx, Ca
     ccgd.setControlDistribution(ctrl_gt);
 }
 
+void CompressedGenotypeTable5::getCaseControlGenotypeDistributions( uint rIdx, const vector< CaseControlSet * > &sets, CaseControlGenotypeDistribution *ccgd ) {
+    const uint nSets = sets.size();
+    if( nSets == 0 ) return;
+
+    PWORD *tmp_data = reinterpret_cast< PWORD * >(data + rIdx * blocks_per_row + 1);
+    PWORD *tmp_data_ab = reinterpret_cast< PWORD * >(data +  rIdx * blocks_per_row + 1+ genotype_block_offset_ab);
+
+    register PWORD _aa, _ab, _bb;
+    PWORD mask;
+
+    vector< frequency_table > case_gt( nSets ), ctrl_gt( nSets );
+    vector< const PWORD * > case_ptr( nSets ), ctrl_ptr( nSets );
+
+    for( uint k = 0; k < nSets; ++k ) {
+        ResetFrequencyTable( case_gt[k] );
+        ResetFrequencyTable( ctrl_gt[k] );
+
+        case_ptr[k] = reinterpret_cast< const PWORD * >( caseStream( *sets[k] ) );
+        ctrl_ptr[k] = reinterpret_cast< const PWORD * >( controlStream( *sets[k] ) );
+    }
+
+    // every word of the row is read once and masked by each set in turn
+    for( uint i = 1, w = 0; i < genotype_block_offset_ab; i += BLOCKS_PER_PWORD, ++w ) {
+        _aa = *tmp_data++;
+        _ab = *tmp_data_ab++;
+        _bb = _aa & _ab;
+
+        for( uint k = 0; k < nSets; ++k ) {
+            mask = case_ptr[k][w];
+            case_gt[k].bb += PopCount( mask & _bb );
+            case_gt[k].ab += PopCount( mask & _ab );
+            case_gt[k].aa += PopCount( mask & _aa );
+
+            mask = ctrl_ptr[k][w];
+            ctrl_gt[k].bb += PopCount( mask & _bb );
+            ctrl_gt[k].ab += PopCount( mask & _ab );
+            ctrl_gt[k].aa += PopCount( mask & _aa );
+        }
+    }
+
+    for( uint k = 0; k < nSets; ++k ) {
+        ctrl_gt[k].aa -= ctrl_gt[k].bb;
+        ctrl_gt[k].ab -= ctrl_gt[k].bb;
+        ctrl_gt[k].xx = sets[k]->getControlCount() - ctrl_gt[k].aa - ctrl_gt[k].ab - ctrl_gt[k].bb;
+
+        case_gt[k].aa -= case_gt[k].bb;
+        case_gt[k].ab -= case_gt[k].bb;
+        case_gt[k].xx = sets[k]->getCaseCount() - case_gt[k].aa - case_gt[k].ab - case_gt[k].bb;
+
+        ccgd[k].setCaseDistribution( case_gt[k] );
+        ccgd[k].setControlDistribution( ctrl_gt[k] );
+    }
+}
+
 void CompressedGenotypeTable5::getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd ) {
     //ulong offset = rIdx * nCaseControlBlockCount;
-    PWORD *tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount);
-    PWORD *tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ nCaseBlockCount);
+    PWORD *tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx ) );
+    PWORD *tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx ) + selected_case_ab );
 
     PWORD _aa, _ab;
 
@@ -676,8 +651,8 @@ void CompressedGenotypeTable5::getCaseControlGenotypeDistribution( uint rIdx, Ca
         case_gt.aa += PopCount( _aa );
     }
 
-    tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ nControlBlockOffset );
-    tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ nControlBlockOffset + nControlBlockCount);
+    tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx ) + selected_ctrl );
+    tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx ) + selected_ctrl_ab );
 
     for( uint i = 0; i < nControlBlockCount; i += BLOCKS_PER_PWORD ) {
         _aa = *tmp_data++;
@@ -702,8 +677,8 @@ void CompressedGenotypeTable5::getCaseControlGenotypeDistribution( uint rIdx, Ca
 
 void CompressedGenotypeTable5::getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m ) {
     //ulong offset = rIdx * nCaseControlBlockCount;
-    PWORD *tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount);
-    PWORD *tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ nCaseBlockCount);
+    PWORD *tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx ) );
+    PWORD *tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx ) + selected_case_ab );
 
     PWORD _aa, _ab;
 
@@ -720,8 +695,8 @@ void CompressedGenotypeTable5::getCaseControlGenotypeDistribution( uint rIdx, Ca
         case_gt.aa += PopCount( _aa );
     }
 
-    tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ nControlBlockOffset );
-    tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx * nCaseControlBlockCount+ nControlBlockOffset + nControlBlockCount);
+    tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx ) + selected_ctrl );
+    tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx ) + selected_ctrl_ab );
 
     for( uint i = 0; i < nControlBlockCount; i += BLOCKS_PER_PWORD ) {
         _aa = *tmp_data++;
@@ -746,6 +721,407 @@ void CompressedGenotypeTable5::getCaseControlGenotypeDistribution( uint rIdx, Ca
     computeMarginalInformation( case_gt, ctrl_gt, (double)nIndivids, m );
 }
 
+// rows ahead of the current one whose leading stream words are requested
+// from memory by the batch distribution kernels
+static const uint DISTRIBUTION_PREFETCH_ROWS = 2;
+
+/**
+ * Counts the set bits of the aa, ab and bb ( aa & ab ) streams of nWords words.
+ * Full groups of eight words go through vertical counters; the tail is counted
+ * word by word.
+ */
+static inline void CountStreams( const PWORD *_aa, const PWORD *_ab, uint nWords, frequency_table &ft ) {
+    vertical_counter c_aa, c_ab, c_bb;
+    ResetVerticalCounter( c_aa );
+    ResetVerticalCounter( c_ab );
+    ResetVerticalCounter( c_bb );
+
+    PWORD _bb[ 8 ];
+
+    uint i = 0;
+    for( ; i + 8 <= nWords; i += 8 ) {
+        for( uint j = 0; j < 8; ++j ) {
+            _bb[ j ] = _aa[ i + j ] & _ab[ i + j ];
+        }
+
+        AccumulateVertical( c_aa, _aa + i );
+        AccumulateVertical( c_ab, _ab + i );
+        AccumulateVertical( c_bb, _bb );
+    }
+
+    ft.aa = VerticalCount( c_aa );
+    ft.ab = VerticalCount( c_ab );
+    ft.bb = VerticalCount( c_bb );
+
+    for( ; i < nWords; ++i ) {
+        ft.bb += PopCount( _aa[ i ] & _ab[ i ] );
+        ft.ab += PopCount( _ab[ i ] );
+        ft.aa += PopCount( _aa[ i ] );
+    }
+}
+
+void CompressedGenotypeTable5::countGenotypeStreams( const DataBlock *row, frequency_table &ft ) const {
+    const uint nWords = ( genotype_block_offset_ab - 1 + BLOCKS_PER_PWORD - 1 ) / BLOCKS_PER_PWORD;
+
+    CountStreams( reinterpret_cast< const PWORD * >( row + 1 ), reinterpret_cast< const PWORD * >( row + 1 + genotype_block_offset_ab ), nWords, ft );
+
+    // same totals as getGenotypeDistribution: padding bits count as unknown
+    ft.xx = nWords * PROCESSOR_WORD_SIZE - ( ft.aa + ft.ab - ft.bb );
+    ft.aa -= ft.bb;
+    ft.ab -= ft.bb;
+}
+
+void CompressedGenotypeTable5::countSelectedStreams( const DataBlock *selected, frequency_table &case_gt, frequency_table &ctrl_gt ) const {
+    CountStreams( reinterpret_cast< const PWORD * >( selected ), reinterpret_cast< const PWORD * >( selected + selected_case_ab ), ( nCaseBlockCount + BLOCKS_PER_PWORD - 1 ) / BLOCKS_PER_PWORD, case_gt );
+    CountStreams( reinterpret_cast< const PWORD * >( selected + selected_ctrl ), reinterpret_cast< const PWORD * >( selected + selected_ctrl_ab ), ( nControlBlockCount + BLOCKS_PER_PWORD - 1 ) / BLOCKS_PER_PWORD, ctrl_gt );
+
+    case_gt.ab -= case_gt.bb;
+    case_gt.aa -= case_gt.bb;
+    case_gt.xx = nCaseCount - case_gt.aa - case_gt.ab - case_gt.bb;
+
+    ctrl_gt.ab -= ctrl_gt.bb;
+    ctrl_gt.aa -= ctrl_gt.bb;
+    ctrl_gt.xx = nControlCount - ctrl_gt.aa - ctrl_gt.ab - ctrl_gt.bb;
+}
+
+void CompressedGenotypeTable5::getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out ) {
+    for( uint r = row_begin; r < row_end; ++r ) {
+        if( r + DISTRIBUTION_PREFETCH_ROWS < row_end ) {
+            const DataBlock *next = data + ( ulong )( r + DISTRIBUTION_PREFETCH_ROWS ) * blocks_per_row;
+            __builtin_prefetch( next );
+            __builtin_prefetch( next + 1 + genotype_block_offset_ab );
+        }
+
+        countGenotypeStreams( data + ( ulong ) r * blocks_per_row, *out++ );
+    }
+}
+
+void CompressedGenotypeTable5::getCaseControlGenotypeDistributions( uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls ) {
+    for( uint r = row_begin; r < row_end; ++r ) {
+        if( r + DISTRIBUTION_PREFETCH_ROWS < row_end ) {
+            const DataBlock *next = selectedRow( r + DISTRIBUTION_PREFETCH_ROWS );
+            __builtin_prefetch( next );
+            __builtin_prefetch( next + selected_case_ab );
+            __builtin_prefetch( next + selected_ctrl );
+            __builtin_prefetch( next + selected_ctrl_ab );
+        }
+
+        countSelectedStreams( selectedRow( r ), *cases++, *ctrls++ );
+    }
+}
+
+// bit planes of a column counter; a counter takes COLUMN_COUNTER_ROWS rows
+// before it is flushed into the column distributions
+static const uint COLUMN_COUNTER_BITS = 8;
+static const uint COLUMN_COUNTER_ROWS = ( 1 << COLUMN_COUNTER_BITS ) - 1;
+
+// counted streams and the frequency_table entry each is added to; the AA
+// count of a column is whatever the other three leave of the rows
+static const uint COLUMN_COUNTER_STREAMS = 3;
+static const byte COLUMN_STREAM_INDEX[ COLUMN_COUNTER_STREAMS ] = { 1, 2, 3 };     // ab, bb, xx
+
+/**
+ * Adds the bits of x to a bit-sliced counter: bit b of planes[ j ] is bit j of
+ * the count of column b. The carry only ripples while x has bits left, and
+ * COLUMN_COUNTER_ROWS additions cannot carry out of the last plane.
+ */
+static inline void AddToColumnCounter( PWORD *planes, PWORD x ) {
+    for( uint j = 0; x != 0; ++j ) {
+        PWORD carry = planes[ j ] & x;
+        planes[ j ] ^= x;
+        x = carry;
+    }
+}
+
+static void FlushColumnCounters( PWORD *counters, uint nWords, uint nRows, frequency_table *columns, uint nColumns ) {
+    for( uint c = 0; c < nColumns; ++c ) {
+        columns[ c ].aa += nRows;
+    }
+
+    for( uint w = 0; w < nWords; ++w ) {
+        PWORD *planes = counters + w * COLUMN_COUNTER_STREAMS * COLUMN_COUNTER_BITS;
+        uint base = w * PROCESSOR_WORD_SIZE;
+
+        for( uint s = 0; s < COLUMN_COUNTER_STREAMS; ++s ) {
+            for( uint j = 0; j < COLUMN_COUNTER_BITS; ++j, ++planes ) {
+                PWORD p = *planes;
+                *planes = 0;
+
+                for( ; p != 0; p &= ( p - 1 ) ) {
+                    uint col = base + __builtin_ctzl( p );
+                    if( col >= nColumns ) break;
+
+                    columns[ col ].freq[ COLUMN_STREAM_INDEX[ s ] ] += ( 1 << j );
+                    columns[ col ].aa -= ( 1 << j );
+                }
+            }
+        }
+    }
+}
+
+void CompressedGenotypeTable5::addColumnStreams( const DataBlock * const *rows, uint nRows, frequency_table *columns, uint nColumns ) const {
+    const uint nWords = ( genotype_block_offset_ab - 1 + BLOCKS_PER_PWORD - 1 ) / BLOCKS_PER_PWORD;
+
+    vector< PWORD > counters( nWords * COLUMN_COUNTER_STREAMS * COLUMN_COUNTER_BITS, 0 );
+
+    for( uint r0 = 0; r0 < nRows; r0 += COLUMN_COUNTER_ROWS ) {
+        uint r1 = min( r0 + COLUMN_COUNTER_ROWS, nRows );
+
+        for( uint r = r0; r < r1; ++r ) {
+            const PWORD *_aa = reinterpret_cast< const PWORD * >( rows[ r ] + 1 );
+            const PWORD *_ab = reinterpret_cast< const PWORD * >( rows[ r ] + 1 + genotype_block_offset_ab );
+            PWORD *planes = &counters[ 0 ];
+
+            for( uint w = 0; w < nWords; ++w ) {
+                PWORD a = _aa[ w ], b = _ab[ w ];
+
+                AddToColumnCounter( planes, b & ~a );
+                planes += COLUMN_COUNTER_BITS;
+                AddToColumnCounter( planes, a & b );
+                planes += COLUMN_COUNTER_BITS;
+                AddToColumnCounter( planes, ~( a | b ) );
+                planes += COLUMN_COUNTER_BITS;
+            }
+        }
+
+        FlushColumnCounters( &counters[ 0 ], nWords, r1 - r0, columns, nColumns );
+    }
+}
+
+void CompressedGenotypeTable5::addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns ) {
+    if( row_begin >= row_end ) return;
+
+    vector< const DataBlock * > rows;
+    rows.reserve( row_end - row_begin );
+    for( uint r = row_begin; r < row_end; ++r ) {
+        rows.push_back( data + ( ulong ) r * blocks_per_row );
+    }
+
+    addColumnStreams( &rows[ 0 ], rows.size(), columns, max_column );
+}
+
+const ushort *CompressedGenotypeTable5::traitPlanes( QuantitativeTraitSet &qts ) {
+    assert( qts.getStreamBlockCount() == genotype_block_offset_ab );
+    return qts.plane_begin();
+}
+
+/**
+ * Each group mask (het, hom, missing) is restricted to the phenotyped columns
+ * and weighted by the value planes: the group sum is the sum over the planes of
+ * PopCount( group & plane_k ) << k. The popcounts are kept per plane and only
+ * weighted once the row is done. The AA group is whatever the other three
+ * leave of the totals of qts, so it is never counted; the square planes are
+ * only read for words which have a missing genotype.
+ */
+void CompressedGenotypeTable5::sumTraitStreams( const DataBlock *row, const ushort *planes, const QuantitativeTraitSet &qts, trait_sums &ts ) const {
+    const uint nWords = ( genotype_block_offset_ab - 1 + BLOCKS_PER_PWORD - 1 ) / BLOCKS_PER_PWORD;
+    const uint nBits = qts.getValueBits();
+    const uint plane_words = genotype_block_offset_ab / BLOCKS_PER_PWORD;
+
+    const PWORD *_aa = reinterpret_cast< const PWORD * >( row + 1 );
+    const PWORD *_ab = reinterpret_cast< const PWORD * >( row + 1 + genotype_block_offset_ab );
+    const PWORD *mask = reinterpret_cast< const PWORD * >( planes );
+    const PWORD *values = mask + plane_words;
+    const PWORD *squares = values + nBits * plane_words;
+
+    ulong het_bits[ QT_MAX_VALUE_BITS ], hom_bits[ QT_MAX_VALUE_BITS ], mis_bits[ QT_MAX_VALUE_BITS ];
+    ulong mis_square_bits[ 2 * QT_MAX_VALUE_BITS ];
+
+    memset( het_bits, 0, sizeof( het_bits ) );
+    memset( hom_bits, 0, sizeof( hom_bits ) );
+    memset( mis_bits, 0, sizeof( mis_bits ) );
+    memset( mis_square_bits, 0, sizeof( mis_square_bits ) );
+
+    ResetTraitSums( ts );
+
+    for( uint w = 0; w < nWords; ++w ) {
+        PWORD m = mask[ w ];
+        if( !m ) continue;
+
+        PWORD a = _aa[ w ], b = _ab[ w ];
+        PWORD het = b & ~a & m;
+        PWORD hom = a & b & m;
+        PWORD mis = ~( a | b ) & m;
+
+        ts.count.ab += PopCount( het );
+        ts.count.bb += PopCount( hom );
+        ts.count.xx += PopCount( mis );
+
+        const PWORD *p = values + w;
+        for( uint k = 0; k < nBits; ++k, p += plane_words ) {
+            het_bits[ k ] += PopCount( het & *p );
+            hom_bits[ k ] += PopCount( hom & *p );
+        }
+
+        if( !mis ) continue;
+
+        p = values + w;
+        for( uint k = 0; k < nBits; ++k, p += plane_words ) {
+            mis_bits[ k ] += PopCount( mis & *p );
+        }
+
+        p = squares + w;
+        for( uint k = 0; k < 2 * nBits; ++k, p += plane_words ) {
+            mis_square_bits[ k ] += PopCount( mis & *p );
+        }
+    }
+
+    ulong mis_square_sum = 0;
+    for( uint k = 0; k < nBits; ++k ) {
+        ts.sum[ 1 ] += het_bits[ k ] << k;
+        ts.sum[ 2 ] += hom_bits[ k ] << k;
+        ts.sum[ 3 ] += mis_bits[ k ] << k;
+    }
+    for( uint k = 0; k < 2 * nBits; ++k ) {
+        mis_square_sum += mis_square_bits[ k ] << k;
+    }
+
+    ts.count.aa = qts.getCount() - ts.count.ab - ts.count.bb - ts.count.xx;
+    ts.sum[ 0 ] = qts.getValueSum() - ts.sum[ 1 ] - ts.sum[ 2 ] - ts.sum[ 3 ];
+    ts.square_sum_called = qts.getSquareSum() - mis_square_sum;
+}
+
+void CompressedGenotypeTable5::getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out ) {
+    const ushort *planes = traitPlanes( qts );
+
+    for( uint r = row_begin; r < row_end; ++r ) {
+        if( r + DISTRIBUTION_PREFETCH_ROWS < row_end ) {
+            const DataBlock *next = data + ( ulong )( r + DISTRIBUTION_PREFETCH_ROWS ) * blocks_per_row;
+            __builtin_prefetch( next );
+            __builtin_prefetch( next + 1 + genotype_block_offset_ab );
+        }
+
+        sumTraitStreams( data + ( ulong ) r * blocks_per_row, planes, qts, *out++ );
+    }
+}
+
+/**
+ * Eight columns at a time: the aa and ab bytes of the columns are spread over
+ * the bytes of a word, which then holds the eight codes.
+ */
+void CompressedGenotypeTable5::decodeStreams( const DataBlock *row, byte *codes, uint nColumns ) const {
+    const byte *_aa = reinterpret_cast< const byte * >( row + 1 );
+    const byte *_ab = reinterpret_cast< const byte * >( row + 1 + genotype_block_offset_ab );
+
+    ulong group;
+    uint c = 0;
+    for( ; c + 8 <= nColumns; c += 8, ++_aa, ++_ab ) {
+        group = SpreadBits( *_aa ) | ( SpreadBits( *_ab ) << 1 );
+        memcpy( codes + c, &group, 8 );
+    }
+
+    if( c < nColumns ) {
+        group = SpreadBits( *_aa ) | ( SpreadBits( *_ab ) << 1 );
+        memcpy( codes + c, &group, nColumns - c );
+    }
+}
+
+void CompressedGenotypeTable5::getGenotypeCodes( uint row_begin, uint row_end, byte *codes ) {
+    for( uint r = row_begin; r < row_end; ++r, codes += max_column ) {
+        decodeStreams( data + ( ulong ) r * blocks_per_row, codes, max_column );
+    }
+}
+
+const uint CompressedGenotypeTable5::NO_STREAM_COLUMN = 0xFFFFFFFF;
+
+void CompressedGenotypeTable5::streamWordRange( uint part, uint nParts, uint &w_begin, uint &w_end ) const {
+    const ulong nWords = genotype_block_offset_ab / BLOCKS_PER_PWORD;
+
+    assert( part < nParts );
+    w_begin = ( uint )( nWords * part / nParts );
+    w_end = ( uint )( nWords * ( part + 1 ) / nParts );
+}
+
+/**
+ * Only the set bits of the AB, BB and missing masks are visited, so a row
+ * costs l additions per non-AA column. Without a column map the padding bits
+ * past the last column, which read as missing, are masked off.
+ */
+void CompressedGenotypeTable5::sumVectorStreams( const DataBlock *row, const double *v, uint l, const uint *stream_columns, double *sums ) const {
+    const uint nWords = genotype_block_offset_ab / BLOCKS_PER_PWORD;
+    const PWORD *_aa = reinterpret_cast< const PWORD * >( row + 1 );
+    const PWORD *_ab = reinterpret_cast< const PWORD * >( row + 1 + genotype_block_offset_ab );
+
+    PWORD group[ 3 ];
+    memset( sums, 0, 3 * l * sizeof( double ) );
+
+    for( uint w = 0, base = 0; w < nWords; ++w, base += PROCESSOR_WORD_SIZE ) {
+        PWORD a = _aa[ w ], b = _ab[ w ];
+        group[ 0 ] = b & ~a;
+        group[ 1 ] = a & b;
+        group[ 2 ] = ~( a | b );
+
+        if( stream_columns == NULL ) {
+            if( base >= ( uint ) max_column ) break;
+            if( base + PROCESSOR_WORD_SIZE > ( uint ) max_column ) {
+                group[ 2 ] &= (( PWORD ) 1 << ( max_column - base ) ) - 1;
+            }
+        }
+
+        for( uint g = 0; g < 3; ++g ) {
+            double *s = sums + g * l;
+            for( PWORD bits = group[ g ]; bits != 0; bits &= ( bits - 1 ) ) {
+                uint col = base + __builtin_ctzl( bits );
+                if( stream_columns != NULL && ( col = stream_columns[ col ] ) == NO_STREAM_COLUMN ) continue;
+
+                const double *x = v + ( ulong ) col * l;
+                for( uint k = 0; k < l; ++k ) {
+                    s[ k ] += x[ k ];
+                }
+            }
+        }
+    }
+}
+
+void CompressedGenotypeTable5::addVectorStreams( const DataBlock *row, const double *w, uint l, const uint *stream_columns, uint w_begin, uint w_end, double *columns ) const {
+    const PWORD *_aa = reinterpret_cast< const PWORD * >( row + 1 );
+    const PWORD *_ab = reinterpret_cast< const PWORD * >( row + 1 + genotype_block_offset_ab );
+
+    PWORD group[ 3 ];
+
+    for( uint i = w_begin, base = w_begin * PROCESSOR_WORD_SIZE; i < w_end; ++i, base += PROCESSOR_WORD_SIZE ) {
+        PWORD a = _aa[ i ], b = _ab[ i ];
+        group[ 0 ] = b & ~a;
+        group[ 1 ] = a & b;
+        group[ 2 ] = ~( a | b );
+
+        if( stream_columns == NULL ) {
+            if( base >= ( uint ) max_column ) break;
+            if( base + PROCESSOR_WORD_SIZE > ( uint ) max_column ) {
+                group[ 2 ] &= (( PWORD ) 1 << ( max_column - base ) ) - 1;
+            }
+        }
+
+        for( uint g = 0; g < 3; ++g ) {
+            const double *x = w + g * l;
+            for( PWORD bits = group[ g ]; bits != 0; bits &= ( bits - 1 ) ) {
+                uint col = base + __builtin_ctzl( bits );
+                if( stream_columns != NULL && ( col = stream_columns[ col ] ) == NO_STREAM_COLUMN ) continue;
+
+                double *s = columns + ( ulong ) col * l;
+                for( uint k = 0; k < l; ++k ) {
+                    s[ k ] += x[ k ];
+                }
+            }
+        }
+    }
+}
+
+void CompressedGenotypeTable5::getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums ) {
+    for( uint r = row_begin; r < row_end; ++r, sums += 3 * l ) {
+        sumVectorStreams( data + ( ulong ) r * blocks_per_row, v, l, NULL, sums );
+    }
+}
+
+void CompressedGenotypeTable5::addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns ) {
+    uint w_begin, w_end;
+    streamWordRange( part, nParts, w_begin, w_end );
+
+    for( uint r = row_begin; r < row_end; ++r, w += 3 * l ) {
+        addVectorStreams( data + ( ulong ) r * blocks_per_row, w, l, NULL, w_begin, w_end, columns );
+    }
+}
+
 void CompressedGenotypeTable5::getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct ) {
     //ulong ma_offset = rIdx1 * blocks_per_row + 1;
     //ulong mb_offset = rIdx2 * blocks_per_row + 1;
@@ -819,8 +1195,8 @@ void CompressedGenotypeTable5::getCaseControlContingencyTable( uint rIdx1, uint
     register PWORD a_aa, a_bb, b_aa, b_bb, a_ab, b_ab, b_xx, a_xx;
     PWORD mask = 0;
 
-    const PWORD *case_ptr = reinterpret_cast< const PWORD * >( ccs.stream_case_begin() );
-    const PWORD *ctrl_ptr = reinterpret_cast< const PWORD * >( ccs.stream_control_begin() );
+    const PWORD *case_ptr = reinterpret_cast< const PWORD * >( caseStream( ccs ) );
+    const PWORD *ctrl_ptr = reinterpret_cast< const PWORD * >( controlStream( ccs ) );
 
     for( uint i = 1; i < genotype_block_offset_ab; i += BLOCKS_PER_PWORD ) {
         mask = *case_ptr++;
@@ -893,14 +1269,95 @@ void CompressedGenotypeTable5::getCaseControlContingencyTable( uint rIdx1, uint
 
     ccct.updateContingencyTables(case_cont, ctrl_cont);
 }
+/**
+ * Adds the columns selected by mask to a contingency table. The streams are
+ * the decoded, unmasked streams of both markers; as in the single set kernel,
+ * every column outside of the mask is counted as missing.
+ */
+static inline void AddMaskedContingencyStreams( CONTIN_TABLE_T &cont, PWORD mask, PWORD a_aa, PWORD a_ab, PWORD a_bb, PWORD a_xx, PWORD b_aa, PWORD b_ab, PWORD b_bb, PWORD b_xx ) {
+    a_aa &= mask; a_ab &= mask; a_bb &= mask; a_xx |= ~mask;
+    b_aa &= mask; b_ab &= mask; b_bb &= mask; b_xx |= ~mask;
+
+    AddToContingencyStream( cont.AA_BB, a_aa, b_aa );
+    AddToContingencyStream( cont.AA_Bb, a_aa, b_ab );
+    AddToContingencyStream( cont.AA_bb, a_aa, b_bb );
+    AddToContingencyStream( cont.Aa_BB, a_ab, b_aa );
+    AddToContingencyStream( cont.Aa_Bb, a_ab, b_ab );
+    AddToContingencyStream( cont.Aa_bb, a_ab, b_bb );
+    AddToContingencyStream( cont.aa_BB, a_bb, b_aa );
+    AddToContingencyStream( cont.aa_Bb, a_bb, b_ab );
+    AddToContingencyStream( cont.aa_bb, a_bb, b_bb );
+
+    if( b_xx ) {
+        AddToContingencyStream( cont.AA_xx, a_aa, b_xx );
+        AddToContingencyStream( cont.Aa_xx, a_ab, b_xx );
+        AddToContingencyStream( cont.aa_xx, a_bb, b_xx );
+    }
+    if( a_xx ) {
+        AddToContingencyStream( cont.xx_BB, a_xx, b_aa );
+        AddToContingencyStream( cont.xx_Bb, a_xx, b_ab );
+        AddToContingencyStream( cont.xx_bb, a_xx, b_bb );
+    }
+    if( a_xx || b_xx )
+        AddToContingencyStream( cont.xx_xx, a_xx, b_xx );
+}
+
+void CompressedGenotypeTable5::getCaseControlContingencyTables( uint rIdx1, uint rIdx2, const vector< CaseControlSet * > &sets, CaseControlContingencyTable *ccct ) {
+    const uint nSets = sets.size();
+    if( nSets == 0 ) return;
+
+    PWORD *ma_tmp_data = reinterpret_cast< PWORD * >( data +  rIdx1 * blocks_per_row + 1);
+    PWORD *ma_tmp_data_ab = reinterpret_cast< PWORD * >( data +  rIdx1 * blocks_per_row + 1+ genotype_block_offset_ab );
+
+    PWORD *mb_tmp_data = reinterpret_cast< PWORD * >( data +  rIdx2 * blocks_per_row + 1);
+    PWORD *mb_tmp_data_ab = reinterpret_cast< PWORD * >( data +  rIdx2 * blocks_per_row + 1+ genotype_block_offset_ab );
+
+    vector< CONTIN_TABLE_T > case_cont( nSets ), ctrl_cont( nSets );
+    vector< const PWORD * > case_ptr( nSets ), ctrl_ptr( nSets );
+
+    for( uint k = 0; k < nSets; ++k ) {
+        ResetContingencyTable( case_cont[k] );
+        ResetContingencyTable( ctrl_cont[k] );
+
+        case_ptr[k] = reinterpret_cast< const PWORD * >( caseStream( *sets[k] ) );
+        ctrl_ptr[k] = reinterpret_cast< const PWORD * >( controlStream( *sets[k] ) );
+    }
+
+    register PWORD a_aa, a_bb, b_aa, b_bb, a_ab, b_ab, b_xx, a_xx;
+
+    // both rows are read and decoded once per word; only the masking and
+    // the counting are repeated for each set
+    for( uint i = 1, w = 0; i < genotype_block_offset_ab; i += BLOCKS_PER_PWORD, ++w ) {
+        a_aa = *ma_tmp_data++;
+        a_ab = *ma_tmp_data_ab++;
+        DecodeBitStreams2BitStream( a_aa, a_ab, a_bb, a_xx );
+
+        b_aa = *mb_tmp_data++;
+        b_ab = *mb_tmp_data_ab++;
+        DecodeBitStreams2BitStream( b_aa, b_ab, b_bb, b_xx );
+
+        for( uint k = 0; k < nSets; ++k ) {
+            AddMaskedContingencyStreams( case_cont[k], case_ptr[k][w], a_aa, a_ab, a_bb, a_xx, b_aa, b_ab, b_bb, b_xx );
+            AddMaskedContingencyStreams( ctrl_cont[k], ctrl_ptr[k][w], a_aa, a_ab, a_bb, a_xx, b_aa, b_ab, b_bb, b_xx );
+        }
+    }
+
+    for( uint k = 0; k < nSets; ++k ) {
+        ccct[k].setMarkerAIndex( rIdx1 );
+        ccct[k].setMarkerBIndex( rIdx2 );
+
+        ccct[k].updateContingencyTables( case_cont[k], ctrl_cont[k] );
+    }
+}
+
 void CompressedGenotypeTable5::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct ) {
     //ulong ma_offset = rIdx1 * nCaseControlBlockCount;
     //ulong mb_offset = rIdx2 * nCaseControlBlockCount;
-    PWORD *ma_tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx1 * nCaseControlBlockCount);
-    PWORD *ma_tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx1 * nCaseControlBlockCount+ nCaseBlockCount );
+    PWORD *ma_tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx1 ) );
+    PWORD *ma_tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx1 ) + selected_case_ab );
 
-    PWORD *mb_tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx2 * nCaseControlBlockCount);
-    PWORD *mb_tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx2 * nCaseControlBlockCount+ nCaseBlockCount );
+    PWORD *mb_tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx2 ) );
+    PWORD *mb_tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx2 ) + selected_case_ab );
 
     CONTIN_TABLE_T case_cont, ctrl_cont;
     ResetContingencyTable( case_cont );
@@ -941,11 +1398,11 @@ void CompressedGenotypeTable5::getCaseControlContingencyTable( uint rIdx1, uint
             AddToContingencyStream( case_cont.xx_xx, a_xx, b_xx );
     }
 
-    ma_tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx1 * nCaseControlBlockCount+ nControlBlockOffset );
-    ma_tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx1 * nCaseControlBlockCount+ nControlBlockOffset + nControlBlockCount );
+    ma_tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx1 ) + selected_ctrl );
+    ma_tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx1 ) + selected_ctrl_ab );
 
-    mb_tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx2 * nCaseControlBlockCount+ nControlBlockOffset );
-    mb_tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx2 * nCaseControlBlockCount+ nControlBlockOffset + nControlBlockCount );
+    mb_tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx2 ) + selected_ctrl );
+    mb_tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx2 ) + selected_ctrl_ab );
 
     for( uint i = 0; i < nControlBlockCount; i += BLOCKS_PER_PWORD ) {
         a_aa = *ma_tmp_data++;
@@ -987,11 +1444,11 @@ void CompressedGenotypeTable5::getCaseControlContingencyTable( uint rIdx1, uint
 }
 
 void CompressedGenotypeTable5::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct ) {
-    PWORD *ma_tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx1 * nCaseControlBlockCount);
-    PWORD *ma_tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls + rIdx1 * nCaseControlBlockCount + nCaseBlockCount );
+    PWORD *ma_tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx1 ) );
+    PWORD *ma_tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx1 ) + selected_case_ab );
 
-    PWORD *mb_tmp_data = reinterpret_cast< PWORD * >( m_cases_controls +  rIdx2 * nCaseControlBlockCount);
-    PWORD *mb_tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls + rIdx2 * nCaseControlBlockCount+ nCaseBlockCount );
+    PWORD *mb_tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx2 ) );
+    PWORD *mb_tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx2 ) + selected_case_ab );
 
     CONTIN_TABLE_T case_cont, ctrl_cont;
     ResetContingencyTable( case_cont );
@@ -1029,11 +1486,11 @@ void CompressedGenotypeTable5::getCaseControlContingencyTable( uint rIdx1, uint
 
         case_cont.xx_xx = m2.cases.xx - case_cont.AA_xx - case_cont.Aa_xx - case_cont.aa_xx;
 
-        ma_tmp_data = reinterpret_cast< PWORD * >( m_cases_controls + rIdx1 * nCaseControlBlockCount + nControlBlockOffset );
-        ma_tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls + rIdx1 * nCaseControlBlockCount+ nControlBlockOffset + nControlBlockCount );
+        ma_tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx1 ) + selected_ctrl );
+        ma_tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx1 ) + selected_ctrl_ab );
 
-        mb_tmp_data = reinterpret_cast< PWORD * >( m_cases_controls + rIdx2 * nCaseControlBlockCount + nControlBlockOffset );
-        mb_tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls + rIdx2 * nCaseControlBlockCount + nControlBlockOffset + nControlBlockCount );
+        mb_tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx2 ) + selected_ctrl );
+        mb_tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx2 ) + selected_ctrl_ab );
 
         for( uint i = 0; i < nControlBlockCount; i += BLOCKS_PER_PWORD ) {
             a_aa = *ma_tmp_data++;
@@ -1105,11 +1562,11 @@ void CompressedGenotypeTable5::getCaseControlContingencyTable( uint rIdx1, uint
 
         case_cont.Aa_Bb = m2.cases.ab - case_cont.AA_Bb - case_cont.aa_Bb;
 
-        ma_tmp_data = reinterpret_cast< PWORD * >( m_cases_controls + rIdx1 * nCaseControlBlockCount + nControlBlockOffset );
-        ma_tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls + rIdx1 * nCaseControlBlockCount+ nControlBlockOffset + nControlBlockCount );
+        ma_tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx1 ) + selected_ctrl );
+        ma_tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx1 ) + selected_ctrl_ab );
 
-        mb_tmp_data = reinterpret_cast< PWORD * >( m_cases_controls + rIdx2 * nCaseControlBlockCount + nControlBlockOffset );
-        mb_tmp_data_ab = reinterpret_cast< PWORD * >( m_cases_controls + rIdx2 * nCaseControlBlockCount + nControlBlockOffset + nControlBlockCount );
+        mb_tmp_data = reinterpret_cast< PWORD * >( selectedRow( rIdx2 ) + selected_ctrl );
+        mb_tmp_data_ab = reinterpret_cast< PWORD * >( selectedRow( rIdx2 ) + selected_ctrl_ab );
 
         count_AB = 0; count_Ab = 0; count_aB = 0; count_ab = 0;
         for( uint i = 0; i < nControlBlockCount; i += BLOCKS_PER_PWORD ) {
@@ -1149,74 +1606,6 @@ void CompressedGenotypeTable5::getCaseControlContingencyTable( uint rIdx1, uint
     ccct.updateContingencyTables(case_cont, ctrl_cont);
 }
 
-void CompressedGenotypeTable5::constructCountLookup( ) {
-    genotype_counts counts;
-    for( uint i = 0; i < 0x10000; ++i ) {
-        counts.ui = 0;
-
-        for( uint j = 0, k = i; j < 8; ++j, k >>= 2 ) {
-            switch( k & 0x0003 ) {
-            case 0x0003:
-                ++counts.c3;
-                break;
-            case 0x0002:
-                ++counts.c2;
-                break;
-            case 0x0001:
-                ++counts.c1;
-                break;
-            default:
-                ++counts.c0;
-                break;
-            }
-        }
-
-        count_lookup[i].ui = counts.ui;
-    }
-}
-
-void CompressedGenotypeTable5::constructContingencyLookup() {
-    joint_genotypes jg;
-
-    byte ma, mb;
-    uint base_offset, offset;
-    int bit_mask, shift, idx;
-
-    memset( contingency_lookup, 0, 16 * 256 * 256 * sizeof( joint_genotypes ) );
-
-    for( uint k = 1, mask = 0x00; k < 16; ++k ) {
-        mask = 0;
-        mask |= (( k & 0x01 ) ? 0x03 : 0 );
-        mask |= (( k & 0x02 ) ? 0x0C : 0 );
-        mask |= (( k & 0x04 ) ? 0x30 : 0 );
-        mask |= (( k & 0x08 ) ? 0xC0 : 0 );
-
-        skip_count[ k ] = 0;
-        skip_count[ k ] += ((( k & 0x01 ) ) ? 0 : 1 );
-        skip_count[ k ] += ((( k & 0x02 ) ) ? 0 : 1 );
-        skip_count[ k ] += ((( k & 0x04 ) ) ? 0 : 1 );
-        skip_count[ k ] += ((( k & 0x08 ) ) ? 0 : 1 );
-
-        for( uint i = 0; i < 256; ++i ) {
-            base_offset = (( k << 16 ) | ( i << 8 ) );
-            for( uint j = 0; j < 256; ++j ) {
-                // clear data
-                ResetJointGenotype( jg );
-                for( bit_mask = 0xC0, shift = 6, idx = 0; shift >= 0; bit_mask >>= 2, shift -= 2, ++idx ) {
-                    ma = (( i & ( bit_mask & mask ) ) >> shift );
-                    mb = (( j & ( bit_mask & mask ) ) >> shift );
-
-                    SetJointGenotype( jg, ma, mb, idx );
-                }
-
-                offset = base_offset | j;
-                CopyJointGenotype( contingency_lookup[ offset ], jg );
-
-            }
-        }
-    }
-}
-
 bool CompressedGenotypeTable5::isGenotypeHomozygous( ushort encoded_gt ) {
     // 0 == AA; 5 == CC; 10 == GG; 15 == TT
     return (( encoded_gt != 0xFFFF ) && ( encoded_gt == 0 || encoded_gt == 5 || encoded_gt == 10 || encoded_gt == 15 ) );
@@ -1237,9 +1626,6 @@ CompressedGenotypeTable5::~CompressedGenotypeTable5() {
         delete [] lookup[ i ];
     }
     delete [] lookup;
-
-//    delete [] contingency_lookup;
-//    delete [] skip_count;
 }
 
 }
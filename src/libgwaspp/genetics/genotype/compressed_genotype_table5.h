@@ -37,6 +37,7 @@
 #include "genetics/genotype/geno_table.h"
 #include "genetics/genotype/common_genotype.h"
 #include "genetics/genotype/common_genotype_func.h"
+#include "genetics/genotype/case_control_split.h"
 
 using namespace std;
 using namespace util;
@@ -124,7 +125,8 @@ inline void DecodeBitStreams2BitStream( PWORD & _aa, PWORD & _ab, PWORD & _bb, P
  */
 class CompressedGenotypeTable5 : public GenoTable {
 public:
-    CompressedGenotypeTable5( indexer *markers, indexer *individs ) : GenoTable( markers, individs ), gt_lookup(NULL) {
+    CompressedGenotypeTable5( indexer *markers, indexer *individs ) : GenoTable( markers, individs ), gt_lookup(NULL), selected_data(NULL) {
+        row_capacity = max_row;
         initialize();
     }
 
@@ -139,12 +141,29 @@ public:
 
     bool isGenotypeHomozygous( ushort encoded_gt );
 
+    // the stream kernels only read the table
+    bool supportsConcurrentReads() const { return true; }
+    // each row is encoded in place at rIdx * blocks_per_row
+    bool supportsConcurrentRowWrites() const { return true; }
+
     void selectMarker( uint rIdx );
 
     void getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist );
     void getCaseControlGenotypeDistribution( uint rIdx, CaseControlSet &ccs, CaseControlGenotypeDistribution &ccgd );
     void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd );
     void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m ); 
+    void getCaseControlGenotypeDistributions( uint rIdx, const vector< CaseControlSet * > &sets, CaseControlGenotypeDistribution *ccgd );
+
+    void getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out );
+    void getCaseControlGenotypeDistributions( uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls );
+
+    void addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns );
+
+    void getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out );
+    void getGenotypeCodes( uint row_begin, uint row_end, byte *codes );
+
+    void getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums );
+    void addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns );
 
     void selectMarkerPair( uint maIdx, uint mbIdx );
     void selectCaseControl( CaseControlSet &ccs );
@@ -155,24 +174,68 @@ public:
 
     void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct );
     void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct );
+    void getCaseControlContingencyTables( uint rIdx1, uint rIdx2, const vector< CaseControlSet * > &sets, CaseControlContingencyTable *ccct );
 
     virtual ~CompressedGenotypeTable5();
 protected:
+    // allows derived tables to allocate fewer row slots than there are markers
+    CompressedGenotypeTable5( indexer *markers, indexer *individs, ulong nRowSlots ) : GenoTable( markers, individs ), gt_lookup(NULL), row_capacity( nRowSlots ), selected_data(NULL) {
+        initialize();
+    }
+
     void initialize();
-    void constructCountLookup();
-    void constructContingencyLookup();
+    void encodeGenotypeRow( DataBlock *row, const char *p_begin, const char *p_end );
+
+    // column masks applied by the case/control kernels that take a CaseControlSet
+    virtual const ushort *caseStream( CaseControlSet &ccs ) { return ccs.stream_case_begin(); }
+    virtual const ushort *controlStream( CaseControlSet &ccs ) { return ccs.stream_control_begin(); }
 
+    DataBlock *selectedRow( uint rIdx ) const { return selected_data + ( ulong ) rIdx * selected_stride; }
+
+    // distribution kernels shared by the batch methods; row is the start of a
+    // row slot in data, selected the start of a row in selected_data
+    void countGenotypeStreams( const DataBlock *row, frequency_table &ft ) const;
+    void countSelectedStreams( const DataBlock *selected, frequency_table &case_gt, frequency_table &ctrl_gt ) const;
+
+    // adds the row slots rows[0, nRows) to the distributions of the first
+    // nColumns stream columns
+    void addColumnStreams( const DataBlock * const *rows, uint nRows, frequency_table *columns, uint nColumns ) const;
+
+    // trait bit-planes of qts in the stream column order of this table, each
+    // genotype_block_offset_ab blocks long
+    virtual const ushort *traitPlanes( QuantitativeTraitSet &qts );
+
+    // trait sums of the row slot row over the bit-planes returned by traitPlanes
+    void sumTraitStreams( const DataBlock *row, const ushort *planes, const QuantitativeTraitSet &qts, trait_sums &ts ) const;
+
+    // stream codes of the first nColumns stream columns of the row slot row
+    void decodeStreams( const DataBlock *row, byte *codes, uint nColumns ) const;
+
+    static const uint NO_STREAM_COLUMN;
+
+    // the stream words [w_begin, w_end) of part `part` of nParts, split evenly
+    void streamWordRange( uint part, uint nParts, uint &w_begin, uint &w_end ) const;
+
+    // vector kernels of getGenotypeVectorSums and addGenotypeVectorProducts
+    // over the stream words [w_begin, w_end) of the row slot row.
+    // stream_columns maps a stream bit to its column, or to NO_STREAM_COLUMN
+    // for a bit which holds no column; NULL maps the first column_size() bits
+    // to themselves.
+    void sumVectorStreams( const DataBlock *row, const double *v, uint l, const uint *stream_columns, double *sums ) const;
+    void addVectorStreams( const DataBlock *row, const double *w, uint l, const uint *stream_columns, uint w_begin, uint w_end, double *columns ) const;
 
     char *gt_lookup, * err_lookup;
     uint gt_size, lookup_size;
     DataBlock **lookup;
 
     uint genotype_block_offset_ab;
+    ulong row_capacity;     // number of row slots allocated in data
 
-    genotype_counts count_lookup[ 0x10000 ];
-
-    joint_genotypes contingency_lookup[ 0x100000 ];
-    byte skip_count[ 16 ];
+    // layout of the selected case/control streams read by the selected kernels;
+    // relative to selectedRow(): case aa at 0, case ab, control aa, control ab
+    DataBlock *selected_data;
+    ulong selected_stride;
+    uint selected_case_ab, selected_ctrl, selected_ctrl_ab;
 };
 
 }
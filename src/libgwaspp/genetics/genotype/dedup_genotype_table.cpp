@@ -0,0 +1,265 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/genotype/dedup_genotype_table.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+const uint DedupGenotypeTable::UNASSIGNED_ROW = 0xFFFFFFFF;
+
+DedupGenotypeTable::DedupGenotypeTable( indexer *markers, indexer *individs ) :
+    CompressedGenotypeTable5( markers, individs, 0 ), slot_count( 0 ),
+    row_lookup( max_row, UNASSIGNED_ROW ), canonical( max_row ), shared( max_row, false ) {
+
+    cout << "Initializing DedupGenotypeTable ... " << endl;
+
+    for( uint i = 0; i < ( uint ) max_row; ++i ) {
+        canonical[ i ] = i;
+    }
+}
+
+ulong DedupGenotypeTable::HashRow( const DataBlock *row, uint nBlocks ) {
+    // 64-bit FNV-1a over the encoded blocks
+    ulong h = 0xcbf29ce484222325UL;
+    for( uint i = 0; i < nBlocks; ++i, ++row ) {
+        h ^= GetUshortAtDataBlockPtr( row );
+        h *= 0x100000001b3UL;
+    }
+    return h;
+}
+
+void DedupGenotypeTable::ensureSlotCapacity() {
+    if( slot_count < row_capacity ) return;
+
+    ulong new_capacity = (( row_capacity < 16 ) ? 16 : 2 * row_capacity );
+    if( new_capacity > ( ulong ) max_row ) {
+        new_capacity = max_row;
+    }
+    assert( new_capacity > slot_count );
+
+    DataBlock *tmp = new DataBlock[ new_capacity * blocks_per_row ];
+    memcpy( tmp, data, slot_count * bytes_per_row );
+    memset( tmp + slot_count * blocks_per_row, 0, ( new_capacity - slot_count ) * bytes_per_row );
+
+    delete [] data;
+    data = tmp;
+
+    row_capacity = new_capacity;
+    total_block_count = blocks_per_row * row_capacity;
+    data_size = row_capacity * bytes_per_row;
+
+    // case/control buffer no longer covers every slot
+    if( m_cases_controls != NULL ) {
+        delete [] m_cases_controls;
+        m_cases_controls = NULL;
+    }
+}
+
+uint DedupGenotypeTable::assignPrivateSlot( uint rIdx ) {
+    ensureSlotCapacity();
+    memset( data + slot_count * blocks_per_row, 0, bytes_per_row );
+
+    row_lookup[ rIdx ] = slot_count;
+    return slot_count++;
+}
+
+DataBlock DedupGenotypeTable::operator()( int r, int c ) {
+    assert( row_lookup[ r ] != UNASSIGNED_ROW );
+    return CompressedGenotypeTable5::operator()( row_lookup[ r ], c );
+}
+
+void DedupGenotypeTable::addGenotype( int rIdx, int cIdx, const string &gt ) {
+    // indexed rows may be aliased, so they cannot be modified in place
+    assert( !shared[ rIdx ] );
+
+    if( row_lookup[ rIdx ] == UNASSIGNED_ROW ) {
+        assignPrivateSlot( rIdx );
+    }
+
+    CompressedGenotypeTable5::addGenotype( row_lookup[ rIdx ], cIdx, gt );
+}
+
+void DedupGenotypeTable::addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim ) {
+    const char *p_begin = (( it < it_end ) ? &*it : NULL );
+    const char *p_end = p_begin + ( it_end - it );
+
+    addGenotypeRow( rIdx, p_begin, p_end, delim );
+    it = it_end;
+}
+
+void DedupGenotypeTable::addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim ) {
+    assert( row_lookup[ rIdx ] == UNASSIGNED_ROW );
+
+    uint slot = assignPrivateSlot( rIdx );
+    DataBlock *row = data + slot * blocks_per_row;
+
+    if( p_begin < p_end ) {
+        encodeGenotypeRow( row, p_begin, p_end );
+    }
+
+    shared[ rIdx ] = true;
+
+    ulong h = HashRow( row, blocks_per_row );
+
+    pair< multimap< ulong, uint >::iterator, multimap< ulong, uint >::iterator > range = row_index.equal_range( h );
+    for( multimap< ulong, uint >::iterator it = range.first; it != range.second; it++ ) {
+        uint other = row_lookup[ it->second ];
+        if( memcmp( data + other * blocks_per_row, row, bytes_per_row ) == 0 ) {
+            // alias the earlier row and release the slot for the next row
+            row_lookup[ rIdx ] = other;
+            canonical[ rIdx ] = it->second;
+            --slot_count;
+            return;
+        }
+    }
+
+    row_index.insert( make_pair( h, ( uint ) rIdx ) );
+}
+
+void DedupGenotypeTable::getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist ) {
+    assert( row_lookup[ rIdx ] != UNASSIGNED_ROW );
+    CompressedGenotypeTable5::getGenotypeDistribution( row_lookup[ rIdx ], dist );
+}
+
+void DedupGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlSet &ccs, CaseControlGenotypeDistribution &ccgd ) {
+    CompressedGenotypeTable5::getCaseControlGenotypeDistribution( row_lookup[ rIdx ], ccs, ccgd );
+}
+
+void DedupGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd ) {
+    CompressedGenotypeTable5::getCaseControlGenotypeDistribution( row_lookup[ rIdx ], ccgd );
+}
+
+void DedupGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m ) {
+    CompressedGenotypeTable5::getCaseControlGenotypeDistribution( row_lookup[ rIdx ], ccgd, m );
+}
+
+void DedupGenotypeTable::getCaseControlGenotypeDistributions( uint rIdx, const vector< CaseControlSet * > &sets, CaseControlGenotypeDistribution *ccgd ) {
+    CompressedGenotypeTable5::getCaseControlGenotypeDistributions( row_lookup[ rIdx ], sets, ccgd );
+}
+
+void DedupGenotypeTable::getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out ) {
+    for( uint r = row_begin; r < row_end; ++r ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+        countGenotypeStreams( data + ( ulong ) row_lookup[ r ] * blocks_per_row, *out++ );
+    }
+}
+
+void DedupGenotypeTable::getCaseControlGenotypeDistributions( uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls ) {
+    for( uint r = row_begin; r < row_end; ++r ) {
+        countSelectedStreams( selectedRow( row_lookup[ r ] ), *cases++, *ctrls++ );
+    }
+}
+
+void DedupGenotypeTable::addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns ) {
+    if( row_begin >= row_end ) return;
+
+    vector< const DataBlock * > rows;
+    rows.reserve( row_end - row_begin );
+    for( uint r = row_begin; r < row_end; ++r ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+        rows.push_back( data + ( ulong ) row_lookup[ r ] * blocks_per_row );
+    }
+
+    addColumnStreams( &rows[ 0 ], rows.size(), columns, max_column );
+}
+
+void DedupGenotypeTable::getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out ) {
+    const ushort *planes = traitPlanes( qts );
+
+    for( uint r = row_begin; r < row_end; ++r ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+        sumTraitStreams( data + ( ulong ) row_lookup[ r ] * blocks_per_row, planes, qts, *out++ );
+    }
+}
+
+void DedupGenotypeTable::getGenotypeCodes( uint row_begin, uint row_end, byte *codes ) {
+    for( uint r = row_begin; r < row_end; ++r, codes += max_column ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+        decodeStreams( data + ( ulong ) row_lookup[ r ] * blocks_per_row, codes, max_column );
+    }
+}
+
+void DedupGenotypeTable::getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums ) {
+    for( uint r = row_begin; r < row_end; ++r, sums += 3 * l ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+        sumVectorStreams( data + ( ulong ) row_lookup[ r ] * blocks_per_row, v, l, NULL, sums );
+    }
+}
+
+void DedupGenotypeTable::addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns ) {
+    uint w_begin, w_end;
+    streamWordRange( part, nParts, w_begin, w_end );
+
+    for( uint r = row_begin; r < row_end; ++r, w += 3 * l ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+        addVectorStreams( data + ( ulong ) row_lookup[ r ] * blocks_per_row, w, l, NULL, w_begin, w_end, columns );
+    }
+}
+
+void DedupGenotypeTable::getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct ) {
+    CompressedGenotypeTable5::getContingencyTable( row_lookup[ rIdx1 ], row_lookup[ rIdx2 ], ct );
+
+    ct.setMarkerAIndex( rIdx1 );
+    ct.setMarkerBIndex( rIdx2 );
+}
+
+void DedupGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlSet &ccs, CaseControlContingencyTable &ccct ) {
+    CompressedGenotypeTable5::getCaseControlContingencyTable( row_lookup[ rIdx1 ], row_lookup[ rIdx2 ], ccs, ccct );
+
+    ccct.setMarkerAIndex( rIdx1 );
+    ccct.setMarkerBIndex( rIdx2 );
+}
+
+void DedupGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct ) {
+    CompressedGenotypeTable5::getCaseControlContingencyTable( row_lookup[ rIdx1 ], row_lookup[ rIdx2 ], ccct );
+
+    ccct.setMarkerAIndex( rIdx1 );
+    ccct.setMarkerBIndex( rIdx2 );
+}
+
+void DedupGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct ) {
+    CompressedGenotypeTable5::getCaseControlContingencyTable( row_lookup[ rIdx1 ], row_lookup[ rIdx2 ], m1, m2, ccct );
+
+    ccct.setMarkerAIndex( rIdx1 );
+    ccct.setMarkerBIndex( rIdx2 );
+}
+
+void DedupGenotypeTable::getCaseControlContingencyTables( uint rIdx1, uint rIdx2, const vector< CaseControlSet * > &sets, CaseControlContingencyTable *ccct ) {
+    CompressedGenotypeTable5::getCaseControlContingencyTables( row_lookup[ rIdx1 ], row_lookup[ rIdx2 ], sets, ccct );
+
+    for( uint k = 0; k < sets.size(); ++k ) {
+        ccct[k].setMarkerAIndex( rIdx1 );
+        ccct[k].setMarkerBIndex( rIdx2 );
+    }
+}
+
+DedupGenotypeTable::~DedupGenotypeTable() {}
+
+}
+}
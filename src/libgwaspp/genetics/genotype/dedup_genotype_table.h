@@ -0,0 +1,124 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef DEDUPGENOTYPETABLE_H
+#define DEDUPGENOTYPETABLE_H
+
+#include <iostream>
+#include <vector>
+#include <map>
+
+#include "common.h"
+#include "util/index_set/indexer.h"
+#include "genetics/genotype/compressed_genotype_table5.h"
+
+using namespace std;
+using namespace util;
+
+namespace libgwaspp {
+namespace genetics {
+
+/**
+ * Class: DedupGenotypeTable
+ * Description: 2-bit streaming table which stores bit-identical rows once.
+ *
+ * Dense genotyping arrays contain many markers in perfect LD, whose rows are
+ * identical after encoding. Each row passed to addGenotypeRow is encoded into
+ * the next free row slot and hashed. If an earlier row has the same content
+ * (header and both streams), the new row becomes an alias of that canonical
+ * row and the slot is reused for the next row.
+ *
+ * The streaming kernels of CompressedGenotypeTable5 operate on row slots,
+ * so every query is answered from the canonical copy. Analyses which visit
+ * marker pairs can use getCanonicalRow() to scan canonical rows only, and
+ * expand their results to the aliases afterwards.
+ *
+ * Rows which are filled one genotype at a time (addGenotype) may still change,
+ * so they are given a private slot and are never shared.
+ */
+class DedupGenotypeTable : public CompressedGenotypeTable5 {
+public:
+    DedupGenotypeTable( indexer *markers, indexer *individs );
+
+    DataBlock operator()( int r, int c );
+
+    void addGenotype( int rIdx, int cIdx, const string &gt );
+    void addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim );
+    void addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim );
+
+    // rows share slots and a hash index
+    bool supportsConcurrentRowWrites() const { return false; }
+
+    void getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlSet &ccs, CaseControlGenotypeDistribution &ccgd );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m );
+    void getCaseControlGenotypeDistributions( uint rIdx, const vector< CaseControlSet * > &sets, CaseControlGenotypeDistribution *ccgd );
+
+    void getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out );
+    void getCaseControlGenotypeDistributions( uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls );
+
+    void addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns );
+
+    void getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out );
+    void getGenotypeCodes( uint row_begin, uint row_end, byte *codes );
+    void getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums );
+    void addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns );
+
+    void getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct );
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlSet &ccs, CaseControlContingencyTable &ccct );
+
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct );
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct );
+    void getCaseControlContingencyTables( uint rIdx1, uint rIdx2, const vector< CaseControlSet * > &sets, CaseControlContingencyTable *ccct );
+
+    uint getCanonicalRow( uint rIdx ) const { return canonical[ rIdx ]; }
+    uint getUniqueRowCount() const { return slot_count; }
+
+    virtual ~DedupGenotypeTable();
+protected:
+    void ensureSlotCapacity();
+    uint assignPrivateSlot( uint rIdx );
+
+    static ulong HashRow( const DataBlock *row, uint nBlocks );
+
+    static const uint UNASSIGNED_ROW;
+
+    uint slot_count;
+
+    vector< uint > row_lookup;          // slot of every row
+    vector< uint > canonical;           // canonical row of every row
+    vector< bool > shared;              // row content is indexed and may not change
+
+    multimap< ulong, uint > row_index;  // row hash -> canonical row
+};
+
+}
+}
+
+#endif // DEDUPGENOTYPETABLE_H
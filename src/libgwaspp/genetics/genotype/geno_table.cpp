@@ -28,6 +28,9 @@
 */
 #include "genetics/genotype/geno_table.h"
 
+#include <cstring>
+#include <vector>
+
 namespace libgwaspp {
 namespace genetics {
 
@@ -37,5 +40,140 @@ const string GenoTable::err_alphabet = "0?N";
 const int GenoTable::BITS_PER_BLOCK = 16;
 const int GenoTable::BYTES_PER_BLOCK = 2;
 
+// frequency_table entry of each stream code
+static const byte CODE_FREQUENCY_INDEX[ GENOTYPE_COUNT ] = { 3, 0, 1, 2 };   // xx, aa, ab, bb
+
+void GenoTable::decodeGenotypeRow( uint rIdx, byte *codes ) {
+    const uint nColumns = column_size();
+    ushort aa = 0xFFFF;
+
+    for( uint c = 0; c < nColumns; ++c ) {
+        ushort enc = GetUshortAtDataBlock( ( *this )( rIdx, c ) );
+
+        if( enc == 0xFFFF ) {
+            codes[ c ] = STREAM_CODE_MISSING;
+        } else if( !isGenotypeHomozygous( enc ) ) {
+            codes[ c ] = STREAM_CODE_AB;
+        } else {
+            if( aa == 0xFFFF ) aa = enc;
+            codes[ c ] = (( enc == aa ) ? STREAM_CODE_AA : STREAM_CODE_BB );
+        }
+    }
+}
+
+void GenoTable::getGenotypeCodes( uint row_begin, uint row_end, byte *codes ) {
+    for( uint r = row_begin; r < row_end; ++r, codes += column_size() ) {
+        decodeGenotypeRow( r, codes );
+    }
+}
+
+void GenoTable::getRowAlleles( uint rIdx, char &a, char &b ) {
+    const uint nColumns = column_size();
+    vector< byte > codes( nColumns );
+    getGenotypeCodes( rIdx, rIdx + 1, &codes[ 0 ] );
+
+    a = b = '0';
+    char het[ 2 ] = { '0', '0' };
+    for( uint c = 0; c < nColumns && ( a == '0' || b == '0' ); ++c ) {
+        if( codes[ c ] == STREAM_CODE_MISSING ) continue;
+
+        const char *call = decodeGenotype( GetUshortAtDataBlock( ( *this )( rIdx, c ) ) );
+        if( codes[ c ] == STREAM_CODE_AA ) {
+            a = call[ 0 ];
+        } else if( codes[ c ] == STREAM_CODE_BB ) {
+            b = call[ 0 ];
+        } else if( het[ 0 ] == '0' ) {
+            het[ 0 ] = call[ 0 ];
+            het[ 1 ] = call[ 1 ];
+        }
+    }
+
+    if( a == '0' && b != '0' && het[ 0 ] != '0' ) {
+        a = ( het[ 0 ] == b ) ? het[ 1 ] : het[ 0 ];
+    } else if( b == '0' && a != '0' && het[ 0 ] != '0' ) {
+        b = ( het[ 0 ] == a ) ? het[ 1 ] : het[ 0 ];
+    }
+}
+
+void GenoTable::addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns ) {
+    const uint nColumns = column_size();
+    vector< byte > codes( nColumns );
+
+    for( uint r = row_begin; r < row_end; ++r ) {
+        decodeGenotypeRow( r, &codes[ 0 ] );
+
+        for( uint c = 0; c < nColumns; ++c ) {
+            ++columns[ c ].freq[ CODE_FREQUENCY_INDEX[ codes[ c ] ] ];
+        }
+    }
+}
+
+void GenoTable::getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out ) {
+    const uint nColumns = column_size();
+    vector< byte > codes( nColumns );
+
+    for( uint r = row_begin; r < row_end; ++r, ++out ) {
+        decodeGenotypeRow( r, &codes[ 0 ] );
+        ResetTraitSums( *out );
+
+        for( uint c = 0; c < nColumns; ++c ) {
+            if( !qts.isPhenotyped( c ) ) continue;
+
+            uint idx = CODE_FREQUENCY_INDEX[ codes[ c ] ];
+            ulong q = qts.value( c );
+
+            ++out->count.freq[ idx ];
+            out->sum[ idx ] += q;
+            if( codes[ c ] != STREAM_CODE_MISSING ) {
+                out->square_sum_called += q * q;
+            }
+        }
+    }
+}
+
+void GenoTable::getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums ) {
+    const uint nColumns = column_size();
+    vector< byte > codes( nColumns );
+
+    for( uint r = row_begin; r < row_end; ++r, sums += 3 * l ) {
+        decodeGenotypeRow( r, &codes[ 0 ] );
+        memset( sums, 0, 3 * l * sizeof( double ) );
+
+        for( uint c = 0; c < nColumns; ++c ) {
+            if( codes[ c ] == STREAM_CODE_AA ) continue;
+
+            // AB, BB and missing sums, in that order
+            double *s = sums + CODE_FREQUENCY_INDEX[ codes[ c ] ] * l - l;
+            const double *x = v + ( ulong ) c * l;
+            for( uint k = 0; k < l; ++k ) {
+                s[ k ] += x[ k ];
+            }
+        }
+    }
+}
+
+void GenoTable::addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns ) {
+    const uint nColumns = column_size();
+    vector< byte > codes( nColumns );
+
+    assert( part < nParts );
+    const uint c_begin = ( uint )(( ulong ) nColumns * part / nParts );
+    const uint c_end = ( uint )(( ulong ) nColumns * ( part + 1 ) / nParts );
+
+    for( uint r = row_begin; r < row_end; ++r, w += 3 * l ) {
+        decodeGenotypeRow( r, &codes[ 0 ] );
+
+        for( uint c = c_begin; c < c_end; ++c ) {
+            if( codes[ c ] == STREAM_CODE_AA ) continue;
+
+            const double *x = w + CODE_FREQUENCY_INDEX[ codes[ c ] ] * l - l;
+            double *s = columns + ( ulong ) c * l;
+            for( uint k = 0; k < l; ++k ) {
+                s[ k ] += x[ k ];
+            }
+        }
+    }
+}
+
 }
 }
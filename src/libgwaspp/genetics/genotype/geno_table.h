@@ -40,6 +40,7 @@
 #include "genetics/genotype/pairwise_marker_analyzable.h"
 #include "genetics/genotype/single_marker_analyzable.h"
 #include "genetics/genotype/case_control_selectable.h"
+#include "genetics/analyzable/quantitative_trait_set.h"
 
 namespace libgwaspp {
 namespace genetics {
@@ -64,11 +65,72 @@ public:
 
     virtual bool isGenotypeHomozygous( ushort enc ) = 0;
 
+    // Row block paging hints. Tables which keep every row resident ignore them.
+    virtual uint getRowBlockSize() const { return 0; }
+    virtual uint getResidentRowBlockCount() const { return 0; }
+    virtual void prefetchRows( uint row_begin, uint row_end ) {}
+    virtual void pinRows( uint row_begin, uint row_end ) {}
+    virtual void unpinRows( uint row_begin, uint row_end ) {}
+
+    // Rows which are bit-identical to an earlier row may share its storage.
+    // Tables which do not deduplicate rows report every row as canonical.
+    virtual uint getCanonicalRow( uint rIdx ) const { return rIdx; }
+
+    // Whether the distribution and contingency kernels which take a
+    // CaseControlSet may run on several threads at once, once a first call
+    // has been made with every set involved.
+    virtual bool supportsConcurrentReads() const { return false; }
+
+    // Whether addGenotypeRow may run on several threads at once for distinct
+    // rows. Rows are written into their own, precomputed storage.
+    virtual bool supportsConcurrentRowWrites() const { return false; }
+
+    // Adds the genotypes of the rows [row_begin, row_end) to the per-column
+    // distributions in columns, which holds column_size() tables.
+    virtual void addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns );
+
+    // Sums of the trait values in qts over the genotype groups of each row
+    // [row_begin, row_end); out[i] belongs to row row_begin + i. qts must be
+    // indexed by the individuals of this table.
+    virtual void getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out );
+
+    // Stream genotype codes (STREAM_CODE_*) of the rows [row_begin, row_end),
+    // column_size() bytes per row in column order.
+    virtual void getGenotypeCodes( uint row_begin, uint row_end, byte *codes );
+
+    // Alleles of the AA and BB homozygotes of row rIdx, in the orientation of
+    // getGenotypeCodes. An allele is named by the heterozygotes when the row
+    // holds only one homozygote; an allele the row never calls is '0'.
+    void getRowAlleles( uint rIdx, char &a, char &b );
+
+    // Sums of the sample vectors in v over the genotype groups of each row
+    // [row_begin, row_end). v holds l values per column, column c starting at
+    // v + c * l; sums receives 3 * l values per row: the sums over the AB, BB
+    // and missing columns, in that order. The AA sum is whatever the three
+    // leave of the column total.
+    virtual void getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums );
+
+    // The transpose of getGenotypeVectorSums: for each row [row_begin,
+    // row_end), w holds 3 * l values (AB, BB and missing), and the l values of
+    // the group of a column are added to that column of columns (l values per
+    // column). Only the columns of part `part` of nParts disjoint parts of the
+    // table are touched, so each thread may add one part. AA columns receive
+    // nothing.
+    virtual void addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns );
+
     virtual ~GenoTable() {
         delete [] beg;
     }
 
 protected:
+    // Stream codes of row rIdx read through operator(), one genotype at a
+    // time. The first homozygote of the row in column order is AA, as in the
+    // row headers the tables build. The column kernels above are built on it,
+    // so every table which answers operator() with encoded genotypes (missing
+    // as 0xFFFF) provides them; the 2-bit stream tables read their streams
+    // instead.
+    void decodeGenotypeRow( uint rIdx, byte *codes );
+
     byte transformations[256];
 
     ulong data_per_block, blocks_per_row, total_block_count;
@@ -0,0 +1,137 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/genotype/genotype_lookup_registry.h"
+
+#include <cstring>
+
+namespace libgwaspp {
+namespace genetics {
+
+const uint GenotypeLookupRegistry::COUNT_LOOKUP_SIZE = 0x10000;
+const uint GenotypeLookupRegistry::CONTINGENCY_LOOKUP_SIZE = 0x100000; // 16 * 256 * 256 == 2^4 * 2^8 * 2^8 == 2^20 == 0x100000
+const uint GenotypeLookupRegistry::SKIP_COUNT_SIZE = 16;
+
+static genotype_counts *BuildCountLookup() {
+    genotype_counts *count_lookup = new genotype_counts[ GenotypeLookupRegistry::COUNT_LOOKUP_SIZE ];
+
+    genotype_counts counts;
+    for( uint i = 0; i < GenotypeLookupRegistry::COUNT_LOOKUP_SIZE; ++i ) {
+        counts.ui = 0;
+
+        for( uint j = 0, k = i; j < 8; ++j, k >>= 2 ) {
+            switch( k & 0x0003 ) {
+            case 0x0003:
+                ++counts.c3;
+                break;
+            case 0x0002:
+                ++counts.c2;
+                break;
+            case 0x0001:
+                ++counts.c1;
+                break;
+            default:
+                ++counts.c0;
+                break;
+            }
+        }
+
+        count_lookup[i].ui = counts.ui;
+    }
+    return count_lookup;
+}
+
+static byte *BuildSkipCount() {
+    byte *skip_count = new byte[ GenotypeLookupRegistry::SKIP_COUNT_SIZE ];
+
+    skip_count[ 0 ] = 0;
+    for( uint k = 1; k < GenotypeLookupRegistry::SKIP_COUNT_SIZE; ++k ) {
+        skip_count[ k ] = 0;
+        skip_count[ k ] += ((( k & 0x01 ) ) ? 0 : 1 );
+        skip_count[ k ] += ((( k & 0x02 ) ) ? 0 : 1 );
+        skip_count[ k ] += ((( k & 0x04 ) ) ? 0 : 1 );
+        skip_count[ k ] += ((( k & 0x08 ) ) ? 0 : 1 );
+    }
+    return skip_count;
+}
+
+static joint_genotypes *BuildContingencyLookup() {
+    joint_genotypes *contingency_lookup = new joint_genotypes[ GenotypeLookupRegistry::CONTINGENCY_LOOKUP_SIZE ];
+    joint_genotypes jg;
+
+    byte ma, mb;
+    uint base_offset, offset;
+    int bit_mask, shift, idx;
+
+    memset( contingency_lookup, 0, GenotypeLookupRegistry::CONTINGENCY_LOOKUP_SIZE * sizeof( joint_genotypes ) );
+
+    for( uint k = 1, mask = 0x00; k < 16; ++k ) {
+        mask = 0;
+        mask |= (( k & 0x01 ) ? 0x03 : 0 );
+        mask |= (( k & 0x02 ) ? 0x0C : 0 );
+        mask |= (( k & 0x04 ) ? 0x30 : 0 );
+        mask |= (( k & 0x08 ) ? 0xC0 : 0 );
+
+        for( uint i = 0; i < 256; ++i ) {
+            base_offset = (( k << 16 ) | ( i << 8 ) );
+            for( uint j = 0; j < 256; ++j ) {
+                // clear data
+                ResetJointGenotype( jg );
+                for( bit_mask = 0xC0, shift = 6, idx = 0; shift >= 0; bit_mask >>= 2, shift -= 2, ++idx ) {
+                    ma = (( i & ( bit_mask & mask ) ) >> shift );
+                    mb = (( j & ( bit_mask & mask ) ) >> shift );
+
+                    SetJointGenotype( jg, ma, mb, idx );
+                }
+
+                offset = base_offset | j;
+                CopyJointGenotype( contingency_lookup[ offset ], jg );
+            }
+        }
+    }
+    return contingency_lookup;
+}
+
+// function local statics are initialized once, on first call
+const genotype_counts *GenotypeLookupRegistry::getCountLookup() {
+    static const genotype_counts *count_lookup = BuildCountLookup();
+    return count_lookup;
+}
+
+const joint_genotypes *GenotypeLookupRegistry::getContingencyLookup() {
+    static const joint_genotypes *contingency_lookup = BuildContingencyLookup();
+    return contingency_lookup;
+}
+
+const byte *GenotypeLookupRegistry::getSkipCount() {
+    static const byte *skip_count = BuildSkipCount();
+    return skip_count;
+}
+
+}
+}
@@ -0,0 +1,71 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef GENOTYPELOOKUPREGISTRY_H
+#define GENOTYPELOOKUPREGISTRY_H
+
+#include "common.h"
+#include "genetics/genotype/common_genotype.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+/**
+ * Process-wide 2-bit genotype lookup tables.
+ *
+ * The 2-bit block tables (CompressedGenotypeTable3) decode a block of 8
+ * genotypes through a count lookup (0x10000 entries) and a joint genotype
+ * lookup (0x100000 entries, roughly 10 MB). The tables only depend on the
+ * encoding, so they are built once, on first use, and shared by every table
+ * which needs them. Tables whose kernels do not use them never pay for them.
+ *
+ * The lookups are read-only once built.
+ */
+class GenotypeLookupRegistry {
+public:
+    // genotype counts of a block of 8 2-bit genotypes; indexed by the block value
+    static const genotype_counts *getCountLookup();
+
+    // joint genotypes of two bytes of 4 2-bit genotypes each;
+    // indexed by ( column mask << 16 ) | ( byte A << 8 ) | byte B
+    static const joint_genotypes *getContingencyLookup();
+
+    // number of genotypes excluded by each column mask
+    static const byte *getSkipCount();
+
+    static const uint COUNT_LOOKUP_SIZE;
+    static const uint CONTINGENCY_LOOKUP_SIZE;
+    static const uint SKIP_COUNT_SIZE;
+private:
+    GenotypeLookupRegistry() {}
+};
+
+}
+}
+
+#endif // GENOTYPELOOKUPREGISTRY_H
@@ -38,5 +38,11 @@
 #include "genetics/genotype/compressed_genotype_table3.h"
 #include "genetics/genotype/compressed_genotype_table4.h"
 #include "genetics/genotype/compressed_genotype_table5.h"
+#include "genetics/genotype/sparse_genotype_table.h"
+#include "genetics/genotype/paged_genotype_table.h"
+#include "genetics/genotype/dedup_genotype_table.h"
+#include "genetics/genotype/haplotype_table.h"
+#include "genetics/genotype/multi_allelic_genotype_table.h"
+#include "genetics/genotype/permuted_genotype_table.h"
 
 #endif
@@ -0,0 +1,212 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/genotype/haplotype_table.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+static void ComputeHaplotypeLD( haplotype_ld &ld ) {
+    ld.D = 0.0;
+    ld.Dprime = 0.0;
+    ld.r2 = 0.0;
+    for( int i = 0; i < 4; ++i ) {
+        ld.freq[ i ] = 0.0;
+    }
+
+    if( ld.n == 0 ) return;
+
+    double p_a = ( double ) ld.n_a / ( double ) ld.n;
+    double p_b = ( double ) ld.n_b / ( double ) ld.n;
+    double p_ab = ( double ) ld.n_ab / ( double ) ld.n;
+
+    ld.freq[ 3 ] = p_ab;
+    ld.freq[ 2 ] = p_a - p_ab;
+    ld.freq[ 1 ] = p_b - p_ab;
+    ld.freq[ 0 ] = 1.0 - p_a - p_b + p_ab;
+
+    ld.D = p_ab - p_a * p_b;
+
+    double d_max;
+    if( ld.D < 0.0 ) {
+        d_max = min( p_a * p_b, ( 1.0 - p_a ) * ( 1.0 - p_b ) );
+    } else {
+        d_max = min( p_a * ( 1.0 - p_b ), ( 1.0 - p_a ) * p_b );
+    }
+
+    if( d_max > 0.0 ) {
+        ld.Dprime = ld.D / d_max;
+    }
+
+    double denom = p_a * ( 1.0 - p_a ) * p_b * ( 1.0 - p_b );
+    if( denom > 0.0 ) {
+        ld.r2 = ( ld.D * ld.D ) / denom;
+    }
+}
+
+HaplotypeTable::HaplotypeTable( indexer *markers, indexer *individs ) : CompressedGenotypeTable5( markers, individs ), ref_allele( max_row, ( byte ) alphabet_size ) {
+    cout << "Initializing HaplotypeTable ... " << endl;
+
+    haplotype_blocks_per_row = 2 * genotype_block_offset_ab;
+    haplotypes = new DataBlock[ haplotype_blocks_per_row * row_capacity ];
+    memset( haplotypes, 0, haplotype_blocks_per_row * row_capacity * sizeof( DataBlock ) );
+
+    cout << "Haplotype table size: " << haplotype_blocks_per_row * row_capacity * sizeof( DataBlock ) << " (bytes)" << endl;
+}
+
+void HaplotypeTable::setHaplotype( uint rIdx, uint cIdx, byte c1, byte c2 ) {
+    if( c1 == alphabet_size || c2 == alphabet_size ) return;  // missing
+
+    byte &ref = ref_allele[ rIdx ];
+    if( ref == alphabet_size ) {
+        ref = c1;
+    }
+
+    DataBlock *copy1 = haplotypes + rIdx * haplotype_blocks_per_row + ( cIdx >> 4 );
+    DataBlock *copy2 = copy1 + genotype_block_offset_ab;
+    ushort bit = ( 1 << ( cIdx & 0x0F ) );
+
+    if( c1 != ref ) {
+        SetUshortAtDataBlockPtr( copy1, ( GetUshortAtDataBlockPtr( copy1 ) | bit ) );
+    } else {
+        SetUshortAtDataBlockPtr( copy1, ( GetUshortAtDataBlockPtr( copy1 ) & ~bit ) );
+    }
+
+    if( c2 != ref ) {
+        SetUshortAtDataBlockPtr( copy2, ( GetUshortAtDataBlockPtr( copy2 ) | bit ) );
+    } else {
+        SetUshortAtDataBlockPtr( copy2, ( GetUshortAtDataBlockPtr( copy2 ) & ~bit ) );
+    }
+}
+
+void HaplotypeTable::addGenotype( int rIdx, int cIdx, const string &gt ) {
+    assert( gt.length() == MAX_ALLELE_COUNT );
+
+    byte c1 = transformations[( byte ) gt[0] ], c2 = transformations[( byte ) gt[1] ];
+
+    // the genotype streams only know unordered calls
+    string unphased( gt );
+    if( c2 < c1 ) {
+        swap( unphased[0], unphased[1] );
+    }
+    CompressedGenotypeTable5::addGenotype( rIdx, cIdx, unphased );
+
+    setHaplotype( rIdx, cIdx, c1, c2 );
+}
+
+void HaplotypeTable::addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim ) {
+    const char *p_begin = (( it < it_end ) ? &*it : NULL );
+    const char *p_end = p_begin + ( it_end - it );
+
+    addGenotypeRow( rIdx, p_begin, p_end, delim );
+    it = it_end;
+}
+
+void HaplotypeTable::addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim ) {
+    if( p_begin >= p_end ) return;
+
+    memset( haplotypes + rIdx * haplotype_blocks_per_row, 0, haplotype_blocks_per_row * sizeof( DataBlock ) );
+    ref_allele[ rIdx ] = alphabet_size;
+
+    unphased_row.assign( p_begin, p_end );
+
+    // calls are 2 alleles followed by a delimiter
+    byte c1, c2;
+    uint cIdx = 0;
+    for( char *tmp_p = &unphased_row[0], *tmp_end = tmp_p + unphased_row.size(); tmp_p + 1 < tmp_end; tmp_p += 3, ++cIdx ) {
+        c1 = transformations[( byte ) tmp_p[0] ];
+        c2 = transformations[( byte ) tmp_p[1] ];
+
+        setHaplotype( rIdx, cIdx, c1, c2 );
+
+        // the genotype streams only know unordered calls
+        if( c2 < c1 ) {
+            swap( tmp_p[0], tmp_p[1] );
+        }
+    }
+
+    CompressedGenotypeTable5::addGenotypeRow( rIdx, &unphased_row[0], &unphased_row[0] + unphased_row.size(), delim );
+}
+
+void HaplotypeTable::getHaplotypeLD( uint rIdx1, uint rIdx2, haplotype_ld &ld ) {
+    assert( rIdx1 < ( uint ) max_row && rIdx2 < ( uint ) max_row );
+
+    const PWORD *a_aa = reinterpret_cast< const PWORD * >( data + rIdx1 * blocks_per_row + 1 );
+    const PWORD *a_ab = reinterpret_cast< const PWORD * >( data + rIdx1 * blocks_per_row + 1 + genotype_block_offset_ab );
+    const PWORD *b_aa = reinterpret_cast< const PWORD * >( data + rIdx2 * blocks_per_row + 1 );
+    const PWORD *b_ab = reinterpret_cast< const PWORD * >( data + rIdx2 * blocks_per_row + 1 + genotype_block_offset_ab );
+
+    const PWORD *a_h1 = reinterpret_cast< const PWORD * >( haplotypes + rIdx1 * haplotype_blocks_per_row );
+    const PWORD *a_h2 = reinterpret_cast< const PWORD * >( haplotypes + rIdx1 * haplotype_blocks_per_row + genotype_block_offset_ab );
+    const PWORD *b_h1 = reinterpret_cast< const PWORD * >( haplotypes + rIdx2 * haplotype_blocks_per_row );
+    const PWORD *b_h2 = reinterpret_cast< const PWORD * >( haplotypes + rIdx2 * haplotype_blocks_per_row + genotype_block_offset_ab );
+
+    PWORD called, _a1, _a2, _b1, _b2;
+    uint n = 0, n_a = 0, n_b = 0, n_ab = 0;
+
+    for( uint i = 0; i < genotype_block_offset_ab; i += BLOCKS_PER_PWORD ) {
+        // padding is neither AA, AB nor BB, so it is never called
+        called = ( *a_aa++ | *a_ab++ ) & ( *b_aa++ | *b_ab++ );
+
+        _a1 = *a_h1++ & called;
+        _a2 = *a_h2++ & called;
+        _b1 = *b_h1++ & called;
+        _b2 = *b_h2++ & called;
+
+        n += PopCount( called );
+        n_a += PopCount( _a1 ) + PopCount( _a2 );
+        n_b += PopCount( _b1 ) + PopCount( _b2 );
+        n_ab += PopCount( _a1 & _b1 ) + PopCount( _a2 & _b2 );
+    }
+
+    ld.n = ( n << 1 );
+    ld.n_a = n_a;
+    ld.n_b = n_b;
+    ld.n_ab = n_ab;
+
+    ComputeHaplotypeLD( ld );
+}
+
+void HaplotypeTable::getHaplotypeLDWindow( uint rIdx, uint window, vector< haplotype_ld > &lds ) {
+    uint row_end = rIdx + 1 + window;
+    if( row_end > ( uint ) max_row ) {
+        row_end = max_row;
+    }
+
+    lds.resize( row_end - rIdx - 1 );
+    for( uint r = rIdx + 1, i = 0; r < row_end; ++r, ++i ) {
+        getHaplotypeLD( rIdx, r, lds[ i ] );
+    }
+}
+
+HaplotypeTable::~HaplotypeTable() {
+    delete [] haplotypes;
+}
+
+}
+}
@@ -0,0 +1,110 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef HAPLOTYPETABLE_H
+#define HAPLOTYPETABLE_H
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "common.h"
+#include "util/index_set/indexer.h"
+#include "genetics/genotype/compressed_genotype_table5.h"
+
+using namespace std;
+using namespace util;
+
+namespace libgwaspp {
+namespace genetics {
+
+/**
+ * Two marker haplotype statistics.
+ *
+ * Allele 0 of a marker is the first allele observed in its row, allele 1 is
+ * the other allele. Only haplotypes of individuals called at both markers are
+ * counted.
+ */
+struct haplotype_ld {
+    uint n;             // haplotypes called at both markers
+    uint n_a, n_b;      // haplotypes carrying allele 1 at marker A, marker B
+    uint n_ab;          // haplotypes carrying allele 1 at both markers
+    double freq[ 4 ];   // haplotype frequencies; 00, 01, 10, 11 (marker A, marker B)
+    double D, Dprime, r2;
+};
+
+/**
+ * Class: HaplotypeTable
+ * Description: 2-bit streaming table for phased genotypes.
+ *
+ * Genotypes are encoded into the streams of CompressedGenotypeTable5 as usual,
+ * so every genotype level kernel is inherited. In addition each row keeps one
+ * bit-plane per haplotype copy, using the column layout of the streams:
+ *
+ *  [ copy 1 | copy 2 ] per row, genotype_block_offset_ab blocks per plane
+ *
+ * A set bit marks allele 1 on that copy. The first allele of a call (as in
+ * "AC") is copy 1, the second is copy 2. The genotype streams receive the
+ * call with its alleles ordered, since "AC" and "CA" are the same genotype.
+ * Missing calls are taken from the genotype streams, so the planes have no
+ * missing state of their own.
+ *
+ * Haplotype frequencies, D, D' and r^2 between two markers reduce to AND and
+ * popcount over the planes.
+ */
+class HaplotypeTable : public CompressedGenotypeTable5 {
+public:
+    HaplotypeTable( indexer *markers, indexer *individs );
+
+    void addGenotype( int rIdx, int cIdx, const string &gt );
+    void addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim );
+    void addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim );
+
+    // rows are unphased through a shared buffer
+    bool supportsConcurrentRowWrites() const { return false; }
+
+    void getHaplotypeLD( uint rIdx1, uint rIdx2, haplotype_ld &ld );
+
+    // LD of rIdx with each of the following window markers
+    void getHaplotypeLDWindow( uint rIdx, uint window, vector< haplotype_ld > &lds );
+
+    virtual ~HaplotypeTable();
+protected:
+    void setHaplotype( uint rIdx, uint cIdx, byte c1, byte c2 );
+
+    DataBlock *haplotypes;
+    ulong haplotype_blocks_per_row;
+
+    vector< byte > ref_allele;      // allele 0 of every row; alphabet_size until observed
+    vector< char > unphased_row;    // row buffer with the alleles of each call ordered
+};
+
+}
+}
+
+#endif // HAPLOTYPETABLE_H
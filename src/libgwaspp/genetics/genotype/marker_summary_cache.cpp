@@ -0,0 +1,407 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/genotype/marker_summary_cache.h"
+#include "genetics/genotype/common_genotype_func.h"
+#include "util/thread/parallel_for.h"
+
+#include <algorithm>
+
+namespace libgwaspp {
+namespace genetics {
+
+const uint MarkerSummaryCache::BLOCK_ROWS = 1024;
+const uint MarkerSummaryCache::FORMAT_MAGIC = 0x43534D4C;     // "LMSC"
+const uint MarkerSummaryCache::FORMAT_VERSION = 1;
+
+struct summary_fill_work {
+    GenoTable *gt;
+    CaseControlSet *ccs;
+    const uint *blocks;
+    void *columns;
+    MarkerSummaryCache *cache;
+};
+
+MarkerSummaryCache::MarkerSummaryCache( GenoTable *_gt ) : gt( NULL ), row_count( 0 ), column_count( 0 ), block_count( 0 ), hits( 0 ), misses( 0 ) {
+    setGenotypeTable( _gt );
+}
+
+void MarkerSummaryCache::setGenotypeTable( GenoTable *_gt ) {
+    gt = _gt;
+    row_count = ( gt != NULL ) ? gt->row_size() : 0;
+    column_count = ( gt != NULL ) ? gt->column_size() : 0;
+    block_count = ( row_count + BLOCK_ROWS - 1 ) / BLOCK_ROWS;
+
+    invalidate();
+}
+
+void MarkerSummaryCache::invalidate() {
+    resetColumns( counts );
+    maf.assign( row_count, 0.0 );
+    missing_rate.assign( row_count, 0.0 );
+    sets.clear();
+}
+
+void MarkerSummaryCache::invalidateRow( uint rIdx ) {
+    assert( rIdx < row_count );
+    uint b = rIdx / BLOCK_ROWS;
+
+    counts.filled[ b ] = 0;
+    for( set_map::iterator it = sets.begin(); it != sets.end(); it++ ) {
+        it->second.cases.filled[ b ] = 0;
+        it->second.ctrls.filled[ b ] = 0;
+    }
+}
+
+void MarkerSummaryCache::resetColumns( count_columns &cc ) {
+    cc.aa.assign( row_count, 0 );
+    cc.ab.assign( row_count, 0 );
+    cc.bb.assign( row_count, 0 );
+    cc.xx.assign( row_count, 0 );
+    cc.filled.assign( block_count, 0 );
+}
+
+void MarkerSummaryCache::storeCounts( count_columns &cc, uint rIdx, const frequency_table &ft ) {
+    cc.aa[ rIdx ] = ft.aa;
+    cc.ab[ rIdx ] = ft.ab;
+    cc.bb[ rIdx ] = ft.bb;
+    cc.xx[ rIdx ] = ft.xx;
+}
+
+/**
+ * Tables differ in what the missing count of a masked row holds: some leave
+ * it empty, others add the padding or the columns outside of the set. The
+ * missing calls are therefore taken from the size of the set.
+ */
+void MarkerSummaryCache::storeCaseControlCounts( count_columns &cc, uint rIdx, const frequency_table &ft, uint nSetSize ) {
+    uint called = ft.aa + ft.ab + ft.bb;
+    assert( called <= nSetSize );
+
+    cc.aa[ rIdx ] = ft.aa;
+    cc.ab[ rIdx ] = ft.ab;
+    cc.bb[ rIdx ] = ft.bb;
+    cc.xx[ rIdx ] = nSetSize - called;
+}
+
+void MarkerSummaryCache::loadCounts( const count_columns &cc, uint rIdx, frequency_table &ft ) const {
+    ResetFrequencyTable( ft );
+    ft.aa = cc.aa[ rIdx ];
+    ft.ab = cc.ab[ rIdx ];
+    ft.bb = cc.bb[ rIdx ];
+    ft.xx = cc.xx[ rIdx ];
+}
+
+/**
+ * The minor allele frequency is taken from the integer allele counts, so that
+ * markers with the same counts compare equal whichever allele is minor.
+ */
+void MarkerSummaryCache::deriveRow( uint rIdx ) {
+    uint called = counts.aa[ rIdx ] + counts.ab[ rIdx ] + counts.bb[ rIdx ];
+    uint minor = min( 2 * counts.aa[ rIdx ] + counts.ab[ rIdx ], 2 * counts.bb[ rIdx ] + counts.ab[ rIdx ] );
+
+    maf[ rIdx ] = ( called > 0 ) ? ( double ) minor / ( 2.0 * called ) : 0.0;
+    missing_rate[ rIdx ] = ( column_count > 0 ) ? ( double )( column_count - called ) / column_count : 0.0;
+}
+
+void MarkerSummaryCache::fillCountWorker( void *arg, ulong begin, ulong end ) {
+    summary_fill_work &w = *reinterpret_cast< summary_fill_work * >( arg );
+    MarkerSummaryCache &cache = *w.cache;
+
+    vector< frequency_table > dist( BLOCK_ROWS );
+    for( ulong i = begin; i < end; ++i ) {
+        uint b = w.blocks[ i ];
+        uint r0 = b * BLOCK_ROWS, r1 = min( r0 + BLOCK_ROWS, cache.row_count );
+
+        w.gt->getGenotypeDistributions( r0, r1, &dist[0] );
+
+        for( uint r = r0; r < r1; ++r ) {
+            cache.storeCounts( cache.counts, r, dist[ r - r0 ] );
+            cache.deriveRow( r );
+        }
+        cache.counts.filled[ b ] = 1;
+    }
+}
+
+void MarkerSummaryCache::fillBlocks( uint block_begin, uint block_end, uint nThreads ) {
+    vector< uint > blocks;
+    for( uint b = block_begin; b < block_end; ++b ) {
+        if( !counts.filled[ b ] ) {
+            blocks.push_back( b );
+        }
+    }
+
+    misses += blocks.size();
+    hits += ( block_end - block_begin ) - blocks.size();
+    if( blocks.empty() ) return;
+
+    summary_fill_work w;
+    w.gt = gt;
+    w.ccs = NULL;
+    w.blocks = &blocks[0];
+    w.columns = &counts;
+    w.cache = this;
+
+    ParallelFor( 0, blocks.size(), fillCountWorker, &w, ( gt->supportsConcurrentReads() ? nThreads : 1 ) );
+}
+
+void MarkerSummaryCache::fillCaseControlWorker( void *arg, ulong begin, ulong end ) {
+    summary_fill_work &w = *reinterpret_cast< summary_fill_work * >( arg );
+    MarkerSummaryCache &cache = *w.cache;
+    case_control_columns &ccc = *reinterpret_cast< case_control_columns * >( w.columns );
+
+    const uint nCases = w.ccs->getCaseCount(), nControls = w.ccs->getControlCount();
+
+    vector< CaseControlSet * > sets( 1, w.ccs );
+    CaseControlGenotypeDistribution ccgd;
+    for( ulong i = begin; i < end; ++i ) {
+        uint b = w.blocks[ i ];
+        uint r0 = b * BLOCK_ROWS, r1 = min( r0 + BLOCK_ROWS, cache.row_count );
+
+        for( uint r = r0; r < r1; ++r ) {
+            w.gt->getCaseControlGenotypeDistributions( r, sets, &ccgd );
+            cache.storeCaseControlCounts( ccc.cases, r, *ccgd.getCaseDistribution(), nCases );
+            cache.storeCaseControlCounts( ccc.ctrls, r, *ccgd.getControlDistribution(), nControls );
+        }
+        ccc.cases.filled[ b ] = 1;
+        ccc.ctrls.filled[ b ] = 1;
+    }
+}
+
+/**
+ * The first block is counted on the calling thread: tables may prepare the
+ * column masks of a set on its first use, and only read them afterwards.
+ */
+void MarkerSummaryCache::fillCaseControlBlocks( case_control_columns &ccc, CaseControlSet &ccs, uint block_begin, uint block_end, uint nThreads ) {
+    vector< uint > blocks;
+    for( uint b = block_begin; b < block_end; ++b ) {
+        if( !ccc.cases.filled[ b ] ) {
+            blocks.push_back( b );
+        }
+    }
+
+    misses += blocks.size();
+    hits += ( block_end - block_begin ) - blocks.size();
+    if( blocks.empty() ) return;
+
+    summary_fill_work w;
+    w.gt = gt;
+    w.ccs = &ccs;
+    w.blocks = &blocks[0];
+    w.columns = &ccc;
+    w.cache = this;
+
+    fillCaseControlWorker( &w, 0, 1 );
+    ParallelFor( 1, blocks.size(), fillCaseControlWorker, &w, ( gt->supportsConcurrentReads() ? nThreads : 1 ) );
+}
+
+MarkerSummaryCache::case_control_columns &MarkerSummaryCache::caseControlColumns( CaseControlSet &ccs ) {
+    ulong fp = Fingerprint( ccs );
+
+    set_map::iterator it = sets.find( fp );
+    if( it != sets.end() ) return it->second;
+
+    case_control_columns &ccc = sets[ fp ];
+    resetColumns( ccc.cases );
+    resetColumns( ccc.ctrls );
+    return ccc;
+}
+
+void MarkerSummaryCache::getCounts( uint rIdx, frequency_table &ft ) {
+    assert( rIdx < row_count );
+    uint b = rIdx / BLOCK_ROWS;
+
+    fillBlocks( b, b + 1, 1 );
+    loadCounts( counts, rIdx, ft );
+}
+
+double MarkerSummaryCache::getMAF( uint rIdx ) {
+    assert( rIdx < row_count );
+    uint b = rIdx / BLOCK_ROWS;
+
+    fillBlocks( b, b + 1, 1 );
+    return maf[ rIdx ];
+}
+
+double MarkerSummaryCache::getMissingRate( uint rIdx ) {
+    assert( rIdx < row_count );
+    uint b = rIdx / BLOCK_ROWS;
+
+    fillBlocks( b, b + 1, 1 );
+    return missing_rate[ rIdx ];
+}
+
+void MarkerSummaryCache::getCounts( uint row_begin, uint row_end, frequency_table *out, uint nThreads ) {
+    assert( row_end <= row_count );
+    if( row_begin >= row_end ) return;
+
+    fillBlocks( row_begin / BLOCK_ROWS, ( row_end - 1 ) / BLOCK_ROWS + 1, nThreads );
+    for( uint r = row_begin; r < row_end; ++r ) {
+        loadCounts( counts, r, *out++ );
+    }
+}
+
+void MarkerSummaryCache::getCaseControlCounts( uint rIdx, CaseControlSet &ccs, frequency_table &cases, frequency_table &ctrls ) {
+    assert( rIdx < row_count );
+    uint b = rIdx / BLOCK_ROWS;
+
+    case_control_columns &ccc = caseControlColumns( ccs );
+    fillCaseControlBlocks( ccc, ccs, b, b + 1, 1 );
+    loadCounts( ccc.cases, rIdx, cases );
+    loadCounts( ccc.ctrls, rIdx, ctrls );
+}
+
+void MarkerSummaryCache::getCaseControlCounts( uint row_begin, uint row_end, CaseControlSet &ccs, frequency_table *cases, frequency_table *ctrls, uint nThreads ) {
+    assert( row_end <= row_count );
+    if( row_begin >= row_end ) return;
+
+    case_control_columns &ccc = caseControlColumns( ccs );
+    fillCaseControlBlocks( ccc, ccs, row_begin / BLOCK_ROWS, ( row_end - 1 ) / BLOCK_ROWS + 1, nThreads );
+    for( uint r = row_begin; r < row_end; ++r ) {
+        loadCounts( ccc.cases, r, *cases++ );
+        loadCounts( ccc.ctrls, r, *ctrls++ );
+    }
+}
+
+void MarkerSummaryCache::getMarginalInformation( uint rIdx, CaseControlSet &ccs, marginal_information &m ) {
+    frequency_table cases, ctrls;
+    getCaseControlCounts( rIdx, ccs, cases, ctrls );
+    computeMarginalInformation( cases, ctrls, ccs.getCaseCount() + ccs.getControlCount(), m );
+}
+
+/**
+ * 64-bit FNV-1a over the case and control column streams of the set, up to
+ * its last possible column.
+ */
+ulong MarkerSummaryCache::Fingerprint( CaseControlSet &ccs ) {
+    const uint nBlocks = ccs.getMaximumIndex() / 16 + 1;
+    const ushort last_mask = ( ushort )( 0xFFFF >> ( 15 - ccs.getMaximumIndex() % 16 ) );
+
+    ulong h = 0xcbf29ce484222325UL;
+
+    const ushort *streams[ 2 ] = { ccs.stream_case_begin(), ccs.stream_control_begin() };
+    for( uint k = 0; k < 2; ++k ) {
+        for( uint b = 0; b < nBlocks; ++b ) {
+            ushort v = streams[ k ][ b ];
+            if( b + 1 == nBlocks ) {
+                v &= last_mask;
+            }
+            h = ( h ^ ( v & 0xFF ) ) * 0x100000001b3UL;
+            h = ( h ^ ( v >> 8 ) ) * 0x100000001b3UL;
+        }
+        // separates the case stream from the control stream
+        h = ( h ^ 0xFF ) * 0x100000001b3UL;
+    }
+    return h;
+}
+
+void MarkerSummaryCache::writeColumns( const count_columns &cc, ostream &out ) {
+    if( !cc.filled.empty() ) {
+        out.write( reinterpret_cast< const char * >( &cc.filled[0] ), cc.filled.size() );
+    }
+
+    const vector< uint > *columns[ 4 ] = { &cc.aa, &cc.ab, &cc.bb, &cc.xx };
+    for( uint k = 0; k < 4; ++k ) {
+        if( !columns[ k ]->empty() ) {
+            out.write( reinterpret_cast< const char * >( &( *columns[ k ] )[0] ), columns[ k ]->size() * sizeof( uint ) );
+        }
+    }
+}
+
+bool MarkerSummaryCache::readColumns( count_columns &cc, uint nRows, uint nBlocks, istream &in ) {
+    cc.filled.resize( nBlocks );
+    if( nBlocks > 0 ) {
+        in.read( reinterpret_cast< char * >( &cc.filled[0] ), nBlocks );
+    }
+
+    vector< uint > *columns[ 4 ] = { &cc.aa, &cc.ab, &cc.bb, &cc.xx };
+    for( uint k = 0; k < 4; ++k ) {
+        columns[ k ]->resize( nRows );
+        if( nRows > 0 ) {
+            in.read( reinterpret_cast< char * >( &( *columns[ k ] )[0] ), nRows * sizeof( uint ) );
+        }
+    }
+    return in.good();
+}
+
+/**
+ * Layout: magic, version, rows, columns, rows per block and the number of
+ * case/control sets as 32-bit values; the whole-table count columns; then
+ * per set its 64-bit fingerprint and the case and control count columns.
+ * Every count column is preceded by its per-block filled flags.
+ */
+void MarkerSummaryCache::write( ostream &out ) const {
+    uint header[ 6 ] = { FORMAT_MAGIC, FORMAT_VERSION, row_count, column_count, BLOCK_ROWS, ( uint ) sets.size() };
+    out.write( reinterpret_cast< const char * >( header ), sizeof( header ) );
+
+    writeColumns( counts, out );
+    for( set_map::const_iterator it = sets.begin(); it != sets.end(); it++ ) {
+        ulong fp = it->first;
+        out.write( reinterpret_cast< const char * >( &fp ), sizeof( fp ) );
+        writeColumns( it->second.cases, out );
+        writeColumns( it->second.ctrls, out );
+    }
+}
+
+bool MarkerSummaryCache::read( istream &in ) {
+    uint header[ 6 ];
+    in.read( reinterpret_cast< char * >( header ), sizeof( header ) );
+
+    if( !in.good() || header[0] != FORMAT_MAGIC || header[1] != FORMAT_VERSION || header[2] != row_count || header[3] != column_count || header[4] != BLOCK_ROWS ) {
+        return false;
+    }
+
+    count_columns tmp_counts;
+    set_map tmp_sets;
+
+    if( !readColumns( tmp_counts, row_count, block_count, in ) ) return false;
+
+    for( uint s = 0; s < header[5]; ++s ) {
+        ulong fp;
+        in.read( reinterpret_cast< char * >( &fp ), sizeof( fp ) );
+
+        case_control_columns &ccc = tmp_sets[ fp ];
+        if( !readColumns( ccc.cases, row_count, block_count, in ) || !readColumns( ccc.ctrls, row_count, block_count, in ) ) return false;
+    }
+
+    counts.aa.swap( tmp_counts.aa );
+    counts.ab.swap( tmp_counts.ab );
+    counts.bb.swap( tmp_counts.bb );
+    counts.xx.swap( tmp_counts.xx );
+    counts.filled.swap( tmp_counts.filled );
+    sets.swap( tmp_sets );
+
+    for( uint r = 0; r < row_count; ++r ) {
+        deriveRow( r );
+    }
+    return true;
+}
+
+MarkerSummaryCache::~MarkerSummaryCache() {}
+
+}
+}
@@ -0,0 +1,159 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef MARKERSUMMARYCACHE_H
+#define MARKERSUMMARYCACHE_H
+
+#include <iostream>
+#include <vector>
+#include <map>
+
+#include "common.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/common_genotype.h"
+#include "genetics/analyzable/case_control_set.h"
+
+using namespace std;
+
+namespace libgwaspp {
+namespace genetics {
+
+/**
+ * Class: MarkerSummaryCache
+ * Description: Per-marker summary statistics of a genotype table, kept in
+ * columns and filled on first use.
+ *
+ * The genotype counts of every row, with the minor allele frequency and the
+ * missing rate derived from them, are computed a block of rows at a time
+ * through the batched distribution kernel of the table. Case/control counts
+ * are kept per CaseControlSet, keyed by a fingerprint of its case and control
+ * columns, so a set rebuilt with the same individuals finds the counts of the
+ * earlier one. They are counted with the kernel which is given the set
+ * explicitly, so the counts belong to the set which is looked up whichever
+ * set is selected on the table.
+ *
+ * Rows are invalidated one block at a time; the owner of the table calls
+ * invalidateRow() when it writes a row, and invalidate() or
+ * setGenotypeTable() when the table or its columns change.
+ *
+ * write() and read() persist the filled blocks, so that a table saved in the
+ * native row layout can carry its statistics along.
+ *
+ * Filling is not thread safe. Threads which share the cache should call the
+ * range accessors first; afterwards the row accessors only read.
+ */
+class MarkerSummaryCache {
+public:
+    MarkerSummaryCache( GenoTable *gt = NULL );
+
+    void setGenotypeTable( GenoTable *gt );
+    GenoTable *getGenotypeTable() { return gt; }
+
+    void invalidate();
+    void invalidateRow( uint rIdx );
+
+    // whole-table statistics of a row
+    void getCounts( uint rIdx, frequency_table &ft );
+    double getMAF( uint rIdx );
+    double getMissingRate( uint rIdx );
+
+    // counts of the rows [row_begin, row_end); out[i] belongs to row row_begin + i
+    void getCounts( uint row_begin, uint row_end, frequency_table *out, uint nThreads = 0 );
+
+    // case/control counts of a row, and of the rows [row_begin, row_end)
+    void getCaseControlCounts( uint rIdx, CaseControlSet &ccs, frequency_table &cases, frequency_table &ctrls );
+    void getCaseControlCounts( uint row_begin, uint row_end, CaseControlSet &ccs, frequency_table *cases, frequency_table *ctrls, uint nThreads = 0 );
+
+    // marginal information of a row, from its case/control counts
+    void getMarginalInformation( uint rIdx, CaseControlSet &ccs, marginal_information &m );
+
+    static ulong Fingerprint( CaseControlSet &ccs );
+
+    // blocks found filled, and blocks which had to be counted
+    ulong getHits() const { return hits; }
+    ulong getMisses() const { return misses; }
+
+    void write( ostream &out ) const;
+
+    // false, leaving the cache untouched, when the stream does not hold a
+    // cache of a table of the same shape
+    bool read( istream &in );
+
+    virtual ~MarkerSummaryCache();
+
+    static const uint BLOCK_ROWS;
+    static const uint FORMAT_MAGIC;
+    static const uint FORMAT_VERSION;
+
+protected:
+    // count columns of a set of rows; filled is one flag per block
+    struct count_columns {
+        vector< uint > aa, ab, bb, xx;
+        vector< byte > filled;
+    };
+
+    struct case_control_columns {
+        count_columns cases, ctrls;
+    };
+
+    typedef map< ulong, case_control_columns > set_map;
+
+    void resetColumns( count_columns &cc );
+    void storeCounts( count_columns &cc, uint rIdx, const frequency_table &ft );
+    void storeCaseControlCounts( count_columns &cc, uint rIdx, const frequency_table &ft, uint nSetSize );
+    void loadCounts( const count_columns &cc, uint rIdx, frequency_table &ft ) const;
+
+    // MAF and missing rate of a row from its whole-table counts
+    void deriveRow( uint rIdx );
+
+    // fills the blocks [block_begin, block_end) which are not filled yet
+    void fillBlocks( uint block_begin, uint block_end, uint nThreads );
+    void fillCaseControlBlocks( case_control_columns &ccc, CaseControlSet &ccs, uint block_begin, uint block_end, uint nThreads );
+    case_control_columns &caseControlColumns( CaseControlSet &ccs );
+
+    static void writeColumns( const count_columns &cc, ostream &out );
+    static bool readColumns( count_columns &cc, uint nRows, uint nBlocks, istream &in );
+
+    GenoTable *gt;
+    uint row_count, column_count, block_count;
+
+    count_columns counts;
+    vector< double > maf, missing_rate;
+
+    set_map sets;
+
+    ulong hits, misses;
+
+    static void fillCountWorker( void *arg, ulong begin, ulong end );
+    static void fillCaseControlWorker( void *arg, ulong begin, ulong end );
+};
+
+}
+}
+
+#endif // MARKERSUMMARYCACHE_H
@@ -0,0 +1,679 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/genotype/multi_allelic_genotype_table.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+const ulong MultiAllelicGenotypeTable::UNASSIGNED_ROW = ( ulong ) -1;
+
+MultiAllelicGenotypeTable::MultiAllelicGenotypeTable( indexer *markers, indexer *individs ) : GenoTable( markers, individs ), gt_lookup( NULL ), err_lookup( NULL ), selected_ccs( NULL ) {
+    initialize();
+}
+
+void MultiAllelicGenotypeTable::initialize() {
+    cout << "Initializing MultiAllelicGenotypeTable ... " << endl;
+    alphabet_size = ( int ) alphabet.length();
+    possible_genotypes_size = pow( alphabet_size, ( double ) MAX_ALLELE_COUNT ) + 1;   // +1 -> "unknown" genotype
+
+    assert( alphabet_size <= MULTI_ALLELE_MAX );
+
+    bits_per_data = 1;
+    data_per_block = ( BITS_PER_BLOCK ) / bits_per_data;
+
+    // same padding as the 2-bit streams, so case/control stream masks line up
+    ulong blocks_per_plane = max_column / data_per_block + 1;
+    if( blocks_per_plane % BLOCKS_PER_PWORD ) {
+        blocks_per_plane += ( BLOCKS_PER_PWORD - ( blocks_per_plane % BLOCKS_PER_PWORD ));
+    }
+    plane_words = blocks_per_plane / BLOCKS_PER_PWORD;
+
+    cout << "Alphabet Size: " << alphabet_size << endl;
+    cout << "Words per plane: " << plane_words << endl;
+
+    allele_row ar;
+    ar.offset = UNASSIGNED_ROW;
+    ar.allele_count = 0;
+    ar.plane_alleles = 0;
+    ar.implied_last = false;
+    allele_rows.assign( max_row, ar );
+
+    row_buffer.resize(( 1 + 2 * alphabet_size ) * plane_words );
+
+    memset( transformations, ( byte )( alphabet_size ), 256 );
+
+    int pattern = 0;
+    for( string::const_iterator it = alphabet.begin(); it != alphabet.end(); ++it, pattern += 1 ) {
+        transformations[( byte ) *it ] = pattern;
+    }
+
+    // encoded genotype = first allele * alphabet_size + second allele
+    beg = new ushort[ possible_genotypes_size ];
+    memset( beg, 0xFF, possible_genotypes_size * sizeof( ushort ) );
+    end = beg + possible_genotypes_size;
+
+    gt_size = MAX_ALLELE_COUNT + 1;
+    gt_lookup = new char[ gt_size * possible_genotypes_size ];
+    memset( gt_lookup, 0, gt_size * possible_genotypes_size );
+
+    for( uint i = 0, k = 0; i < alphabet_size; ++i ) {
+        for( uint j = 0; j < alphabet_size; ++j, ++k ) {
+            beg[ k ] = ( ushort ) k;
+            gt_lookup[ k * gt_size ] = alphabet[ i ];
+            gt_lookup[ k * gt_size + 1 ] = alphabet[ j ];
+        }
+    }
+
+    err_lookup = new char[ gt_size ];
+    for( int k = 0; k < MAX_ALLELE_COUNT; ++k ) {
+        err_lookup[ k ] = '0';
+    }
+    err_lookup[ MAX_ALLELE_COUNT ] = '\0';
+}
+
+byte MultiAllelicGenotypeTable::findOrAddAllele( allele_row &ar, byte allele ) {
+    for( byte a = 0; a < ar.allele_count; ++a ) {
+        if( ar.alleles[ a ] == allele ) {
+            return a;
+        }
+    }
+
+    assert( ar.allele_count < MULTI_ALLELE_MAX );
+    ar.alleles[ ar.allele_count ] = allele;
+    return ar.allele_count++;
+}
+
+DataBlock MultiAllelicGenotypeTable::operator()( int r, int c ) {
+    const allele_row &ar = allele_rows[ r ];
+    assert( ar.offset != UNASSIGNED_ROW );
+
+    PWORD called, one[ MULTI_ALLELE_MAX ], two[ MULTI_ALLELE_MAX ];
+    loadAlleleWords( ar, c / PROCESSOR_WORD_SIZE, called, one, two );
+
+    PWORD bit = (( PWORD ) 1 << ( c % PROCESSOR_WORD_SIZE ));
+
+    DataBlock db;
+    SetUshortAtDataBlock( db, 0xFFFF );
+    if( !( called & bit ) ) {
+        return db;
+    }
+
+    byte first = alphabet_size, second = alphabet_size;
+    for( byte a = 0; a < ar.allele_count; ++a ) {
+        if( two[ a ] & bit ) {
+            first = second = ar.alleles[ a ];
+            break;
+        }
+        if( one[ a ] & bit ) {
+            if( first == alphabet_size ) {
+                first = ar.alleles[ a ];
+            } else {
+                second = ar.alleles[ a ];
+            }
+        }
+    }
+
+    if( second < first ) {
+        swap( first, second );
+    }
+    SetUshortAtDataBlock( db, first * alphabet_size + second );
+    return db;
+}
+
+void MultiAllelicGenotypeTable::addGenotype( int rIdx, int cIdx, const string &gt ) {
+    assert( gt.length() == MAX_ALLELE_COUNT );
+    allele_row &ar = allele_rows[ rIdx ];
+
+    if( ar.offset == UNASSIGNED_ROW ) {
+        // alleles are not known up front; keep planes for all of them
+        ar.offset = planes.size();
+        ar.plane_alleles = alphabet_size;
+        planes.resize( planes.size() + ( 1 + 2 * alphabet_size ) * plane_words, 0 );
+    }
+    assert( !ar.implied_last );
+
+    uint w = cIdx / PROCESSOR_WORD_SIZE;
+    PWORD bit = (( PWORD ) 1 << ( cIdx % PROCESSOR_WORD_SIZE ));
+
+    PWORD *p = &planes[ ar.offset ] + w;
+    for( uint i = 0; i < 1 + 2 * ( uint ) ar.plane_alleles; ++i, p += plane_words ) {
+        *p &= ~bit;
+    }
+
+    byte c1 = transformations[( byte ) gt[0] ], c2 = transformations[( byte ) gt[1] ];
+    if( c1 == alphabet_size || c2 == alphabet_size ) return;
+
+    byte s1 = findOrAddAllele( ar, c1 ), s2 = findOrAddAllele( ar, c2 );
+
+    p = &planes[ ar.offset ] + w;
+    *p |= bit;
+    *( p + ( 1 + 2 * s1 ) * plane_words ) |= bit;
+    *( p + ( 1 + 2 * s2 ) * plane_words ) |= bit;
+    if( s1 == s2 ) {
+        *( p + ( 2 + 2 * s1 ) * plane_words ) |= bit;
+    }
+}
+
+void MultiAllelicGenotypeTable::addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim ) {
+    const char *p_begin = (( it < it_end ) ? &*it : NULL );
+    const char *p_end = p_begin + ( it_end - it );
+
+    addGenotypeRow( rIdx, p_begin, p_end, delim );
+    it = it_end;
+}
+
+void MultiAllelicGenotypeTable::addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim ) {
+    allele_row &ar = allele_rows[ rIdx ];
+    assert( ar.offset == UNASSIGNED_ROW );
+
+    memset( &row_buffer[0], 0, row_buffer.size() * sizeof( PWORD ) );
+
+    PWORD *called = &row_buffer[0];
+    byte c1, c2, s1, s2;
+    uint cIdx = 0, w;
+    PWORD bit;
+
+    // calls are 2 alleles followed by a delimiter
+    for( const char *tmp_p = p_begin; tmp_p + 1 < p_end; tmp_p += 3, ++cIdx ) {
+        c1 = transformations[( byte ) tmp_p[0] ];
+        c2 = transformations[( byte ) tmp_p[1] ];
+        if( c1 == alphabet_size || c2 == alphabet_size ) continue;
+
+        s1 = findOrAddAllele( ar, c1 );
+        s2 = findOrAddAllele( ar, c2 );
+
+        w = cIdx / PROCESSOR_WORD_SIZE;
+        bit = (( PWORD ) 1 << ( cIdx % PROCESSOR_WORD_SIZE ));
+
+        called[ w ] |= bit;
+        called[ ( 1 + 2 * s1 ) * plane_words + w ] |= bit;
+        called[ ( 1 + 2 * s2 ) * plane_words + w ] |= bit;
+        if( s1 == s2 ) {
+            called[ ( 2 + 2 * s1 ) * plane_words + w ] |= bit;
+        }
+    }
+
+    // the planes of the last allele are not stored
+    ar.implied_last = ( ar.allele_count > 0 );
+    ar.plane_alleles = ( byte )( ar.implied_last ? ar.allele_count - 1 : 0 );
+    ar.offset = planes.size();
+
+    planes.insert( planes.end(), row_buffer.begin(), row_buffer.begin() + ( 1 + 2 * ar.plane_alleles ) * plane_words );
+}
+
+ushort MultiAllelicGenotypeTable::encodeGenotype( const string &gt ) {
+    assert( gt.length() == MAX_ALLELE_COUNT );
+
+    byte c1 = transformations[( byte ) gt[0] ], c2 = transformations[( byte ) gt[1] ];
+    if( c1 == alphabet_size || c2 == alphabet_size ) {
+        return 0xFFFF;
+    }
+
+    // genotypes are unordered
+    if( c2 < c1 ) {
+        swap( c1, c2 );
+    }
+    return ( ushort )( c1 * alphabet_size + c2 );
+}
+
+const char *MultiAllelicGenotypeTable::decodeGenotype( ushort encoded_gt ) {
+    if( encoded_gt == 0xFFFF ) {
+        return err_lookup;
+    }
+    return ( gt_lookup + encoded_gt * gt_size );
+}
+
+bool MultiAllelicGenotypeTable::isGenotypeHomozygous( ushort encoded_gt ) {
+    return ( encoded_gt != 0xFFFF ) && ( encoded_gt / alphabet_size == encoded_gt % alphabet_size );
+}
+
+uint MultiAllelicGenotypeTable::maskCount( const ushort *mask ) const {
+    const PWORD *m = reinterpret_cast< const PWORD * >( mask );
+    uint n = 0;
+    for( uint w = 0; w < plane_words; ++w ) {
+        n += PopCount( m[ w ] );
+    }
+    return n;
+}
+
+void MultiAllelicGenotypeTable::collapsedDistribution( uint rIdx, const ushort *mask, uint total, frequency_table &ft ) {
+    const allele_row &ar = allele_rows[ rIdx ];
+    assert( ar.offset != UNASSIGNED_ROW );
+
+    const PWORD *m = reinterpret_cast< const PWORD * >( mask );
+    PWORD called, one[ MULTI_ALLELE_MAX ], two[ MULTI_ALLELE_MAX ], sel;
+
+    ResetFrequencyTable( ft );
+    if( ar.allele_count > 0 ) {
+        for( uint w = 0; w < plane_words; ++w ) {
+            loadAlleleWords( ar, w, called, one, two );
+            sel = (( m == NULL ) ? called : ( called & m[ w ] ));
+
+            ft.aa += PopCount( two[0] & sel );
+            ft.ab += PopCount( one[0] & ~two[0] & sel );
+            ft.bb += PopCount( ~one[0] & sel );
+        }
+    }
+    ft.xx = total - ft.aa - ft.ab - ft.bb;
+}
+
+void MultiAllelicGenotypeTable::collapsedContingency( uint rIdx1, uint rIdx2, const ushort *mask, uint total, CONTIN_TABLE_T &ct ) {
+    const allele_row &ar_a = allele_rows[ rIdx1 ], &ar_b = allele_rows[ rIdx2 ];
+    assert( ar_a.offset != UNASSIGNED_ROW && ar_b.offset != UNASSIGNED_ROW );
+
+    const PWORD *m = reinterpret_cast< const PWORD * >( mask );
+    PWORD called_a, one_a[ MULTI_ALLELE_MAX ], two_a[ MULTI_ALLELE_MAX ];
+    PWORD called_b, one_b[ MULTI_ALLELE_MAX ], two_b[ MULTI_ALLELE_MAX ];
+    PWORD ga[ GENOTYPE_COUNT - 1 ], gb[ GENOTYPE_COUNT - 1 ], sel;
+
+    ResetContingencyTable( ct );
+
+    // rows without any called genotype only contribute missing calls
+    one_a[0] = two_a[0] = one_b[0] = two_b[0] = 0;
+
+    uint listed = 0;
+    for( uint w = 0; w < plane_words; ++w ) {
+        loadAlleleWords( ar_a, w, called_a, one_a, two_a );
+        loadAlleleWords( ar_b, w, called_b, one_b, two_b );
+
+        sel = (( m == NULL ) ? ( PWORD ) -1 : m[ w ] );
+        called_a &= sel;
+        called_b &= sel;
+
+        ga[0] = two_a[0] & called_a;
+        ga[1] = one_a[0] & ~two_a[0] & called_a;
+        ga[2] = ~one_a[0] & called_a;
+
+        gb[0] = two_b[0] & called_b;
+        gb[1] = one_b[0] & ~two_b[0] & called_b;
+        gb[2] = ~one_b[0] & called_b;
+
+        for( int i = 0; i < GENOTYPE_COUNT - 1; ++i ) {
+            for( int j = 0; j < GENOTYPE_COUNT - 1; ++j ) {
+                ct.contin[ i * GENOTYPE_COUNT + j ] += PopCount( ga[i] & gb[j] );
+            }
+            ct.contin[ i * GENOTYPE_COUNT + GENOTYPE_COUNT - 1 ] += PopCount( ga[i] & ~called_b );
+            ct.contin[ ( GENOTYPE_COUNT - 1 ) * GENOTYPE_COUNT + i ] += PopCount( ~called_a & gb[i] );
+        }
+        listed += PopCount( called_a | called_b );
+    }
+
+    ct.xx_xx = total - listed;
+}
+
+void MultiAllelicGenotypeTable::getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist ) {
+    frequency_table ft;
+    collapsedDistribution( rIdx, NULL, max_column, ft );
+    dist.setDistribution( ft );
+}
+
+void MultiAllelicGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlSet &ccs, CaseControlGenotypeDistribution &ccgd ) {
+    frequency_table case_gt, ctrl_gt;
+    collapsedDistribution( rIdx, ccs.stream_case_begin(), ccs.getCaseCount(), case_gt );
+    collapsedDistribution( rIdx, ccs.stream_control_begin(), ccs.getControlCount(), ctrl_gt );
+
+    ccgd.setCaseDistribution( case_gt );
+    ccgd.setControlDistribution( ctrl_gt );
+}
+
+void MultiAllelicGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd ) {
+    assert( selected_ccs != NULL );
+    getCaseControlGenotypeDistribution( rIdx, *selected_ccs, ccgd );
+}
+
+void MultiAllelicGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m ) {
+    getCaseControlGenotypeDistribution( rIdx, ccgd );
+
+    computeMarginalInformation( *ccgd.getCaseDistribution(), *ccgd.getControlDistribution(), ( double ) nIndivids, m );
+}
+
+void MultiAllelicGenotypeTable::selectCaseControl( CaseControlSet &ccs ) {
+    // the stream masks are applied directly; nothing is split
+    selected_ccs = &ccs;
+
+    nCaseCount = ccs.getCaseCount();
+    nControlCount = ccs.getControlCount();
+    nIndivids = nCaseCount + nControlCount;
+}
+
+void MultiAllelicGenotypeTable::getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct ) {
+    CONTIN_TABLE_T cont;
+    collapsedContingency( rIdx1, rIdx2, NULL, max_column, cont );
+
+    ct.setContingency( cont );
+    ct.setMarkerAIndex( rIdx1 );
+    ct.setMarkerBIndex( rIdx2 );
+}
+
+void MultiAllelicGenotypeTable::getContingencyTable( uint rIdx1, uint rIdx2, ushort *column_set, ContingencyTable &ct ) {
+    CONTIN_TABLE_T cont;
+    collapsedContingency( rIdx1, rIdx2, column_set, maskCount( column_set ), cont );
+
+    ct.setContingency( cont );
+    ct.setMarkerAIndex( rIdx1 );
+    ct.setMarkerBIndex( rIdx2 );
+}
+
+void MultiAllelicGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlSet &ccs, CaseControlContingencyTable &ccct ) {
+    CONTIN_TABLE_T case_cont, ctrl_cont;
+    collapsedContingency( rIdx1, rIdx2, ccs.stream_case_begin(), ccs.getCaseCount(), case_cont );
+    collapsedContingency( rIdx1, rIdx2, ccs.stream_control_begin(), ccs.getControlCount(), ctrl_cont );
+
+    ccct.updateContingencyTables( case_cont, ctrl_cont );
+    ccct.setMarkerAIndex( rIdx1 );
+    ccct.setMarkerBIndex( rIdx2 );
+}
+
+void MultiAllelicGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct ) {
+    assert( selected_ccs != NULL );
+    getCaseControlContingencyTable( rIdx1, rIdx2, *selected_ccs, ccct );
+}
+
+void MultiAllelicGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct ) {
+    getCaseControlContingencyTable( rIdx1, rIdx2, ccct );
+}
+
+void MultiAllelicGenotypeTable::loadCollapsedWords( const allele_row &ar, uint w, PWORD *groups ) const {
+    PWORD called = 0, one[ MULTI_ALLELE_MAX ], two[ MULTI_ALLELE_MAX ];
+    one[0] = two[0] = 0;
+
+    if( ar.allele_count > 0 ) {
+        loadAlleleWords( ar, w, called, one, two );
+    }
+
+    PWORD real = ( PWORD ) -1;
+    uint base = w * PROCESSOR_WORD_SIZE;
+    if( base + PROCESSOR_WORD_SIZE > ( uint ) max_column ) {
+        real = (( base >= ( uint ) max_column ) ? 0 : ((( PWORD ) 1 << ( max_column - base ) ) - 1 ));
+    }
+
+    groups[0] = two[0] & called;
+    groups[1] = one[0] & ~two[0] & called;
+    groups[2] = ~one[0] & called;
+    groups[3] = ~called & real;
+}
+
+/**
+ * As in the 2-bit stream tables, every column starts out missing for each row
+ * and the called columns move their count to their group.
+ */
+void MultiAllelicGenotypeTable::addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns ) {
+    PWORD groups[ GENOTYPE_COUNT ];
+
+    for( uint c = 0; c < ( uint ) max_column; ++c ) {
+        columns[ c ].xx += row_end - row_begin;
+    }
+
+    for( uint r = row_begin; r < row_end; ++r ) {
+        const allele_row &ar = allele_rows[ r ];
+        assert( ar.offset != UNASSIGNED_ROW );
+
+        for( uint w = 0, base = 0; w < plane_words; ++w, base += PROCESSOR_WORD_SIZE ) {
+            loadCollapsedWords( ar, w, groups );
+
+            for( uint g = 0; g < GENOTYPE_COUNT - 1; ++g ) {
+                for( PWORD bits = groups[ g ]; bits != 0; bits &= ( bits - 1 ) ) {
+                    frequency_table &ft = columns[ base + __builtin_ctzl( bits ) ];
+                    ++ft.freq[ g ];
+                    --ft.xx;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * The AB, BB and missing groups are restricted to the phenotyped columns and
+ * weighted by the value planes of qts, which share the column layout of the
+ * allele planes; the AA group is whatever the three leave of the totals.
+ */
+void MultiAllelicGenotypeTable::getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out ) {
+    assert( qts.getStreamBlockCount() == plane_words * BLOCKS_PER_PWORD );
+
+    const uint nBits = qts.getValueBits();
+    const PWORD *mask = reinterpret_cast< const PWORD * >( qts.plane_begin() );
+    const PWORD *values = mask + plane_words;
+    const PWORD *squares = values + nBits * plane_words;
+
+    PWORD groups[ GENOTYPE_COUNT ];
+
+    for( uint r = row_begin; r < row_end; ++r, ++out ) {
+        const allele_row &ar = allele_rows[ r ];
+        assert( ar.offset != UNASSIGNED_ROW );
+
+        ulong mis_square_sum = 0;
+        ResetTraitSums( *out );
+
+        for( uint w = 0; w < plane_words; ++w ) {
+            PWORD m = mask[ w ];
+            if( !m ) continue;
+
+            loadCollapsedWords( ar, w, groups );
+
+            for( uint g = 1; g < GENOTYPE_COUNT; ++g ) {
+                PWORD x = groups[ g ] & m;
+                out->count.freq[ g ] += PopCount( x );
+
+                const PWORD *p = values + w;
+                for( uint k = 0; k < nBits; ++k, p += plane_words ) {
+                    out->sum[ g ] += ( ulong ) PopCount( x & *p ) << k;
+                }
+            }
+
+            PWORD mis = groups[ 3 ] & m;
+            if( !mis ) continue;
+
+            const PWORD *p = squares + w;
+            for( uint k = 0; k < 2 * nBits; ++k, p += plane_words ) {
+                mis_square_sum += ( ulong ) PopCount( mis & *p ) << k;
+            }
+        }
+
+        out->count.aa = qts.getCount() - out->count.ab - out->count.bb - out->count.xx;
+        out->sum[ 0 ] = qts.getValueSum() - out->sum[ 1 ] - out->sum[ 2 ] - out->sum[ 3 ];
+        out->square_sum_called = qts.getSquareSum() - mis_square_sum;
+    }
+}
+
+void MultiAllelicGenotypeTable::getGenotypeCodes( uint row_begin, uint row_end, byte *codes ) {
+    static const byte GROUP_CODE[ GENOTYPE_COUNT - 1 ] = { STREAM_CODE_AA, STREAM_CODE_AB, STREAM_CODE_BB };
+    PWORD groups[ GENOTYPE_COUNT ];
+
+    for( uint r = row_begin; r < row_end; ++r, codes += max_column ) {
+        const allele_row &ar = allele_rows[ r ];
+        assert( ar.offset != UNASSIGNED_ROW );
+
+        memset( codes, STREAM_CODE_MISSING, max_column );
+        for( uint w = 0, base = 0; w < plane_words; ++w, base += PROCESSOR_WORD_SIZE ) {
+            loadCollapsedWords( ar, w, groups );
+
+            for( uint g = 0; g < GENOTYPE_COUNT - 1; ++g ) {
+                for( PWORD bits = groups[ g ]; bits != 0; bits &= ( bits - 1 ) ) {
+                    codes[ base + __builtin_ctzl( bits ) ] = GROUP_CODE[ g ];
+                }
+            }
+        }
+    }
+}
+
+void MultiAllelicGenotypeTable::getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums ) {
+    PWORD groups[ GENOTYPE_COUNT ];
+
+    for( uint r = row_begin; r < row_end; ++r, sums += 3 * l ) {
+        const allele_row &ar = allele_rows[ r ];
+        assert( ar.offset != UNASSIGNED_ROW );
+
+        memset( sums, 0, 3 * l * sizeof( double ) );
+        for( uint w = 0, base = 0; w < plane_words; ++w, base += PROCESSOR_WORD_SIZE ) {
+            loadCollapsedWords( ar, w, groups );
+
+            // AB, BB and missing
+            for( uint g = 1; g < GENOTYPE_COUNT; ++g ) {
+                double *s = sums + ( g - 1 ) * l;
+                for( PWORD bits = groups[ g ]; bits != 0; bits &= ( bits - 1 ) ) {
+                    const double *x = v + ( ulong )( base + __builtin_ctzl( bits ) ) * l;
+                    for( uint k = 0; k < l; ++k ) {
+                        s[ k ] += x[ k ];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void MultiAllelicGenotypeTable::addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns ) {
+    PWORD groups[ GENOTYPE_COUNT ];
+
+    assert( part < nParts );
+    const uint w_begin = ( uint )(( ulong ) plane_words * part / nParts );
+    const uint w_end = ( uint )(( ulong ) plane_words * ( part + 1 ) / nParts );
+
+    for( uint r = row_begin; r < row_end; ++r, w += 3 * l ) {
+        const allele_row &ar = allele_rows[ r ];
+        assert( ar.offset != UNASSIGNED_ROW );
+
+        for( uint i = w_begin, base = w_begin * PROCESSOR_WORD_SIZE; i < w_end; ++i, base += PROCESSOR_WORD_SIZE ) {
+            loadCollapsedWords( ar, i, groups );
+
+            for( uint g = 1; g < GENOTYPE_COUNT; ++g ) {
+                const double *x = w + ( g - 1 ) * l;
+                for( PWORD bits = groups[ g ]; bits != 0; bits &= ( bits - 1 ) ) {
+                    double *s = columns + ( ulong )( base + __builtin_ctzl( bits ) ) * l;
+                    for( uint k = 0; k < l; ++k ) {
+                        s[ k ] += x[ k ];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void MultiAllelicGenotypeTable::getMultiAllelicDistribution( uint rIdx, multi_allelic_distribution &dist, const ushort *mask ) {
+    const allele_row &ar = allele_rows[ rIdx ];
+    assert( ar.offset != UNASSIGNED_ROW );
+
+    const PWORD *m = reinterpret_cast< const PWORD * >( mask );
+    PWORD called, one[ MULTI_ALLELE_MAX ], two[ MULTI_ALLELE_MAX ], sel;
+    uint k = ar.allele_count, n = 0;
+
+    memset( &dist, 0, sizeof( multi_allelic_distribution ) );
+    dist.allele_count = k;
+    for( uint a = 0; a < k; ++a ) {
+        dist.alleles[ a ] = ar.alleles[ a ];
+    }
+
+    if( k > 0 ) {
+        for( uint w = 0; w < plane_words; ++w ) {
+            loadAlleleWords( ar, w, called, one, two );
+            sel = (( m == NULL ) ? called : ( called & m[ w ] ));
+
+            n += PopCount( sel );
+            for( uint i = 0; i < k; ++i ) {
+                dist.genotypes[ MultiAllelicGenotypeIndex( i, i, k ) ] += PopCount( two[ i ] & sel );
+                for( uint j = i + 1; j < k; ++j ) {
+                    dist.genotypes[ MultiAllelicGenotypeIndex( i, j, k ) ] += PopCount( one[ i ] & one[ j ] & sel );
+                }
+            }
+        }
+    }
+
+    for( uint i = 0; i < k; ++i ) {
+        dist.allele_copies[ i ] += 2 * dist.genotypes[ MultiAllelicGenotypeIndex( i, i, k ) ];
+        for( uint j = i + 1; j < k; ++j ) {
+            dist.allele_copies[ i ] += dist.genotypes[ MultiAllelicGenotypeIndex( i, j, k ) ];
+            dist.allele_copies[ j ] += dist.genotypes[ MultiAllelicGenotypeIndex( i, j, k ) ];
+        }
+    }
+
+    dist.xx = (( mask == NULL ) ? ( uint ) max_column : maskCount( mask ) ) - n;
+}
+
+void MultiAllelicGenotypeTable::getMultiAllelicContingencyTable( uint rIdx1, uint rIdx2, multi_allelic_contingency &ct, const ushort *mask ) {
+    const allele_row &ar_a = allele_rows[ rIdx1 ], &ar_b = allele_rows[ rIdx2 ];
+    assert( ar_a.offset != UNASSIGNED_ROW && ar_b.offset != UNASSIGNED_ROW );
+
+    const PWORD *m = reinterpret_cast< const PWORD * >( mask );
+    PWORD called_a, one_a[ MULTI_ALLELE_MAX ], two_a[ MULTI_ALLELE_MAX ];
+    PWORD called_b, one_b[ MULTI_ALLELE_MAX ], two_b[ MULTI_ALLELE_MAX ];
+    PWORD ga[ MULTI_GENOTYPE_MAX ], gb[ MULTI_GENOTYPE_MAX ], sel;
+
+    uint ka = ar_a.allele_count, kb = ar_b.allele_count;
+    uint na = (( ka * ( ka + 1 ) ) >> 1 ), nb = (( kb * ( kb + 1 ) ) >> 1 );
+
+    memset( &ct, 0, sizeof( multi_allelic_contingency ) );
+    ct.genotype_count_a = na;
+    ct.genotype_count_b = nb;
+
+    uint listed = 0, g;
+    for( uint w = 0; w < plane_words; ++w ) {
+        loadAlleleWords( ar_a, w, called_a, one_a, two_a );
+        loadAlleleWords( ar_b, w, called_b, one_b, two_b );
+
+        sel = (( m == NULL ) ? ( PWORD ) -1 : m[ w ] );
+        called_a &= sel;
+        called_b &= sel;
+
+        g = 0;
+        for( uint i = 0; i < ka; ++i ) {
+            ga[ g++ ] = two_a[ i ] & called_a;
+            for( uint j = i + 1; j < ka; ++j ) {
+                ga[ g++ ] = one_a[ i ] & one_a[ j ] & called_a;
+            }
+        }
+
+        g = 0;
+        for( uint i = 0; i < kb; ++i ) {
+            gb[ g++ ] = two_b[ i ] & called_b;
+            for( uint j = i + 1; j < kb; ++j ) {
+                gb[ g++ ] = one_b[ i ] & one_b[ j ] & called_b;
+            }
+        }
+
+        for( uint i = 0; i < na; ++i ) {
+            for( uint j = 0; j < nb; ++j ) {
+                ct.contin[ i ][ j ] += PopCount( ga[ i ] & gb[ j ] );
+            }
+            ct.contin[ i ][ nb ] += PopCount( ga[ i ] & ~called_b );
+        }
+        for( uint j = 0; j < nb; ++j ) {
+            ct.contin[ na ][ j ] += PopCount( ~called_a & gb[ j ] );
+        }
+        listed += PopCount( called_a | called_b );
+    }
+
+    ct.contin[ na ][ nb ] = (( mask == NULL ) ? ( uint ) max_column : maskCount( mask ) ) - listed;
+}
+
+MultiAllelicGenotypeTable::~MultiAllelicGenotypeTable() {
+    delete [] gt_lookup;
+    delete [] err_lookup;
+}
+
+}
+}
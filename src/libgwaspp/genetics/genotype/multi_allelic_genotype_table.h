@@ -0,0 +1,213 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef MULTIALLELICGENOTYPETABLE_H
+#define MULTIALLELICGENOTYPETABLE_H
+
+#include <iostream>
+#include <vector>
+
+#include "common.h"
+#include "util/index_set/indexer.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/common_genotype.h"
+#include "genetics/genotype/common_genotype_func.h"
+
+using namespace std;
+using namespace util;
+
+namespace libgwaspp {
+namespace genetics {
+
+#define MULTI_ALLELE_MAX 4
+#define MULTI_GENOTYPE_MAX 10   // MULTI_ALLELE_MAX * ( MULTI_ALLELE_MAX + 1 ) / 2
+
+/**
+ * Genotype distribution of a marker with k alleles.
+ *
+ * Genotypes are unordered allele pairs (i, j), i <= j, listed in lexicographic
+ * order: (0,0), (0,1), ..., (0,k-1), (1,1), ... Alleles are numbered in the
+ * order they first appear in the row.
+ */
+struct multi_allelic_distribution {
+    uint allele_count;
+    byte alleles[ MULTI_ALLELE_MAX ];       // alphabet index of each allele
+    uint genotypes[ MULTI_GENOTYPE_MAX ];
+    uint allele_copies[ MULTI_ALLELE_MAX ];
+    uint xx;                                // missing
+};
+
+/**
+ * Joint genotype counts of two markers. Rows are the genotypes of marker A,
+ * columns those of marker B; the last used row/column holds the missing calls.
+ */
+struct multi_allelic_contingency {
+    uint genotype_count_a, genotype_count_b;
+    uint contin[ MULTI_GENOTYPE_MAX + 1 ][ MULTI_GENOTYPE_MAX + 1 ];
+};
+
+inline uint MultiAllelicGenotypeIndex( uint i, uint j, uint k ) {
+    // i <= j < k
+    return i * k - (( i * ( i - 1 ) ) >> 1 ) + ( j - i );
+}
+
+/**
+ * Class: MultiAllelicGenotypeTable
+ * Description: bit-plane table for markers with more than two alleles
+ *
+ * Every row stores one "called" plane and two allele dosage planes per
+ * allele: one (at least one copy) and two (two copies). The planes use the
+ * column layout of the 2-bit streams, so the case/control stream masks apply
+ * directly. With k alleles:
+ *
+ *  homozygous (i,i)    = two_i
+ *  heterozygous (i,j)  = one_i & one_j
+ *
+ * The planes of the last allele follow from the others and the called plane,
+ * so a biallelic row stores 3 planes and a k-allele row 2k - 1.
+ *
+ * The biallelic interface of GenoTable treats the first allele of a row as
+ * allele A and pools every other allele into B: AA = two_0,
+ * AB = one_0 & ~two_0, BB = called & ~one_0. Missing counts only cover
+ * real columns.
+ *
+ * Rows filled one genotype at a time (addGenotype) keep explicit planes for
+ * every allele of the alphabet, as their alleles are not known up front.
+ */
+class MultiAllelicGenotypeTable : public GenoTable {
+public:
+    MultiAllelicGenotypeTable( indexer *markers, indexer *individs );
+
+    DataBlock operator()( int r, int c );
+
+    void addGenotype( int rIdx, int cIdx, const string &gt );
+    void addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim );
+    void addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim );
+
+    ushort encodeGenotype( const string &gt );
+    const char *decodeGenotype( ushort encoded_gt );
+
+    bool isGenotypeHomozygous( ushort encoded_gt );
+
+    void selectMarker( uint rIdx ) { assert( false ); }
+    void selectMarkerPair( uint rIdx1, uint rIdx2 ) { assert( false ); }
+
+    void getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlSet &ccs, CaseControlGenotypeDistribution &ccgd );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m );
+
+    void selectCaseControl( CaseControlSet &ccs );
+
+    void getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct );
+    void getContingencyTable( uint rIdx1, uint rIdx2, ushort *column_set, ContingencyTable &ct );
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlSet &ccs, CaseControlContingencyTable &ccct );
+
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct );
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct );
+
+    // biallelic column kernels over the collapsed planes
+    void addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns );
+    void getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out );
+    void getGenotypeCodes( uint row_begin, uint row_end, byte *codes );
+    void getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums );
+    void addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns );
+
+    // general k-allele kernels; mask selects columns (NULL for all columns)
+    void getMultiAllelicDistribution( uint rIdx, multi_allelic_distribution &dist, const ushort *mask = NULL );
+    void getMultiAllelicContingencyTable( uint rIdx1, uint rIdx2, multi_allelic_contingency &ct, const ushort *mask = NULL );
+
+    uint getAlleleCount( uint rIdx ) const { return allele_rows[ rIdx ].allele_count; }
+
+    virtual ~MultiAllelicGenotypeTable();
+protected:
+    struct allele_row {
+        ulong offset;                   // first word of the row in planes
+        byte allele_count;
+        byte plane_alleles;             // alleles with stored planes
+        bool implied_last;              // planes of the last allele are derived
+        byte alleles[ MULTI_ALLELE_MAX ];
+    };
+
+    void initialize();
+
+    byte findOrAddAllele( allele_row &ar, byte allele );
+    inline void loadAlleleWords( const allele_row &ar, uint w, PWORD &called, PWORD *one, PWORD *two ) const;
+
+    // word w of the biallelic collapse of a row: the AA, AB, BB and missing
+    // columns, in that order. Missing only covers real columns.
+    void loadCollapsedWords( const allele_row &ar, uint w, PWORD *groups ) const;
+
+    void collapsedDistribution( uint rIdx, const ushort *mask, uint total, frequency_table &ft );
+    void collapsedContingency( uint rIdx1, uint rIdx2, const ushort *mask, uint total, CONTIN_TABLE_T &ct );
+    uint maskCount( const ushort *mask ) const;
+
+    static const ulong UNASSIGNED_ROW;
+
+    uint plane_words;                   // processor words per bit-plane
+
+    vector< allele_row > allele_rows;
+    vector< PWORD > planes;
+    vector< PWORD > row_buffer;
+
+    char *gt_lookup, *err_lookup;
+    uint gt_size;
+
+    CaseControlSet *selected_ccs;
+};
+
+inline void MultiAllelicGenotypeTable::loadAlleleWords( const allele_row &ar, uint w, PWORD &called, PWORD *one, PWORD *two ) const {
+    const PWORD *p = &planes[ ar.offset ] + w;
+
+    called = *p;
+    p += plane_words;
+
+    byte stored = ( byte )( ar.implied_last ? ar.allele_count - 1 : ar.allele_count );
+    PWORD any_one = 0, any_two = 0, het = 0;
+    for( byte a = 0; a < stored; ++a ) {
+        one[ a ] = *p;
+        p += plane_words;
+        two[ a ] = *p;
+        p += plane_words;
+
+        het |= ( any_one & one[ a ] );
+        any_one |= one[ a ];
+        any_two |= two[ a ];
+    }
+
+    if( ar.implied_last ) {
+        // a call lacks the last allele if it is homozygous for, or heterozygous between, other alleles
+        one[ stored ] = called & ~( any_two | het );
+        two[ stored ] = called & ~any_one;
+    }
+}
+
+}
+}
+
+#endif // MULTIALLELICGENOTYPETABLE_H
@@ -0,0 +1,448 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/genotype/paged_genotype_table.h"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace libgwaspp {
+namespace genetics {
+
+const uint PagedGenotypeTable::DEFAULT_ROWS_PER_PAGE = 1024;
+const uint PagedGenotypeTable::DEFAULT_CACHED_PAGES = 64;
+
+const uint PagedGenotypeTable::UNMAPPED = 0xFFFFFFFF;
+
+static uint ResidentPageCount( indexer *markers, uint rows_per_page, uint cached_pages ) {
+    uint page_count = markers->included_size() / rows_per_page + 1;
+    return (( cached_pages < page_count ) ? cached_pages : page_count );
+}
+
+PagedGenotypeTable::PagedGenotypeTable( indexer *markers, indexer *individs, const string &file, uint _rows_per_page, uint cached_pages ) :
+    CompressedGenotypeTable5( markers, individs, ( ulong ) _rows_per_page * ResidentPageCount( markers, _rows_per_page, cached_pages ) ),
+    page_file( file ), fd( -1 ), rows_per_page( _rows_per_page ), selected_ccs( NULL ), page_hits( 0 ), page_misses( 0 ) {
+
+    cout << "Initializing PagedGenotypeTable ... " << endl;
+
+    frame_count = ResidentPageCount( markers, rows_per_page, cached_pages );
+    page_count = max_row / rows_per_page + 1;
+    page_bytes = ( ulong ) rows_per_page * bytes_per_row;
+
+    // a pair of rows must be resident at the same time
+    assert( frame_count >= 2 || page_count == 1 );
+
+    cout << "Rows per page: " << rows_per_page << endl;
+    cout << "Page size: " << page_bytes << " (bytes)" << endl;
+    cout << "Resident pages: " << frame_count << " of " << page_count << endl;
+
+    if( page_file.empty() ) {
+        fd = openTemporaryPageFile();
+    } else {
+        fd = open( page_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    }
+    if( fd < 0 ) {
+        cout << "ERROR: Unable to open page file " << page_file << endl;
+    }
+    assert( fd >= 0 );
+
+    page_frame.assign( page_count, UNMAPPED );
+    frame_page.assign( frame_count, UNMAPPED );
+    frame_pins.assign( frame_count, 0 );
+    frame_dirty.assign( frame_count, false );
+
+    lru_pos.resize( frame_count );
+    for( uint i = 0; i < frame_count; ++i ) {
+        lru_pos[ i ] = lru.insert( lru.end(), i );
+    }
+}
+
+int PagedGenotypeTable::openTemporaryPageFile() {
+    const char *dir = getenv( "TMPDIR" );
+    string tmpl = string( ( dir != NULL && *dir != '\0' ) ? dir : "/tmp" ) + "/genotype_table.XXXXXX";
+
+    vector< char > path( tmpl.begin(), tmpl.end() );
+    path.push_back( '\0' );
+
+    int tmp_fd = mkstemp( &path[ 0 ] );
+    if( tmp_fd >= 0 ) {
+        // the pages live only as long as the descriptor
+        unlink( &path[ 0 ] );
+    }
+    page_file = &path[ 0 ];
+    return tmp_fd;
+}
+
+void PagedGenotypeTable::readPage( uint page, uint frame ) {
+    char *buf = reinterpret_cast< char * >( data + ( ulong ) frame * rows_per_page * blocks_per_row );
+    off_t offset = ( off_t ) page * page_bytes;
+
+    ulong nRead = 0;
+    ssize_t res;
+    while( nRead < page_bytes && ( res = pread( fd, buf + nRead, page_bytes - nRead, offset + nRead ) ) > 0 ) {
+        nRead += res;
+    }
+
+    // pages which have not been written yet are "unknown"
+    if( nRead < page_bytes ) {
+        memset( buf + nRead, 0, page_bytes - nRead );
+    }
+}
+
+void PagedGenotypeTable::writePage( uint page, uint frame ) {
+    const char *buf = reinterpret_cast< const char * >( data + ( ulong ) frame * rows_per_page * blocks_per_row );
+    off_t offset = ( off_t ) page * page_bytes;
+
+    ulong nWritten = 0;
+    ssize_t res;
+    while( nWritten < page_bytes && ( res = pwrite( fd, buf + nWritten, page_bytes - nWritten, offset + nWritten ) ) > 0 ) {
+        nWritten += res;
+    }
+    assert( nWritten == page_bytes );
+
+    frame_dirty[ frame ] = false;
+}
+
+uint PagedGenotypeTable::evictFrame() {
+    // least recently used frame which is not pinned
+    list< uint >::reverse_iterator it = lru.rbegin();
+    while( it != lru.rend() && frame_pins[ *it ] > 0 ) {
+        ++it;
+    }
+    assert( it != lru.rend() );
+
+    uint frame = *it;
+    uint page = frame_page[ frame ];
+    if( page != UNMAPPED ) {
+        if( frame_dirty[ frame ] ) {
+            writePage( page, frame );
+        }
+        page_frame[ page ] = UNMAPPED;
+        frame_page[ frame ] = UNMAPPED;
+    }
+    return frame;
+}
+
+uint PagedGenotypeTable::fetchPage( uint page ) {
+    uint frame = page_frame[ page ];
+
+    if( frame != UNMAPPED ) {
+        ++page_hits;
+    } else {
+        ++page_misses;
+
+        frame = evictFrame();
+        readPage( page, frame );
+
+        page_frame[ page ] = frame;
+        frame_page[ frame ] = page;
+    }
+
+    lru.splice( lru.begin(), lru, lru_pos[ frame ] );
+    return frame;
+}
+
+void PagedGenotypeTable::prefetchRows( uint row_begin, uint row_end ) {
+    if( row_begin >= row_end ) return;
+    if( row_end > ( uint ) max_row ) {
+        row_end = max_row;
+    }
+
+    uint first = row_begin / rows_per_page, last = ( row_end - 1 ) / rows_per_page;
+
+    // only pages which are not resident need to be read ahead
+    while( first <= last && page_frame[ first ] != UNMAPPED ) {
+        ++first;
+    }
+    if( first > last ) return;
+
+#ifdef POSIX_FADV_WILLNEED
+    posix_fadvise( fd, ( off_t ) first * page_bytes, ( off_t )( last - first + 1 ) * page_bytes, POSIX_FADV_WILLNEED );
+#endif
+}
+
+void PagedGenotypeTable::pinRows( uint row_begin, uint row_end ) {
+    if( row_begin >= row_end ) return;
+
+    uint first = row_begin / rows_per_page, last = ( row_end - 1 ) / rows_per_page;
+    for( uint p = first; p <= last; ++p ) {
+        ++frame_pins[ fetchPage( p ) ];
+    }
+}
+
+void PagedGenotypeTable::unpinRows( uint row_begin, uint row_end ) {
+    if( row_begin >= row_end ) return;
+
+    uint first = row_begin / rows_per_page, last = ( row_end - 1 ) / rows_per_page;
+    for( uint p = first; p <= last; ++p ) {
+        assert( page_frame[ p ] != UNMAPPED && frame_pins[ page_frame[ p ] ] > 0 );
+        --frame_pins[ page_frame[ p ] ];
+    }
+}
+
+void PagedGenotypeTable::flush() {
+    for( uint i = 0; i < frame_count; ++i ) {
+        if( frame_page[ i ] != UNMAPPED && frame_dirty[ i ] ) {
+            writePage( frame_page[ i ], i );
+        }
+    }
+}
+
+DataBlock PagedGenotypeTable::operator()( int r, int c ) {
+    return CompressedGenotypeTable5::operator()( rowSlot( r ), c );
+}
+
+void PagedGenotypeTable::addGenotype( int rIdx, int cIdx, const string &gt ) {
+    CompressedGenotypeTable5::addGenotype( rowSlot( rIdx, true ), cIdx, gt );
+}
+
+void PagedGenotypeTable::addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim ) {
+    if( it >= it_end ) return;
+
+    const char *p_begin = &*it;
+    addGenotypeRow( rIdx, p_begin, p_begin + ( it_end - it ), delim );
+    it = it_end;
+}
+
+void PagedGenotypeTable::addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim ) {
+    if( p_begin >= p_end ) return;
+
+    encodeGenotypeRow( data + ( ulong ) rowSlot( rIdx, true ) * blocks_per_row, p_begin, p_end );
+}
+
+void PagedGenotypeTable::getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist ) {
+    CompressedGenotypeTable5::getGenotypeDistribution( rowSlot( rIdx ), dist );
+}
+
+void PagedGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlSet &ccs, CaseControlGenotypeDistribution &ccgd ) {
+    CompressedGenotypeTable5::getCaseControlGenotypeDistribution( rowSlot( rIdx ), ccs, ccgd );
+}
+
+void PagedGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd ) {
+    assert( selected_ccs != NULL );
+    CompressedGenotypeTable5::getCaseControlGenotypeDistribution( rowSlot( rIdx ), *selected_ccs, ccgd );
+}
+
+void PagedGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m ) {
+    getCaseControlGenotypeDistribution( rIdx, ccgd );
+
+    computeMarginalInformation( *ccgd.getCaseDistribution(), *ccgd.getControlDistribution(), ( double ) nIndivids, m );
+}
+
+void PagedGenotypeTable::getCaseControlGenotypeDistributions( uint rIdx, const vector< CaseControlSet * > &sets, CaseControlGenotypeDistribution *ccgd ) {
+    CompressedGenotypeTable5::getCaseControlGenotypeDistributions( rowSlot( rIdx ), sets, ccgd );
+}
+
+// rows are only addressable through rowSlot(), which may page them in
+void PagedGenotypeTable::getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out ) {
+    GenoTable::getGenotypeDistributions( row_begin, row_end, out );
+}
+
+void PagedGenotypeTable::getCaseControlGenotypeDistributions( uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls ) {
+    GenoTable::getCaseControlGenotypeDistributions( row_begin, row_end, cases, ctrls );
+}
+
+// one page at a time, pinned while its slots are read
+void PagedGenotypeTable::addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns ) {
+    vector< const DataBlock * > rows;
+
+    for( uint p_begin = row_begin; p_begin < row_end; ) {
+        uint p_end = min( ( p_begin / rows_per_page + 1 ) * rows_per_page, row_end );
+
+        pinRows( p_begin, p_end );
+
+        rows.clear();
+        for( uint r = p_begin; r < p_end; ++r ) {
+            rows.push_back( data + ( ulong ) rowSlot( r ) * blocks_per_row );
+        }
+        addColumnStreams( &rows[ 0 ], rows.size(), columns, max_column );
+
+        unpinRows( p_begin, p_end );
+        p_begin = p_end;
+    }
+}
+
+void PagedGenotypeTable::getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out ) {
+    const ushort *planes = traitPlanes( qts );
+
+    for( uint p_begin = row_begin; p_begin < row_end; ) {
+        uint p_end = min( ( p_begin / rows_per_page + 1 ) * rows_per_page, row_end );
+
+        pinRows( p_begin, p_end );
+        for( uint r = p_begin; r < p_end; ++r ) {
+            sumTraitStreams( data + ( ulong ) rowSlot( r ) * blocks_per_row, planes, qts, *out++ );
+        }
+        unpinRows( p_begin, p_end );
+
+        p_begin = p_end;
+    }
+}
+
+void PagedGenotypeTable::getGenotypeCodes( uint row_begin, uint row_end, byte *codes ) {
+    for( uint p_begin = row_begin; p_begin < row_end; ) {
+        uint p_end = min( ( p_begin / rows_per_page + 1 ) * rows_per_page, row_end );
+
+        pinRows( p_begin, p_end );
+        for( uint r = p_begin; r < p_end; ++r, codes += max_column ) {
+            decodeStreams( data + ( ulong ) rowSlot( r ) * blocks_per_row, codes, max_column );
+        }
+        unpinRows( p_begin, p_end );
+
+        p_begin = p_end;
+    }
+}
+
+void PagedGenotypeTable::getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums ) {
+    for( uint p_begin = row_begin; p_begin < row_end; ) {
+        uint p_end = min( ( p_begin / rows_per_page + 1 ) * rows_per_page, row_end );
+
+        pinRows( p_begin, p_end );
+        for( uint r = p_begin; r < p_end; ++r, sums += 3 * l ) {
+            sumVectorStreams( data + ( ulong ) rowSlot( r ) * blocks_per_row, v, l, NULL, sums );
+        }
+        unpinRows( p_begin, p_end );
+
+        p_begin = p_end;
+    }
+}
+
+void PagedGenotypeTable::addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns ) {
+    uint w_begin, w_end;
+    streamWordRange( part, nParts, w_begin, w_end );
+
+    for( uint p_begin = row_begin; p_begin < row_end; ) {
+        uint p_end = min( ( p_begin / rows_per_page + 1 ) * rows_per_page, row_end );
+
+        pinRows( p_begin, p_end );
+        for( uint r = p_begin; r < p_end; ++r, w += 3 * l ) {
+            addVectorStreams( data + ( ulong ) rowSlot( r ) * blocks_per_row, w, l, NULL, w_begin, w_end, columns );
+        }
+        unpinRows( p_begin, p_end );
+
+        p_begin = p_end;
+    }
+}
+
+void PagedGenotypeTable::selectCaseControl( CaseControlSet &ccs ) {
+    selected_ccs = &ccs;
+
+    nCaseCount = ccs.getCaseCount();
+    nControlCount = ccs.getControlCount();
+    nIndivids = nCaseCount + nControlCount;
+
+    // block counts of the case/control buffers a resident table would build;
+    // only used to keep the missing counts of the selected kernels consistent
+    int tmp_data_per_block = ( BITS_PER_BLOCK ) / bits_per_data;
+    nCaseBlockCount = nCaseCount / tmp_data_per_block + 1;
+    nControlBlockCount = nControlCount / tmp_data_per_block + 1;
+
+    int block_per_pword = ( PROCESSOR_WORD_SIZE / ( sizeof( DataBlock ) << 3 ) );
+    if( block_per_pword > 1 ) {
+        if( nCaseBlockCount % block_per_pword ) {
+            nCaseBlockCount += ( block_per_pword - ( nCaseBlockCount % block_per_pword ) );
+        }
+        if( nControlBlockCount % block_per_pword ) {
+            nControlBlockCount += ( block_per_pword - ( nControlBlockCount % block_per_pword ) );
+        }
+    }
+}
+
+void PagedGenotypeTable::getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct ) {
+    uint slot1 = rowSlot( rIdx1 );
+    uint frame1 = slot1 / rows_per_page;
+
+    // keep the first row resident while the second is paged in
+    ++frame_pins[ frame1 ];
+    uint slot2 = rowSlot( rIdx2 );
+    --frame_pins[ frame1 ];
+
+    CompressedGenotypeTable5::getContingencyTable( slot1, slot2, ct );
+
+    ct.setMarkerAIndex( rIdx1 );
+    ct.setMarkerBIndex( rIdx2 );
+}
+
+void PagedGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlSet &ccs, CaseControlContingencyTable &ccct ) {
+    uint slot1 = rowSlot( rIdx1 );
+    uint frame1 = slot1 / rows_per_page;
+
+    ++frame_pins[ frame1 ];
+    uint slot2 = rowSlot( rIdx2 );
+    --frame_pins[ frame1 ];
+
+    CompressedGenotypeTable5::getCaseControlContingencyTable( slot1, slot2, ccs, ccct );
+
+    ccct.setMarkerAIndex( rIdx1 );
+    ccct.setMarkerBIndex( rIdx2 );
+}
+
+void PagedGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct ) {
+    assert( selected_ccs != NULL );
+    getCaseControlContingencyTable( rIdx1, rIdx2, *selected_ccs, ccct );
+
+    // the masking kernels read every unselected column as missing, whereas
+    // the split buffers only contribute their padding
+    CONTIN_TABLE_T case_cont = *ccct.getCaseContingencyTable();
+    CONTIN_TABLE_T ctrl_cont = *ccct.getControlContingencyTable();
+
+    case_cont.xx_xx -= genotype_block_offset_ab * BITS_PER_BLOCK - nCaseBlockCount * BITS_PER_BLOCK;
+    ctrl_cont.xx_xx -= genotype_block_offset_ab * BITS_PER_BLOCK - nControlBlockCount * BITS_PER_BLOCK;
+
+    ccct.updateContingencyTables( case_cont, ctrl_cont );
+}
+
+void PagedGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct ) {
+    getCaseControlContingencyTable( rIdx1, rIdx2, ccct );
+}
+
+void PagedGenotypeTable::getCaseControlContingencyTables( uint rIdx1, uint rIdx2, const vector< CaseControlSet * > &sets, CaseControlContingencyTable *ccct ) {
+    uint slot1 = rowSlot( rIdx1 );
+    uint frame1 = slot1 / rows_per_page;
+
+    ++frame_pins[ frame1 ];
+    uint slot2 = rowSlot( rIdx2 );
+    --frame_pins[ frame1 ];
+
+    CompressedGenotypeTable5::getCaseControlContingencyTables( slot1, slot2, sets, ccct );
+
+    for( uint k = 0; k < sets.size(); ++k ) {
+        ccct[k].setMarkerAIndex( rIdx1 );
+        ccct[k].setMarkerBIndex( rIdx2 );
+    }
+}
+
+PagedGenotypeTable::~PagedGenotypeTable() {
+    if( fd >= 0 ) {
+        flush();
+        close( fd );
+    }
+}
+
+}
+}
@@ -0,0 +1,168 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef PAGEDGENOTYPETABLE_H
+#define PAGEDGENOTYPETABLE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+
+#include "common.h"
+#include "util/index_set/indexer.h"
+#include "genetics/genotype/compressed_genotype_table5.h"
+
+using namespace std;
+using namespace util;
+
+namespace libgwaspp {
+namespace genetics {
+
+/**
+ * Class: PagedGenotypeTable
+ * Description: Out-of-core variant of the 2-bit streaming table.
+ *
+ * Rows are grouped into fixed size row blocks (pages). Every page is stored
+ * in a backing file in the native row layout of CompressedGenotypeTable5
+ * ([header][aa stream][ab stream] per row), so page p starts at byte offset
+ * p * rows_per_page * bytes_per_row. Without a file name the pages go to a
+ * temporary file which is unlinked as soon as it is opened.
+ *
+ * Only a bounded number of pages are resident at any time. The inherited data
+ * buffer is divided into frames of rows_per_page row slots, and pages are
+ * brought into frames on demand with least recently used replacement.
+ * Modified pages are written back when they are evicted or flushed.
+ *
+ * prefetchRows() asks the operating system to read ahead the pages covering
+ * a row range; pinRows() keeps pages resident until they are unpinned, which
+ * allows a pair scheduler to hold one set of rows while streaming the rest.
+ *
+ * Case/control selection does not build a split buffer for every row, as that
+ * would not fit in memory either. Instead the selected set is remembered and
+ * the masking kernels are used.
+ */
+class PagedGenotypeTable : public CompressedGenotypeTable5 {
+public:
+    PagedGenotypeTable( indexer *markers, indexer *individs, const string &page_file, uint rows_per_page = DEFAULT_ROWS_PER_PAGE, uint cached_pages = DEFAULT_CACHED_PAGES );
+
+    DataBlock operator()( int r, int c );
+
+    void addGenotype( int rIdx, int cIdx, const string &gt );
+    void addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim );
+    void addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim );
+
+    void getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlSet &ccs, CaseControlGenotypeDistribution &ccgd );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m );
+    void getCaseControlGenotypeDistributions( uint rIdx, const vector< CaseControlSet * > &sets, CaseControlGenotypeDistribution *ccgd );
+
+    void getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out );
+    void getCaseControlGenotypeDistributions( uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls );
+
+    void addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns );
+
+    void getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out );
+    void getGenotypeCodes( uint row_begin, uint row_end, byte *codes );
+    void getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums );
+    void addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns );
+
+    void selectCaseControl( CaseControlSet &ccs );
+
+    void getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct );
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlSet &ccs, CaseControlContingencyTable &ccct );
+
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct );
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct );
+    void getCaseControlContingencyTables( uint rIdx1, uint rIdx2, const vector< CaseControlSet * > &sets, CaseControlContingencyTable *ccct );
+
+    uint getRowBlockSize() const { return rows_per_page; }
+    uint getResidentRowBlockCount() const { return frame_count; }
+    void prefetchRows( uint row_begin, uint row_end );
+    void pinRows( uint row_begin, uint row_end );
+    void unpinRows( uint row_begin, uint row_end );
+
+    // reading a row may evict another
+    bool supportsConcurrentReads() const { return false; }
+    bool supportsConcurrentRowWrites() const { return false; }
+
+    void flush();
+
+    ulong getPageHits() const { return page_hits; }
+    ulong getPageMisses() const { return page_misses; }
+
+    virtual ~PagedGenotypeTable();
+
+    static const uint DEFAULT_ROWS_PER_PAGE;
+    static const uint DEFAULT_CACHED_PAGES;
+protected:
+    inline uint rowSlot( uint rIdx, bool modify = false );
+
+    int openTemporaryPageFile();
+
+    uint fetchPage( uint page );
+    uint evictFrame();
+    void readPage( uint page, uint frame );
+    void writePage( uint page, uint frame );
+
+    static const uint UNMAPPED;
+
+    string page_file;
+    int fd;
+
+    uint rows_per_page, frame_count, page_count;
+    ulong page_bytes;
+
+    vector< uint > page_frame;      // frame holding each page, or UNMAPPED
+    vector< uint > frame_page;      // page held by each frame, or UNMAPPED
+    vector< uint > frame_pins;
+    vector< bool > frame_dirty;
+
+    list< uint > lru;               // most recently used frame at the front
+    vector< list< uint >::iterator > lru_pos;
+
+    CaseControlSet *selected_ccs;
+
+    ulong page_hits, page_misses;
+};
+
+inline uint PagedGenotypeTable::rowSlot( uint rIdx, bool modify ) {
+    assert( rIdx < ( uint ) max_row );
+
+    uint frame = fetchPage( rIdx / rows_per_page );
+    if( modify ) {
+        frame_dirty[ frame ] = true;
+    }
+    return frame * rows_per_page + ( rIdx % rows_per_page );
+}
+
+}
+}
+
+#endif // PAGEDGENOTYPETABLE_H
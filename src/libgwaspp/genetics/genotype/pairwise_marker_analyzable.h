@@ -186,6 +186,14 @@ class PairwiseMarkerAnalyzable : public virtual CaseControlSelectable {
         virtual void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct ) = 0;
         virtual void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct ) = 0;
 
+        // one table per CaseControlSet; ccct must hold sets.size() entries.
+        // Tables which can read the row pair once for every set override this.
+        virtual void getCaseControlContingencyTables( uint rIdx1, uint rIdx2, const vector< CaseControlSet * > &sets, CaseControlContingencyTable *ccct ) {
+            for( uint k = 0; k < sets.size(); ++k ) {
+                getCaseControlContingencyTable( rIdx1, rIdx2, *sets[k], ccct[k] );
+            }
+        }
+
         virtual ~PairwiseMarkerAnalyzable() {}
     protected:
         void resetSelectedMarkerPair() {
@@ -0,0 +1,408 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/genotype/permuted_genotype_table.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+const uint PermutedGenotypeTable::UNMAPPED = 0xFFFFFFFF;
+
+PermutedGenotypeTable::PermutedGenotypeTable( indexer *markers, indexer *individs ) :
+    CompressedGenotypeTable5( markers, individs ), permuted( false ), loaded_offset_ab( genotype_block_offset_ab ),
+    column_position( max_column ), row_buffer( blocks_per_row ) {
+
+    cout << "Initializing PermutedGenotypeTable ... " << endl;
+
+    for( uint i = 0; i < ( uint ) max_column; ++i ) {
+        column_position[ i ] = i;
+    }
+}
+
+DataBlock PermutedGenotypeTable::operator()( int r, int c ) {
+    return CompressedGenotypeTable5::operator()( r, column_position[ c ] );
+}
+
+void PermutedGenotypeTable::addGenotype( int rIdx, int cIdx, const string &gt ) {
+    CompressedGenotypeTable5::addGenotype( rIdx, column_position[ cIdx ], gt );
+}
+
+void PermutedGenotypeTable::addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim ) {
+    const char *p_begin = (( it < it_end ) ? &*it : NULL );
+    const char *p_end = p_begin + ( it_end - it );
+
+    addGenotypeRow( rIdx, p_begin, p_end, delim );
+    it = it_end;
+}
+
+void PermutedGenotypeTable::addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim ) {
+    if( p_begin >= p_end ) return;
+
+    DataBlock *row = data + rIdx * blocks_per_row;
+    encodeGenotypeRow( row, p_begin, p_end );
+
+    if( permuted ) {
+        // rows are encoded in column order; move them into the selected layout
+        permuteRow( row, genotype_block_offset_ab, &row_buffer[0], genotype_block_offset_ab, column_position );
+        memcpy( row, &row_buffer[0], bytes_per_row );
+    }
+}
+
+void PermutedGenotypeTable::getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist ) {
+    CompressedGenotypeTable5::getGenotypeDistribution( rIdx, dist );
+
+    frequency_table ft = *dist.getDistribution();
+    ft.xx -= ( genotype_block_offset_ab - loaded_offset_ab ) * BITS_PER_BLOCK;
+    dist.setDistribution( ft );
+}
+
+void PermutedGenotypeTable::getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out ) {
+    CompressedGenotypeTable5::getGenotypeDistributions( row_begin, row_end, out );
+
+    for( uint r = row_begin; r < row_end; ++r ) {
+        (out++)->xx -= ( genotype_block_offset_ab - loaded_offset_ab ) * BITS_PER_BLOCK;
+    }
+}
+
+void PermutedGenotypeTable::addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns ) {
+    if( row_begin >= row_end ) return;
+
+    vector< const DataBlock * > rows;
+    rows.reserve( row_end - row_begin );
+    for( uint r = row_begin; r < row_end; ++r ) {
+        rows.push_back( data + ( ulong ) r * blocks_per_row );
+    }
+
+    // counted in stream order, then handed back in column order
+    uint nStreamColumns = genotype_block_offset_ab * BITS_PER_BLOCK;
+    vector< frequency_table > stream_columns( nStreamColumns );
+    for( uint c = 0; c < nStreamColumns; ++c ) {
+        ResetFrequencyTable( stream_columns[ c ] );
+    }
+
+    addColumnStreams( &rows[ 0 ], rows.size(), &stream_columns[ 0 ], nStreamColumns );
+
+    for( uint c = 0; c < ( uint ) max_column; ++c ) {
+        const frequency_table &ft = stream_columns[ column_position[ c ] ];
+        columns[ c ].aa += ft.aa;
+        columns[ c ].ab += ft.ab;
+        columns[ c ].bb += ft.bb;
+        columns[ c ].xx += ft.xx;
+    }
+}
+
+void PermutedGenotypeTable::getGenotypeCodes( uint row_begin, uint row_end, byte *codes ) {
+    if( !permuted ) {
+        CompressedGenotypeTable5::getGenotypeCodes( row_begin, row_end, codes );
+        return;
+    }
+
+    // decoded in stream order, then handed back in column order
+    vector< byte > stream_codes( genotype_block_offset_ab * BITS_PER_BLOCK );
+    for( uint r = row_begin; r < row_end; ++r, codes += max_column ) {
+        decodeStreams( data + ( ulong ) r * blocks_per_row, &stream_codes[0], stream_codes.size() );
+
+        for( uint c = 0; c < ( uint ) max_column; ++c ) {
+            codes[ c ] = stream_codes[ column_position[ c ] ];
+        }
+    }
+}
+
+void PermutedGenotypeTable::streamColumns( vector< uint > &stream_columns ) const {
+    stream_columns.assign( genotype_block_offset_ab * BITS_PER_BLOCK, NO_STREAM_COLUMN );
+    for( uint c = 0; c < ( uint ) max_column; ++c ) {
+        stream_columns[ column_position[ c ] ] = c;
+    }
+}
+
+void PermutedGenotypeTable::getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums ) {
+    if( !permuted ) {
+        CompressedGenotypeTable5::getGenotypeVectorSums( row_begin, row_end, v, l, sums );
+        return;
+    }
+
+    vector< uint > stream_columns;
+    streamColumns( stream_columns );
+
+    for( uint r = row_begin; r < row_end; ++r, sums += 3 * l ) {
+        sumVectorStreams( data + ( ulong ) r * blocks_per_row, v, l, &stream_columns[0], sums );
+    }
+}
+
+/**
+ * The parts split the streams rather than the columns; the columns of a part
+ * are scattered, but no two parts share one.
+ */
+void PermutedGenotypeTable::addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns ) {
+    if( !permuted ) {
+        CompressedGenotypeTable5::addGenotypeVectorProducts( row_begin, row_end, w, l, part, nParts, columns );
+        return;
+    }
+
+    vector< uint > stream_columns;
+    streamColumns( stream_columns );
+
+    uint w_begin, w_end;
+    streamWordRange( part, nParts, w_begin, w_end );
+
+    for( uint r = row_begin; r < row_end; ++r, w += 3 * l ) {
+        addVectorStreams( data + ( ulong ) r * blocks_per_row, w, l, &stream_columns[0], w_begin, w_end, columns );
+    }
+}
+
+void PermutedGenotypeTable::getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct ) {
+    CompressedGenotypeTable5::getContingencyTable( rIdx1, rIdx2, ct );
+
+    CONTIN_TABLE_T cont = *ct.getContingencyTable();
+    cont.xx_xx -= ( genotype_block_offset_ab - loaded_offset_ab ) * BITS_PER_BLOCK;
+    ct.setContingency( cont );
+}
+
+void PermutedGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlSet &ccs, CaseControlContingencyTable &ccct ) {
+    CompressedGenotypeTable5::getCaseControlContingencyTable( rIdx1, rIdx2, ccs, ccct );
+
+    CONTIN_TABLE_T case_cont = *ccct.getCaseContingencyTable();
+    CONTIN_TABLE_T ctrl_cont = *ccct.getControlContingencyTable();
+
+    case_cont.xx_xx -= ( genotype_block_offset_ab - loaded_offset_ab ) * BITS_PER_BLOCK;
+    ctrl_cont.xx_xx -= ( genotype_block_offset_ab - loaded_offset_ab ) * BITS_PER_BLOCK;
+
+    ccct.updateContingencyTables( case_cont, ctrl_cont );
+}
+
+void PermutedGenotypeTable::permuteRow( const DataBlock *src, uint src_offset_ab, DataBlock *dst, uint dst_offset_ab, const vector< uint > &remap ) {
+    memset( dst, 0, ( 2 * dst_offset_ab + 1 ) * BYTES_PER_BLOCK );
+    *dst = *src;    // header
+
+    const PWORD *src_aa = reinterpret_cast< const PWORD * >( src + 1 );
+    const PWORD *src_ab = reinterpret_cast< const PWORD * >( src + 1 + src_offset_ab );
+
+    DataBlock *dst_aa = dst + 1;
+    DataBlock *dst_ab = dst + 1 + dst_offset_ab;
+    DataBlock *tmp;
+
+    PWORD called, bit;
+    uint to;
+
+    // only called columns have bits to move
+    for( uint w = 0, base = 0; w < src_offset_ab / BLOCKS_PER_PWORD; ++w, base += PROCESSOR_WORD_SIZE ) {
+        called = src_aa[ w ] | src_ab[ w ];
+        while( called ) {
+            uint col = base + __builtin_ctzl( called );
+            assert( col < remap.size() && remap[ col ] != UNMAPPED );
+
+            bit = ( called & ( ~called + 1 ) );
+            to = remap[ col ];
+
+            if( src_aa[ w ] & bit ) {
+                tmp = dst_aa + ( to >> 4 );
+                GetUshortAtDataBlockPtr( tmp ) |= ( 1 << ( to & 0x0F ) );
+            }
+            if( src_ab[ w ] & bit ) {
+                tmp = dst_ab + ( to >> 4 );
+                GetUshortAtDataBlockPtr( tmp ) |= ( 1 << ( to & 0x0F ) );
+            }
+
+            called ^= bit;
+        }
+    }
+}
+
+void PermutedGenotypeTable::resizeStreams( uint offset_ab ) {
+    DataBlock *tmp = new DataBlock[ row_capacity * ( 2 * offset_ab + 1 ) ];
+
+    vector< uint > remap( genotype_block_offset_ab * data_per_block );
+    for( uint i = 0; i < remap.size(); ++i ) {
+        remap[ i ] = i;
+    }
+
+    for( ulong r = 0; r < row_capacity; ++r ) {
+        permuteRow( data + r * blocks_per_row, genotype_block_offset_ab, tmp + r * ( 2 * offset_ab + 1 ), offset_ab, remap );
+    }
+
+    delete [] data;
+    data = tmp;
+
+    genotype_block_offset_ab = offset_ab;
+    blocks_per_row = 2 * offset_ab + 1;
+    total_block_count = blocks_per_row * row_capacity;
+    bytes_per_row = blocks_per_row * BYTES_PER_BLOCK;
+    data_size = row_capacity * bytes_per_row;
+
+    row_buffer.resize( blocks_per_row );
+
+    cout << "Genotype block offset: " << ( int ) genotype_block_offset_ab << endl;
+    cout << "Blocks per row: " << blocks_per_row << endl;
+}
+
+void PermutedGenotypeTable::selectCaseControl( CaseControlSet &ccs ) {
+    nCaseCount = ccs.getCaseCount();
+    nControlCount = ccs.getControlCount();
+    nIndivids = nCaseCount + nControlCount;
+
+    // same padding as the case/control buffer of CompressedGenotypeTable5
+    nCaseBlockCount = nCaseCount / data_per_block + 1;
+    nControlBlockCount = nControlCount / data_per_block + 1;
+    if( nCaseBlockCount % BLOCKS_PER_PWORD ) {
+        nCaseBlockCount += ( BLOCKS_PER_PWORD - ( nCaseBlockCount % BLOCKS_PER_PWORD ));
+    }
+    if( nControlBlockCount % BLOCKS_PER_PWORD ) {
+        nControlBlockCount += ( BLOCKS_PER_PWORD - ( nControlBlockCount % BLOCKS_PER_PWORD ));
+    }
+
+    const ushort *case_ptr = ccs.stream_case_begin();
+    const ushort *ctrl_ptr = ccs.stream_control_begin();
+
+    vector< uint > position( max_column );
+    uint next_case = 0;
+    uint next_ctrl = nCaseBlockCount * data_per_block;
+    uint next_other = ( nCaseBlockCount + nControlBlockCount ) * data_per_block;
+
+    for( uint c = 0; c < ( uint ) max_column; ++c ) {
+        ushort bit = ( 1 << ( c & 0x0F ) );
+        if( case_ptr[ c >> 4 ] & bit ) {
+            position[ c ] = next_case++;
+        } else if( ctrl_ptr[ c >> 4 ] & bit ) {
+            position[ c ] = next_ctrl++;
+        } else {
+            position[ c ] = next_other++;
+        }
+    }
+
+    uint offset_ab = next_other / data_per_block + 1;
+    if( offset_ab % BLOCKS_PER_PWORD ) {
+        offset_ab += ( BLOCKS_PER_PWORD - ( offset_ab % BLOCKS_PER_PWORD ));
+    }
+
+    if( offset_ab > genotype_block_offset_ab ) {
+        resizeStreams( offset_ab );
+    }
+
+    if( !permuted || position != column_position ) {
+        cout << "Permuting columns of " << row_capacity << " rows (" << nCaseCount << " cases, " << nControlCount << " controls)" << endl;
+
+        // stream bit in the current layout -> stream bit in the selected layout
+        vector< uint > remap( genotype_block_offset_ab * data_per_block, UNMAPPED );
+        for( uint c = 0; c < ( uint ) max_column; ++c ) {
+            remap[ column_position[ c ] ] = position[ c ];
+        }
+
+        for( ulong r = 0; r < row_capacity; ++r ) {
+            DataBlock *row = data + r * blocks_per_row;
+            permuteRow( row, genotype_block_offset_ab, &row_buffer[0], genotype_block_offset_ab, remap );
+            memcpy( row, &row_buffer[0], bytes_per_row );
+        }
+
+        column_position.swap( position );
+        permuted = true;
+        streams.clear();
+        trait_planes.clear();
+    }
+
+    // the selected kernels read the case and control ranges in place
+    selected_data = data + 1;
+    selected_stride = blocks_per_row;
+    selected_case_ab = genotype_block_offset_ab;
+    selected_ctrl = nCaseBlockCount;
+    selected_ctrl_ab = genotype_block_offset_ab + nCaseBlockCount;
+}
+
+PermutedGenotypeTable::permuted_streams &PermutedGenotypeTable::permuteStreams( CaseControlSet &ccs ) {
+    stream_map::iterator it = streams.find( &ccs );
+    if( it != streams.end() && it->second.revision == ccs.getRevision() ) return it->second;
+
+    permuted_streams &ps = streams[ &ccs ];
+
+    const ushort *case_ptr = ccs.stream_case_begin();
+    const ushort *ctrl_ptr = ccs.stream_control_begin();
+
+    vector< ushort > &case_stream = ps.case_stream;
+    vector< ushort > &ctrl_stream = ps.ctrl_stream;
+
+    case_stream.assign( genotype_block_offset_ab, 0 );
+    ctrl_stream.assign( genotype_block_offset_ab, 0 );
+
+    for( uint c = 0; c < ( uint ) max_column; ++c ) {
+        ushort bit = ( 1 << ( c & 0x0F ) );
+        uint to = column_position[ c ];
+
+        if( case_ptr[ c >> 4 ] & bit ) {
+            case_stream[ to >> 4 ] |= ( 1 << ( to & 0x0F ) );
+        }
+        if( ctrl_ptr[ c >> 4 ] & bit ) {
+            ctrl_stream[ to >> 4 ] |= ( 1 << ( to & 0x0F ) );
+        }
+    }
+
+    ps.revision = ccs.getRevision();
+    return ps;
+}
+
+const ushort *PermutedGenotypeTable::caseStream( CaseControlSet &ccs ) {
+    if( !permuted ) return ccs.stream_case_begin();
+
+    return &permuteStreams( ccs ).case_stream[0];
+}
+
+const ushort *PermutedGenotypeTable::controlStream( CaseControlSet &ccs ) {
+    if( !permuted ) return ccs.stream_control_begin();
+
+    return &permuteStreams( ccs ).ctrl_stream[0];
+}
+
+const ushort *PermutedGenotypeTable::traitPlanes( QuantitativeTraitSet &qts ) {
+    if( !permuted ) return CompressedGenotypeTable5::traitPlanes( qts );
+
+    plane_map::iterator it = trait_planes.find( &qts );
+    if( it != trait_planes.end() && it->second.revision == qts.getRevision() ) return &it->second.planes[0];
+
+    permuted_planes &pp = trait_planes[ &qts ];
+
+    const uint src_stride = qts.getStreamBlockCount();
+    pp.planes.assign( qts.getPlaneCount() * genotype_block_offset_ab, 0 );
+
+    for( uint k = 0; k < qts.getPlaneCount(); ++k ) {
+        const ushort *src = qts.plane( k );
+        ushort *dst = &pp.planes[ k * genotype_block_offset_ab ];
+
+        for( uint b = 0; b < src_stride; ++b ) {
+            for( ushort bits = src[ b ]; bits != 0; bits &= ( bits - 1 ) ) {
+                uint to = column_position[ ( b << 4 ) + __builtin_ctz( bits ) ];
+                dst[ to >> 4 ] |= ( 1 << ( to & 0x0F ) );
+            }
+        }
+    }
+
+    pp.revision = qts.getRevision();
+    return &pp.planes[0];
+}
+
+PermutedGenotypeTable::~PermutedGenotypeTable() {}
+
+}
+}
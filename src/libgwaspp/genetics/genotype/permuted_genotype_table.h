@@ -0,0 +1,143 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef PERMUTEDGENOTYPETABLE_H
+#define PERMUTEDGENOTYPETABLE_H
+
+#include <iostream>
+#include <vector>
+#include <map>
+
+#include "common.h"
+#include "util/index_set/indexer.h"
+#include "genetics/genotype/compressed_genotype_table5.h"
+
+using namespace std;
+using namespace util;
+
+namespace libgwaspp {
+namespace genetics {
+
+/**
+ * Class: PermutedGenotypeTable
+ * Description: 2-bit streaming table whose sample columns are reordered so
+ * that the selected cases and controls are contiguous ranges of every row.
+ *
+ * selectCaseControl() permutes the columns of every row in place instead of
+ * copying them into a separate case/control buffer. Within each stream, cases
+ * occupy bits [0, nCases) and controls start at the next processor word
+ * boundary; columns in neither set follow the controls. The stream width is
+ * grown if the padded layout does not fit; the padding this adds is not
+ * reported as missing genotypes.
+ *
+ * The selected kernels of CompressedGenotypeTable5 then read the case and
+ * control ranges directly from the table. Selecting the same set again is
+ * free, and selecting a different set is a single pass over the called bits.
+ *
+ * Rows loaded after a selection are permuted as they are added, so the
+ * selection may also be made before the genotypes are loaded. Column indices
+ * passed to operator() and addGenotype, and the masks of a CaseControlSet,
+ * always refer to the original column order.
+ */
+class PermutedGenotypeTable : public CompressedGenotypeTable5 {
+public:
+    PermutedGenotypeTable( indexer *markers, indexer *individs );
+
+    DataBlock operator()( int r, int c );
+
+    void addGenotype( int rIdx, int cIdx, const string &gt );
+    void addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim );
+    void addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim );
+
+    // rows are permuted through a shared buffer
+    bool supportsConcurrentRowWrites() const { return false; }
+
+    void getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist );
+    void getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out );
+    void addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns );
+    void getGenotypeCodes( uint row_begin, uint row_end, byte *codes );
+    void getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums );
+    void addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns );
+    void getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct );
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlSet &ccs, CaseControlContingencyTable &ccct );
+
+    using CompressedGenotypeTable5::getContingencyTable;
+    using CompressedGenotypeTable5::getCaseControlContingencyTable;
+
+    void selectCaseControl( CaseControlSet &ccs );
+
+    bool isPermuted() const { return permuted; }
+    uint getColumnPosition( uint cIdx ) const { return column_position[ cIdx ]; }
+
+    virtual ~PermutedGenotypeTable();
+protected:
+    const ushort *caseStream( CaseControlSet &ccs );
+    const ushort *controlStream( CaseControlSet &ccs );
+    const ushort *traitPlanes( QuantitativeTraitSet &qts );
+
+    // the column of every stream bit, NO_STREAM_COLUMN for unused bits
+    void streamColumns( vector< uint > &stream_columns ) const;
+
+    void permuteRow( const DataBlock *src, uint src_offset_ab, DataBlock *dst, uint dst_offset_ab, const vector< uint > &remap );
+    void resizeStreams( uint offset_ab );
+
+    static const uint UNMAPPED;
+
+    bool permuted;
+    uint loaded_offset_ab;              // stream width before any resize
+    vector< uint > column_position;     // stream bit of every original column
+
+    vector< DataBlock > row_buffer;
+
+    // CaseControlSet masks translated to the permuted column order; one entry
+    // per set so that a batch of sets can be masked in a single pass. A set
+    // refilled in place is translated again when its revision changes.
+    struct permuted_streams {
+        uint revision;
+        vector< ushort > case_stream, ctrl_stream;
+    };
+    typedef map< const CaseControlSet *, permuted_streams > stream_map;
+
+    permuted_streams &permuteStreams( CaseControlSet &ccs );
+
+    stream_map streams;
+
+    // trait bit-planes translated to the permuted column order
+    struct permuted_planes {
+        uint revision;
+        vector< ushort > planes;
+    };
+    typedef map< const QuantitativeTraitSet *, permuted_planes > plane_map;
+
+    plane_map trait_planes;
+};
+
+}
+}
+
+#endif // PERMUTEDGENOTYPETABLE_H
@@ -144,6 +144,34 @@ public:
     virtual void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd ) = 0;
     virtual void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m ) = 0;
 
+    // one distribution per CaseControlSet; ccgd must hold sets.size() entries.
+    // Tables which can read the row once for every set override this.
+    virtual void getCaseControlGenotypeDistributions( uint rIdx, const vector< CaseControlSet * > &sets, CaseControlGenotypeDistribution *ccgd ) {
+        for( uint k = 0; k < sets.size(); ++k ) {
+            getCaseControlGenotypeDistribution( rIdx, *sets[k], ccgd[k] );
+        }
+    }
+
+    // distributions of the rows [row_begin, row_end); out[i] belongs to row
+    // row_begin + i. Tables which can count several rows at once override these.
+    virtual void getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out ) {
+        GenotypeDistribution dist;
+        for( uint r = row_begin; r < row_end; ++r ) {
+            getGenotypeDistribution( r, dist );
+            CopyFrequencyTable( *out++, *dist.getDistribution() );
+        }
+    }
+
+    // assumes that CaseControl Set has already been selected
+    virtual void getCaseControlGenotypeDistributions( uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls ) {
+        CaseControlGenotypeDistribution ccgd;
+        for( uint r = row_begin; r < row_end; ++r ) {
+            getCaseControlGenotypeDistribution( r, ccgd );
+            CopyFrequencyTable( *cases++, *ccgd.getCaseDistribution() );
+            CopyFrequencyTable( *ctrls++, *ccgd.getControlDistribution() );
+        }
+    }
+
     virtual ~SingleMarkerAnalyzable() {}
 protected:
     void resetSelectedMarker() {
@@ -0,0 +1,798 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/genotype/sparse_genotype_table.h"
+
+namespace libgwaspp {
+namespace genetics {
+
+const uint SparseGenotypeTable::DEFAULT_CARRIER_RATIO = 32;
+
+const uint SparseGenotypeTable::UNASSIGNED_ROW = 0xFFFFFFFF;
+const uint SparseGenotypeTable::SPARSE_ROW_FLAG = 0x80000000;
+
+// stream genotype code -> frequency_table/CONTIN_TABLE_T index
+// xx -> 3; AA -> 0; AB -> 1; BB -> 2
+const byte SparseGenotypeTable::STATE_INDEX[ GENOTYPE_COUNT ] = { 3, 0, 1, 2 };
+
+#define ColumnInMask( m, c ) ( (m)[ (c) >> 4 ] & ( 1 << ( (c) & 0x0F ) ) )
+
+static uint IntersectCarriers( const uint *a, const uint *a_end, const uint *b, const uint *b_end, const ushort *mask ) {
+    uint n = 0;
+    while( a != a_end && b != b_end ) {
+        if( *a < *b ) {
+            ++a;
+        } else if( *b < *a ) {
+            ++b;
+        } else {
+            if( mask == NULL || ColumnInMask( mask, *a ) ) {
+                ++n;
+            }
+            ++a;
+            ++b;
+        }
+    }
+    return n;
+}
+
+SparseGenotypeTable::SparseGenotypeTable( indexer *markers, indexer *individs, uint ratio ) :
+    CompressedGenotypeTable5( markers, individs, 0 ), carrier_ratio( ratio ), dense_count( 0 ),
+    row_lookup( max_row, UNASSIGNED_ROW ), margins( max_row ) {
+
+    cout << "Initializing SparseGenotypeTable ... " << endl;
+
+    // padding bits at the end of each stream are read as missing genotypes
+    padding_count = genotype_block_offset_ab * BITS_PER_BLOCK - max_column;
+
+    cout << "Carrier ratio: " << carrier_ratio << endl;
+    cout << "Padding columns: " << padding_count << endl;
+}
+
+void SparseGenotypeTable::ensureDenseCapacity() {
+    if( dense_count < row_capacity ) return;
+
+    // grow geometrically; a dense slot is only needed while a row is being encoded
+    // or if the row remains dense
+    ulong new_capacity = (( row_capacity < 16 ) ? 16 : 2 * row_capacity );
+    if( new_capacity > ( ulong ) max_row ) {
+        new_capacity = max_row;
+    }
+    assert( new_capacity > dense_count );
+
+    DataBlock *tmp = new DataBlock[ new_capacity * blocks_per_row ];
+    memcpy( tmp, data, dense_count * bytes_per_row );
+    memset( tmp + dense_count * blocks_per_row, 0, ( new_capacity - dense_count ) * bytes_per_row );
+
+    delete [] data;
+    data = tmp;
+
+    row_capacity = new_capacity;
+    total_block_count = blocks_per_row * row_capacity;
+    data_size = row_capacity * bytes_per_row;
+
+    // case/control buffer no longer covers every slot
+    if( m_cases_controls != NULL ) {
+        delete [] m_cases_controls;
+        m_cases_controls = NULL;
+    }
+}
+
+void SparseGenotypeTable::countDenseRow( uint slot, frequency_table &ft ) {
+    const PWORD *tmp_data = reinterpret_cast< const PWORD * >( data + slot * blocks_per_row + 1 );
+    const PWORD *tmp_data_ab = reinterpret_cast< const PWORD * >( data + slot * blocks_per_row + 1 + genotype_block_offset_ab );
+    PWORD _aa, _ab;
+
+    ResetFrequencyTable( ft );
+    for( uint i = 1; i < genotype_block_offset_ab; i += BLOCKS_PER_PWORD ) {
+        _aa = *tmp_data++;
+        _ab = *tmp_data_ab++;
+
+        ft.bb += PopCount( _aa & _ab );
+        ft.ab += PopCount( _ab );
+        ft.aa += PopCount( _aa );
+        ft.xx += PopCount( ~( _aa | _ab ) );
+    }
+
+    ft.aa -= ft.bb;
+    ft.ab -= ft.bb;
+    ft.xx -= padding_count;
+}
+
+void SparseGenotypeTable::countSparseRow( const sparse_row &sr, const ushort *mask, uint total, frequency_table &ft ) {
+    uint listed = 0, n;
+
+    ResetFrequencyTable( ft );
+    for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+        if( c == sr.background ) continue;
+
+        if( mask == NULL ) {
+            n = sr.count[ c ];
+        } else {
+            n = 0;
+            for( const uint *it = carrier_begin( sr, c ), *it_end = it + sr.count[ c ]; it != it_end; ++it ) {
+                if( ColumnInMask( mask, *it ) ) {
+                    ++n;
+                }
+            }
+        }
+        ft.freq[ STATE_INDEX[ c ] ] = n;
+        listed += n;
+    }
+    ft.freq[ STATE_INDEX[ sr.background ] ] = total - listed;
+}
+
+void SparseGenotypeTable::finalizeRow( uint rIdx ) {
+    uint slot = row_lookup[ rIdx ];
+    frequency_table &ft = margins[ rIdx ];
+
+    countDenseRow( slot, ft );
+
+    // background genotype is the most frequent called genotype
+    byte bg = 1;
+    for( byte c = 2; c < GENOTYPE_COUNT; ++c ) {
+        if( ft.freq[ STATE_INDEX[ c ] ] > ft.freq[ STATE_INDEX[ bg ] ] ) {
+            bg = c;
+        }
+    }
+
+    ulong listed = max_column - ft.freq[ STATE_INDEX[ bg ] ];
+
+    // only the most recently encoded slot can be released
+    if( slot + 1 != dense_count || listed * carrier_ratio > ( ulong ) max_column ) return;
+
+    DataBlock *tmp_header = data + slot * blocks_per_row;
+
+    sparse_row sr;
+    sr.offset = carriers.size();
+    sr.header = GetUshortAtDataBlockPtr( tmp_header );
+    sr.background = bg;
+
+    const PWORD *_aa_ptr = reinterpret_cast< const PWORD * >( tmp_header + 1 );
+    const PWORD *_ab_ptr = reinterpret_cast< const PWORD * >( tmp_header + 1 + genotype_block_offset_ab );
+    PWORD _aa, _ab, w;
+    uint col;
+
+    for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+        sr.count[ c ] = 0;
+        if( c == bg ) continue;
+
+        for( uint i = 0, base = 0; base < ( uint ) max_column; ++i, base += PROCESSOR_WORD_SIZE ) {
+            _aa = _aa_ptr[ i ];
+            _ab = _ab_ptr[ i ];
+
+            switch( c ) {
+            case 0:
+                w = ~( _aa | _ab );
+                break;
+            case 1:
+                w = _aa & ~_ab;
+                break;
+            case 2:
+                w = _ab & ~_aa;
+                break;
+            default:
+                w = _aa & _ab;
+                break;
+            }
+
+            while( w ) {
+                col = base + __builtin_ctzl( w );
+                if( col >= ( uint ) max_column ) break;    // padding
+
+                carriers.push_back( col );
+                ++sr.count[ c ];
+                w &= ( w - 1 );
+            }
+        }
+    }
+
+    row_lookup[ rIdx ] = SPARSE_ROW_FLAG | ( uint ) sparse_rows.size();
+    sparse_rows.push_back( sr );
+
+    // release the slot for the next row
+    --dense_count;
+}
+
+DataBlock SparseGenotypeTable::operator()( int r, int c ) {
+    assert( row_lookup[ r ] != UNASSIGNED_ROW );
+
+    if( !isSparseRow( r ) ) {
+        return CompressedGenotypeTable5::operator()( row_lookup[ r ], c );
+    }
+
+    const sparse_row &sr = sparse_rows[ row_lookup[ r ] ^ SPARSE_ROW_FLAG ];
+
+    DataBlock db;
+    switch( sparseStateAt( sr, c ) ) {
+    case 1:     // AA
+        SetUshortAtDataBlock( db, (( sr.header & 0x0F00 ) >> 8 ) );
+        break;
+    case 2:     // AB
+        SetUshortAtDataBlock( db, (( sr.header & 0x00F0 ) >> 4 ) );
+        break;
+    case 3:     // BB
+        SetUshortAtDataBlock( db, ( sr.header & 0x000F ) );
+        break;
+    default:
+        SetUshortAtDataBlock( db, 0xFFFF );
+        break;
+    }
+    return db;
+}
+
+void SparseGenotypeTable::addGenotype( int rIdx, int cIdx, const string &gt ) {
+    // sparse rows are immutable once they have been converted
+    assert( !isSparseRow( rIdx ) );
+
+    if( row_lookup[ rIdx ] == UNASSIGNED_ROW ) {
+        ensureDenseCapacity();
+        memset( data + dense_count * blocks_per_row, 0, bytes_per_row );
+        row_lookup[ rIdx ] = dense_count++;
+    }
+
+    CompressedGenotypeTable5::addGenotype( row_lookup[ rIdx ], cIdx, gt );
+    countDenseRow( row_lookup[ rIdx ], margins[ rIdx ] );
+}
+
+void SparseGenotypeTable::addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim ) {
+    const char *p_begin = (( it < it_end ) ? &*it : NULL );
+    const char *p_end = p_begin + ( it_end - it );
+
+    addGenotypeRow( rIdx, p_begin, p_end, delim );
+    it = it_end;
+}
+
+void SparseGenotypeTable::addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim ) {
+    assert( row_lookup[ rIdx ] == UNASSIGNED_ROW );
+
+    ensureDenseCapacity();
+
+    DataBlock *row = data + dense_count * blocks_per_row;
+    memset( row, 0, bytes_per_row );
+
+    if( p_begin < p_end ) {
+        encodeGenotypeRow( row, p_begin, p_end );
+    }
+
+    row_lookup[ rIdx ] = dense_count++;
+    finalizeRow( rIdx );
+}
+
+void SparseGenotypeTable::getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist ) {
+    assert( row_lookup[ rIdx ] != UNASSIGNED_ROW );
+
+    frequency_table ft;
+    CopyFrequencyTable( ft, margins[ rIdx ] );
+
+    // CompressedGenotypeTable5 counts the padding as missing
+    ft.xx += padding_count;
+
+    dist.setDistribution( ft );
+}
+
+void SparseGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlSet &ccs, CaseControlGenotypeDistribution &ccgd ) {
+    assert( row_lookup[ rIdx ] != UNASSIGNED_ROW );
+
+    if( !isSparseRow( rIdx ) ) {
+        CompressedGenotypeTable5::getCaseControlGenotypeDistribution( row_lookup[ rIdx ], ccs, ccgd );
+        return;
+    }
+
+    const sparse_row &sr = sparse_rows[ row_lookup[ rIdx ] ^ SPARSE_ROW_FLAG ];
+
+    frequency_table case_gt, ctrl_gt;
+    countSparseRow( sr, ccs.stream_case_begin(), ccs.getCaseCount(), case_gt );
+    countSparseRow( sr, ccs.stream_control_begin(), ccs.getControlCount(), ctrl_gt );
+
+    ccgd.setCaseDistribution( case_gt );
+    ccgd.setControlDistribution( ctrl_gt );
+}
+
+void SparseGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd ) {
+    ccgd.setCaseDistribution( case_margins[ rIdx ] );
+    ccgd.setControlDistribution( ctrl_margins[ rIdx ] );
+}
+
+void SparseGenotypeTable::getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m ) {
+    ccgd.setCaseDistribution( case_margins[ rIdx ] );
+    ccgd.setControlDistribution( ctrl_margins[ rIdx ] );
+
+    computeMarginalInformation( case_margins[ rIdx ], ctrl_margins[ rIdx ], ( double ) nIndivids, m );
+}
+
+void SparseGenotypeTable::getCaseControlGenotypeDistributions( uint rIdx, const vector< CaseControlSet * > &sets, CaseControlGenotypeDistribution *ccgd ) {
+    assert( row_lookup[ rIdx ] != UNASSIGNED_ROW );
+
+    if( !isSparseRow( rIdx ) ) {
+        CompressedGenotypeTable5::getCaseControlGenotypeDistributions( row_lookup[ rIdx ], sets, ccgd );
+    } else {
+        // sparse rows only touch their listed columns; nothing to share
+        GenoTable::getCaseControlGenotypeDistributions( rIdx, sets, ccgd );
+    }
+}
+
+// sparse rows keep their own margins; count row by row
+void SparseGenotypeTable::getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out ) {
+    GenoTable::getGenotypeDistributions( row_begin, row_end, out );
+}
+
+void SparseGenotypeTable::getCaseControlGenotypeDistributions( uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls ) {
+    GenoTable::getCaseControlGenotypeDistributions( row_begin, row_end, cases, ctrls );
+}
+
+/**
+ * Dense rows go through the stream counters. A sparse row moves its listed
+ * columns from the background genotype to their own; the background itself
+ * is added to every column once all rows have been seen, so the counts may
+ * wrap below zero in between.
+ */
+void SparseGenotypeTable::addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns ) {
+    vector< const DataBlock * > rows;
+    uint background[ GENOTYPE_COUNT ] = { 0, 0, 0, 0 };
+
+    for( uint r = row_begin; r < row_end; ++r ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+
+        if( !isSparseRow( r ) ) {
+            rows.push_back( data + ( ulong ) row_lookup[ r ] * blocks_per_row );
+            continue;
+        }
+
+        const sparse_row &sr = sparse_rows[ row_lookup[ r ] ^ SPARSE_ROW_FLAG ];
+        byte bg = STATE_INDEX[ sr.background ];
+        ++background[ bg ];
+
+        for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+            if( c == sr.background ) continue;
+
+            byte idx = STATE_INDEX[ c ];
+            for( const uint *it = carrier_begin( sr, c ), *it_end = it + sr.count[ c ]; it != it_end; ++it ) {
+                ++columns[ *it ].freq[ idx ];
+                --columns[ *it ].freq[ bg ];
+            }
+        }
+    }
+
+    if( !rows.empty() ) {
+        addColumnStreams( &rows[ 0 ], rows.size(), columns, max_column );
+    }
+
+    for( uint c = 0; c < ( uint ) max_column; ++c ) {
+        for( uint i = 0; i < GENOTYPE_COUNT; ++i ) {
+            columns[ c ].freq[ i ] += background[ i ];
+        }
+    }
+}
+
+/**
+ * A sparse row sums the trait values of its listed columns; the background
+ * group receives whatever the listed groups leave of the totals of qts.
+ */
+void SparseGenotypeTable::getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out ) {
+    const ushort *planes = traitPlanes( qts );
+
+    for( uint r = row_begin; r < row_end; ++r, ++out ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+
+        if( !isSparseRow( r ) ) {
+            sumTraitStreams( data + ( ulong ) row_lookup[ r ] * blocks_per_row, planes, qts, *out );
+            continue;
+        }
+
+        const sparse_row &sr = sparse_rows[ row_lookup[ r ] ^ SPARSE_ROW_FLAG ];
+        byte bg = STATE_INDEX[ sr.background ];
+
+        ulong n = 0, sum = 0, square_sum = 0, xx_square_sum = 0;
+        ResetTraitSums( *out );
+
+        for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+            if( c == sr.background ) continue;
+
+            byte idx = STATE_INDEX[ c ];
+            for( const uint *it = carrier_begin( sr, c ), *it_end = it + sr.count[ c ]; it != it_end; ++it ) {
+                if( !qts.isPhenotyped( *it ) ) continue;
+
+                ulong q = qts.value( *it );
+                ++out->count.freq[ idx ];
+                out->sum[ idx ] += q;
+
+                ++n;
+                sum += q;
+                square_sum += q * q;
+                if( idx == 3 ) {
+                    xx_square_sum += q * q;
+                }
+            }
+        }
+
+        out->count.freq[ bg ] = qts.getCount() - n;
+        out->sum[ bg ] = qts.getValueSum() - sum;
+
+        if( bg == 3 ) {
+            // only the listed columns are called
+            out->square_sum_called = square_sum;
+        } else {
+            out->square_sum_called = qts.getSquareSum() - xx_square_sum;
+        }
+    }
+}
+
+void SparseGenotypeTable::getGenotypeCodes( uint row_begin, uint row_end, byte *codes ) {
+    for( uint r = row_begin; r < row_end; ++r, codes += max_column ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+
+        if( !isSparseRow( r ) ) {
+            decodeStreams( data + ( ulong ) row_lookup[ r ] * blocks_per_row, codes, max_column );
+            continue;
+        }
+
+        const sparse_row &sr = sparse_rows[ row_lookup[ r ] ^ SPARSE_ROW_FLAG ];
+        memset( codes, sr.background, max_column );
+
+        for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+            if( c == sr.background ) continue;
+
+            for( const uint *it = carrier_begin( sr, c ), *it_end = it + sr.count[ c ]; it != it_end; ++it ) {
+                codes[ *it ] = c;
+            }
+        }
+    }
+}
+
+// group of each stream code in the vector sums; AA has none
+static const int VECTOR_GROUP[ GENOTYPE_COUNT ] = { 2, -1, 0, 1 };
+
+/**
+ * A sparse row sums v over its listed columns; when the background is not AA
+ * its group receives whatever the listed columns leave of the column total.
+ */
+void SparseGenotypeTable::getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums ) {
+    vector< double > listed( GENOTYPE_COUNT * l ), total;
+
+    for( uint r = row_begin; r < row_end; ++r, sums += 3 * l ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+
+        if( !isSparseRow( r ) ) {
+            sumVectorStreams( data + ( ulong ) row_lookup[ r ] * blocks_per_row, v, l, NULL, sums );
+            continue;
+        }
+
+        const sparse_row &sr = sparse_rows[ row_lookup[ r ] ^ SPARSE_ROW_FLAG ];
+        fill( listed.begin(), listed.end(), 0.0 );
+
+        for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+            if( c == sr.background ) continue;
+
+            double *s = &listed[ c * l ];
+            for( const uint *it = carrier_begin( sr, c ), *it_end = it + sr.count[ c ]; it != it_end; ++it ) {
+                const double *x = v + ( ulong ) *it * l;
+                for( uint k = 0; k < l; ++k ) {
+                    s[ k ] += x[ k ];
+                }
+            }
+        }
+
+        if( VECTOR_GROUP[ sr.background ] >= 0 ) {
+            if( total.empty() ) {
+                total.assign( l, 0.0 );
+                for( uint col = 0; col < ( uint ) max_column; ++col ) {
+                    for( uint k = 0; k < l; ++k ) {
+                        total[ k ] += v[ ( ulong ) col * l + k ];
+                    }
+                }
+            }
+
+            double *s = &listed[ sr.background * l ];
+            for( uint k = 0; k < l; ++k ) {
+                s[ k ] = total[ k ];
+                for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+                    if( c != sr.background ) {
+                        s[ k ] -= listed[ c * l + k ];
+                    }
+                }
+            }
+        }
+
+        for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+            if( VECTOR_GROUP[ c ] >= 0 ) {
+                memcpy( sums + VECTOR_GROUP[ c ] * l, &listed[ c * l ], l * sizeof( double ) );
+            }
+        }
+    }
+}
+
+/**
+ * A sparse row whose background is not AA adds the background values to every
+ * column of the part, and the listed columns the difference to their own
+ * group. The listed columns are in column order, so the part is found by
+ * binary search.
+ */
+void SparseGenotypeTable::addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns ) {
+    uint w_begin, w_end;
+    streamWordRange( part, nParts, w_begin, w_end );
+
+    const uint c_begin = min( w_begin * PROCESSOR_WORD_SIZE, ( uint ) max_column );
+    const uint c_end = min( w_end * PROCESSOR_WORD_SIZE, ( uint ) max_column );
+
+    vector< double > delta( l );
+
+    for( uint r = row_begin; r < row_end; ++r, w += 3 * l ) {
+        assert( row_lookup[ r ] != UNASSIGNED_ROW );
+
+        if( !isSparseRow( r ) ) {
+            addVectorStreams( data + ( ulong ) row_lookup[ r ] * blocks_per_row, w, l, NULL, w_begin, w_end, columns );
+            continue;
+        }
+
+        const sparse_row &sr = sparse_rows[ row_lookup[ r ] ^ SPARSE_ROW_FLAG ];
+        const double *bg = ( VECTOR_GROUP[ sr.background ] >= 0 ) ? w + VECTOR_GROUP[ sr.background ] * l : NULL;
+
+        if( bg != NULL ) {
+            for( uint col = c_begin; col < c_end; ++col ) {
+                double *s = columns + ( ulong ) col * l;
+                for( uint k = 0; k < l; ++k ) {
+                    s[ k ] += bg[ k ];
+                }
+            }
+        }
+
+        for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+            if( c == sr.background ) continue;
+
+            for( uint k = 0; k < l; ++k ) {
+                delta[ k ] = ( VECTOR_GROUP[ c ] >= 0 ? w[ VECTOR_GROUP[ c ] * l + k ] : 0.0 ) - ( bg != NULL ? bg[ k ] : 0.0 );
+            }
+
+            const uint *it_end = carrier_begin( sr, c ) + sr.count[ c ];
+            for( const uint *it = lower_bound( carrier_begin( sr, c ), it_end, c_begin ); it != it_end && *it < c_end; ++it ) {
+                double *s = columns + ( ulong ) *it * l;
+                for( uint k = 0; k < l; ++k ) {
+                    s[ k ] += delta[ k ];
+                }
+            }
+        }
+    }
+}
+
+void SparseGenotypeTable::selectCaseControl( CaseControlSet &ccs ) {
+    // splits the dense slots
+    CompressedGenotypeTable5::selectCaseControl( ccs );
+
+    case_mask.assign( ccs.stream_case_begin(), ccs.stream_case_begin() + genotype_block_offset_ab );
+    ctrl_mask.assign( ccs.stream_control_begin(), ccs.stream_control_begin() + genotype_block_offset_ab );
+
+    case_margins.resize( max_row );
+    ctrl_margins.resize( max_row );
+
+    // pre-compute the case/control distributions of every row;
+    // the background counts of sparse pairs are derived from them
+    CaseControlGenotypeDistribution ccgd;
+    for( uint i = 0; i < ( uint ) max_row; ++i ) {
+        if( row_lookup[ i ] == UNASSIGNED_ROW ) continue;
+
+        if( isSparseRow( i ) ) {
+            const sparse_row &sr = sparse_rows[ row_lookup[ i ] ^ SPARSE_ROW_FLAG ];
+            countSparseRow( sr, &case_mask[0], nCaseCount, case_margins[ i ] );
+            countSparseRow( sr, &ctrl_mask[0], nControlCount, ctrl_margins[ i ] );
+        } else {
+            CompressedGenotypeTable5::getCaseControlGenotypeDistribution( row_lookup[ i ], ccgd );
+            CopyFrequencyTable( case_margins[ i ], *ccgd.getCaseDistribution() );
+            CopyFrequencyTable( ctrl_margins[ i ], *ccgd.getControlDistribution() );
+        }
+    }
+}
+
+void SparseGenotypeTable::sparseDenseContingency( const sparse_row &a, uint slot_b, const frequency_table &b_margin, const ushort *mask, CONTIN_TABLE_T &ct ) {
+    ResetContingencyTable( ct );
+
+    uint row_offset;
+    for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+        if( c == a.background ) continue;
+
+        row_offset = STATE_INDEX[ c ] * CONTIN_COLUMN_COUNT;
+        for( const uint *it = carrier_begin( a, c ), *it_end = it + a.count[ c ]; it != it_end; ++it ) {
+            if( mask != NULL && !ColumnInMask( mask, *it ) ) continue;
+
+            ++ct.contin[ row_offset + STATE_INDEX[ denseStateAt( slot_b, *it ) ] ];
+        }
+    }
+
+    // every other column carries the background genotype of A
+    uint bg_offset = STATE_INDEX[ a.background ] * CONTIN_COLUMN_COUNT;
+    for( uint j = 0; j < CONTIN_COLUMN_COUNT; ++j ) {
+        uint n = b_margin.freq[ j ];
+        for( uint i = 0; i < CONTIN_ROW_COUNT; ++i ) {
+            if( i * CONTIN_COLUMN_COUNT != bg_offset ) {
+                n -= ct.contin[ i * CONTIN_COLUMN_COUNT + j ];
+            }
+        }
+        ct.contin[ bg_offset + j ] = n;
+    }
+}
+
+void SparseGenotypeTable::sparseSparseContingency( const sparse_row &a, const sparse_row &b, const ushort *mask, uint total, CONTIN_TABLE_T &ct ) {
+    ResetContingencyTable( ct );
+
+    frequency_table fa, fb;
+    countSparseRow( a, mask, total, fa );
+    countSparseRow( b, mask, total, fb );
+
+    uint ia, ib, n;
+
+    // listed x listed
+    for( byte ca = 0; ca < GENOTYPE_COUNT; ++ca ) {
+        if( ca == a.background || a.count[ ca ] == 0 ) continue;
+
+        const uint *a_begin = carrier_begin( a, ca ), *a_end = a_begin + a.count[ ca ];
+        ia = STATE_INDEX[ ca ] * CONTIN_COLUMN_COUNT;
+        for( byte cb = 0; cb < GENOTYPE_COUNT; ++cb ) {
+            if( cb == b.background || b.count[ cb ] == 0 ) continue;
+
+            const uint *b_begin = carrier_begin( b, cb );
+            ct.contin[ ia + STATE_INDEX[ cb ] ] = IntersectCarriers( a_begin, a_end, b_begin, b_begin + b.count[ cb ], mask );
+        }
+    }
+
+    // listed x background of B
+    ib = STATE_INDEX[ b.background ];
+    for( byte ca = 0; ca < GENOTYPE_COUNT; ++ca ) {
+        if( ca == a.background ) continue;
+
+        ia = STATE_INDEX[ ca ];
+        n = fa.freq[ ia ];
+        for( uint j = 0; j < CONTIN_COLUMN_COUNT; ++j ) {
+            if( j != ib ) {
+                n -= ct.contin[ ia * CONTIN_COLUMN_COUNT + j ];
+            }
+        }
+        ct.contin[ ia * CONTIN_COLUMN_COUNT + ib ] = n;
+    }
+
+    // background of A x everything
+    ia = STATE_INDEX[ a.background ];
+    for( uint j = 0; j < CONTIN_COLUMN_COUNT; ++j ) {
+        n = fb.freq[ j ];
+        for( uint i = 0; i < CONTIN_ROW_COUNT; ++i ) {
+            if( i != ia ) {
+                n -= ct.contin[ i * CONTIN_COLUMN_COUNT + j ];
+            }
+        }
+        ct.contin[ ia * CONTIN_COLUMN_COUNT + j ] = n;
+    }
+}
+
+void SparseGenotypeTable::computeContingency( uint rIdx1, uint rIdx2, const ushort *mask, uint total, const frequency_table &m1, const frequency_table &m2, CONTIN_TABLE_T &ct ) {
+    assert( row_lookup[ rIdx1 ] != UNASSIGNED_ROW && row_lookup[ rIdx2 ] != UNASSIGNED_ROW );
+
+    bool s1 = isSparseRow( rIdx1 ), s2 = isSparseRow( rIdx2 );
+
+    if( s1 && s2 ) {
+        sparseSparseContingency( sparse_rows[ row_lookup[ rIdx1 ] ^ SPARSE_ROW_FLAG ], sparse_rows[ row_lookup[ rIdx2 ] ^ SPARSE_ROW_FLAG ], mask, total, ct );
+    } else if( s1 ) {
+        sparseDenseContingency( sparse_rows[ row_lookup[ rIdx1 ] ^ SPARSE_ROW_FLAG ], row_lookup[ rIdx2 ], m2, mask, ct );
+    } else {
+        assert( s2 );
+        sparseDenseContingency( sparse_rows[ row_lookup[ rIdx2 ] ^ SPARSE_ROW_FLAG ], row_lookup[ rIdx1 ], m1, mask, ct );
+        TransposeContingencyTable( ct );
+    }
+}
+
+void SparseGenotypeTable::getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct ) {
+    if( !isSparseRow( rIdx1 ) && !isSparseRow( rIdx2 ) ) {
+        CompressedGenotypeTable5::getContingencyTable( row_lookup[ rIdx1 ], row_lookup[ rIdx2 ], ct );
+    } else {
+        CONTIN_TABLE_T contingency;
+        computeContingency( rIdx1, rIdx2, NULL, max_column, margins[ rIdx1 ], margins[ rIdx2 ], contingency );
+
+        // padding is missing for both markers in CompressedGenotypeTable5
+        contingency.xx_xx += padding_count;
+        ct.setContingency( contingency );
+    }
+
+    ct.setMarkerAIndex( rIdx1 );
+    ct.setMarkerBIndex( rIdx2 );
+}
+
+void SparseGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlSet &ccs, CaseControlContingencyTable &ccct ) {
+    if( !isSparseRow( rIdx1 ) && !isSparseRow( rIdx2 ) ) {
+        CompressedGenotypeTable5::getCaseControlContingencyTable( row_lookup[ rIdx1 ], row_lookup[ rIdx2 ], ccs, ccct );
+    } else {
+        CaseControlGenotypeDistribution d1, d2;
+        getCaseControlGenotypeDistribution( rIdx1, ccs, d1 );
+        getCaseControlGenotypeDistribution( rIdx2, ccs, d2 );
+
+        CONTIN_TABLE_T case_cont, ctrl_cont;
+        computeContingency( rIdx1, rIdx2, ccs.stream_case_begin(), ccs.getCaseCount(), *d1.getCaseDistribution(), *d2.getCaseDistribution(), case_cont );
+        computeContingency( rIdx1, rIdx2, ccs.stream_control_begin(), ccs.getControlCount(), *d1.getControlDistribution(), *d2.getControlDistribution(), ctrl_cont );
+
+        // the streaming kernels read every unselected column as missing
+        case_cont.xx_xx += genotype_block_offset_ab * BITS_PER_BLOCK - ccs.getCaseCount();
+        ctrl_cont.xx_xx += genotype_block_offset_ab * BITS_PER_BLOCK - ccs.getControlCount();
+
+        ccct.updateContingencyTables( case_cont, ctrl_cont );
+    }
+
+    ccct.setMarkerAIndex( rIdx1 );
+    ccct.setMarkerBIndex( rIdx2 );
+}
+
+void SparseGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct ) {
+    if( !isSparseRow( rIdx1 ) && !isSparseRow( rIdx2 ) ) {
+        CompressedGenotypeTable5::getCaseControlContingencyTable( row_lookup[ rIdx1 ], row_lookup[ rIdx2 ], ccct );
+    } else {
+        CONTIN_TABLE_T case_cont, ctrl_cont;
+        computeContingency( rIdx1, rIdx2, &case_mask[0], nCaseCount, case_margins[ rIdx1 ], case_margins[ rIdx2 ], case_cont );
+        computeContingency( rIdx1, rIdx2, &ctrl_mask[0], nControlCount, ctrl_margins[ rIdx1 ], ctrl_margins[ rIdx2 ], ctrl_cont );
+
+        // padding of the case/control buffers is read as missing by the streaming kernels
+        case_cont.xx_xx += nCaseBlockCount * BITS_PER_BLOCK - nCaseCount;
+        ctrl_cont.xx_xx += nControlBlockCount * BITS_PER_BLOCK - nControlCount;
+
+        ccct.updateContingencyTables( case_cont, ctrl_cont );
+    }
+
+    ccct.setMarkerAIndex( rIdx1 );
+    ccct.setMarkerBIndex( rIdx2 );
+}
+
+void SparseGenotypeTable::getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct ) {
+    if( !isSparseRow( rIdx1 ) && !isSparseRow( rIdx2 ) ) {
+        CompressedGenotypeTable5::getCaseControlContingencyTable( row_lookup[ rIdx1 ], row_lookup[ rIdx2 ], m1, m2, ccct );
+        ccct.setMarkerAIndex( rIdx1 );
+        ccct.setMarkerBIndex( rIdx2 );
+    } else {
+        getCaseControlContingencyTable( rIdx1, rIdx2, ccct );
+    }
+}
+
+void SparseGenotypeTable::TransposeContingencyTable( CONTIN_TABLE_T &ct ) {
+    for( uint i = 0; i < CONTIN_ROW_COUNT; ++i ) {
+        for( uint j = i + 1; j < CONTIN_COLUMN_COUNT; ++j ) {
+            swap( ct.contin[ i * CONTIN_COLUMN_COUNT + j ], ct.contin[ j * CONTIN_COLUMN_COUNT + i ] );
+        }
+    }
+}
+
+void SparseGenotypeTable::getCaseControlContingencyTables( uint rIdx1, uint rIdx2, const vector< CaseControlSet * > &sets, CaseControlContingencyTable *ccct ) {
+    if( isSparseRow( rIdx1 ) || isSparseRow( rIdx2 ) ) {
+        GenoTable::getCaseControlContingencyTables( rIdx1, rIdx2, sets, ccct );
+        return;
+    }
+
+    CompressedGenotypeTable5::getCaseControlContingencyTables( row_lookup[ rIdx1 ], row_lookup[ rIdx2 ], sets, ccct );
+
+    for( uint k = 0; k < sets.size(); ++k ) {
+        ccct[k].setMarkerAIndex( rIdx1 );
+        ccct[k].setMarkerBIndex( rIdx2 );
+    }
+}
+
+SparseGenotypeTable::~SparseGenotypeTable() { }
+
+}
+}
@@ -0,0 +1,187 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#ifndef SPARSEGENOTYPETABLE_H
+#define SPARSEGENOTYPETABLE_H
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "common.h"
+#include "util/index_set/indexer.h"
+#include "genetics/genotype/compressed_genotype_table5.h"
+
+using namespace std;
+using namespace util;
+
+namespace libgwaspp {
+namespace genetics {
+
+/**
+ * Class: SparseGenotypeTable
+ * Description: Hybrid of the 2-bit streaming table (CompressedGenotypeTable5)
+ * and sorted carrier index lists.
+ *
+ * Every row is encoded into the 2-bit streams first. Rows where the number of
+ * individuals not carrying the most common genotype (the background genotype)
+ * is small relative to the number of individuals are converted into sparse
+ * rows. A sparse row stores a sorted list of column indices for each of the
+ * non-background genotypes (missing, AA, AB, BB in stream encoding order);
+ * the background genotype is implied for all unlisted columns.
+ *
+ * Dense rows are stored in the inherited data buffer at a compacted "slot"
+ * index, so the streaming kernels of CompressedGenotypeTable5 are reused
+ * as-is for dense x dense pairs. Pairs involving a sparse row only touch
+ * the listed columns, and derive the background counts from the stored
+ * marginal distributions.
+ *
+ * Stream genotype codes (see CompressedGenotypeTable5):
+ *  0 - missing (xx)
+ *  1 - aa stream only (AA)
+ *  2 - ab stream only (AB)
+ *  3 - both streams (BB)
+ */
+class SparseGenotypeTable : public CompressedGenotypeTable5 {
+public:
+    SparseGenotypeTable( indexer *markers, indexer *individs, uint carrier_ratio = DEFAULT_CARRIER_RATIO );
+
+    DataBlock operator()( int r, int c );
+
+    void addGenotype( int rIdx, int cIdx, const string &gt );
+    void addGenotypeRow( int rIdx, string::const_iterator &it, string::const_iterator &it_end, char delim );
+    void addGenotypeRow( int rIdx, const char *p_begin, const char *p_end, char delim );
+
+    // rows are appended to the dense storage in arrival order
+    bool supportsConcurrentRowWrites() const { return false; }
+
+    void getGenotypeDistribution( uint rIdx, GenotypeDistribution &dist );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlSet &ccs, CaseControlGenotypeDistribution &ccgd );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd );
+    void getCaseControlGenotypeDistribution( uint rIdx, CaseControlGenotypeDistribution &ccgd, marginal_information & m );
+    void getCaseControlGenotypeDistributions( uint rIdx, const vector< CaseControlSet * > &sets, CaseControlGenotypeDistribution *ccgd );
+
+    void getGenotypeDistributions( uint row_begin, uint row_end, frequency_table *out );
+    void getCaseControlGenotypeDistributions( uint row_begin, uint row_end, frequency_table *cases, frequency_table *ctrls );
+
+    void addColumnGenotypeCounts( uint row_begin, uint row_end, frequency_table *columns );
+
+    void getTraitSums( uint row_begin, uint row_end, QuantitativeTraitSet &qts, trait_sums *out );
+    void getGenotypeCodes( uint row_begin, uint row_end, byte *codes );
+    void getGenotypeVectorSums( uint row_begin, uint row_end, const double *v, uint l, double *sums );
+    void addGenotypeVectorProducts( uint row_begin, uint row_end, const double *w, uint l, uint part, uint nParts, double *columns );
+
+    void selectCaseControl( CaseControlSet &ccs );
+
+    void getContingencyTable( uint rIdx1, uint rIdx2, ContingencyTable &ct );
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlSet &ccs, CaseControlContingencyTable &ccct );
+
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, CaseControlContingencyTable &ccct );
+    void getCaseControlContingencyTable( uint rIdx1, uint rIdx2, const marginal_information &m1, const marginal_information &m2, CaseControlContingencyTable & ccct );
+    void getCaseControlContingencyTables( uint rIdx1, uint rIdx2, const vector< CaseControlSet * > &sets, CaseControlContingencyTable *ccct );
+
+    bool isSparseRow( uint rIdx ) const { return (row_lookup[ rIdx ] != UNASSIGNED_ROW) && (row_lookup[ rIdx ] & SPARSE_ROW_FLAG); }
+    uint getSparseRowCount() const { return (uint) sparse_rows.size(); }
+    uint getDenseRowCount() const { return dense_count; }
+
+    virtual ~SparseGenotypeTable();
+
+    static const uint DEFAULT_CARRIER_RATIO;
+protected:
+    struct sparse_row {
+        ulong offset;                   // offset of first listed column in carriers
+        uint count[ GENOTYPE_COUNT ];   // list length per stream code; 0 for background
+        ushort header;                  // CompressedGenotypeTable5 row header
+        byte background;                // stream code implied for unlisted columns
+    };
+
+    void ensureDenseCapacity();
+    void finalizeRow( uint rIdx );
+    void countDenseRow( uint slot, frequency_table &ft );
+    void countSparseRow( const sparse_row &sr, const ushort *mask, uint total, frequency_table &ft );
+
+    inline byte denseStateAt( uint slot, uint col ) const;
+    inline byte sparseStateAt( const sparse_row &sr, uint col ) const;
+    inline const uint *carrier_begin( const sparse_row &sr, byte code ) const;
+    const uint *carrier_data() const { return carriers.empty() ? NULL : &carriers[0]; }
+
+    void sparseDenseContingency( const sparse_row &a, uint slot_b, const frequency_table &b_margin, const ushort *mask, CONTIN_TABLE_T &ct );
+    void sparseSparseContingency( const sparse_row &a, const sparse_row &b, const ushort *mask, uint total, CONTIN_TABLE_T &ct );
+    void computeContingency( uint rIdx1, uint rIdx2, const ushort *mask, uint total, const frequency_table &m1, const frequency_table &m2, CONTIN_TABLE_T &ct );
+    void selectedMargins( uint rIdx, frequency_table &case_gt, frequency_table &ctrl_gt );
+
+    static void TransposeContingencyTable( CONTIN_TABLE_T &ct );
+
+    static const uint UNASSIGNED_ROW;
+    static const uint SPARSE_ROW_FLAG;
+    static const byte STATE_INDEX[ GENOTYPE_COUNT ];
+
+    uint carrier_ratio;
+    uint dense_count;
+    uint padding_count;
+
+    vector< uint > row_lookup;              // dense slot, or (SPARSE_ROW_FLAG | sparse row index)
+    vector< frequency_table > margins;      // genotype distribution of every row (padding excluded)
+    vector< sparse_row > sparse_rows;
+    vector< uint > carriers;
+
+    // selected case/control set
+    vector< ushort > case_mask, ctrl_mask;
+    vector< frequency_table > case_margins, ctrl_margins;
+};
+
+inline byte SparseGenotypeTable::denseStateAt( uint slot, uint col ) const {
+    const ushort *row = data + slot * blocks_per_row + 1 + ( col >> 4 );
+    ushort bit = ( 1 << ( col & 0x0F ) );
+
+    return (( *row & bit ) ? 1 : 0 ) | (( *( row + genotype_block_offset_ab ) & bit ) ? 2 : 0 );
+}
+
+inline const uint *SparseGenotypeTable::carrier_begin( const sparse_row &sr, byte code ) const {
+    ulong offset = sr.offset;
+    for( byte c = 0; c < code; ++c ) {
+        offset += sr.count[ c ];
+    }
+    return carrier_data() + offset;
+}
+
+inline byte SparseGenotypeTable::sparseStateAt( const sparse_row &sr, uint col ) const {
+    const uint *it = carrier_data() + sr.offset;
+    for( byte c = 0; c < GENOTYPE_COUNT; ++c ) {
+        if( sr.count[ c ] && binary_search( it, it + sr.count[ c ], col ) ) {
+            return c;
+        }
+        it += sr.count[ c ];
+    }
+    return sr.background;
+}
+
+}
+}
+
+#endif // SPARSEGENOTYPETABLE_H
@@ -0,0 +1,107 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/individual/covariate_file.h"
+
+#include <cstdlib>
+
+namespace libgwaspp {
+namespace genetics {
+
+CovariateFile::CovariateFile() : GeneticDataFile() {
+    //ctor
+}
+
+bool CovariateFile::populateGeneticData( string &filename, GeneticData   *gd, char delim ) {
+    if( filename.empty() ) {
+        return true;
+    }
+
+    ifstream iFile( filename.c_str() );
+    if( !iFile.is_open() ) {
+        cout << "ERROR: Could not open the covariate file " << filename << endl;
+        return false;
+    }
+
+    vector< string > names;
+
+    getline( iFile, line );
+    parser.str( line );
+    parser.clear();
+
+    getline( parser, tok, delim );  // FID
+    getline( parser, tok, delim );  // IID
+    while( getline( parser, tok, delim ) ) {
+        names.push_back( tok );
+    }
+
+    if( names.empty() ) {
+        cout << "ERROR: No covariates in the header of " << filename << endl;
+        return false;
+    }
+
+    vector< map< string, double > > values( names.size() );
+
+    string id;
+    char *end;
+    while( !iFile.eof() ) {
+        getline( iFile, line );
+        if( line == "" )
+            continue;
+        parser.str( line );
+        parser.clear();
+
+        getline( parser, id, delim );  // family id
+        getline( parser, tok, delim );   // individual id
+        id += "-" + tok;
+
+        for( uint k = 0; k < names.size() && getline( parser, tok, delim ); ++k ) {
+            double v = strtod( tok.c_str(), &end );
+            if( end == tok.c_str() || v == -9.0 ) {
+                continue;
+            }
+
+            values[ k ][ id ] = v;
+        }
+    }
+
+    for( uint k = 0; k < names.size(); ++k ) {
+        cout << "Setting covariate " << names[ k ] << " of " << values[ k ].size() << " individuals." << endl;
+        gd->addCovariate( names[ k ], &values[ k ] );
+    }
+
+    iFile.close();
+    return true;
+}
+
+CovariateFile::~CovariateFile() {
+    //dtor
+}
+
+}
+}
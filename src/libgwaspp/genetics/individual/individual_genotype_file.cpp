@@ -28,18 +28,42 @@
 */
 #include "genetics/individual/individual_genotype_file.h"
 
+#include <sys/stat.h>
+
 namespace libgwaspp {
 namespace genetics {
 
+const ulong IndividualGenotypeFile::CALL_BLOCK_SIZE = 0x1000000;   // 16MB of buffered calls per block
+
 IndividualGenotypeFile::IndividualGenotypeFile() : GeneticDataFile(),  row_idx( 0 ), col_idx( 0 ) {
     //ctor
+    for( int i = 0; i < 256; ++i ) {
+        identity_codes[ i ] = ( char ) i;
+    }
+    memset( call_codes, 0xFF, sizeof( call_codes ) );
+}
+
+bool IndividualGenotypeFile::isCompressed( const string & filename ) {
+    struct stat st;
+    if( stat( filename.c_str(), &st ) != 0 || !S_ISREG( st.st_mode ) ) {
+        string ext = filename.substr(( int )filename.find_last_of( "." ) + 1 );
+        return ext.compare( "gz" ) == 0 || ext.compare( "GZ" ) == 0;
+    }
+
+    ifstream iFile( filename.c_str(), ios::in | ios::binary );
+    unsigned char magic[ 2 ] = { 0, 0 };
+    iFile.read(( char * ) magic, 2 );
+
+    return iFile.gcount() == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
 }
 
 bool IndividualGenotypeFile::populateGeneticData( string &filename, GeneticData *gd, char delim ) {
-    bool success = true, is_gz = false;
+    bool success = true, is_gz = false, is_stdin = false;
     istream *iFile;
-    string ext = filename.substr(( int )filename.find_last_of( "." ) + 1 );
-    if( ext.compare( "gz" ) == 0 || ext.compare( "GZ" ) == 0 ) {
+    if( filename.compare( "-" ) == 0 ) {
+        iFile = &cin;
+        is_stdin = true;
+    } else if( isCompressed( filename ) ) {
         iFile = new igzstream( filename.c_str() );
         is_gz = true;
     } else {
@@ -50,24 +74,26 @@ bool IndividualGenotypeFile::populateGeneticData( string &filename, GeneticData
     RECORD_START;
 
     if( parseHeader( iFile, gd, delim ) ) {
-
-        long first_rec = iFile->tellg();
-
         RECORD_STOP;
         PRINT_LAPSE(cout, "Parse Individuals Time Lapse: " );
         cout << endl;
-        // build markers
+        // build markers, buffering the genotypes of each
         marker_indexes.clear();
+        clearBufferedRows();
 
         RECORD_START;
         while( !iFile->eof() ) {
-            if( ! parseNextMarkerRecord( iFile, gd, delim ) ) {
+            if( ! parseNextMarkerRecord( iFile, gd, delim ) || ! bufferGenotypeRecord( delim ) ) {
                 success = false;
                 break;
             }
             iFile->peek();
         }
+    } else {
+        success = false;
+    }
 
+    if( success ) {
         assert(( int )marker_indexes.size() == gd->getMarkerCount() );
 
         RECORD_STOP;
@@ -91,25 +117,21 @@ bool IndividualGenotypeFile::populateGeneticData( string &filename, GeneticData
         PRINT_LAPSE(cout, "Lapsed time for updating Genotype Table for genotyped individuals and markers: " );
         cout << endl;
 
-        iFile->seekg( first_rec, ios::beg );
-        iFile->clear();
-
         RECORD_START;
         // build genotypes
-        row_idx = 0;
-        while( !iFile->eof() ) {
-            if( ! parseNextGenotypeRecord( iFile, gd, delim ) ) {
-                success = false;
-                break;
-            }
-            iFile->peek();
-        }
+        addBufferedRows( gd, delim );
 
         RECORD_STOP;
         PRINT_LAPSE(cout, "Lapsed time for compacting Genotype Data: " );
         cout << endl;
     } else {
-        success = false;
+        // nothing of a file which failed to parse is added to the table
+        marker_indexes.clear();
+        clearBufferedRows();
+    }
+
+    if( is_stdin ) {
+        return success;
     }
 
     if( is_gz ) {
@@ -123,6 +145,88 @@ bool IndividualGenotypeFile::populateGeneticData( string &filename, GeneticData
     return success;
 }
 
+bool IndividualGenotypeFile::bufferGenotypeRecord( char delim ) {
+    trim( line );
+
+    // skip the 4 marker columns
+    const char *p = line.c_str(), *p_end = p + line.length();
+    int delim_count = 0;
+    while( delim_count < 4 && p < p_end ) {
+        if( *p++ == delim ) { ++delim_count; }
+    }
+
+    // calls are 2 characters followed by a delimiter
+    return bufferRow( p, (( ulong )( p_end - p ) + 1 ) / 3, 3, 1, identity_codes );
+}
+
+bool IndividualGenotypeFile::bufferRow( const char *p, ulong count, uint stride, uint second, const char *codes ) {
+    if( call_blocks.empty() || call_blocks.back().capacity() - call_blocks.back().size() < count ) {
+        call_blocks.push_back( vector< byte >() );
+        call_blocks.back().reserve( max( CALL_BLOCK_SIZE, count ) );
+    }
+
+    vector< byte > &blk = call_blocks.back();
+
+    buffered_row br;
+    br.block = call_blocks.size() - 1;
+    br.offset = blk.size();
+    br.count = count;
+    buffered_rows.push_back( br );
+
+    blk.resize( br.offset + count );
+
+    byte *out = ( count > 0 ) ? &blk[ br.offset ] : NULL;
+    for( ulong i = 0; i < count; ++i, p += stride ) {
+        byte c1 = ( byte ) codes[( byte ) p[0] ], c2 = ( byte ) codes[( byte ) p[ second ] ];
+        ushort form = ( ushort )(( c1 << 8 ) | c2 );
+
+        if( call_codes[ form ] == 0xFF ) {
+            // 0xFF marks an unseen form, which leaves 255 codes
+            if( call_forms.size() == 2 * 0xFF ) {
+                cout << "ERROR: More than " << 0xFF << " distinct genotype calls; the call \"" << ( char ) c1 << ( char ) c2 << "\" of marker record " << buffered_rows.size() << " has no code left" << endl;
+                return false;
+            }
+            call_codes[ form ] = ( byte )( call_forms.size() / 2 );
+            call_forms.push_back(( char ) c1 );
+            call_forms.push_back(( char ) c2 );
+        }
+        out[ i ] = call_codes[ form ];
+    }
+    return true;
+}
+
+void IndividualGenotypeFile::addBufferedRows( GeneticData *gd, char delim ) {
+    string row;
+    row_idx = 0;
+    for( vector< buffered_row >::iterator it = buffered_rows.begin(); it != buffered_rows.end(); ++it ) {
+        // rows are written in the order they were read; release blocks as they are consumed
+        if( it != buffered_rows.begin() && ( it - 1 )->block != it->block ) {
+            vector< byte >().swap( call_blocks[( it - 1 )->block ] );
+        }
+
+        row.resize(( it->count > 0 ) ? 3 * it->count - 1 : 0, delim );
+
+        const byte *calls = ( it->count > 0 ) ? &call_blocks[ it->block ][ it->offset ] : NULL;
+        for( uint i = 0; i < it->count; ++i ) {
+            const char *form = &call_forms[ 2 * calls[ i ] ];
+            row[ 3 * i ] = form[0];
+            row[ 3 * i + 1 ] = form[1];
+        }
+
+        string::const_iterator r_it = row.begin(), r_end = row.end();
+        gd->addGenotypeRow( row_idx++, r_it, r_end, delim );
+    }
+
+    clearBufferedRows();
+}
+
+void IndividualGenotypeFile::clearBufferedRows() {
+    call_blocks.clear();
+    buffered_rows.clear();
+    call_forms.clear();
+    memset( call_codes, 0xFF, sizeof( call_codes ) );
+}
+
 void IndividualGenotypeFile::guessExpectedSizes( istream *iFile, int &mcnt, int &gt_width, char delim ) {
     iFile->seekg( 0, ios::beg );
 
@@ -147,7 +251,6 @@ bool IndividualGenotypeFile::parseHeader( istream *iFile, GeneticData *gd, char
     if( delim == 0 ) return false;
     bool success = true;
 
-    iFile->seekg( 0, ios::beg );
     getline( *iFile, line );
 
     parser.str( line );
@@ -50,14 +50,44 @@ using namespace boost::algorithm;
 namespace libgwaspp {
 namespace genetics {
 
+/**
+ * Reads a genotype file in a single pass. "-" reads standard input.
+ *
+ * The genotype table can only be built once every marker is known, so the
+ * calls of each record are buffered while the markers are created, one byte
+ * per call (an index into the distinct call forms of the file). The buffered
+ * rows are encoded into the table once the file has been read; nothing is
+ * read twice, so compressed files are inflated once and pipes may be read.
+ */
 class IndividualGenotypeFile : public GeneticDataFile {
     public:
         IndividualGenotypeFile( );
 
         bool populateGeneticData( string &filename, GeneticData   *gd, char delim );
 
+        static const ulong CALL_BLOCK_SIZE;
+
+        // true when the file starts with the gzip magic bytes 1f 8b (gzip
+        // and BGZF); pipes cannot be sniffed, so only their ".gz" name tells
+        static bool isCompressed( const string & filename );
+
         virtual ~IndividualGenotypeFile();
     protected:
+        struct buffered_row {
+            uint block, count;
+            ulong offset;
+        };
+
+        // buffers the calls of the record left in line by parseNextMarkerRecord;
+        // false when the record cannot be encoded
+        virtual bool bufferGenotypeRecord( char delim );
+
+        // buffers a row of count calls; call i is codes[p[i * stride]] followed
+        // by codes[p[i * stride + second]]. Every distinct call gets a byte code,
+        // so false once a file holds more than 255 distinct calls.
+        bool bufferRow( const char *p, ulong count, uint stride, uint second, const char *codes );
+        void addBufferedRows( GeneticData *gd, char delim );
+        void clearBufferedRows();
 
         virtual void guessExpectedSizes( istream *iFile, int &mcnt, int &gt_width, char delim );
 
@@ -69,6 +99,12 @@ class IndividualGenotypeFile : public GeneticDataFile {
 
         int row_idx, col_idx;
         vector<int> individ_indexes, marker_indexes;
+
+        vector< vector< byte > > call_blocks;
+        vector< buffered_row > buffered_rows;
+        vector< char > call_forms;      // 2 characters per call code
+        byte call_codes[ 0x10000 ];     // call code of each character pair; 0xFF if unseen
+        char identity_codes[ 256 ];
 };
 
 }
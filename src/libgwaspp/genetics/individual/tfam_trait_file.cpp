@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "genetics/individual/tfam_trait_file.h"
+
+#include <cstdlib>
+
+namespace libgwaspp {
+namespace genetics {
+
+TFamTraitFile::TFamTraitFile() : GeneticDataFile() {
+    //ctor
+}
+
+bool TFamTraitFile::populateGeneticData( string &filename, GeneticData   *gd, char delim ) {
+    if( filename.empty() ) {
+        gd->setQuantitativeTraitSet( NULL );
+        return true;
+    }
+
+    ifstream iFile( filename.c_str() );
+
+    map< string, double > values;
+
+    string id;
+    char *end;
+    while( !iFile.eof() ) {
+        getline( iFile, line );
+        if( line == "" )
+            continue;
+        parser.str( line );
+        parser.clear();
+
+        getline( parser, id, delim );  // family id
+        getline( parser, tok, delim );   // individual id
+        id += "-" + tok;
+        getline( parser, tok, delim);   // paternal id
+        getline( parser, tok, delim);   // maternal id
+        getline( parser, tok, delim);   // sex
+        getline( parser, tok, delim);   // trait value
+
+        double v = strtod( tok.c_str(), &end );
+        if( end == tok.c_str() || v == -9.0 ) {
+            continue;
+        }
+
+        values[ id ] = v;
+    }
+
+    cout << "Setting trait values of " << values.size() << " individuals." << endl;
+    gd->setQuantitativeTraitSet( &values );
+
+    iFile.close();
+    return true;
+}
+
+TFamTraitFile::~TFamTraitFile() {
+    //dtor
+}
+
+}
+}
@@ -27,13 +27,290 @@
 * either expressed or implied, of the FreeBSD Project.
 */
 #include "genetics/individual/tped_genotype_file.h"
+#include "util/thread/parallel_for.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace libgwaspp {
 namespace genetics {
 
-TpedGenotypeFile::TpedGenotypeFile() : buffer(NULL)
+const ulong TpedGenotypeFile::CHUNK_SIZE = 0x400000;   // 4MB of text per indexing task
+const ulong TpedGenotypeFile::ROW_GRAIN = 64;
+
+struct tped_line_work {
+    const char *data;
+    ulong size;
+    vector< ulong > *begins, *ends;
+};
+
+struct tped_row_work {
+    const char *data;
+    const ulong *begin, *end;
+    const char *codes;
+    char delim;
+    GenoTable *gt;
+};
+
+/**
+ * First occurrence of c in [p, e), or e. Compares 16 bytes at a time.
+ */
+static inline const char *FindByte( const char *p, const char *e, char c ) {
+#ifdef __SSE2__
+    const __m128i pattern = _mm_set1_epi8( c );
+    for( ; p + 16 <= e; p += 16 ) {
+        int m = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128(( const __m128i * ) p ), pattern ) );
+        if( m ) return p + __builtin_ctz( m );
+    }
+#endif
+    while( p < e && *p != c ) ++p;
+    return p;
+}
+
+/**
+ * First space or tab in [p, e), or e.
+ */
+static inline const char *FindBlank( const char *p, const char *e ) {
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8( ' ' ), tab = _mm_set1_epi8( '\t' );
+    for( ; p + 16 <= e; p += 16 ) {
+        __m128i v = _mm_loadu_si128(( const __m128i * ) p );
+        int m = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( v, space ), _mm_cmpeq_epi8( v, tab ) ) );
+        if( m ) return p + __builtin_ctz( m );
+    }
+#endif
+    while( p < e && *p != ' ' && *p != '\t' ) ++p;
+    return p;
+}
+
+static inline bool IsSpace( char c ) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+/**
+ * Converts the genotype columns of the record [p, e) into buf as the
+ * stream parser does: 2 allele characters and delim per genotype.
+ * Returns the number of characters written.
+ */
+static ulong ConvertGenotypeRecord( const char *p, const char *e, const char *codes, char delim, vector< char > &buf ) {
+    // skip the marker columns
+    for( int i = 0; i < 4 && p < e; ++i ) {
+        p = FindBlank( p, e ) + 1;
+    }
+
+    ulong n = ( p < e ) ? ((( ulong )( e - p ) + 1 ) >> 2 ) : 0;
+    if( buf.size() < n * 3 + 1 ) {
+        buf.resize( n * 3 + 1 );
+    }
+
+    char *out = &buf[0];
+    for( ulong i = 0; i < n; ++i, p += 4, out += 3 ) {
+        out[0] = codes[( byte ) p[0] ];
+        out[1] = codes[( byte ) p[2] ];
+        out[2] = delim;
+    }
+    return n * 3;
+}
+
+static void indexLinesWorker( void *arg, ulong begin, ulong end ) {
+    tped_line_work *w = ( tped_line_work * ) arg;
+    const char *data_end = w->data + w->size;
+
+    for( ulong c = begin; c < end; ++c ) {
+        const char *p = w->data + c * TpedGenotypeFile::CHUNK_SIZE;
+        const char *chunk_end = (( ulong )( data_end - p ) > TpedGenotypeFile::CHUNK_SIZE ) ? p + TpedGenotypeFile::CHUNK_SIZE : data_end;
+
+        // a line belongs to the chunk in which it starts
+        if( c > 0 && p[-1] != '\n' ) {
+            p = FindByte( p, chunk_end, '\n' ) + 1;
+        }
+
+        while( p < chunk_end ) {
+            const char *q = FindByte( p, data_end, '\n' );
+            const char *line_end = q;
+
+            while( p < line_end && IsSpace( *p ) ) ++p;
+            while( line_end > p && IsSpace( line_end[-1] ) ) --line_end;
+
+            if( p < line_end ) {
+                w->begins[c].push_back( p - w->data );
+                w->ends[c].push_back( line_end - w->data );
+            }
+            p = q + 1;
+        }
+    }
+}
+
+static void encodeRowsWorker( void *arg, ulong begin, ulong end ) {
+    tped_row_work *w = ( tped_row_work * ) arg;
+    vector< char > buf( 1 );
+
+    for( ulong r = begin; r < end; ++r ) {
+        ulong n = ConvertGenotypeRecord( w->data + w->begin[r], w->data + w->end[r], w->codes, w->delim, buf );
+        w->gt->addGenotypeRow( ( int ) r, &buf[0], &buf[0] + n, w->delim );
+    }
+}
+
+TpedGenotypeFile::TpedGenotypeFile() : buffer(NULL), nThreads( 0 )
 {
     //ctor
+    for( int i = 0; i < 256; ++i ) {
+        allele_codes[ i ] = ( char ) i;
+    }
+    allele_codes[( byte ) '1' ] = 'A';
+    allele_codes[( byte ) '2' ] = 'C';
+    allele_codes[( byte ) '3' ] = 'G';
+    allele_codes[( byte ) '4' ] = 'T';
+}
+
+bool TpedGenotypeFile::populateGeneticData( string &filename, GeneticData *gd, char delim ) {
+    if( isCompressed( filename ) ) {
+        return IndividualGenotypeFile::populateGeneticData( filename, gd, delim );
+    }
+
+    // pipes are not opened here; they can only be read once
+    struct stat st;
+    if( stat( filename.c_str(), &st ) != 0 || !S_ISREG( st.st_mode ) || st.st_size == 0 ) {
+        return IndividualGenotypeFile::populateGeneticData( filename, gd, delim );
+    }
+
+    int fd = open( filename.c_str(), O_RDONLY );
+    if( fd < 0 ) {
+        return IndividualGenotypeFile::populateGeneticData( filename, gd, delim );
+    }
+
+    void *data = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+
+    if( data == MAP_FAILED ) {
+        return IndividualGenotypeFile::populateGeneticData( filename, gd, delim );
+    }
+
+    madvise( data, st.st_size, MADV_WILLNEED );
+
+    bool success = populateFromMapping(( const char * ) data, st.st_size, gd, delim );
+
+    munmap( data, st.st_size );
+    return success;
+}
+
+void TpedGenotypeFile::indexLines( const char *data, ulong size ) {
+    ulong nChunks = ( size + CHUNK_SIZE - 1 ) / CHUNK_SIZE;
+    vector< vector< ulong > > begins( nChunks ), ends( nChunks );
+
+    tped_line_work w;
+    w.data = data;
+    w.size = size;
+    w.begins = &begins[0];
+    w.ends = &ends[0];
+
+    ParallelFor( 0, nChunks, indexLinesWorker, &w, nThreads );
+
+    record_begin.clear();
+    record_end.clear();
+    for( ulong c = 0; c < nChunks; ++c ) {
+        record_begin.insert( record_begin.end(), begins[c].begin(), begins[c].end() );
+        record_end.insert( record_end.end(), ends[c].begin(), ends[c].end() );
+    }
+}
+
+bool TpedGenotypeFile::populateFromMapping( const char *data, ulong size, GeneticData *gd, char delim ) {
+    if( delim == 0 ) return false;
+
+    INIT_LAPSE_TIME;
+    RECORD_START;
+
+    indexLines( data, size );
+
+    RECORD_STOP;
+    PRINT_LAPSE(cout, "Index Lines Time Lapse: " );
+    cout << endl;
+
+    RECORD_START;
+    // build markers
+    marker_indexes.clear();
+
+    string rs, chr, strand, allele = "";
+    for( ulong r = 0; r < record_begin.size(); ++r ) {
+        const char *p = data + record_begin[r], *e = data + record_end[r], *q;
+
+        q = FindByte( p, e, delim );
+        chr.assign( p, q );
+        p = ( q < e ) ? q + 1 : e;
+
+        q = FindByte( p, e, delim );
+        rs.assign( p, q );
+        p = ( q < e ) ? q + 1 : e;
+
+        q = FindByte( p, e, delim );
+        strand.assign( p, q );
+        p = ( q < e ) ? q + 1 : e;
+
+        uint pos = 0;
+        while( p < e && IsSpace( *p ) ) ++p;
+        for( ; p < e && *p >= '0' && *p <= '9'; ++p ) {
+            pos = pos * 10 + ( uint )( *p - '0' );
+        }
+
+        marker_indexes.push_back( gd->getMarkerIndex( gd->createMarker( rs, chr, pos, pos + 1, -1.0, allele ) ) );
+    }
+
+    assert(( int )marker_indexes.size() == gd->getMarkerCount() );
+
+    RECORD_STOP;
+    PRINT_LAPSE(cout, "Parse Marker Time Lapse: " );
+    cout << endl;
+
+    RECORD_START;
+    gd->createGenotypedMarkers( marker_indexes );
+
+    assert( gd->getGenotypedMarkersCount() == gd->getMarkerCount() );
+
+    RECORD_STOP;
+    PRINT_LAPSE(cout, "Create Genotyped Marker Time Lapse: " );
+    cout << endl;
+
+    marker_indexes.clear();
+
+    RECORD_START;
+    gd->updateGenotypeTable();
+    RECORD_STOP;
+    PRINT_LAPSE(cout, "Lapsed time for updating Genotype Table for genotyped individuals and markers: " );
+    cout << endl;
+
+    RECORD_START;
+    // build genotypes; each record is encoded into the row of its line
+    GenoTable *gt = gd->getGenotypeTable();
+
+    tped_row_work w;
+    w.data = data;
+    w.begin = record_begin.empty() ? NULL : &record_begin[0];
+    w.end = record_end.empty() ? NULL : &record_end[0];
+    w.codes = allele_codes;
+    w.delim = delim;
+    w.gt = gt;
+
+    ParallelFor( 0, record_begin.size(), encodeRowsWorker, &w, ( gt->supportsConcurrentRowWrites() ? nThreads : 1 ), ROW_GRAIN );
+
+    // rows were written past GeneticData
+    gd->getSummaryCache()->invalidate();
+
+    row_idx = record_begin.size();
+
+    RECORD_STOP;
+    PRINT_LAPSE(cout, "Lapsed time for compacting Genotype Data: " );
+    cout << endl;
+
+    record_begin.clear();
+    record_end.clear();
+
+    return true;
 }
 
 void TpedGenotypeFile::guessExpectedSizes( istream *iFile, int &mcnt, int &gt_width, char delim ) {
@@ -189,6 +466,19 @@ bool TpedGenotypeFile::parseNextGenotypeRecord( istream *iFile, GeneticData *gd,
     return success;
 }
 
+bool TpedGenotypeFile::bufferGenotypeRecord( char delim ) {
+    trim( line );
+
+    // skip the 4 marker columns
+    const char *p = line.c_str(), *p_end = p + line.length();
+    for( int i = 0; i < 4 && p < p_end; ++i ) {
+        p = FindBlank( p, p_end ) + 1;
+    }
+
+    // alleles are single characters, each followed by a separator
+    return bufferRow( p, ( p < p_end ) ? ((( ulong )( p_end - p ) + 1 ) >> 2 ) : 0, 4, 2, allele_codes );
+}
+
 TpedGenotypeFile::~TpedGenotypeFile()
 {
     //dtor
@@ -31,6 +31,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include "genetics/individual/individual_genotype_file.h"
 #include "genetics/genetic_data.h"
@@ -40,20 +41,49 @@ using namespace std;
 namespace libgwaspp {
 namespace genetics {
 
+/**
+ * Reads PLINK transposed (TPED) genotype files.
+ *
+ * Uncompressed files are memory mapped and split at newline boundaries into
+ * chunks which are indexed on several threads. Markers are created from the
+ * indexed lines, and the genotype columns of each line are then converted and
+ * encoded straight into the table row of that line. Tables which support
+ * concurrent row writes have their rows encoded on several threads; others
+ * are filled in line order. Compressed files, standard input and other files
+ * which cannot be mapped are read in a single pass through the stream parser.
+ */
 class TpedGenotypeFile : public IndividualGenotypeFile {
 public:
     TpedGenotypeFile();
 
+    bool populateGeneticData( string &filename, GeneticData *gd, char delim );
+
+    // number of threads used for mapped files; 0 uses every processor
+    void setThreadCount( uint n ) { nThreads = n; }
+
+    static const ulong CHUNK_SIZE;
+    static const ulong ROW_GRAIN;
+
     virtual ~TpedGenotypeFile();
 protected:
+        bool populateFromMapping( const char *data, ulong size, GeneticData *gd, char delim );
+        void indexLines( const char *data, ulong size );
+
         void guessExpectedSizes( istream *iFile, int &mcnt, int &gt_width, char delim );
 
         bool parseHeader( istream *iFile, GeneticData *gd, char delim );
         bool parseNextMarkerRecord( istream *iFile, GeneticData *gd, char delim );
         bool parseNextGenotypeRecord( istream *iFile, GeneticData *gd, char delim );
+        bool bufferGenotypeRecord( char delim );
 
         char *buffer, *tmp_buffer;
         int buffer_size;
+
+        uint nThreads;
+        char allele_codes[ 256 ];
+
+        // [record_begin[r], record_end[r]) is the trimmed text of genotype row r
+        vector< ulong > record_begin, record_end;
 };
 
 }
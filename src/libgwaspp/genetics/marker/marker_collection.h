@@ -55,6 +55,7 @@ class MarkerCollection : public util::indexable {
 
         const Marker *getMarkerAt( int idx ) const { return markers[ idx ]; }
         const AlleleForm *getAlleleFormAt( int idx ) const { return alleles->getAlleleAt(idx); }
+        const Chromosome *findChromosome( ChromosomeID id ) const { return chromosomes->findChromosome( id ); }
 
         int operator()( const string &id );
         string operator()( int idx ) const;
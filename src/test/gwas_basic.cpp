@@ -50,6 +50,9 @@
 
 #include "genetics/individual/illumina_annotation_file.h"
 #include "genetics/individual/tfam_annotation_file.h"
+#include "genetics/individual/tfam_trait_file.h"
+#include "genetics/individual/covariate_file.h"
+#include "genetics/individual/strata_file.h"
 
 #include "genetics/genotype/geno_table.h"
 
@@ -58,6 +61,17 @@
 #include "algorithms/computation_engine.h"
 #include "algorithms/epistasis_func.h"
 #include "algorithms/maf_func.h"
+#include "algorithms/association_func.h"
+#include "algorithms/fisher_func.h"
+#include "algorithms/hwe_func.h"
+#include "algorithms/sample_qc_func.h"
+#include "algorithms/qt_func.h"
+#include "algorithms/logistic_func.h"
+#include "algorithms/cmh_func.h"
+#include "algorithms/ld_func.h"
+#include "algorithms/clump_func.h"
+#include "algorithms/relationship_func.h"
+#include "algorithms/pca_func.h"
 
 #include "validation_tests/validate_func.h"
 
@@ -94,6 +108,10 @@ const string PHENOTYPE_FILE_KEY = "pheno";
 const string CASE_CONTROL_ANNOTATION_FILE = "annot";
 
 const string OUTPUT_FILE_KEY = "output";
+const string COVARIATE_FILE_KEY = "covar";
+const string STRATA_FILE_KEY = "strata";
+const string CLUMP_RESULTS_KEY = "clump-results";
+const string CLUMP_OUTPUT_KEY = "clump-out";
 
 const string TEST_CONTINGENGY_PERFORMANCE_KEY = "contin-perform";
 const string TEST_CONTINGENGY_CC_PERFORMANCE_KEY = "contin-cc-perform";
@@ -112,13 +130,57 @@ const string TEST_SELECT_DIST_DEBUG_KEY = "test-select-maf";
 
 const string TEST_BOOST_KEY = "test-boost-epi";
 
+const string ASSOCIATION_KEY = "assoc";
+const string FISHER_KEY = "fisher";
+const string HWE_KEY = "hwe";
+const string SAMPLE_QC_KEY = "sample-qc";
+const string QT_KEY = "qt";
+const string LOGISTIC_KEY = "logistic";
+const string CMH_KEY = "cmh";
+const string LD_PRUNE_KEY = "ld-prune";
+const string CLUMP_KEY = "clump";
+const string BOOST_CLUMP_KEY = "boost-clump";
+const string GRM_KEY = "grm";
+const string IBS_KEY = "ibs";
+const string PCA_KEY = "pca";
+
 const string VALIDATE_CALL_KEY = "valid-calls";
 const string VALIDATE_GENO_KEY = "valid-geno";
 
 const string COMPRESSION_LEVEL_KEY = "comp-level";
+const string PAGE_FILE_KEY = "page-file";
+const string PAGE_ROWS_KEY = "page-rows";
+const string CACHED_PAGES_KEY = "cached-pages";
+const string PHASED_KEY = "phased";
 
 bool parseArguments( int argc, char **argv, po::variables_map &vm );
 
+// BOOST reads the case/control contingency tables of the selected set,
+// which the tables below the 3-bit streams do not provide
+inline bool supportsBoost( eCompressionLevel comp_level ) {
+    return comp_level >= e3BitStream;
+}
+
+// the CMH tests read the case/control distributions of every stratum, which
+// the tables below the 3-bit streams do not provide
+inline bool supportsStrata( eCompressionLevel comp_level ) {
+    return comp_level >= e3BitStream;
+}
+
+// the genome-wide analyses read the genotype distributions of the table,
+// which the tables below the 2-bit blocks do not provide
+inline bool supportsAnalyses( eCompressionLevel comp_level ) {
+    return comp_level >= e2BitBlockCompression;
+}
+
+inline bool requestsAnalysis( const po::variables_map &vm ) {
+    const string keys[] = { ASSOCIATION_KEY, FISHER_KEY, HWE_KEY, SAMPLE_QC_KEY, QT_KEY, LOGISTIC_KEY, CMH_KEY, LD_PRUNE_KEY, CLUMP_KEY, BOOST_CLUMP_KEY, GRM_KEY, IBS_KEY, PCA_KEY, TEST_BOOST_KEY };
+    for( uint i = 0; i < sizeof( keys ) / sizeof( keys[0] ); ++i ) {
+        if( vm.count( keys[i] ) ) return true;
+    }
+    return false;
+}
+
 enum FileType { UNK, TPLINK, ILLUMINA };
 
 FileType g_ft = UNK;
@@ -135,7 +197,16 @@ int main( int argc, char **argv ) {
     string annot_file = vm[ CASE_CONTROL_ANNOTATION_FILE.c_str() ].as<string>();
     string out_file = vm[ OUTPUT_FILE_KEY.c_str() ].as<string>();
 
-    auto_ptr<GeneticData> gd( new GeneticData( (eCompressionLevel) vm[ COMPRESSION_LEVEL_KEY ].as< int >() ) );
+    eCompressionLevel comp_level = (eCompressionLevel) vm[ COMPRESSION_LEVEL_KEY ].as< int >();
+    if( requestsAnalysis( vm ) && !supportsAnalyses( comp_level ) ) {
+        cout << "ERROR: The analyses are not supported at compression level " << comp_level << "; use level " << e2BitBlockCompression << " or above" << endl;
+        return 1;
+    }
+
+    auto_ptr<GeneticData> gd( new GeneticData( comp_level, vm.count( PHASED_KEY ) > 0 ) );
+    gd->setPageFile( vm[ PAGE_FILE_KEY ].as< string >() );
+    gd->setPageRowCount( vm[ PAGE_ROWS_KEY ].as< uint >() );
+    gd->setCachedPageCount( vm[ CACHED_PAGES_KEY ].as< uint >() );
     auto_ptr<GeneticDataFile> ipf;  // phenotype file parser
     auto_ptr<GeneticDataFile> igf;  // genotype file parser
     auto_ptr<GeneticDataFile> iaf;  // annotation file parser
@@ -184,7 +255,10 @@ int main( int argc, char **argv ) {
     cout << "Found " << gd->getPhenotypeCount() << " phenotyped traits." << endl;
 
     cout << "Starting to populate genotype data" << endl;
-    igf->populateGeneticData( geno_file, &*gd, delim);
+    if( !igf->populateGeneticData( geno_file, &*gd, delim) ) {
+        cout << "ERROR: Unable to read the genotype file " << geno_file << endl;
+        return 1;
+    }
 
     cout << "Genotyped Individual Count: " << gd->getGenotypedIndividualsCount() << endl;
     cout << "Found " << gd->getMarkerCount() << " markers" << endl;
@@ -233,7 +307,112 @@ int main( int argc, char **argv ) {
     }
 
     if( vm.count( TEST_BOOST_KEY ) ) {
-        compute( computeBoost, &*gd, out );
+        if( supportsBoost( comp_level ) ) {
+            compute( computeBoost, &*gd, out );
+        } else {
+            cout << "BOOST is not supported at compression level " << comp_level << endl;
+        }
+    }
+
+    if( vm.count( ASSOCIATION_KEY ) ) {
+        compute( association_scan, &*gd, out );
+    }
+
+    if( vm.count( FISHER_KEY ) ) {
+        compute( fisher_scan, &*gd, out );
+    }
+
+    if( vm.count( HWE_KEY ) ) {
+        compute( hwe_scan, &*gd, out );
+    }
+
+    if( vm.count( SAMPLE_QC_KEY ) ) {
+        compute( sample_qc_scan, &*gd, out );
+    }
+
+    if( vm.count( QT_KEY ) ) {
+        if( g_ft == TPLINK ) {
+            TFamTraitFile tf;
+            tf.populateGeneticData( annot_file, &*gd, delim );
+            compute( qt_scan, &*gd, out );
+        } else {
+            cout << "Quantitative traits are only read from TFAM files" << endl;
+        }
+    }
+
+    if( vm.count( LOGISTIC_KEY ) ) {
+        CovariateFile cf;
+        string covar_file = vm[ COVARIATE_FILE_KEY ].as< string >();
+        if( cf.populateGeneticData( covar_file, &*gd, delim ) ) {
+            compute( logistic_scan, &*gd, out );
+        }
+    }
+
+    if( vm.count( CMH_KEY ) ) {
+        if( supportsStrata( comp_level ) ) {
+            StrataFile sf;
+            string strata_file = vm[ STRATA_FILE_KEY ].as< string >();
+            if( sf.populateGeneticData( strata_file, &*gd, delim ) ) {
+                compute( cmh_scan, &*gd, out );
+            }
+        } else {
+            cout << "CMH is not supported at compression level " << comp_level << endl;
+        }
+    }
+
+    if( vm.count( LD_PRUNE_KEY ) ) {
+        compute( ld_prune_scan, &*gd, out );
+    }
+
+    if( vm.count( CLUMP_KEY ) ) {
+        string results_file = vm[ CLUMP_RESULTS_KEY ].as< string >();
+        if( results_file.empty() ) {
+            compute( clump_scan, &*gd, out );
+        } else if( results_file.compare( "-" ) == 0 ) {
+            clump_scan( &*gd, &cin, out );
+        } else {
+            ifstream results( results_file.c_str() );
+            if( results.is_open() ) {
+                clump_scan( &*gd, &results, out );
+            } else {
+                cout << "ERROR: Could not open the association results " << results_file << endl;
+            }
+        }
+    }
+
+    if( vm.count( BOOST_CLUMP_KEY ) ) {
+        if( supportsBoost( comp_level ) ) {
+            // the interactions go to the results file, the clumps to a file of their own
+            string clump_file = vm[ CLUMP_OUTPUT_KEY ].as< string >();
+            if( clump_file.empty() && !out_file.empty() ) {
+                clump_file = out_file + ".clumped";
+            }
+
+            if( clump_file.empty() || clump_file.compare( "-" ) == 0 ) {
+                boost_clump_scan( &*gd, out, &cout );
+            } else {
+                ofstream clumps( clump_file.c_str() );
+                if( clumps.is_open() ) {
+                    boost_clump_scan( &*gd, out, &clumps );
+                } else {
+                    cout << "ERROR: Could not open the clump file " << clump_file << endl;
+                }
+            }
+        } else {
+            cout << "BOOST is not supported at compression level " << comp_level << endl;
+        }
+    }
+
+    if( vm.count( GRM_KEY ) ) {
+        compute( grm_scan, &*gd, out );
+    }
+
+    if( vm.count( IBS_KEY ) ) {
+        compute( ibs_scan, &*gd, out );
+    }
+
+    if( vm.count( PCA_KEY ) ) {
+        compute( pca_scan, &*gd, out );
     }
 
     marker_ids->clear();
@@ -252,10 +431,14 @@ bool parseArguments( int argc, char **argv, po::variables_map &vm ) {
 
     po::options_description data_opt( "Data Files" );
     data_opt.add_options()
-    (( GENOTYPE_FILE_KEY + ",g" ).c_str(), po::value< string >()->default_value( "" ), "Genotype File" )
+    (( GENOTYPE_FILE_KEY + ",g" ).c_str(), po::value< string >()->default_value( "" ), "Genotype File; - reads standard input" )
     (( PHENOTYPE_FILE_KEY + ",p").c_str(), po::value< string >()->default_value( "" ), "Phenotype File" )
     (( CASE_CONTROL_ANNOTATION_FILE + ",a").c_str(), po::value<string>()->default_value(""), "Case/Control set annotation file")
     (( OUTPUT_FILE_KEY + ",o").c_str(), po::value< string >()->default_value( "" ), "Results file")
+    (( COVARIATE_FILE_KEY ).c_str(), po::value< string >()->default_value( "" ), "Covariate file of the logistic regression; a FID IID header followed by the covariate names")
+    (( CLUMP_RESULTS_KEY ).c_str(), po::value< string >()->default_value( "" ), "Association results clumped by --clump instead of the allelic test; a MARKER and a P_ALLELIC (or P) column. - reads standard input")
+    (( CLUMP_OUTPUT_KEY ).c_str(), po::value< string >()->default_value( "" ), "Clump report of --boost-clump; by default the results file with .clumped appended, or standard output. - writes standard output")
+    (( STRATA_FILE_KEY ).c_str(), po::value< string >()->default_value( "" ), "Strata file of the CMH tests; a FID IID header followed by the stratum label column")
     ;
 
     po::options_description annotations("Annotation Types (optional)");
@@ -263,6 +446,10 @@ bool parseArguments( int argc, char **argv, po::variables_map &vm ) {
     (( TPLINK_KEY + ",t").c_str(), "Providing genotype file in TPED format, and phenotype file in TFAM format")
     (( ILLUMINA_KEY + ",i").c_str(), "Providing genotype file in ILLU format, and a table of phenotype values")
     (( COMPRESSION_LEVEL_KEY ).c_str(), po::value< int >()->default_value( e2BitBlockCompression ), "Specify which compression method to use default is 2-bit block compression")
+    (( PAGE_FILE_KEY ).c_str(), po::value< string >()->default_value( "" ), "Backing file for the paged genotype table; by default an unlinked temporary file")
+    (( PAGE_ROWS_KEY ).c_str(), po::value< uint >()->default_value( PagedGenotypeTable::DEFAULT_ROWS_PER_PAGE ), "Rows per page of the paged genotype table")
+    (( CACHED_PAGES_KEY ).c_str(), po::value< uint >()->default_value( PagedGenotypeTable::DEFAULT_CACHED_PAGES ), "Pages of the paged genotype table kept in memory; at least 2")
+    (( PHASED_KEY ).c_str(), "The genotype calls are phased; the first allele of a call is on the first haplotype")
     ;
 
     po::options_description tests("Tests");
@@ -277,6 +464,19 @@ bool parseArguments( int argc, char **argv, po::variables_map &vm ) {
     ((TEST_CC_INLINE_DIST_PERFORMANCE_KEY).c_str(), "Performance test of Case/Control Genotype Distributions; Compute MAF using C/C inline")
     ((TEST_INLINE_DIST_DEBUG_KEY).c_str(), "Print all maf distributions for the input set, using an inline distribution counting method")
     ((TEST_BOOST_KEY).c_str(), "Perform Epistasis analysis using an optimized BOOST algorithm")
+    ((ASSOCIATION_KEY).c_str(), "Single marker allelic, trend and genotypic association tests of every marker")
+    ((FISHER_KEY).c_str(), "Fisher exact allelic test of every marker")
+    ((HWE_KEY).c_str(), "Hardy-Weinberg exact test of every marker; cases and controls separately when a case/control set is given")
+    ((SAMPLE_QC_KEY).c_str(), "Call rate, heterozygosity and inbreeding coefficient of every individual")
+    ((QT_KEY).c_str(), "Linear regression of the TFAM phenotype, read as a quantitative trait, on the allele dosage of every marker")
+    ((LOGISTIC_KEY).c_str(), "Logistic regression of case/control status on the allele dosage of every marker, adjusted for the covariates")
+    ((CMH_KEY).c_str(), "Cochran-Mantel-Haenszel allelic and genotypic tests of every marker over the strata of --strata")
+    ((LD_PRUNE_KEY).c_str(), "Sliding window LD pruning; lists the markers which remain in position order")
+    ((CLUMP_KEY).c_str(), "LD clumping of the allelic association results, or of those of --clump-results")
+    ((BOOST_CLUMP_KEY).c_str(), "Optimized BOOST epistasis analysis followed by LD clumping of the reported interactions; the clumps go to --clump-out")
+    ((GRM_KEY).c_str(), "Genomic relationship matrix of the individuals; the lower triangle is written as binary 32-bit floats")
+    ((IBS_KEY).c_str(), "IBS0/IBS1/IBS2 counts of every pair of individuals; the lower triangle is written as binary 32-bit counts")
+    ((PCA_KEY).c_str(), "Top principal components of the standardised genotypes by randomized subspace iteration")
     ;
 
     po::options_description validate( "Validations" );
@@ -324,6 +524,23 @@ bool parseArguments( int argc, char **argv, po::variables_map &vm ) {
     case e2BitBlockCompression:
     case e3BitStream:
     case e2BitStream:
+    case eSparse2BitStream:
+    case eDedup2BitStream:
+    case eMultiAllelicBitPlane:
+    case ePermuted2BitStream:
+        break;
+    case ePaged2BitStream:
+        // a pair of rows must be resident at the same time
+        if( vm[ PAGE_ROWS_KEY ].as< uint >() == 0 || vm[ CACHED_PAGES_KEY ].as< uint >() < 2 ) {
+            cout << "ERROR: The paged genotype table needs at least 1 row per page and 2 cached pages" << endl;
+            return false;
+        }
+        break;
+    case ePhased2BitStream:
+        if( !vm.count( PHASED_KEY ) ) {
+            cout << "ERROR: Compression level " << ePhased2BitStream << " stores haplotypes and needs phased input; pass --" << PHASED_KEY << endl;
+            return false;
+        }
         break;
     default:
         cout << "Invalid Compression Level specified.";
@@ -0,0 +1,556 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <set>
+#include <cstdlib>
+
+#include "libgwaspp.h"
+#include "genetics/genetic_data.h"
+#include "genetics/individual/tped_genotype_file.h"
+#include "genetics/individual/tfam_phenotype_file.h"
+#include "genetics/individual/tfam_annotation_file.h"
+#include "genetics/individual/tfam_trait_file.h"
+#include "genetics/genotype/geno_table.h"
+#include "genetics/genotype/marker_summary_cache.h"
+#include "genetics/analyzable/case_control_set.h"
+#include "genetics/analyzable/quantitative_trait_set.h"
+
+using namespace std;
+using namespace libgwaspp::genetics;
+
+/**
+ * Check of the batched kernels of every table against CompressedGenotypeTable5.
+ *
+ * The genotype codes of each table must match those of the 2-bit stream table,
+ * up to which homozygote of a row is AA. The distribution, column, trait and
+ * vector kernels of the table are then checked against sums computed one
+ * genotype at a time from its own codes. The per-row kernels masked by a
+ * case/control set are compared with those of the 2-bit stream table, before
+ * and after the set is relabelled in place with the same counts, and the
+ * kernel over several sets at once with the per-row kernel of each. The counts
+ * of the relabelled set are also taken from a MarkerSummaryCache, while the
+ * table still has the set selected with its old masks, and from a copy of
+ * that cache written and read back.
+ *
+ * Levels 0 to 2 cannot load TPED rows, and level 3 provides no case/control
+ * kernels.
+ *
+ * Usage: KernelCheck <tped> <tfam> [levels ...]
+ */
+
+// values per column of the vector kernels
+const uint VECTOR_LENGTH = 2;
+
+// rows reported per failed check
+const uint REPORTED_MISMATCHES = 5;
+
+GeneticData *Load( eCompressionLevel level, bool phased, string tped, string tfam ) {
+    GeneticData *gd = new GeneticData( level, phased );
+
+    TfamPhenotypeFile pf;
+    TpedGenotypeFile gf;
+    TFamAnnotationFile af;
+    TFamTraitFile tf;
+
+    pf.populateGeneticData( tfam, gd, '\t' );
+    gf.populateGeneticData( tped, gd, '\t' );
+    af.populateGeneticData( tfam, gd, '\t' );
+    tf.populateGeneticData( tfam, gd, '\t' );
+    return gd;
+}
+
+// small integers, so that every sum is exact
+double VectorValue( uint i, uint k ) {
+    return ( double )(( i * 7 + k * 3 ) % 11 ) - 5.0;
+}
+
+// column c of a mask in the stream column layout
+bool InStream( const ushort *stream, uint c ) {
+    return ( stream[ c >> 4 ] >> ( c & 0x0F ) ) & 1;
+}
+
+// ids of the cases and controls of the set of gd
+void CaseControlIDs( GeneticData &gd, set< string > &cases, set< string > &ctrls ) {
+    CaseControlSet &ccs = *gd.getCaseControlSet();
+    for( int c = 0; c < gd.getGenotypedIndividualsCount(); ++c ) {
+        if( InStream( ccs.stream_case_begin(), c ) ) {
+            cases.insert( gd.getGenotypedIndividualID( c ) );
+        } else if( InStream( ccs.stream_control_begin(), c ) ) {
+            ctrls.insert( gd.getGenotypedIndividualID( c ) );
+        }
+    }
+}
+
+uint CodeIndex( byte code ) {
+    static const uint index[ GENOTYPE_COUNT ] = { 3, 0, 1, 2 };    // xx, aa, ab, bb
+    return index[ code ];
+}
+
+class KernelCheck {
+public:
+    KernelCheck( GenoTable &_gt, uint _level ) : gt( _gt ), level( _level ), nRows( _gt.row_size() ), nColumns( _gt.column_size() ), failures( 0 ) {}
+
+    void checkCodes( const vector< byte > &expected );
+    void checkDistributions();
+    void checkCaseControlDistributions( CaseControlSet &ccs );
+    void checkMaskedDistributions( const string &check, CaseControlSet &ccs, GenoTable &ref_gt, CaseControlSet &ref_ccs );
+    void checkBatchedDistributions( const vector< CaseControlSet * > &sets );
+    void checkSummaryCache( CaseControlSet &ccs, GenoTable &ref_gt, CaseControlSet &ref_ccs );
+    void checkColumnCounts();
+    void checkTraitSums( QuantitativeTraitSet &qts );
+    void checkVectorSums();
+    void checkVectorProducts();
+
+    uint getFailureCount() const { return failures; }
+protected:
+    void report( const string &check, uint mismatches );
+    bool sameCounts( const frequency_table &a, const frequency_table &b, bool called_only ) const;
+    bool sameCalls( const frequency_table &a, const frequency_table &b, bool flipped ) const;
+
+    byte code( uint r, uint c ) const { return codes[ ( ulong ) r * nColumns + c ]; }
+
+    GenoTable &gt;
+    uint level;
+    uint nRows, nColumns;
+    uint failures;
+
+    vector< byte > codes;
+    vector< bool > flipped_rows;    // rows whose AA is the BB of CompressedGenotypeTable5
+};
+
+void KernelCheck::report( const string &check, uint mismatches ) {
+    cout << "level " << level << "\t" << check << "\t" << (( mismatches == 0 ) ? "ok" : "MISMATCH" );
+    if( mismatches ) {
+        cout << " (" << mismatches << ")";
+        ++failures;
+    }
+    cout << endl;
+}
+
+bool KernelCheck::sameCounts( const frequency_table &a, const frequency_table &b, bool called_only ) const {
+    return a.aa == b.aa && a.ab == b.ab && a.bb == b.bb && ( called_only || a.xx == b.xx );
+}
+
+bool KernelCheck::sameCalls( const frequency_table &a, const frequency_table &b, bool flipped ) const {
+    return a.ab == b.ab && ( flipped ? ( a.aa == b.bb && a.bb == b.aa ) : ( a.aa == b.aa && a.bb == b.bb ));
+}
+
+/**
+ * A row matches when its codes equal those of expected, or equal them with AA
+ * and BB swapped throughout the row.
+ */
+void KernelCheck::checkCodes( const vector< byte > &expected ) {
+    codes.assign(( ulong ) nRows * nColumns, 0 );
+    flipped_rows.assign( nRows, false );
+    gt.getGenotypeCodes( 0, nRows, &codes[0] );
+
+    uint mismatches = 0, flipped = 0;
+    for( uint r = 0; r < nRows; ++r ) {
+        const byte *a = &codes[ ( ulong ) r * nColumns ], *b = &expected[ ( ulong ) r * nColumns ];
+        bool same = true, swapped = true;
+
+        for( uint c = 0; c < nColumns; ++c ) {
+            byte s = (( b[c] == STREAM_CODE_AA ) ? STREAM_CODE_BB : (( b[c] == STREAM_CODE_BB ) ? STREAM_CODE_AA : b[c] ));
+            same = same && ( a[c] == b[c] );
+            swapped = swapped && ( a[c] == s );
+        }
+
+        if( !same && swapped ) {
+            flipped_rows[ r ] = true;
+            ++flipped;
+        } else if( !same && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\tcodes of row " << r << " differ" << endl;
+        }
+    }
+
+    if( flipped ) {
+        cout << "level " << level << "\t" << flipped << " rows with the other homozygote as AA" << endl;
+    }
+    report( "codes", mismatches );
+}
+
+void KernelCheck::checkDistributions() {
+    vector< frequency_table > dist( nRows );
+    gt.getGenotypeDistributions( 0, nRows, &dist[0] );
+
+    uint mismatches = 0;
+    for( uint r = 0; r < nRows; ++r ) {
+        frequency_table ft;
+        ResetFrequencyTable( ft );
+        for( uint c = 0; c < nColumns; ++c ) {
+            ++ft.freq[ CodeIndex( code( r, c ) ) ];
+        }
+
+        // the tables differ in what they count as missing; callers take it
+        // from the column count
+        if( !sameCounts( dist[r], ft, true ) && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\tdistribution of row " << r << " differs" << endl;
+        }
+    }
+    report( "distributions", mismatches );
+}
+
+void KernelCheck::checkCaseControlDistributions( CaseControlSet &ccs ) {
+    vector< frequency_table > cases( nRows ), ctrls( nRows );
+    gt.selectCaseControl( ccs );
+    gt.getCaseControlGenotypeDistributions( 0, nRows, &cases[0], &ctrls[0] );
+
+    uint mismatches = 0;
+    for( uint r = 0; r < nRows; ++r ) {
+        frequency_table case_ft, ctrl_ft;
+        ResetFrequencyTable( case_ft );
+        ResetFrequencyTable( ctrl_ft );
+        for( uint c = 0; c < nColumns; ++c ) {
+            if( InStream( ccs.stream_case_begin(), c ) ) {
+                ++case_ft.freq[ CodeIndex( code( r, c ) ) ];
+            } else if( InStream( ccs.stream_control_begin(), c ) ) {
+                ++ctrl_ft.freq[ CodeIndex( code( r, c ) ) ];
+            }
+        }
+
+        if( !( sameCounts( cases[r], case_ft, true ) && sameCounts( ctrls[r], ctrl_ft, true ) ) && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\tcase/control distribution of row " << r << " differs" << endl;
+        }
+    }
+    report( "case/control distributions", mismatches );
+}
+
+/**
+ * The per-row kernel masked by ccs against that of CompressedGenotypeTable5
+ * masked by ref_ccs, which holds the same individuals.
+ */
+void KernelCheck::checkMaskedDistributions( const string &check, CaseControlSet &ccs, GenoTable &ref_gt, CaseControlSet &ref_ccs ) {
+    CaseControlGenotypeDistribution ccgd, ref_ccgd;
+
+    uint mismatches = 0;
+    for( uint r = 0; r < nRows; ++r ) {
+        gt.getCaseControlGenotypeDistribution( r, ccs, ccgd );
+        ref_gt.getCaseControlGenotypeDistribution( r, ref_ccs, ref_ccgd );
+
+        bool same = sameCalls( *ccgd.getCaseDistribution(), *ref_ccgd.getCaseDistribution(), flipped_rows[ r ] )
+                    && sameCalls( *ccgd.getControlDistribution(), *ref_ccgd.getControlDistribution(), flipped_rows[ r ] );
+        if( !same && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\t" << check << " of row " << r << " differs" << endl;
+        }
+    }
+    report( check, mismatches );
+}
+
+/**
+ * The kernel over several sets against the per-row kernel of each set.
+ */
+void KernelCheck::checkBatchedDistributions( const vector< CaseControlSet * > &sets ) {
+    vector< CaseControlGenotypeDistribution > batched( sets.size() );
+    CaseControlGenotypeDistribution single;
+
+    uint mismatches = 0;
+    for( uint r = 0; r < nRows; ++r ) {
+        gt.getCaseControlGenotypeDistributions( r, sets, &batched[0] );
+
+        bool same = true;
+        for( uint k = 0; k < sets.size(); ++k ) {
+            gt.getCaseControlGenotypeDistribution( r, *sets[k], single );
+            same = same && sameCounts( *batched[k].getCaseDistribution(), *single.getCaseDistribution(), true )
+                        && sameCounts( *batched[k].getControlDistribution(), *single.getControlDistribution(), true );
+        }
+        if( !same && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\tbatched case/control distributions of row " << r << " differ" << endl;
+        }
+    }
+    report( "batched case/control distributions", mismatches );
+}
+
+void KernelCheck::checkSummaryCache( CaseControlSet &ccs, GenoTable &ref_gt, CaseControlSet &ref_ccs ) {
+    MarkerSummaryCache cache( &gt );
+
+    vector< frequency_table > counts( nRows ), cases( nRows ), ctrls( nRows );
+    cache.getCounts( 0, nRows, &counts[0] );
+    cache.getCaseControlCounts( 0, nRows, ccs, &cases[0], &ctrls[0] );
+
+    CaseControlGenotypeDistribution ref_ccgd;
+
+    uint mismatches = 0;
+    for( uint r = 0; r < nRows; ++r ) {
+        ref_gt.getCaseControlGenotypeDistribution( r, ref_ccs, ref_ccgd );
+
+        bool same = sameCalls( cases[r], *ref_ccgd.getCaseDistribution(), flipped_rows[ r ] )
+                    && sameCalls( ctrls[r], *ref_ccgd.getControlDistribution(), flipped_rows[ r ] );
+        if( !same && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\tcached case/control counts of row " << r << " differ" << endl;
+        }
+    }
+    report( "cached case/control counts", mismatches );
+
+    stringstream saved;
+    cache.write( saved );
+    string image = saved.str();
+
+    // a truncated image is rejected and leaves the cache empty
+    MarkerSummaryCache copy( &gt );
+    stringstream truncated( image.substr( 0, image.size() / 2 ) );
+    mismatches = copy.read( truncated ) ? 1 : 0;
+
+    stringstream in( image );
+    if( !copy.read( in ) ) {
+        ++mismatches;
+    }
+
+    vector< frequency_table > copy_counts( nRows ), copy_cases( nRows ), copy_ctrls( nRows );
+    copy.getCounts( 0, nRows, &copy_counts[0] );
+    copy.getCaseControlCounts( 0, nRows, ccs, &copy_cases[0], &copy_ctrls[0] );
+
+    // every block must come from the image
+    if( copy.getMisses() != 0 ) {
+        ++mismatches;
+    }
+    for( uint r = 0; r < nRows; ++r ) {
+        bool same = sameCounts( copy_counts[r], counts[r], false ) && sameCounts( copy_cases[r], cases[r], false )
+                    && sameCounts( copy_ctrls[r], ctrls[r], false ) && copy.getMAF( r ) == cache.getMAF( r );
+        if( !same && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\tsummary of row " << r << " differs after write and read" << endl;
+        }
+    }
+    report( "summary cache write and read", mismatches );
+}
+
+void KernelCheck::checkColumnCounts() {
+    vector< frequency_table > columns( nColumns ), expected( nColumns );
+    for( uint c = 0; c < nColumns; ++c ) {
+        ResetFrequencyTable( columns[c] );
+        ResetFrequencyTable( expected[c] );
+    }
+
+    // in two calls, so that the counts are seen to accumulate
+    gt.addColumnGenotypeCounts( 0, nRows / 2, &columns[0] );
+    gt.addColumnGenotypeCounts( nRows / 2, nRows, &columns[0] );
+
+    for( uint r = 0; r < nRows; ++r ) {
+        for( uint c = 0; c < nColumns; ++c ) {
+            ++expected[c].freq[ CodeIndex( code( r, c ) ) ];
+        }
+    }
+
+    uint mismatches = 0;
+    for( uint c = 0; c < nColumns; ++c ) {
+        if( !sameCounts( columns[c], expected[c], false ) && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\tcounts of column " << c << " differ" << endl;
+        }
+    }
+    report( "column counts", mismatches );
+}
+
+void KernelCheck::checkTraitSums( QuantitativeTraitSet &qts ) {
+    vector< trait_sums > sums( nRows );
+    gt.getTraitSums( 0, nRows, qts, &sums[0] );
+
+    uint mismatches = 0;
+    for( uint r = 0; r < nRows; ++r ) {
+        trait_sums ts;
+        ResetTraitSums( ts );
+        for( uint c = 0; c < nColumns; ++c ) {
+            if( !qts.isPhenotyped( c ) ) continue;
+
+            uint idx = CodeIndex( code( r, c ) );
+            ulong q = qts.value( c );
+            ++ts.count.freq[ idx ];
+            ts.sum[ idx ] += q;
+            if( code( r, c ) != STREAM_CODE_MISSING ) {
+                ts.square_sum_called += q * q;
+            }
+        }
+
+        bool same = sameCounts( sums[r].count, ts.count, false ) && sums[r].square_sum_called == ts.square_sum_called;
+        for( uint g = 0; g < GENOTYPE_COUNT; ++g ) {
+            same = same && ( sums[r].sum[g] == ts.sum[g] );
+        }
+        if( !same && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\ttrait sums of row " << r << " differ" << endl;
+        }
+    }
+    report( "trait sums", mismatches );
+}
+
+void KernelCheck::checkVectorSums() {
+    const uint l = VECTOR_LENGTH;
+
+    vector< double > v(( ulong ) nColumns * l );
+    for( uint c = 0; c < nColumns; ++c ) {
+        for( uint k = 0; k < l; ++k ) {
+            v[ ( ulong ) c * l + k ] = VectorValue( c, k );
+        }
+    }
+
+    vector< double > sums(( ulong ) nRows * 3 * l );
+    gt.getGenotypeVectorSums( 0, nRows, &v[0], l, &sums[0] );
+
+    uint mismatches = 0;
+    for( uint r = 0; r < nRows; ++r ) {
+        vector< double > expected( 3 * l, 0.0 );
+        for( uint c = 0; c < nColumns; ++c ) {
+            if( code( r, c ) == STREAM_CODE_AA ) continue;
+
+            // AB, BB and missing
+            uint g = CodeIndex( code( r, c ) ) - 1;
+            for( uint k = 0; k < l; ++k ) {
+                expected[ g * l + k ] += v[ ( ulong ) c * l + k ];
+            }
+        }
+
+        bool same = true;
+        for( uint k = 0; k < 3 * l; ++k ) {
+            same = same && ( sums[ ( ulong ) r * 3 * l + k ] == expected[k] );
+        }
+        if( !same && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\tvector sums of row " << r << " differ" << endl;
+        }
+    }
+    report( "vector sums", mismatches );
+}
+
+void KernelCheck::checkVectorProducts() {
+    const uint l = VECTOR_LENGTH, nParts = 3;
+
+    vector< double > w(( ulong ) nRows * 3 * l );
+    for( uint i = 0; i < w.size(); ++i ) {
+        w[i] = VectorValue( i, 0 );
+    }
+
+    vector< double > columns(( ulong ) nColumns * l, 0.0 ), expected(( ulong ) nColumns * l, 0.0 );
+    for( uint part = 0; part < nParts; ++part ) {
+        gt.addGenotypeVectorProducts( 0, nRows, &w[0], l, part, nParts, &columns[0] );
+    }
+
+    for( uint r = 0; r < nRows; ++r ) {
+        for( uint c = 0; c < nColumns; ++c ) {
+            if( code( r, c ) == STREAM_CODE_AA ) continue;
+
+            uint g = CodeIndex( code( r, c ) ) - 1;
+            for( uint k = 0; k < l; ++k ) {
+                expected[ ( ulong ) c * l + k ] += w[ ( ( ulong ) r * 3 + g ) * l + k ];
+            }
+        }
+    }
+
+    uint mismatches = 0;
+    for( uint c = 0; c < nColumns; ++c ) {
+        bool same = true;
+        for( uint k = 0; k < l; ++k ) {
+            same = same && ( columns[ ( ulong ) c * l + k ] == expected[ ( ulong ) c * l + k ] );
+        }
+        if( !same && ++mismatches <= REPORTED_MISMATCHES ) {
+            cout << "level " << level << "\tvector products of column " << c << " differ" << endl;
+        }
+    }
+    report( "vector products", mismatches );
+}
+
+int main( int argc, char **argv ) {
+    if( argc < 3 ) {
+        cout << "Usage: " << argv[0] << " <tped> <tfam> [levels ...]" << endl;
+        return 1;
+    }
+
+    vector< eCompressionLevel > levels;
+    for( int i = 3; i < argc; ++i ) {
+        levels.push_back(( eCompressionLevel ) atoi( argv[i] ) );
+    }
+    if( levels.empty() ) {
+        for( int l = e2BitBlockCompression; l <= ePermuted2BitStream; ++l ) {
+            levels.push_back(( eCompressionLevel ) l );
+        }
+    }
+
+    GeneticData *ref = Load( e2BitStream, false, argv[1], argv[2] );
+    GenoTable &ref_gt = *ref->getGenotypeTable();
+
+    vector< byte > expected(( ulong ) ref_gt.row_size() * ref_gt.column_size() );
+    ref_gt.getGenotypeCodes( 0, ref_gt.row_size(), &expected[0] );
+
+    set< string > cases, ctrls;
+    CaseControlIDs( *ref, cases, ctrls );
+
+    uint failures = 0;
+    for( uint i = 0; i < levels.size(); ++i ) {
+        // the haplotype table only takes phased calls; the fixture is read as phased
+        GeneticData *gd = Load( levels[i], levels[i] == ePhased2BitStream, argv[1], argv[2] );
+        GenoTable &gt = *gd->getGenotypeTable();
+
+        KernelCheck check( gt, levels[i] );
+
+        check.checkCodes( expected );
+        check.checkDistributions();
+        if( levels[i] >= e3BitStream ) {
+            check.checkCaseControlDistributions( *gd->getCaseControlSet() );
+            check.checkMaskedDistributions( "masked case/control distributions", *gd->getCaseControlSet(), ref_gt, *ref->getCaseControlSet() );
+
+            // the set of the fixture, its complement, and one of every other
+            // case and control
+            set< string > half_cases, half_ctrls;
+            uint n = 0;
+            for( set< string >::iterator it = cases.begin(); it != cases.end(); ++it ) {
+                if( n++ % 2 == 0 ) half_cases.insert( *it );
+            }
+            for( set< string >::iterator it = ctrls.begin(); it != ctrls.end(); ++it ) {
+                if( n++ % 2 == 0 ) half_ctrls.insert( *it );
+            }
+            gd->addCaseControlSet( &cases, &ctrls );
+            gd->addCaseControlSet( &ctrls, &cases );
+            gd->addCaseControlSet( &half_cases, &half_ctrls );
+            check.checkBatchedDistributions( gd->getCaseControlSets() );
+
+            // exchange one case and one control: the set is refilled in place
+            // with the same counts, and must not be answered with its old masks
+            set< string > relabel_cases( cases ), relabel_ctrls( ctrls );
+            relabel_cases.erase( relabel_cases.begin() );
+            relabel_cases.insert( *ctrls.begin() );
+            relabel_ctrls.erase( relabel_ctrls.begin() );
+            relabel_ctrls.insert( *cases.begin() );
+
+            gd->setCaseControlSet( &relabel_cases, &relabel_ctrls );
+            ref->setCaseControlSet( &relabel_cases, &relabel_ctrls );
+            check.checkMaskedDistributions( "relabelled case/control distributions", *gd->getCaseControlSet(), ref_gt, *ref->getCaseControlSet() );
+            check.checkSummaryCache( *gd->getCaseControlSet(), ref_gt, *ref->getCaseControlSet() );
+
+            ref->setCaseControlSet( &cases, &ctrls );
+        }
+        check.checkColumnCounts();
+        check.checkTraitSums( *gd->getQuantitativeTraitSet() );
+        check.checkVectorSums();
+        check.checkVectorProducts();
+
+        failures += check.getFailureCount();
+        delete gd;
+    }
+    delete ref;
+
+    cout << (( failures == 0 ) ? "PASS" : "FAIL" ) << endl;
+    return (( failures == 0 ) ? 0 : 1 );
+}
@@ -0,0 +1,48 @@
+# Runs the GWAS driver for one ctest case.
+#
+#   GWAS    path of the driver
+#   ARGS    its arguments, separated by spaces
+#   PASS    regular expression the standard output must match (optional)
+#   REF_ARGS  arguments of a second, reference run (optional)
+#   COMPARE   files the first and the reference run write, which must be
+#             identical; separated by spaces
+#
+# The case fails when a run does not exit with 0, when the output does not
+# match PASS, or when the COMPARE files differ.
+
+separate_arguments( DRIVER_ARGS UNIX_COMMAND "${ARGS}" )
+
+execute_process( COMMAND ${GWAS} ${DRIVER_ARGS}
+	RESULT_VARIABLE DRIVER_RESULT
+	OUTPUT_VARIABLE DRIVER_OUTPUT
+	ERROR_VARIABLE DRIVER_ERROR )
+
+if( NOT DRIVER_RESULT EQUAL 0 )
+	message( FATAL_ERROR "GWAS ${ARGS} exited with ${DRIVER_RESULT}\n${DRIVER_OUTPUT}${DRIVER_ERROR}" )
+endif( NOT DRIVER_RESULT EQUAL 0 )
+
+if( PASS AND NOT DRIVER_OUTPUT MATCHES "${PASS}" )
+	message( FATAL_ERROR "GWAS ${ARGS} did not print \"${PASS}\"\n${DRIVER_OUTPUT}${DRIVER_ERROR}" )
+endif( PASS AND NOT DRIVER_OUTPUT MATCHES "${PASS}" )
+
+if( REF_ARGS )
+	separate_arguments( REF_DRIVER_ARGS UNIX_COMMAND "${REF_ARGS}" )
+
+	execute_process( COMMAND ${GWAS} ${REF_DRIVER_ARGS}
+		RESULT_VARIABLE REF_RESULT
+		OUTPUT_VARIABLE REF_OUTPUT
+		ERROR_VARIABLE REF_ERROR )
+
+	if( NOT REF_RESULT EQUAL 0 )
+		message( FATAL_ERROR "GWAS ${REF_ARGS} exited with ${REF_RESULT}\n${REF_OUTPUT}${REF_ERROR}" )
+	endif( NOT REF_RESULT EQUAL 0 )
+
+	separate_arguments( COMPARE_FILES UNIX_COMMAND "${COMPARE}" )
+
+	execute_process( COMMAND ${CMAKE_COMMAND} -E compare_files ${COMPARE_FILES}
+		RESULT_VARIABLE COMPARE_RESULT )
+
+	if( NOT COMPARE_RESULT EQUAL 0 )
+		message( FATAL_ERROR "${COMPARE} differ between GWAS ${ARGS} and GWAS ${REF_ARGS}" )
+	endif( NOT COMPARE_RESULT EQUAL 0 )
+endif( REF_ARGS )
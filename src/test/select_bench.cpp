@@ -0,0 +1,253 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include <iostream>
+#include <vector>
+#include <set>
+#include <cstdlib>
+#include <cstring>
+
+#include "libgwaspp.h"
+#include "genetics/analyzable/case_control_set.h"
+#include "genetics/genotype/common_genotype_func.h"
+#include "genetics/genotype/case_control_split.h"
+
+#include "util/index_set/indexer.h"
+#include "util/thread/parallel_for.h"
+#include "util/time/timing.h"
+
+using namespace std;
+using namespace util;
+using namespace libgwaspp::genetics;
+
+/**
+ * Benchmark of the case/control split used by selectCaseControl.
+ *
+ * Compares the previous bit-at-a-time split against SplitCaseControl on one
+ * thread and on every processor, for 2-plane (CompressedGenotypeTable5)
+ * rows of random genotypes.
+ *
+ * Usage: SelectBench [markers] [samples ...]
+ */
+
+// every column of a fixed size set is included, in order
+class SequentialIndexer : public indexer {
+public:
+    SequentialIndexer( int n ) : count( n ) {}
+
+    int orderOf( const string &id ) { return atoi( id.c_str() ); }
+    int indexOf( int _ord ) { return _ord; }
+    string getIDAtOrderedIndex( int _ord ) { return ""; }
+
+    IndexIterator *included_begin() { return NULL; }
+    IndexIterator *included_end() { return NULL; }
+    IndexIterator *excluded_begin() { return NULL; }
+    IndexIterator *excluded_end() { return NULL; }
+
+    int included_size() const { return count; }
+    int excluded_size() const { return 0; }
+    int maximum_size() const { return count; }
+protected:
+    void include( int idx, int at ) {}
+    void include( const vector< int > &idx ) {}
+    void include( int *indices, int count ) {}
+    void include( const string &id, int at ) {}
+    void include( const vector< string > &id ) {}
+
+    void exclude( int idx ) {}
+    void exclude( const vector< int > &idx ) {}
+    void exclude( int *indices, int count ) {}
+    void exclude( const string &id ) {}
+    void exclude( const vector< string > &id ) {}
+
+    int count;
+};
+
+// previous implementation: test and shift one column at a time
+void SplitBitwise( const case_control_split &l, CaseControlSet &ccs, ulong nRows ) {
+    const PWORD *case_ptr = reinterpret_cast< const PWORD * >( ccs.stream_case_begin() );
+    const PWORD *ctrl_ptr = reinterpret_cast< const PWORD * >( ccs.stream_control_begin() );
+
+    memset( l.dst, 0, nRows * l.dst_stride * sizeof( DataBlock ) );
+
+    for( ulong i = 0; i < nRows; ++i ) {
+        const PWORD *_data = reinterpret_cast< const PWORD * >( l.src + i * l.src_stride );
+        const PWORD *_data_ab = reinterpret_cast< const PWORD * >( l.src + i * l.src_stride + l.src_plane_offset );
+
+        PWORD *case_out = reinterpret_cast< PWORD * >( l.dst + i * l.dst_stride );
+        PWORD *case_out_ab = reinterpret_cast< PWORD * >( l.dst + i * l.dst_stride + l.case_blocks );
+        PWORD *ctrl_out = reinterpret_cast< PWORD * >( l.dst + i * l.dst_stride + 2 * l.case_blocks );
+        PWORD *ctrl_out_ab = reinterpret_cast< PWORD * >( l.dst + i * l.dst_stride + 2 * l.case_blocks + l.ctrl_blocks );
+
+        PWORD case_word = 0, case_word_ab = 0, ctrl_word = 0, ctrl_word_ab = 0;
+        PWORD case_mask = 1, ctrl_mask = 1, mask;
+
+        for( uint j = 0; j < l.plane_words; ++j ) {
+            PWORD _aa = _data[ j ], _ab = _data_ab[ j ], _case = case_ptr[ j ], _ctrl = ctrl_ptr[ j ];
+
+            for( mask = 1; mask != 0; mask <<= 1 ) {
+                if( case_mask == 0 ) {
+                    *case_out++ = case_word;
+                    *case_out_ab++ = case_word_ab;
+                    case_word = case_word_ab = 0;
+                    case_mask = 1;
+                }
+                if( ctrl_mask == 0 ) {
+                    *ctrl_out++ = ctrl_word;
+                    *ctrl_out_ab++ = ctrl_word_ab;
+                    ctrl_word = ctrl_word_ab = 0;
+                    ctrl_mask = 1;
+                }
+                if( _case & mask ) {
+                    if( _aa & mask ) case_word |= case_mask;
+                    if( _ab & mask ) case_word_ab |= case_mask;
+                    case_mask <<= 1;
+                } else if( _ctrl & mask ) {
+                    if( _aa & mask ) ctrl_word |= ctrl_mask;
+                    if( _ab & mask ) ctrl_word_ab |= ctrl_mask;
+                    ctrl_mask <<= 1;
+                }
+            }
+        }
+
+        if( case_mask != 1 ) {
+            *case_out = case_word;
+            *case_out_ab = case_word_ab;
+        }
+        if( ctrl_mask != 1 ) {
+            *ctrl_out = ctrl_word;
+            *ctrl_out_ab = ctrl_word_ab;
+        }
+    }
+}
+
+// same padding as CompressedGenotypeTable5
+uint PaddedBlocks( uint n ) {
+    uint blocks = n / ( sizeof( DataBlock ) << 3 ) + 1;
+    if( blocks % BLOCKS_PER_PWORD ) {
+        blocks += ( BLOCKS_PER_PWORD - ( blocks % BLOCKS_PER_PWORD ));
+    }
+    return blocks;
+}
+
+double Seconds( TIME &start, TIME &stop ) {
+    TIME res;
+    diff_TIME( res, stop, start );
+    return res.tv_sec + ( double ) res.FRAC / FRAC_SEC_TIME;
+}
+
+void RunBenchmark( uint nMarkers, uint nSamples ) {
+    SequentialIndexer individs( nSamples );
+
+    set< int > cases, controls;
+    for( uint i = 0; i < nSamples; ++i ) {
+        int r = rand() % 10;
+        if( r < 4 ) {
+            cases.insert( i );
+        } else if( r < 8 ) {
+            controls.insert( i );
+        }
+    }
+
+    CaseControlSet ccs( &individs );
+    ccs.setCases( cases );
+    ccs.setControls( controls );
+
+    case_control_split layout;
+    layout.src_plane_offset = PaddedBlocks( nSamples );
+    layout.src_stride = 2 * layout.src_plane_offset + 1;
+    layout.plane_words = layout.src_plane_offset / BLOCKS_PER_PWORD;
+    layout.plane_count = 2;
+    layout.case_blocks = PaddedBlocks( cases.size() );
+    layout.ctrl_blocks = PaddedBlocks( controls.size() );
+    layout.dst_stride = 2 * ( layout.case_blocks + layout.ctrl_blocks );
+
+    vector< DataBlock > table( nMarkers * layout.src_stride, 0 );
+    for( uint i = 0; i < table.size(); ++i ) {
+        table[ i ] = ( DataBlock ) rand();
+    }
+    layout.src = &table[1];
+
+    vector< DataBlock > expected( nMarkers * layout.dst_stride ), split( nMarkers * layout.dst_stride );
+
+    TIME t1, t2;
+
+    layout.dst = &expected[0];
+    GetTime( t1 );
+    SplitBitwise( layout, ccs, nMarkers );
+    GetTime( t2 );
+    double bitwise = Seconds( t1, t2 );
+
+    layout.dst = &split[0];
+    GetTime( t1 );
+    SplitCaseControl( layout, ccs, nMarkers, 1 );
+    GetTime( t2 );
+    double single = Seconds( t1, t2 );
+    bool single_ok = ( expected == split );
+
+    memset( &split[0], 0, split.size() * sizeof( DataBlock ) );
+    GetTime( t1 );
+    SplitCaseControl( layout, ccs, nMarkers );
+    GetTime( t2 );
+    double threaded = Seconds( t1, t2 );
+    bool threaded_ok = ( expected == split );
+
+    cout << nSamples << "\t" << nMarkers << "\t" << bitwise
+         << "\t" << single << "\t" << bitwise / single
+         << "\t" << threaded << "\t" << bitwise / threaded
+         << "\t" << (( single_ok && threaded_ok ) ? "ok" : "MISMATCH" ) << endl;
+}
+
+int main( int argc, char **argv ) {
+    uint nMarkers = (( argc > 1 ) ? atoi( argv[1] ) : 500 );
+
+    vector< uint > samples;
+    for( int i = 2; i < argc; ++i ) {
+        samples.push_back( atoi( argv[i] ) );
+    }
+    if( samples.empty() ) {
+        samples.push_back( 10000 );
+        samples.push_back( 100000 );
+        samples.push_back( 500000 );
+    }
+
+#ifdef __BMI2__
+    cout << "Bit extraction: BMI2 pext" << endl;
+#else
+    cout << "Bit extraction: portable" << endl;
+#endif
+    cout << "Threads: " << GetProcessorCount() << endl;
+    cout << "Samples\tMarkers\tBitwise(s)\t1 thread(s)\tSpeedup\tAll threads(s)\tSpeedup\tCheck" << endl;
+
+    srand( 42 );
+    for( uint i = 0; i < samples.size(); ++i ) {
+        RunBenchmark( nMarkers, samples[i] );
+    }
+
+    return 0;
+}
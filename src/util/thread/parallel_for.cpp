@@ -0,0 +1,96 @@
+/*
+* Copyright (c) 2012, Patrick Putnam
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met: 
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer. 
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution. 
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are those
+* of the authors and should not be interpreted as representing official policies, 
+* either expressed or implied, of the FreeBSD Project.
+*/
+#include "util/thread/parallel_for.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <cassert>
+#include <vector>
+
+using namespace std;
+
+namespace util {
+
+struct range_task {
+    range_func fn;
+    void *arg;
+    ulong begin, end;
+};
+
+static void *RunRangeTask( void *t ) {
+    range_task *task = reinterpret_cast< range_task * >( t );
+    task->fn( task->arg, task->begin, task->end );
+    return NULL;
+}
+
+uint GetProcessorCount() {
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+    return (( n < 1 ) ? 1 : ( uint ) n );
+}
+
+void ParallelFor( ulong begin, ulong end, range_func fn, void *arg, uint nThreads, ulong min_grain ) {
+    if( begin >= end ) return;
+
+    if( nThreads == 0 ) {
+        nThreads = GetProcessorCount();
+    }
+    if( min_grain == 0 ) {
+        min_grain = 1;
+    }
+
+    ulong n = end - begin;
+    if(( ulong ) nThreads > n / min_grain ) {
+        nThreads = (( n / min_grain > 0 ) ? ( uint )( n / min_grain ) : 1 );
+    }
+
+    vector< range_task > tasks( nThreads );
+    ulong step = n / nThreads, extra = n % nThreads;
+    for( uint i = 0; i < nThreads; ++i ) {
+        tasks[ i ].fn = fn;
+        tasks[ i ].arg = arg;
+        tasks[ i ].begin = begin;
+        begin += step + (( i < extra ) ? 1 : 0 );
+        tasks[ i ].end = begin;
+    }
+
+    // the calling thread takes the first range
+    vector< pthread_t > threads( nThreads );
+    for( uint i = 1; i < nThreads; ++i ) {
+        int res = pthread_create( &threads[ i ], NULL, &RunRangeTask, &tasks[ i ] );
+        assert( res == 0 );
+    }
+
+    RunRangeTask( &tasks[ 0 ] );
+
+    for( uint i = 1; i < nThreads; ++i ) {
+        pthread_join( threads[ i ], NULL );
+    }
+}
+
+}